@@ -20,6 +20,8 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// Modified for Urho3D
+
 #ifndef B2_CONTACT_H
 #define B2_CONTACT_H
 
@@ -210,6 +212,11 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// Urho3D: the two halves of Update. Computing the manifold only writes to this contact,
+	// so it may run on another thread.
+	bool UpdateManifold(b2Manifold* oldManifold);
+	void UpdateTouching(bool touching, const b2Manifold* oldManifold, b2ContactListener* listener);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
@@ -20,22 +20,27 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// Modified for Urho3D
+
 #ifndef B2_CONTACT_MANAGER_H
 #define B2_CONTACT_MANAGER_H
 
 #include "b2_api.h"
 #include "b2_broad_phase.h"
+#include "b2_collision.h"
 
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2TaskExecutor;
 
 // Delegate of b2World.
 class B2_API b2ContactManager
 {
 public:
 	b2ContactManager();
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -52,6 +57,30 @@ public:
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// Urho3D: multithreaded contact updates
+	struct b2ContactUpdate
+	{
+		enum Action
+		{
+			e_destroy,
+			e_sleeping,
+			e_update,
+			e_evaluate
+		};
+
+		b2Contact* contact;
+		b2Manifold oldManifold;
+		int32 action;
+		bool touching;
+	};
+
+	void CollideParallel();
+	static void EvaluateContacts(int32 begin, int32 end, void* context);
+
+	b2TaskExecutor* m_taskExecutor;
+	b2ContactUpdate* m_updates;
+	int32 m_updateCapacity;
 };
 
 #endif
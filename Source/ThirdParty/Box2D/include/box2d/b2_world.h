@@ -20,6 +20,8 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// Modified for Urho3D
+
 #ifndef B2_WORLD_H
 #define B2_WORLD_H
 
@@ -66,6 +68,15 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Urho3D: register a task executor to update the contacts on multiple threads. The contact
+	/// filter and listener are still called from the thread stepping the world, and the contacts
+	/// are updated in the same order as without an executor. The executor is owned by you and
+	/// must remain in scope. Pass null to update the contacts on the stepping thread only.
+	void SetTaskExecutor(b2TaskExecutor* executor);
+
+	/// Urho3D: get the registered task executor.
+	b2TaskExecutor* GetTaskExecutor() const;
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DebugDraw method. The debug draw object is owned
 	/// by you and must remain in scope.
@@ -332,6 +343,11 @@ inline bool b2World::GetAutoClearForces() const
 	return m_clearForces;
 }
 
+inline b2TaskExecutor* b2World::GetTaskExecutor() const
+{
+	return m_contactManager.m_taskExecutor;
+}
+
 inline const b2ContactManager& b2World::GetContactManager() const
 {
 	return m_contactManager;
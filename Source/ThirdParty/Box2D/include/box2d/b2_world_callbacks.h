@@ -20,6 +20,8 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// Modified for Urho3D
+
 #ifndef B2_WORLD_CALLBACKS_H
 #define B2_WORLD_CALLBACKS_H
 
@@ -158,4 +160,22 @@ public:
 									const b2Vec2& normal, float fraction) = 0;
 };
 
+// Urho3D: added task executor for multithreaded contact updates
+
+/// Function executing the items [begin, end) of a parallel loop.
+typedef void b2TaskCallback(int32 begin, int32 end, void* context);
+
+/// Runs the parallel loops of a time step on multiple threads.
+/// See b2World::SetTaskExecutor
+class B2_API b2TaskExecutor
+{
+public:
+	virtual ~b2TaskExecutor() {}
+
+	/// Execute the task for the items [0, itemCount) and return once all of them are done.
+	/// The items may be split into ranges executed in parallel by other threads.
+	/// @param minRange the smallest number of items worth running on another thread
+	virtual void ParallelFor(int32 itemCount, int32 minRange, b2TaskCallback* task, void* context) = 0;
+};
+
 #endif
@@ -20,6 +20,8 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// Modified for Urho3D
+
 #include "box2d/b2_body.h"
 #include "box2d/b2_contact.h"
 #include "box2d/b2_contact_manager.h"
@@ -36,6 +38,14 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = nullptr;
+	m_taskExecutor = nullptr;
+	m_updates = nullptr;
+	m_updateCapacity = 0;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_updates);
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -108,6 +118,12 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
+	if (m_taskExecutor)
+	{
+		CollideParallel();
+		return;
+	}
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
@@ -173,6 +189,143 @@ void b2ContactManager::Collide()
 	}
 }
 
+// Urho3D: the narrow phase of Collide with the manifolds computed by the task executor.
+// The filtering and the broad-phase checks are done first, then the manifolds of the awake
+// solid contacts are computed in parallel. Finally the contacts are destroyed or updated in
+// list order, so the bodies are woken and the listener is called like in the serial loop.
+void b2ContactManager::CollideParallel()
+{
+	if (m_updateCapacity < m_contactCount)
+	{
+		b2Free(m_updates);
+		m_updateCapacity = b2Max(m_contactCount, 2 * m_updateCapacity);
+		m_updates = (b2ContactUpdate*)b2Alloc(m_updateCapacity * sizeof(b2ContactUpdate));
+	}
+
+	int32 updateCount = 0;
+	for (b2Contact* c = m_contactList; c; c = c->GetNext())
+	{
+		b2Fixture* fixtureA = c->GetFixtureA();
+		b2Fixture* fixtureB = c->GetFixtureB();
+		int32 indexA = c->GetChildIndexA();
+		int32 indexB = c->GetChildIndexB();
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+
+		b2ContactUpdate* update = m_updates + updateCount++;
+		update->contact = c;
+
+		// Is this contact flagged for filtering?
+		if (c->m_flags & b2Contact::e_filterFlag)
+		{
+			// Should these bodies collide?
+			if (bodyB->ShouldCollide(bodyA) == false)
+			{
+				update->action = b2ContactUpdate::e_destroy;
+				continue;
+			}
+
+			// Check user filtering.
+			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+			{
+				update->action = b2ContactUpdate::e_destroy;
+				continue;
+			}
+
+			// Clear the filtering flag.
+			c->m_flags &= ~b2Contact::e_filterFlag;
+		}
+
+		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+
+		// The bodies may still be woken by the contacts before this one.
+		if (activeA == false && activeB == false)
+		{
+			update->action = b2ContactUpdate::e_sleeping;
+			continue;
+		}
+
+		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+
+		// Here we destroy contacts that cease to overlap in the broad-phase.
+		if (overlap == false)
+		{
+			update->action = b2ContactUpdate::e_destroy;
+			continue;
+		}
+
+		// The overlap test of sensors updates the global GJK statistics, so update them in order.
+		bool sensor = fixtureA->IsSensor() || fixtureB->IsSensor();
+		update->action = sensor ? b2ContactUpdate::e_update : b2ContactUpdate::e_evaluate;
+	}
+
+	const int32 minRange = 64;
+	m_taskExecutor->ParallelFor(updateCount, minRange, EvaluateContacts, m_updates);
+
+	for (int32 i = 0; i < updateCount; ++i)
+	{
+		b2ContactUpdate* update = m_updates + i;
+		b2Contact* c = update->contact;
+
+		switch (update->action)
+		{
+		case b2ContactUpdate::e_destroy:
+			Destroy(c);
+			break;
+
+		case b2ContactUpdate::e_sleeping:
+			{
+				b2Fixture* fixtureA = c->GetFixtureA();
+				b2Fixture* fixtureB = c->GetFixtureB();
+				b2Body* bodyA = fixtureA->GetBody();
+				b2Body* bodyB = fixtureB->GetBody();
+				bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+				bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+				if (activeA == false && activeB == false)
+				{
+					break;
+				}
+
+				int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+				int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+				if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+				{
+					Destroy(c);
+					break;
+				}
+
+				c->Update(m_contactListener);
+			}
+			break;
+
+		case b2ContactUpdate::e_update:
+			c->Update(m_contactListener);
+			break;
+
+		case b2ContactUpdate::e_evaluate:
+			c->UpdateTouching(update->touching, &update->oldManifold, m_contactListener);
+			break;
+		}
+	}
+}
+
+// Urho3D: compute the manifolds of a range of contacts on a task executor thread.
+void b2ContactManager::EvaluateContacts(int32 begin, int32 end, void* context)
+{
+	b2ContactUpdate* updates = (b2ContactUpdate*)context;
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2ContactUpdate* update = updates + i;
+		if (update->action == b2ContactUpdate::e_evaluate)
+		{
+			update->touching = update->contact->UpdateManifold(&update->oldManifold);
+		}
+	}
+}
+
 void b2ContactManager::FindNewContacts()
 {
 	m_broadPhase.UpdatePairs(this);
@@ -20,6 +20,8 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// Modified for Urho3D
+
 #include "b2_contact_solver.h"
 #include "b2_island.h"
 
@@ -107,6 +109,12 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+// Urho3D: added
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+	m_contactManager.m_taskExecutor = executor;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	m_debugDraw = debugDraw;
@@ -204,6 +204,26 @@ struct dtCrowdAgentDebugInfo
 /// Type for the update callback.
 typedef void (*dtUpdateCallback)(dtCrowdAgent* ag, float dt);
 
+// Urho3D: Add parallel update support
+/// Type for a loop body processing the items [begin, end) on the thread with the given index.
+typedef void (*dtCrowdTaskCallback)(int begin, int end, int threadIndex, void* context);
+
+/// Runs the per-agent phases of the crowd update on multiple threads.
+/// @ingroup crowd
+class dtCrowdTaskExecutor
+{
+public:
+	virtual ~dtCrowdTaskExecutor() {}
+
+	/// The number of threads that may run the tasks, including the calling thread.
+	/// The thread indices passed to the tasks must be less than this.
+	virtual int getThreadCount() const = 0;
+
+	/// Runs the task over the items [0, count) split in ranges of at least minRange items, and returns when
+	/// all the ranges are done. The ranges may run in any order.
+	virtual void parallelFor(int count, int minRange, dtCrowdTaskCallback task, void* context) = 0;
+};
+
 /// Provides local steering behaviors for a group of agents. 
 /// @ingroup crowd
 class dtCrowd
@@ -234,6 +254,42 @@ class dtCrowd
 
 	dtNavMeshQuery* m_navquery;
 
+	// Urho3D: Add parallel update support
+	/// Query objects of a thread running the update phases.
+	struct ThreadData
+	{
+		dtNavMeshQuery* navquery;
+		dtObstacleAvoidanceQuery* obstacleQuery;
+		int velocitySampleCount;
+	};
+
+	/// Per-agent phases of the update that may run in parallel.
+	enum UpdatePhase
+	{
+		PHASE_NEIGHBOURS,
+		PHASE_CORNERS,
+		PHASE_STEERING,
+		PHASE_VELOCITY_PLANNING,
+		PHASE_INTEGRATE,
+		PHASE_COLLISION_DISPLACEMENT,
+		PHASE_COLLISION_APPLY,
+		PHASE_MOVE,
+	};
+
+	dtCrowdTaskExecutor* m_taskExecutor;
+	ThreadData* m_threadData;
+	int m_threadCount;
+
+	int m_updateAgentCount;
+	UpdatePhase m_updatePhase;
+	float m_updateDt;
+	dtCrowdAgentDebugInfo* m_updateDebug;
+
+	void runUpdatePhase(UpdatePhase phase, const int minRange);
+	void updatePhaseRange(const int begin, const int end, ThreadData* thread);
+	static void updatePhaseTask(int begin, int end, int threadIndex, void* context);
+	void freeThreadData();
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
@@ -330,6 +386,29 @@ public:
 	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
 	///  @param[out]	debug	A debug object to load with debug information. [Opt]
 	void update(const float dt, dtCrowdAgentDebugInfo* debug);
+
+	// Urho3D: Add parallel update support
+	/// Sets the executor running the per-agent phases of the update on multiple threads, or null to run them on
+	/// the calling thread. Each thread of the executor gets its own navigation and obstacle avoidance queries,
+	/// which are reallocated when its thread count changes. Must be set again after #init().
+	///  @param[in]		executor	The task executor. [Opt]
+	/// @return True if the per-thread queries could be allocated.
+	bool setTaskExecutor(dtCrowdTaskExecutor* executor);
+
+	/// Gets the executor running the per-agent phases of the update.
+	/// @return The task executor, or null.
+	dtCrowdTaskExecutor* getTaskExecutor() const { return m_taskExecutor; }
+
+	/// Updates the steering and positions of all agents without invoking the update callback or advancing the
+	/// off-mesh connection animations. Touches no other crowd, so crowds sharing a navigation mesh may run this
+	/// concurrently. Must be followed by #finishUpdate().
+	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
+	///  @param[out]	debug	A debug object to load with debug information. [Opt]
+	void updateAgents(const float dt, dtCrowdAgentDebugInfo* debug);
+
+	/// Invokes the update callback for the moved agents and advances the off-mesh connection animations.
+	///  @param[in]		dt		The time, in seconds, passed to #updateAgents().
+	void finishUpdate(const float dt);
 	
 	/// Gets the filter used by the crowd.
 	/// @return The filter used by the crowd.
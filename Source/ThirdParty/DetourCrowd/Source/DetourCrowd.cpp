@@ -343,7 +343,14 @@ dtCrowd::dtCrowd() :
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
 	m_velocitySampleCount(0),
-	m_navquery(0)
+	m_navquery(0),
+	m_taskExecutor(0), // Urho3D: Add parallel update support
+	m_threadData(0),
+	m_threadCount(0),
+	m_updateAgentCount(0),
+	m_updatePhase(PHASE_NEIGHBOURS),
+	m_updateDt(0),
+	m_updateDebug(0)
 {
 	// Urho3D: initialize all class members
 	memset(&m_agentPlacementHalfExtents, 0, sizeof(m_agentPlacementHalfExtents));
@@ -357,6 +364,11 @@ dtCrowd::~dtCrowd()
 
 void dtCrowd::purge()
 {
+	// Urho3D: Add parallel update support
+	freeThreadData();
+	m_taskExecutor = 0;
+	m_updateAgentCount = 0;
+
 	for (int i = 0; i < m_maxAgents; ++i)
 		m_agents[i].~dtCrowdAgent();
 	dtFree(m_agents);
@@ -1057,288 +1069,335 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 	
 void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 {
-	m_velocitySampleCount = 0;
-	
-	const int debugIdx = debug ? debug->idx : -1;
-	
-	dtCrowdAgent** agents = m_activeAgents;
-	int nagents = getActiveAgents(agents, m_maxAgents);
+	// Urho3D: Add parallel update support
+	updateAgents(dt, debug);
+	finishUpdate(dt);
+}
 
-	// Check that all agents still have valid paths.
-	checkPathValidity(agents, nagents, dt);
-	
-	// Update async move request and path finder.
-	updateMoveRequest(dt);
+// Urho3D: Add parallel update support
+/// Minimum number of agents per thread in the phases running navigation and obstacle avoidance queries.
+static const int MIN_PARALLEL_QUERY_AGENTS = 16;
+/// Minimum number of agents per thread in the phases doing only a little arithmetic per agent.
+static const int MIN_PARALLEL_AGENTS = 256;
 
-	// Optimize path topology.
-	updateTopologyOptimization(agents, nagents, dt);
-	
-	// Register agents to proximity grid.
-	m_grid->clear();
-	for (int i = 0; i < nagents; ++i)
+bool dtCrowd::setTaskExecutor(dtCrowdTaskExecutor* executor)
+{
+	const int threadCount = executor ? executor->getThreadCount() : 0;
+	m_taskExecutor = executor;
+	if (threadCount == m_threadCount || (threadCount <= 1 && !m_threadData))
+		return true;
+
+	freeThreadData();
+	if (threadCount <= 1)
+		return true;
+	if (!m_navquery)
 	{
-		dtCrowdAgent* ag = agents[i];
-		const float* p = ag->npos;
-		const float r = ag->params.radius;
-		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
+		m_taskExecutor = 0;
+		return false;
 	}
-	
-	// Get nearby navmesh segments and agents to collide with.
-	for (int i = 0; i < nagents; ++i)
+
+	m_threadData = (ThreadData*)dtAlloc(sizeof(ThreadData)*threadCount, DT_ALLOC_PERM);
+	if (!m_threadData)
 	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+		m_taskExecutor = 0;
+		return false;
+	}
+	memset(m_threadData, 0, sizeof(ThreadData)*threadCount);
+	m_threadCount = threadCount;
 
-		// Update the collision boundary after certain distance has been passed or
-		// if it has become invalid.
-		const float updateThr = ag->params.collisionQueryRange*0.25f;
-		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filters[ag->params.queryFilterType]))
+	// The calling thread uses the crowd's own queries.
+	m_threadData[0].navquery = m_navquery;
+	m_threadData[0].obstacleQuery = m_obstacleQuery;
+	for (int i = 1; i < threadCount; ++i)
+	{
+		ThreadData& thread = m_threadData[i];
+		thread.navquery = dtAllocNavMeshQuery();
+		thread.obstacleQuery = dtAllocObstacleAvoidanceQuery();
+		if (!thread.navquery || dtStatusFailed(thread.navquery->init(m_navquery->getAttachedNavMesh(), MAX_COMMON_NODES)) ||
+			!thread.obstacleQuery || !thread.obstacleQuery->init(6, 8))
 		{
-			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
-								m_navquery, &m_filters[ag->params.queryFilterType]);
+			freeThreadData();
+			m_taskExecutor = 0;
+			return false;
 		}
-		// Query neighbour agents
-		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
-								  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
-								  agents, nagents, m_grid);
-		for (int j = 0; j < ag->nneis; j++)
-			ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
 	}
-	
-	// Find next corner to steer to.
-	for (int i = 0; i < nagents; ++i)
+
+	return true;
+}
+
+void dtCrowd::freeThreadData()
+{
+	for (int i = 1; i < m_threadCount; ++i)
 	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
-		
-		// Find corners for steering
-		ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
-												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filters[ag->params.queryFilterType]);
-		
-		// Check to see if the corner after the next corner is directly visible,
-		// and short cut to there.
-		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
-		{
-			const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
-			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filters[ag->params.queryFilterType]);
-			
-			// Copy data for debug purposes.
-			if (debugIdx == i)
-			{
-				dtVcopy(debug->optStart, ag->corridor.getPos());
-				dtVcopy(debug->optEnd, target);
-			}
-		}
-		else
+		dtFreeNavMeshQuery(m_threadData[i].navquery);
+		dtFreeObstacleAvoidanceQuery(m_threadData[i].obstacleQuery);
+	}
+	dtFree(m_threadData);
+	m_threadData = 0;
+	m_threadCount = 0;
+}
+
+void dtCrowd::runUpdatePhase(UpdatePhase phase, const int minRange)
+{
+	m_updatePhase = phase;
+
+	if (m_taskExecutor && m_threadCount > 1 && m_updateAgentCount > minRange)
+	{
+		for (int i = 0; i < m_threadCount; ++i)
+			m_threadData[i].velocitySampleCount = 0;
+		m_taskExecutor->parallelFor(m_updateAgentCount, minRange, updatePhaseTask, this);
+		for (int i = 0; i < m_threadCount; ++i)
+			m_velocitySampleCount += m_threadData[i].velocitySampleCount;
+	}
+	else
+	{
+		ThreadData thread = { m_navquery, m_obstacleQuery, 0 };
+		updatePhaseRange(0, m_updateAgentCount, &thread);
+		m_velocitySampleCount += thread.velocitySampleCount;
+	}
+}
+
+void dtCrowd::updatePhaseTask(int begin, int end, int threadIndex, void* context)
+{
+	dtCrowd* crowd = (dtCrowd*)context;
+	dtAssert(threadIndex >= 0 && threadIndex < crowd->m_threadCount);
+	crowd->updatePhaseRange(begin, end, &crowd->m_threadData[threadIndex]);
+}
+
+/// @par
+///
+/// Each phase only writes to the agents in the range, and only reads the other agents' data that no earlier
+/// phase of the same pass writes to, so the result does not depend on how the agents are split.
+void dtCrowd::updatePhaseRange(const int begin, const int end, ThreadData* thread)
+{
+	dtCrowdAgent** agents = m_activeAgents;
+	const int nagents = m_updateAgentCount;
+	const float dt = m_updateDt;
+	dtCrowdAgentDebugInfo* debug = m_updateDebug;
+	const int debugIdx = debug ? debug->idx : -1;
+	dtNavMeshQuery* navquery = thread->navquery;
+	dtObstacleAvoidanceQuery* obstacleQuery = thread->obstacleQuery;
+
+	switch (m_updatePhase)
+	{
+	case PHASE_NEIGHBOURS:
+		for (int i = begin; i < end; ++i)
 		{
-			// Copy data for debug purposes.
-			if (debugIdx == i)
+			dtCrowdAgent* ag = agents[i];
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+
+			// Update the collision boundary after certain distance has been passed or
+			// if it has become invalid.
+			const float updateThr = ag->params.collisionQueryRange*0.25f;
+			if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
+				!ag->boundary.isValid(navquery, &m_filters[ag->params.queryFilterType]))
 			{
-				dtVset(debug->optStart, 0,0,0);
-				dtVset(debug->optEnd, 0,0,0);
+				ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
+									navquery, &m_filters[ag->params.queryFilterType]);
 			}
+			// Query neighbour agents
+			ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
+									  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
+									  agents, nagents, m_grid);
+			for (int j = 0; j < ag->nneis; j++)
+				ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
 		}
-	}
-	
-	// Trigger off-mesh connections (depends on corners).
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
-		
-		// Check 
-		const float triggerRadius = ag->params.radius*2.25f;
-		if (overOffmeshConnection(ag, triggerRadius))
+		break;
+
+	case PHASE_CORNERS:
+		for (int i = begin; i < end; ++i)
 		{
-			// Prepare to off-mesh connection.
-			const int idx = (int)(ag - m_agents);
-			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
+			dtCrowdAgent* ag = agents[i];
 			
-			// Adjust the path over the off-mesh connection.
-			dtPolyRef refs[2];
-			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
-													   anim->startPos, anim->endPos, m_navquery))
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+				continue;
+			
+			// Find corners for steering
+			ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
+													DT_CROWDAGENT_MAX_CORNERS, navquery, &m_filters[ag->params.queryFilterType]);
+			
+			// Check to see if the corner after the next corner is directly visible,
+			// and short cut to there.
+			if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
 			{
-				dtVcopy(anim->initPos, ag->npos);
-				anim->polyRef = refs[1];
-				anim->active = true;
-				anim->t = 0.0f;
-				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+				const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
+				ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, navquery, &m_filters[ag->params.queryFilterType]);
 				
-				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
-				ag->ncorners = 0;
-				ag->nneis = 0;
-				continue;
+				// Copy data for debug purposes.
+				if (debugIdx == i)
+				{
+					dtVcopy(debug->optStart, ag->corridor.getPos());
+					dtVcopy(debug->optEnd, target);
+				}
 			}
 			else
 			{
-				// Path validity check will ensure that bad/blocked connections will be replanned.
+				// Copy data for debug purposes.
+				if (debugIdx == i)
+				{
+					dtVset(debug->optStart, 0,0,0);
+					dtVset(debug->optEnd, 0,0,0);
+				}
 			}
 		}
-	}
-		
-	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
+		break;
 
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
-			continue;
-		
-		float dvel[3] = {0,0,0};
-
-		if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-		{
-			dtVcopy(dvel, ag->targetPos);
-			ag->desiredSpeed = dtVlen(ag->targetPos);
-		}
-		else
+	case PHASE_STEERING:
+		for (int i = begin; i < end; ++i)
 		{
-			// Calculate steering direction.
-			if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
-				calcSmoothSteerDirection(ag, dvel);
-			else
-				calcStraightSteerDirection(ag, dvel);
+			dtCrowdAgent* ag = agents[i];
+
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
+				continue;
 			
-			// Calculate speed scale, which tells the agent to slowdown at the end of the path.
-			const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
-			const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
+			float dvel[3] = {0,0,0};
+
+			if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+			{
+				dtVcopy(dvel, ag->targetPos);
+				ag->desiredSpeed = dtVlen(ag->targetPos);
+			}
+			else
+			{
+				// Calculate steering direction.
+				if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
+					calcSmoothSteerDirection(ag, dvel);
+				else
+					calcStraightSteerDirection(ag, dvel);
 				
-			ag->desiredSpeed = ag->params.maxSpeed;
-			dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
-		}
+				// Calculate speed scale, which tells the agent to slowdown at the end of the path.
+				const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
+				const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
+					
+				ag->desiredSpeed = ag->params.maxSpeed;
+				dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
+			}
 
-		// Separation
-		if (ag->params.updateFlags & DT_CROWD_SEPARATION)
-		{
-			const float separationDist = ag->params.collisionQueryRange; 
-			const float invSeparationDist = 1.0f / separationDist; 
-			const float separationWeight = ag->params.separationWeight;
-			
-			float w = 0;
-			float disp[3] = {0,0,0};
-			
-			for (int j = 0; j < ag->nneis; ++j)
+			// Separation
+			if (ag->params.updateFlags & DT_CROWD_SEPARATION)
 			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+				const float separationDist = ag->params.collisionQueryRange; 
+				const float invSeparationDist = 1.0f / separationDist; 
+				const float separationWeight = ag->params.separationWeight;
 				
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
+				float w = 0;
+				float disp[3] = {0,0,0};
 				
-				const float distSqr = dtVlenSqr(diff);
-				if (distSqr < 0.00001f)
-					continue;
-				if (distSqr > dtSqr(separationDist))
-					continue;
-				const float dist = dtMathSqrtf(distSqr);
-				const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
+				for (int j = 0; j < ag->nneis; ++j)
+				{
+					const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+					
+					float diff[3];
+					dtVsub(diff, ag->npos, nei->npos);
+					diff[1] = 0;
+					
+					const float distSqr = dtVlenSqr(diff);
+					if (distSqr < 0.00001f)
+						continue;
+					if (distSqr > dtSqr(separationDist))
+						continue;
+					const float dist = dtMathSqrtf(distSqr);
+					const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
+					
+					dtVmad(disp, disp, diff, weight/dist);
+					w += 1.0f;
+				}
 				
-				dtVmad(disp, disp, diff, weight/dist);
-				w += 1.0f;
+				if (w > 0.0001f)
+				{
+					// Adjust desired velocity.
+					dtVmad(dvel, dvel, disp, 1.0f/w);
+					// Clamp desired velocity to desired speed.
+					const float speedSqr = dtVlenSqr(dvel);
+					const float desiredSqr = dtSqr(ag->desiredSpeed);
+					if (speedSqr > desiredSqr)
+						dtVscale(dvel, dvel, desiredSqr/speedSqr);
+				}
 			}
 			
-			if (w > 0.0001f)
-			{
-				// Adjust desired velocity.
-				dtVmad(dvel, dvel, disp, 1.0f/w);
-				// Clamp desired velocity to desired speed.
-				const float speedSqr = dtVlenSqr(dvel);
-				const float desiredSqr = dtSqr(ag->desiredSpeed);
-				if (speedSqr > desiredSqr)
-					dtVscale(dvel, dvel, desiredSqr/speedSqr);
-			}
+			// Set the desired velocity.
+			dtVcopy(ag->dvel, dvel);
 		}
-		
-		// Set the desired velocity.
-		dtVcopy(ag->dvel, dvel);
-	}
-	
-	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		
-		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
+		break;
+
+	case PHASE_VELOCITY_PLANNING:
+		for (int i = begin; i < end; ++i)
 		{
-			m_obstacleQuery->reset();
+			dtCrowdAgent* ag = agents[i];
 			
-			// Add neighbours as obstacles.
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				m_obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
-			}
-
-			// Append neighbour segments as obstacles.
-			for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			
+			if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
 			{
-				const float* s = ag->boundary.getSegment(j);
-				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
-					continue;
-				m_obstacleQuery->addSegment(s, s+3);
-			}
+				obstacleQuery->reset();
+				
+				// Add neighbours as obstacles.
+				for (int j = 0; j < ag->nneis; ++j)
+				{
+					const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+					obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
+				}
 
-			dtObstacleAvoidanceDebugData* vod = 0;
-			if (debugIdx == i) 
-				vod = debug->vod;
-			
-			// Sample new safe velocity.
-			bool adaptive = true;
-			int ns = 0;
+				// Append neighbour segments as obstacles.
+				for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
+				{
+					const float* s = ag->boundary.getSegment(j);
+					if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
+						continue;
+					obstacleQuery->addSegment(s, s+3);
+				}
 
-			const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
+				dtObstacleAvoidanceDebugData* vod = 0;
+				if (debugIdx == i) 
+					vod = debug->vod;
 				
-			if (adaptive)
-			{
-				ns = m_obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
-															 ag->vel, ag->dvel, ag->nvel, params, vod);
+				// Sample new safe velocity.
+				bool adaptive = true;
+				int ns = 0;
+
+				const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
+					
+				if (adaptive)
+				{
+					ns = obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+															   ag->vel, ag->dvel, ag->nvel, params, vod);
+				}
+				else
+				{
+					ns = obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
+														   ag->vel, ag->dvel, ag->nvel, params, vod);
+				}
+				thread->velocitySampleCount += ns;
 			}
 			else
 			{
-				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
-														 ag->vel, ag->dvel, ag->nvel, params, vod);
+				// If not using velocity planning, new velocity is directly the desired velocity.
+				dtVcopy(ag->nvel, ag->dvel);
 			}
-			m_velocitySampleCount += ns;
 		}
-		else
+		break;
+
+	case PHASE_INTEGRATE:
+		for (int i = begin; i < end; ++i)
 		{
-			// If not using velocity planning, new velocity is directly the desired velocity.
-			dtVcopy(ag->nvel, ag->dvel);
+			dtCrowdAgent* ag = agents[i];
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			integrate(ag, dt);
 		}
-	}
+		break;
 
-	// Integrate.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		integrate(ag, dt);
-	}
-	
-	// Handle collisions.
-	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
-	
-	for (int iter = 0; iter < 4; ++iter)
-	{
-		for (int i = 0; i < nagents; ++i)
+	case PHASE_COLLISION_DISPLACEMENT:
+		for (int i = begin; i < end; ++i)
 		{
+			static const float COLLISION_RESOLVE_FACTOR = 0.7f;
+
 			dtCrowdAgent* ag = agents[i];
 			const int idx0 = getAgentIndex(ag);
 			
@@ -1392,8 +1451,10 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				dtVscale(ag->disp, ag->disp, iw);
 			}
 		}
-		
-		for (int i = 0; i < nagents; ++i)
+		break;
+
+	case PHASE_COLLISION_APPLY:
+		for (int i = begin; i < end; ++i)
 		{
 			dtCrowdAgent* ag = agents[i];
 			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
@@ -1401,29 +1462,147 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			
 			dtVadd(ag->npos, ag->npos, ag->disp);
 		}
+		break;
+
+	case PHASE_MOVE:
+		for (int i = begin; i < end; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			
+			// Move along navmesh.
+			ag->corridor.movePosition(ag->npos, navquery, &m_filters[ag->params.queryFilterType]);
+			// Get valid constrained position back.
+			dtVcopy(ag->npos, ag->corridor.getPos());
+
+			// If not using path, truncate the corridor to just one poly.
+			if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+			{
+				ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
+				ag->partial = false;
+			}
+		}
+		break;
+	}
+}
+
+/// @par
+///
+/// The per-agent phases run on the task executor when one is set, see #setTaskExecutor().
+void dtCrowd::updateAgents(const float dt, dtCrowdAgentDebugInfo* debug)
+{
+	m_velocitySampleCount = 0;
+	
+	dtCrowdAgent** agents = m_activeAgents;
+	int nagents = getActiveAgents(agents, m_maxAgents);
+
+	// Check that all agents still have valid paths.
+	checkPathValidity(agents, nagents, dt);
+	
+	// Update async move request and path finder.
+	updateMoveRequest(dt);
+
+	// Optimize path topology.
+	updateTopologyOptimization(agents, nagents, dt);
+	
+	// Register agents to proximity grid.
+	m_grid->clear();
+	for (int i = 0; i < nagents; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		const float* p = ag->npos;
+		const float r = ag->params.radius;
+		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
 	}
 	
+	m_updateAgentCount = nagents;
+	m_updateDt = dt;
+	m_updateDebug = debug;
+
+	// Get nearby navmesh segments and agents to collide with.
+	runUpdatePhase(PHASE_NEIGHBOURS, MIN_PARALLEL_QUERY_AGENTS);
+	
+	// Find next corner to steer to.
+	runUpdatePhase(PHASE_CORNERS, MIN_PARALLEL_QUERY_AGENTS);
+	
+	// Trigger off-mesh connections (depends on corners).
 	for (int i = 0; i < nagents; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
+		
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
-		
-		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
-		// Get valid constrained position back.
-		dtVcopy(ag->npos, ag->corridor.getPos());
-
-		// If not using path, truncate the corridor to just one poly.
 		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+			continue;
+		
+		// Check 
+		const float triggerRadius = ag->params.radius*2.25f;
+		if (overOffmeshConnection(ag, triggerRadius))
 		{
-			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
-			ag->partial = false;
+			// Prepare to off-mesh connection.
+			const int idx = (int)(ag - m_agents);
+			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
+			
+			// Adjust the path over the off-mesh connection.
+			dtPolyRef refs[2];
+			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
+													   anim->startPos, anim->endPos, m_navquery))
+			{
+				dtVcopy(anim->initPos, ag->npos);
+				anim->polyRef = refs[1];
+				anim->active = true;
+				anim->t = 0.0f;
+				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+				
+				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
+				ag->ncorners = 0;
+				ag->nneis = 0;
+				continue;
+			}
+			else
+			{
+				// Path validity check will ensure that bad/blocked connections will be replanned.
+			}
 		}
+	}
 		
-		// Urho3D: Add update callback support
-		if (m_updateCallback)
+	// Calculate steering.
+	runUpdatePhase(PHASE_STEERING, MIN_PARALLEL_AGENTS);
+	
+	// Velocity planning.
+	runUpdatePhase(PHASE_VELOCITY_PLANNING, MIN_PARALLEL_QUERY_AGENTS);
+
+	// Integrate.
+	runUpdatePhase(PHASE_INTEGRATE, MIN_PARALLEL_AGENTS);
+	
+	// Handle collisions.
+	for (int iter = 0; iter < 4; ++iter)
+	{
+		runUpdatePhase(PHASE_COLLISION_DISPLACEMENT, MIN_PARALLEL_AGENTS);
+		runUpdatePhase(PHASE_COLLISION_APPLY, MIN_PARALLEL_AGENTS);
+	}
+	
+	// Move along navmesh.
+	runUpdatePhase(PHASE_MOVE, MIN_PARALLEL_QUERY_AGENTS);
+
+	m_updateDebug = 0;
+}
+
+void dtCrowd::finishUpdate(const float dt)
+{
+	dtCrowdAgent** agents = m_activeAgents;
+
+	// Urho3D: Add update callback support
+	if (m_updateCallback)
+	{
+		for (int i = 0; i < m_updateAgentCount; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
+			if (!ag->active || ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
 			(*m_updateCallback)(ag, dt);
+		}
 	}
 	
 	// Update agents using off-mesh connection.
@@ -0,0 +1,251 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef WIN32
+#include <Urho3D/Engine/WinWrapped.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+using namespace Urho3D;
+
+static const String USAGE_STR =
+    "Usage: NetworkBenchmark [options]\n"
+    "Replicates a scene of moving nodes from a headless server to in-process loopback clients and reports the cost.\n"
+    "Options:\n"
+    "-nodes <n>       Number of replicated nodes, default 1000\n"
+    "-moving <n>      Percentage of the nodes moving on each update, default 100\n"
+    "-clients <n>     Number of loopback clients, default 8\n"
+    "-seconds <n>     Simulated seconds to run after the clients have joined, default 10\n"
+    "-fps <n>         Network update rate, default 30\n"
+    "-bandwidth <n>   Bandwidth budget per client in bytes per second, default unlimited\n"
+    "-snapshot        Replicate node transforms as snapshots\n"
+    "-compress        Compress the update packets\n"
+    "-serial          Build the server updates on the main thread only\n"
+    "-journal         Use the network change journal instead of comparing all attributes of changed nodes\n"
+    "Example: NetworkBenchmark -nodes 5000 -clients 16 -snapshot";
+
+/// Benchmark settings.
+struct BenchmarkSettings
+{
+    i32 numNodes_{1000};
+    i32 movingPercent_{100};
+    i32 numClients_{8};
+    float seconds_{10.0f};
+    int updateFps_{30};
+    unsigned bandwidthLimit_{0};
+    bool snapshot_{false};
+    bool compress_{false};
+    bool parallel_{true};
+    bool journal_{false};
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+BenchmarkSettings ParseSettings(const Vector<String>& arguments);
+void MoveNodes(Scene* scene, float time, i32 movingPercent);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+BenchmarkSettings ParseSettings(const Vector<String>& arguments)
+{
+    BenchmarkSettings settings;
+
+    for (i32 i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (argument == "-nodes" && hasValue)
+            settings.numNodes_ = Max(ToI32(arguments[++i]), 1);
+        else if (argument == "-moving" && hasValue)
+            settings.movingPercent_ = Clamp(ToI32(arguments[++i]), 0, 100);
+        else if (argument == "-clients" && hasValue)
+            settings.numClients_ = Max(ToI32(arguments[++i]), 1);
+        else if (argument == "-seconds" && hasValue)
+            settings.seconds_ = Max(ToFloat(arguments[++i]), 1.0f);
+        else if (argument == "-fps" && hasValue)
+            settings.updateFps_ = Max(ToI32(arguments[++i]), 1);
+        else if (argument == "-bandwidth" && hasValue)
+            settings.bandwidthLimit_ = ToU32(arguments[++i]);
+        else if (argument == "-snapshot")
+            settings.snapshot_ = true;
+        else if (argument == "-compress")
+            settings.compress_ = true;
+        else if (argument == "-serial")
+            settings.parallel_ = false;
+        else if (argument == "-journal")
+            settings.journal_ = true;
+        else
+            ErrorExit(USAGE_STR);
+    }
+
+    return settings;
+}
+
+void MoveNodes(Scene* scene, float time, i32 movingPercent)
+{
+    // Move the nodes in circles of varying radius and speed, so that the moving ones change on each update
+    const Vector<SharedPtr<Node>>& children = scene->GetChildren();
+    for (i32 i = 0; i < children.Size(); ++i)
+    {
+        if (i % 100 >= movingPercent)
+            continue;
+
+        float angle = time * (30.0f + (i % 7) * 10.0f) + i;
+        float radius = 5.0f + (i % 11);
+        Vector3 center((float)(i % 100) * 20.0f, 0.0f, (float)(i / 100) * 20.0f);
+        children[i]->SetTransform(center + Vector3(Cos(angle) * radius, 0.0f, Sin(angle) * radius),
+            Quaternion(angle, Vector3::UP));
+    }
+}
+
+void Run(const Vector<String>& arguments)
+{
+    BenchmarkSettings settings = ParseSettings(arguments);
+
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    auto* network = new Network(context);
+    context->RegisterSubsystem(network);
+    RegisterSceneLibrary(context);
+
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    queue->CreateThreads(Max((i32)GetNumLogicalCPUs() - 1, 0));
+    network->SetUpdateFps(settings.updateFps_);
+    network->SetParallelServerUpdate(settings.parallel_);
+
+    SharedPtr<Scene> serverScene(new Scene(context));
+    serverScene->SetNetworkChangeJournal(settings.journal_);
+    for (i32 i = 0; i < settings.numNodes_; ++i)
+        serverScene->CreateChild("Node");
+    MoveNodes(serverScene, 0.0f, 100);
+
+    Vector<SharedPtr<Scene>> clientScenes;
+    Vector<Connection*> serverConnections;
+    for (i32 i = 0; i < settings.numClients_; ++i)
+    {
+        SharedPtr<Scene> clientScene(new Scene(context));
+        Connection* connection = network->ConnectLoopback(clientScene);
+        Connection* serverConnection = connection->GetLoopback();
+        serverConnection->SetReplicationMode(settings.snapshot_ ? REPLICATION_SNAPSHOT : REPLICATION_LATESTDATA);
+        serverConnection->SetBandwidthLimit(settings.bandwidthLimit_);
+        for (i32 j = 0; j < MAX_PACKET_TYPES; ++j)
+            serverConnection->SetCompression((PacketType)j, settings.compress_);
+        serverConnection->SetScene(serverScene);
+        clientScenes.Push(clientScene);
+        serverConnections.Push(serverConnection);
+    }
+
+    // Run one network update per frame. Let the clients join and receive the initial scene first
+    const float timeStep = 1.0f / settings.updateFps_;
+    const i32 numWarmupFrames = settings.updateFps_ * 2;
+    const i32 numFrames = (i32)(settings.seconds_ * settings.updateFps_);
+    float time = 0.0f;
+    long long serverUSec = 0;
+    long long prepareUSec = 0;
+    long long clientUSec = 0;
+    long long maxServerUSec = 0;
+    HiresTimer timer;
+
+    for (i32 frame = 0; frame < numWarmupFrames + numFrames; ++frame)
+    {
+        if (frame == numWarmupFrames)
+            serverUSec = prepareUSec = clientUSec = maxServerUSec = 0;
+
+        time += timeStep;
+        MoveNodes(serverScene, time, settings.movingPercent_);
+
+        // Prepare the scene separately to measure the change detection. Network would do it first in its update
+        timer.Reset();
+        serverScene->PrepareNetworkUpdate();
+        prepareUSec += timer.GetUSec(false);
+        network->PostUpdate(timeStep);
+        long long frameServerUSec = timer.GetUSec(false);
+        serverUSec += frameServerUSec;
+        maxServerUSec = Max(maxServerUSec, frameServerUSec);
+
+        timer.Reset();
+        network->Update(timeStep);
+        for (i32 i = 0; i < clientScenes.Size(); ++i)
+            clientScenes[i]->Update(timeStep);
+        clientUSec += timer.GetUSec(false);
+    }
+
+    for (i32 i = 0; i < settings.numClients_; ++i)
+    {
+        if (!serverConnections[i]->IsSceneLoaded())
+            ErrorExit("Client " + String(i) + " did not join the scene");
+    }
+
+    float bytesPerClient = 0.0f;
+    float deferredNodes = 0.0f;
+    for (i32 i = 0; i < settings.numClients_; ++i)
+    {
+        bytesPerClient += serverConnections[i]->GetMessageBytesPerSec();
+        deferredNodes += (float)serverConnections[i]->GetNumDeferredNodes();
+    }
+    bytesPerClient /= settings.numClients_;
+    deferredNodes /= settings.numClients_;
+
+    char line[256];
+    snprintf(line, sizeof line, "Nodes %d (%d%% moving) clients %d update fps %d worker threads %d", settings.numNodes_,
+        settings.movingPercent_, settings.numClients_, settings.updateFps_, settings.parallel_ ? queue->GetNumThreads() : 0);
+    PrintLine(line);
+    snprintf(line, sizeof line, "Server update: %.3f ms average, %.3f ms max", serverUSec / 1000.0 / numFrames,
+        maxServerUSec / 1000.0);
+    PrintLine(line);
+    snprintf(line, sizeof line, "Change detection: %.3f ms average%s", prepareUSec / 1000.0 / numFrames,
+        settings.journal_ ? " using the change journal" : "");
+    PrintLine(line);
+    snprintf(line, sizeof line, "Client apply: %.3f ms average per client", clientUSec / 1000.0 / numFrames / settings.numClients_);
+    PrintLine(line);
+    snprintf(line, sizeof line, "Messages: %.1f KB/s per client over the last second", bytesPerClient / 1024.0f);
+    PrintLine(line);
+    if (settings.compress_)
+    {
+        unsigned long long uncompressed = 0;
+        unsigned long long compressed = 0;
+        for (i32 i = 0; i < settings.numClients_; ++i)
+        {
+            uncompressed += serverConnections[i]->GetUncompressedBytesOut();
+            compressed += serverConnections[i]->GetCompressedBytesOut();
+        }
+        if (uncompressed)
+        {
+            snprintf(line, sizeof line, "Compression ratio: %.3f", (double)compressed / uncompressed);
+            PrintLine(line);
+        }
+    }
+    if (settings.bandwidthLimit_)
+    {
+        snprintf(line, sizeof line, "Deferred nodes: %.1f per client update", deferredNodes);
+        PrintLine(line);
+    }
+}
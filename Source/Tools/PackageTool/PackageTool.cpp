@@ -4,6 +4,7 @@
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Container/ArrayPtr.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/IO/Compression.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/PackageFile.h>
@@ -12,9 +13,6 @@
 #include <Urho3D/Engine/WinWrapped.h>
 #endif
 
-#include <LZ4/lz4.h>
-#include <LZ4/lz4hc.h>
-
 #include <Urho3D/DebugNew.h>
 
 using namespace Urho3D;
@@ -35,6 +33,7 @@ String basePath_;
 Vector<FileEntry> entries_;
 hash32 checksum_ = 0;
 bool compress_ = false;
+CompressionCodec codec_ = COMPRESSION_LZ4;
 bool quiet_ = false;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
 
@@ -72,6 +71,7 @@ static const String USAGE_STR =
     "   Options:\n"
     "     q - enable quiet mode\n"
     "     c - enable LZ4 compression\n"
+    "     z - enable Zstandard compression (better ratio, slower to pack)\n"
     "   Base path is an optional prefix that will be added to the file entries.\n"
     "   Example: PackageTool -pqc CoreData CoreData.pak\n"
     "2) Unpacking: PackageTool -u<options> <input package name> <output directory name>\n"
@@ -98,6 +98,11 @@ void Pack(const Vector<String>& arguments)
             quiet_ = true;
         else if (mode[i] == 'c')
             compress_ = true;
+        else if (mode[i] == 'z')
+        {
+            compress_ = true;
+            codec_ = COMPRESSION_ZSTD;
+        }
         else
             ErrorExit("Unrecognized option");
     }
@@ -342,7 +347,8 @@ void WritePackageFile(const String& fileName, const String& rootDir)
         }
         else // Compress 
         {
-            SharedArrayPtr<u8> compressBuffer(new u8[LZ4_compressBound(blockSize_)]);
+            unsigned compressBound = EstimateCompressBound(blockSize_, codec_);
+            SharedArrayPtr<u8> compressBuffer(new u8[compressBound]);
 
             unsigned pos = 0;
 
@@ -352,9 +358,9 @@ void WritePackageFile(const String& fileName, const String& rootDir)
                 if (pos + unpackedSize > dataSize)
                     unpackedSize = dataSize - pos;
 
-                auto packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)compressBuffer.Get(), unpackedSize, LZ4_compressBound(unpackedSize), 0);
+                unsigned packedSize = CompressData(compressBuffer.Get(), compressBound, &buffer[pos], unpackedSize, codec_);
                 if (!packedSize)
-                    ErrorExit("LZ4 compression failed for file " + entries_[i].name_ + " at offset " + String(pos));
+                    ErrorExit("Compression failed for file " + entries_[i].name_ + " at offset " + String(pos));
 
                 dest.WriteU16((unsigned short)unpackedSize);
                 dest.WriteU16((unsigned short)packedSize);
@@ -396,7 +402,7 @@ void WritePackageFile(const String& fileName, const String& rootDir)
         PrintLine("File data size: " + String(totalDataSize));
         PrintLine("Package size: " + String(dest.GetSize()));
         PrintLine("Checksum: " + String(checksum_));
-        PrintLine("Compressed: " + String(compress_ ? "yes" : "no"));
+        PrintLine("Compressed: " + String(compress_ ? (codec_ == COMPRESSION_ZSTD ? "Zstandard" : "LZ4") : "no"));
     }
 }
 
@@ -404,6 +410,8 @@ void WriteHeader(File& dest)
 {
     if (!compress_)
         dest.WriteFileID("UPAK");
+    else if (codec_ == COMPRESSION_ZSTD)
+        dest.WriteFileID("UZST");
     else
         dest.WriteFileID("ULZ4");
     dest.WriteU32(entries_.Size());
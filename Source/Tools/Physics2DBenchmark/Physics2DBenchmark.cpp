@@ -0,0 +1,210 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Physics2D/CollisionBox2D.h>
+#include <Urho3D/Physics2D/CollisionCircle2D.h>
+#include <Urho3D/Physics2D/Physics2D.h>
+#include <Urho3D/Physics2D/PhysicsWorld2D.h>
+#include <Urho3D/Physics2D/RigidBody2D.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef WIN32
+#include <Urho3D/Engine/WinWrapped.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+using namespace Urho3D;
+
+static const String USAGE_STR =
+    "Usage: Physics2DBenchmark [options]\n"
+    "Steps a headless 2D physics scene of bodies falling into piles and reports the cost.\n"
+    "Options:\n"
+    "-bodies <n>      Number of dynamic bodies, default 10000\n"
+    "-seconds <n>     Simulated seconds, default 10\n"
+    "-fps <n>         Physics steps per second, default 60\n"
+    "-threads <n>     Number of worker threads, default one less than the logical CPUs\n"
+    "-serial          Compute the contacts on the main thread only\n"
+    "-serialsync      Apply the body transforms to the scene nodes on the main thread only\n"
+    "Example: Physics2DBenchmark -bodies 20000 -serial";
+
+/// Benchmark settings.
+struct BenchmarkSettings
+{
+    i32 numBodies_{10000};
+    float seconds_{10.0f};
+    int fps_{60};
+    i32 numThreads_{-1};
+    bool multithreaded_{true};
+    bool parallelTransformSync_{true};
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+BenchmarkSettings ParseSettings(const Vector<String>& arguments);
+void CreateBodies(Scene* scene, i32 numBodies);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+BenchmarkSettings ParseSettings(const Vector<String>& arguments)
+{
+    BenchmarkSettings settings;
+
+    for (i32 i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (argument == "-bodies" && hasValue)
+            settings.numBodies_ = Max(ToI32(arguments[++i]), 1);
+        else if (argument == "-seconds" && hasValue)
+            settings.seconds_ = Max(ToFloat(arguments[++i]), 1.0f);
+        else if (argument == "-fps" && hasValue)
+            settings.fps_ = Max(ToI32(arguments[++i]), 1);
+        else if (argument == "-threads" && hasValue)
+            settings.numThreads_ = Max(ToI32(arguments[++i]), 0);
+        else if (argument == "-serial")
+            settings.multithreaded_ = false;
+        else if (argument == "-serialsync")
+            settings.parallelTransformSync_ = false;
+        else
+            ErrorExit(USAGE_STR);
+    }
+
+    return settings;
+}
+
+void CreateBodies(Scene* scene, i32 numBodies)
+{
+    // Bodies fall in columns of 100 into separate bins, so that the piles form many contacts but few huge islands
+    const i32 numColumns = 100;
+    const i32 numBins = Max((numBodies + 999) / 1000, 1);
+    const float binWidth = numColumns / numBins * 1.1f + 4.0f;
+
+    for (i32 i = 0; i <= numBins; ++i)
+    {
+        Node* node = scene->CreateChild("Wall");
+        node->SetPosition2D(Vector2(i * binWidth - 1.0f, 100.0f));
+        node->CreateComponent<RigidBody2D>();
+        node->CreateComponent<CollisionBox2D>()->SetSize(Vector2(1.0f, 200.0f));
+    }
+
+    Node* ground = scene->CreateChild("Ground");
+    ground->SetPosition2D(Vector2(numBins * binWidth * 0.5f, -1.0f));
+    ground->CreateComponent<RigidBody2D>();
+    ground->CreateComponent<CollisionBox2D>()->SetSize(Vector2(numBins * binWidth + 2.0f, 2.0f));
+
+    const i32 columnsPerBin = numColumns / numBins;
+    for (i32 i = 0; i < numBodies; ++i)
+    {
+        const i32 column = i % numColumns;
+        const i32 row = i / numColumns;
+        const i32 bin = Min(column / Max(columnsPerBin, 1), numBins - 1);
+        const float x = bin * binWidth + 1.5f + (column - bin * columnsPerBin) * 1.1f + (row % 2) * 0.3f;
+
+        Node* node = scene->CreateChild("Body");
+        node->SetPosition2D(Vector2(x, 1.0f + row * 1.2f));
+        node->CreateComponent<RigidBody2D>()->SetBodyType(BT_DYNAMIC);
+        CollisionShape2D* shape;
+        if (i % 2)
+        {
+            auto* circle = node->CreateComponent<CollisionCircle2D>();
+            circle->SetRadius(0.5f);
+            shape = circle;
+        }
+        else
+        {
+            auto* box = node->CreateComponent<CollisionBox2D>();
+            box->SetSize(Vector2(0.9f, 0.9f));
+            shape = box;
+        }
+        shape->SetDensity(1.0f);
+        shape->SetFriction(0.4f);
+    }
+}
+
+void Run(const Vector<String>& arguments)
+{
+    BenchmarkSettings settings = ParseSettings(arguments);
+
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    RegisterSceneLibrary(context);
+    RegisterPhysics2DLibrary(context);
+
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    queue->CreateThreads(settings.numThreads_ >= 0 ? settings.numThreads_ : Max((i32)GetNumLogicalCPUs() - 1, 0));
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* physicsWorld = scene->CreateComponent<PhysicsWorld2D>();
+    physicsWorld->SetMultithreaded(settings.multithreaded_);
+    physicsWorld->SetParallelTransformSync(settings.parallelTransformSync_);
+    CreateBodies(scene, settings.numBodies_);
+
+    const float timeStep = 1.0f / settings.fps_;
+    const i32 numSteps = (i32)(settings.seconds_ * settings.fps_);
+    long long totalUSec = 0;
+    long long maxUSec = 0;
+    double stepMSec = 0.0;
+    double collideMSec = 0.0;
+    double solveMSec = 0.0;
+    double solveTOIMSec = 0.0;
+    HiresTimer timer;
+
+    for (i32 step = 0; step < numSteps; ++step)
+    {
+        timer.Reset();
+        physicsWorld->Update(timeStep);
+        long long stepUSec = timer.GetUSec(false);
+        totalUSec += stepUSec;
+        maxUSec = Max(maxUSec, stepUSec);
+
+        const b2Profile& profile = physicsWorld->GetWorld()->GetProfile();
+        stepMSec += profile.step;
+        collideMSec += profile.collide;
+        solveMSec += profile.solve;
+        solveTOIMSec += profile.solveTOI;
+    }
+
+    i32 numAwake = 0;
+    for (b2Body* body = physicsWorld->GetWorld()->GetBodyList(); body; body = body->GetNext())
+    {
+        if (body->GetType() == b2_dynamicBody && body->IsAwake())
+            ++numAwake;
+    }
+
+    char line[256];
+    snprintf(line, sizeof line, "Bodies %d steps %d worker threads %d, contacts %s, transform sync %s", settings.numBodies_,
+        numSteps, queue->GetNumThreads(), settings.multithreaded_ ? "parallel" : "serial",
+        settings.parallelTransformSync_ ? "parallel" : "serial");
+    PrintLine(line);
+    snprintf(line, sizeof line, "Update: %.3f ms average, %.3f ms max", totalUSec / 1000.0 / numSteps, maxUSec / 1000.0);
+    PrintLine(line);
+    snprintf(line, sizeof line, "Box2D step: %.3f ms average (contacts %.3f ms, solve %.3f ms, continuous %.3f ms)",
+        stepMSec / numSteps, collideMSec / numSteps, solveMSec / numSteps, solveTOIMSec / numSteps);
+    PrintLine(line);
+    snprintf(line, sizeof line, "Transform sync and events: %.3f ms average", totalUSec / 1000.0 / numSteps - stepMSec / numSteps);
+    PrintLine(line);
+    snprintf(line, sizeof line, "Final contacts %d, awake bodies %d", physicsWorld->GetWorld()->GetContactCount(), numAwake);
+    PrintLine(line);
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/TextureStreamer.h>
+#include <Urho3D/GraphicsAPI/Texture2D.h>
+#include <Urho3D/Resource/Image.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static SharedPtr<Image> MakeImage(Context* context, int size)
+{
+    SharedPtr<Image> image(new Image(context));
+    image->SetSize(size, size, 4);
+    image->Clear(Color::WHITE);
+    return image;
+}
+
+void Test_Graphics_TextureStreamer()
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<TextureStreamer> streamer(new TextureStreamer(context));
+    streamer->SetMinResidentSize(64);
+
+    assert(TextureStreamer::CalculateRequiredLevel(1024, 1024.0f, 11) == 0);
+    assert(TextureStreamer::CalculateRequiredLevel(1024, 256.0f, 11) == 2);
+    assert(TextureStreamer::CalculateRequiredLevel(1024, 200.0f, 11) == 2);
+    assert(TextureStreamer::CalculateRequiredLevel(1024, 0.0f, 11) == 10);
+
+    // Textures at or below the resident size are not streamed
+    SharedPtr<Texture2D> small(new Texture2D(context));
+    SharedPtr<Image> smallImage = MakeImage(context, 32);
+    assert(!streamer->AddTexture(small, smallImage));
+    assert(!small->IsStreamed());
+
+    // Only the mip levels from 64x64 down are initially resident
+    SharedPtr<Texture2D> first(new Texture2D(context));
+    SharedPtr<Texture2D> second(new Texture2D(context));
+    first->SetName("First.png");
+    second->SetName("Second.png");
+    SharedPtr<Image> firstImage = MakeImage(context, 1024);
+    SharedPtr<Image> secondImage = MakeImage(context, 1024);
+    assert(streamer->AddTexture(first, firstImage));
+    assert(streamer->AddTexture(second, secondImage));
+    assert(first->IsStreamed() && first->GetStreamingLevel() == 4);
+
+    const StreamedTexture* firstState = streamer->GetTexture(first);
+    assert(firstState->levelSizes_.Size() == 11);
+    assert(firstState->levelSizes_[0] == 1024 * 1024 * 4);
+    unsigned long long minMemory = TextureStreamer::GetLevelsMemory(firstState->levelSizes_, 4);
+    assert(streamer->GetMemoryUse() == 2 * minMemory);
+
+    // Full size on screen requires the full resolution within an unlimited budget
+    first->RequestStreaming(100.0f, 1);
+    first->RequestStreaming(1024.0f, 1);
+    second->RequestStreaming(512.0f, 1);
+    streamer->Update(1);
+    assert(streamer->GetLevelBias() == 0);
+    assert(firstState->targetLevel_ == 0);
+    assert(streamer->GetTexture(second)->targetLevel_ == 1);
+
+    // Image data arriving from the loader makes the target levels resident
+    assert(streamer->SetLevelData(first, firstImage));
+    assert(streamer->SetLevelData(second, secondImage));
+    assert(firstState->residentLevel_ == 0 && first->GetStreamingLevel() == 0);
+    assert(streamer->GetMemoryUse() == streamer->GetTargetMemoryUse());
+
+    // A smaller budget drops the same number of levels from both textures
+    streamer->SetMemoryBudget(TextureStreamer::GetLevelsMemory(firstState->levelSizes_, 2) * 2);
+    first->RequestStreaming(1024.0f, 2);
+    second->RequestStreaming(512.0f, 2);
+    streamer->Update(2);
+    assert(streamer->GetLevelBias() == 2);
+    assert(firstState->targetLevel_ == 2);
+    assert(streamer->GetTexture(second)->targetLevel_ == 3);
+    assert(streamer->GetTargetMemoryUse() <= streamer->GetMemoryBudget());
+
+    // Textures not visible anymore stream out to the lowest detail after the timeout
+    streamer->SetMemoryBudget(M_MAX_UNSIGNED);
+    streamer->SetRequestTimeout(10);
+    second->RequestStreaming(512.0f, 20);
+    streamer->Update(20);
+    assert(firstState->targetLevel_ == 4);
+    assert(streamer->GetTexture(second)->targetLevel_ == 1);
+
+    // Destroyed textures are forgotten
+    second.Reset();
+    streamer->Update(21);
+    assert(streamer->GetNumTextures() == 1);
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/IO/BitStream.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+void Test_IO_BitStream()
+{
+    VectorBuffer buffer;
+    {
+        BitWriter writer(buffer);
+        writer.WriteBit(true);
+        writer.WriteBits(5, 3);
+        // Bytes written after unaligned bits are packed too
+        writer.WriteString("Urho3D");
+        writer.WriteBits(0xffffffffu, 32);
+        writer.WriteQuantizedFloat(0.25f, -1.0f, 1.0f, 10);
+        writer.WriteQuantizedFloat(1000.0f, -1.0f, 1.0f, 10);
+        assert(writer.GetNumBits() == 1 + 3 + 7 * 8 + 32 + 10 + 10);
+    }
+    assert(buffer.GetSize() == (1 + 3 + 7 * 8 + 32 + 10 + 10 + 7) / 8);
+
+    MemoryBuffer source(buffer.GetBuffer());
+    {
+        BitReader reader(source);
+        assert(reader.ReadBit());
+        assert(reader.ReadBits(3) == 5);
+        assert(reader.ReadString() == "Urho3D");
+        assert(reader.ReadBits(32) == 0xffffffffu);
+        assert(Abs(reader.ReadQuantizedFloat(-1.0f, 1.0f, 10) - 0.25f) < 0.002f);
+        // Values outside the range are clamped
+        assert(reader.ReadQuantizedFloat(-1.0f, 1.0f, 10) == 1.0f);
+    }
+    assert(source.IsEof());
+
+    // Aligned bytes pass through unchanged
+    VectorBuffer aligned;
+    {
+        BitWriter writer(aligned);
+        writer.WriteU32(0x12345678u);
+        writer.WriteBits(1, 1);
+    }
+    MemoryBuffer alignedSource(aligned.GetBuffer());
+    assert(alignedSource.ReadU32() == 0x12345678u);
+    assert(alignedSource.ReadU8() == 1);
+
+    assert(QuantizeFloat(-5.0f, -5.0f, 5.0f, 8) == 0);
+    assert(QuantizeFloat(5.0f, -5.0f, 5.0f, 8) == 255);
+    assert(Abs(DequantizeFloat(QuantizeFloat(1.0f, -5.0f, 5.0f, 16), -5.0f, 5.0f, 16) - 1.0f) < 0.0002f);
+}
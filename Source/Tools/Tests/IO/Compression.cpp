@@ -0,0 +1,79 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/IO/Compression.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static VectorBuffer MakeSamplePayload(unsigned index)
+{
+    // Small scene-update-like payloads which share most of their structure
+    VectorBuffer buffer;
+    buffer.WriteString("<node id=\"" + String(index) + "\"><attribute name=\"Position\" value=\"" + String(index * 0.5f) +
+        " 0 " + String(index * 0.25f) + "\" /><attribute name=\"Rotation\" value=\"1 0 0 0\" /></node>");
+    return buffer;
+}
+
+void Test_IO_Compression()
+{
+    VectorBuffer source;
+    for (unsigned i = 0; i < 200; ++i)
+        source.Write(MakeSamplePayload(i).GetData(), MakeSamplePayload(i).GetSize());
+
+    // Stream roundtrip with both codecs, Zstandard should compress the repetitive data at least as well as LZ4
+    unsigned compressedSizes[MAX_COMPRESSION_CODECS];
+    for (unsigned codec = 0; codec < MAX_COMPRESSION_CODECS; ++codec)
+    {
+        VectorBuffer compressed = CompressVectorBuffer(source, (CompressionCodec)codec);
+        VectorBuffer decompressed = DecompressVectorBuffer(compressed, (CompressionCodec)codec);
+        assert(compressed.GetSize() < source.GetSize());
+        assert(decompressed.GetBuffer() == source.GetBuffer());
+        compressedSizes[codec] = compressed.GetSize();
+    }
+    assert(compressedSizes[COMPRESSION_ZSTD] <= compressedSizes[COMPRESSION_LZ4]);
+
+    // The legacy LZ4 functions remain compatible with the codec-based ones
+    {
+        VectorBuffer compressed = CompressVectorBuffer(source);
+        VectorBuffer decompressed = DecompressVectorBuffer(compressed, COMPRESSION_LZ4);
+        assert(decompressed.GetBuffer() == source.GetBuffer());
+    }
+
+    // Dictionary compression of small payloads
+    Vector<Vector<byte>> samples;
+    for (unsigned i = 0; i < 1000; ++i)
+        samples.Push(MakeSamplePayload(i).GetBuffer());
+
+    CompressionDictionary dictionary;
+    assert(dictionary.Train(samples, 4096));
+    assert(dictionary.IsValid());
+
+    VectorBuffer payload = MakeSamplePayload(12345);
+    Vector<byte> output(EstimateCompressBound(payload.GetSize(), COMPRESSION_ZSTD));
+    Vector<byte> restored(payload.GetSize());
+
+    unsigned plainSize = CompressData(output.Buffer(), output.Size(), payload.GetData(), payload.GetSize(), COMPRESSION_ZSTD);
+    unsigned dictSize = CompressData(output.Buffer(), output.Size(), payload.GetData(), payload.GetSize(), COMPRESSION_ZSTD,
+        &dictionary);
+    assert(plainSize && dictSize);
+    assert(dictSize < plainSize);
+    assert(DecompressData(restored.Buffer(), restored.Size(), output.Buffer(), dictSize, COMPRESSION_ZSTD, &dictionary) ==
+        payload.GetSize());
+    assert(restored == payload.GetBuffer());
+
+    // Dictionary survives serialization
+    VectorBuffer saved;
+    assert(dictionary.Save(saved));
+    saved.Seek(0);
+    CompressionDictionary loaded;
+    assert(loaded.Load(saved));
+    assert(loaded.GetID() == dictionary.GetID());
+    assert(DecompressData(restored.Buffer(), restored.Size(), output.Buffer(), dictSize, COMPRESSION_ZSTD, &loaded) ==
+        payload.GetSize());
+}
@@ -6,13 +6,59 @@
 #include <clocale>
 
 void Test_Container_Str();
+void Test_Graphics_TextureStreamer();
+void Test_IO_BitStream();
+void Test_IO_Compression();
 void Test_Math_BigInt();
+void Test_Navigation_ParallelCrowd();
+void Test_Navigation_PathRequests();
+void Test_Navigation_TileBuild();
+void Test_Network_BandwidthBudget();
+void Test_Network_InterestManagement();
+void Test_Network_Loopback();
+void Test_Network_PacketBuffer();
+void Test_Network_Snapshot();
+void Test_Physics_BatchedQueries();
+void Test_Physics_ContactStream();
+void Test_Physics_CookedGeometry();
+void Test_Physics_MultithreadedWorld();
+void Test_Physics_Snapshot();
+void Test_Physics_TransformSync();
+void Test_Physics2D_ParallelStep();
+void Test_Resource_BackgroundLoad();
+void Test_Resource_MemoryBudget();
+void Test_Scene_NetworkChangeJournal();
+void Test_Scene_NetworkQuantization();
+void Test_Scene_TransformInterpolation();
 void test_third_party_sdl();
 
 void Run()
 {
     Test_Container_Str();
+    Test_Graphics_TextureStreamer();
+    Test_IO_BitStream();
+    Test_IO_Compression();
     Test_Math_BigInt();
+    Test_Navigation_ParallelCrowd();
+    Test_Navigation_PathRequests();
+    Test_Navigation_TileBuild();
+    Test_Network_BandwidthBudget();
+    Test_Network_InterestManagement();
+    Test_Network_Loopback();
+    Test_Network_PacketBuffer();
+    Test_Network_Snapshot();
+    Test_Physics_BatchedQueries();
+    Test_Physics_ContactStream();
+    Test_Physics_CookedGeometry();
+    Test_Physics_MultithreadedWorld();
+    Test_Physics_Snapshot();
+    Test_Physics_TransformSync();
+    Test_Physics2D_ParallelStep();
+    Test_Resource_BackgroundLoad();
+    Test_Resource_MemoryBudget();
+    Test_Scene_NetworkChangeJournal();
+    Test_Scene_NetworkQuantization();
+    Test_Scene_TransformInterpolation();
     test_third_party_sdl();
 }
 
@@ -0,0 +1,133 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Navigation/CrowdAgent.h>
+#include <Urho3D/Navigation/CrowdManager.h>
+#include <Urho3D/Navigation/Navigable.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Create a scene of a floor with pillars and crowds of agents walking across it, assigned to the crowds in turn.
+static SharedPtr<Scene> CreateScene(Context* context, i32 numCrowds, bool multithreaded, Vector<CrowdAgent*>& agents)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<PhysicsWorld>();
+
+    Node* floor = scene->CreateChild("Floor");
+    floor->SetScale(Vector3(60.0f, 1.0f, 60.0f));
+    floor->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+    floor->CreateComponent<Navigable>();
+    for (i32 i = 0; i < 9; ++i)
+    {
+        Node* pillar = scene->CreateChild("Pillar");
+        pillar->SetPosition(Vector3((i % 3 - 1) * 12.0f, 2.0f, (i / 3 - 1) * 12.0f));
+        pillar->SetScale(Vector3(3.0f, 4.0f, 3.0f));
+        pillar->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+        pillar->CreateComponent<Navigable>();
+    }
+
+    auto* navMesh = scene->CreateComponent<NavigationMesh>();
+    navMesh->SetPadding(Vector3(0.0f, 10.0f, 0.0f));
+    assert(navMesh->Build());
+
+    Vector<CrowdManager*> crowdManagers;
+    for (i32 i = 0; i < numCrowds; ++i)
+    {
+        auto* crowdManager = scene->CreateComponent<CrowdManager>();
+        crowdManager->SetMultithreaded(multithreaded);
+        crowdManagers.Push(crowdManager);
+    }
+
+    agents.Clear();
+    for (i32 i = 0; i < 300; ++i)
+    {
+        Node* node = scene->CreateChild("Agent");
+        const float x = (i % 30) * 1.5f - 22.0f;
+        const float z = (i / 30) * 1.2f - 25.0f;
+        node->SetPosition(Vector3(x, 0.5f, z));
+        auto* agent = node->CreateComponent<CrowdAgent>();
+        agent->SetMaxSpeed(3.0f);
+        agent->SetMaxAccel(8.0f);
+        agent->SetCrowdManager(crowdManagers[i % numCrowds]);
+        agent->SetTargetPosition(Vector3(-x, 0.5f, -z));
+        agents.Push(agent);
+    }
+
+    return scene;
+}
+
+/// Update the scenes side by side and check that the agents move identically.
+static void CompareScenes(Scene* serialScene, const Vector<CrowdAgent*>& serialAgents, Scene* parallelScene,
+    const Vector<CrowdAgent*>& parallelAgents)
+{
+    assert(serialAgents.Size() == parallelAgents.Size());
+    Vector<Vector3> startPositions;
+    for (CrowdAgent* agent : parallelAgents)
+        startPositions.Push(agent->GetPosition());
+
+    for (i32 i = 0; i < 120; ++i)
+    {
+        serialScene->Update(1.0f / 60.0f);
+        parallelScene->Update(1.0f / 60.0f);
+    }
+
+    i32 numMoved = 0;
+    for (i32 i = 0; i < serialAgents.Size(); ++i)
+    {
+        assert(serialAgents[i]->GetPosition() == parallelAgents[i]->GetPosition());
+        assert(serialAgents[i]->GetActualVelocity() == parallelAgents[i]->GetActualVelocity());
+        if ((parallelAgents[i]->GetPosition() - startPositions[i]).Length() > 3.0f)
+        {
+            // The nodes follow the walking agents
+            assert(parallelAgents[i]->GetNode()->GetWorldPosition() == parallelAgents[i]->GetPosition());
+            ++numMoved;
+        }
+    }
+    assert(numMoved > serialAgents.Size() / 2);
+}
+
+void Test_Navigation_ParallelCrowd()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+    RegisterNavigationLibrary(context);
+
+    // One crowd, its agents split across the threads
+    {
+        Vector<CrowdAgent*> serialAgents;
+        Vector<CrowdAgent*> parallelAgents;
+        SharedPtr<Scene> serialScene = CreateScene(context, 1, false, serialAgents);
+        SharedPtr<Scene> parallelScene = CreateScene(context, 1, true, parallelAgents);
+        CompareScenes(serialScene, serialAgents, parallelScene, parallelAgents);
+    }
+
+    // As many crowds as threads on the same navigation mesh, updated concurrently
+    {
+        Vector<CrowdAgent*> serialAgents;
+        Vector<CrowdAgent*> parallelAgents;
+        SharedPtr<Scene> serialScene = CreateScene(context, 3, false, serialAgents);
+        SharedPtr<Scene> parallelScene = CreateScene(context, 3, true, parallelAgents);
+
+        Vector<CrowdManager*> crowdManagers;
+        parallelScene->GetComponents<CrowdManager>(crowdManagers);
+        assert(crowdManagers.Size() == 3);
+        for (CrowdManager* crowdManager : crowdManagers)
+            assert(crowdManager->GetAgents().Size() == 100);
+        assert(parallelAgents[4]->GetCrowdManager() == crowdManagers[1]);
+
+        CompareScenes(serialScene, serialAgents, parallelScene, parallelAgents);
+    }
+}
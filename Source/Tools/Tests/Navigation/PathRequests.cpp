@@ -0,0 +1,199 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Navigation/Navigable.h>
+#include <Urho3D/Navigation/NavigationEvents.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Create a scene of a floor with pillars and a navigation mesh built over it.
+static SharedPtr<Scene> CreateScene(Context* context)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<PhysicsWorld>();
+
+    Node* floor = scene->CreateChild("Floor");
+    floor->SetScale(Vector3(60.0f, 1.0f, 60.0f));
+    floor->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+    floor->CreateComponent<Navigable>();
+    for (i32 i = 0; i < 9; ++i)
+    {
+        Node* pillar = scene->CreateChild("Pillar");
+        pillar->SetPosition(Vector3((i % 3 - 1) * 12.0f, 2.0f, (i / 3 - 1) * 12.0f));
+        pillar->SetScale(Vector3(3.0f, 4.0f, 3.0f));
+        pillar->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+        pillar->CreateComponent<Navigable>();
+    }
+
+    auto* navMesh = scene->CreateComponent<NavigationMesh>();
+    navMesh->SetPadding(Vector3(0.0f, 10.0f, 0.0f));
+    assert(navMesh->Build());
+    return scene;
+}
+
+/// Return the start point of a test path.
+static Vector3 GetStart(i32 index)
+{
+    return Vector3((index % 10) * 5.0f - 25.0f, 0.5f, -26.0f + (index / 10) * 0.7f);
+}
+
+/// Return the end point of a test path.
+static Vector3 GetEnd(i32 index)
+{
+    return Vector3(25.0f - (index % 7) * 7.0f, 0.5f, 26.0f - (index / 7) * 0.9f);
+}
+
+/// Collects the completed path requests.
+struct CompletedPaths
+{
+    Vector<u32> requests_;
+    HashMap<u32, Vector<Vector3>> paths_;
+    HashMap<u32, bool> success_;
+};
+
+/// Record the completed path requests of a navigation mesh.
+static void SubscribeToCompleted(Scene* scene, NavigationMesh* navMesh, CompletedPaths& completed)
+{
+    scene->SubscribeToEvent(navMesh, E_NAVIGATION_PATH_COMPLETED, [&completed](StringHash, VariantMap& eventData)
+    {
+        using namespace NavigationPathCompleted;
+        const u32 requestId = eventData[P_REQUEST].GetU32();
+        completed.requests_.Push(requestId);
+        completed.success_[requestId] = eventData[P_SUCCESS].GetBool();
+        Vector<Vector3>& path = completed.paths_[requestId];
+        for (const Variant& point : eventData[P_PATH].GetVariantVector())
+            path.Push(point.GetVector3());
+    });
+}
+
+void Test_Navigation_PathRequests()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+    RegisterNavigationLibrary(context);
+
+    // Searched on the worker threads, delivered on the next update and matching the synchronous paths
+    {
+        SharedPtr<Scene> scene = CreateScene(context);
+        auto* navMesh = scene->GetComponent<NavigationMesh>();
+        navMesh->SetPathRequestTimeSlice(1000000);
+        CompletedPaths completed;
+        SubscribeToCompleted(scene, navMesh, completed);
+
+        Vector<u32> requests;
+        for (i32 i = 0; i < 50; ++i)
+            requests.Push(navMesh->RequestPath(GetStart(i), GetEnd(i)));
+        const u32 unreachable = navMesh->RequestPath(GetStart(0), Vector3(200.0f, 0.0f, 0.0f));
+        assert(requests[0] && navMesh->GetPathRequestState(requests[0]) == NAVPATHREQUEST_QUEUED);
+        assert(navMesh->GetPathRequestStats().numQueued_ == 51);
+
+        scene->Update(1.0f / 60.0f);
+        assert(completed.requests_.Empty());
+        assert(navMesh->GetPathRequestState(requests[0]) == NAVPATHREQUEST_SEARCHING);
+        NavigationPathRequestStats stats = navMesh->GetPathRequestStats();
+        assert(stats.numQueued_ == 0 && stats.numSearching_ == 51 && stats.numIterationsLastUpdate_ > 0);
+
+        scene->Update(1.0f / 60.0f);
+        assert(completed.requests_.Size() == 51);
+        stats = navMesh->GetPathRequestStats();
+        assert(stats.numSearching_ == 0 && stats.numSucceeded_ == 50 && stats.numFailed_ == 1);
+        assert(stats.numDeliveredLastUpdate_ == 51);
+        assert(!completed.success_[unreachable]);
+        assert(navMesh->GetPathRequestState(unreachable) == NAVPATHREQUEST_FAILED);
+
+        i32 numIdentical = 0;
+        for (i32 i = 0; i < requests.Size(); ++i)
+        {
+            Vector<NavigationPathPoint> expected;
+            navMesh->FindPath(expected, GetStart(i), GetEnd(i));
+            assert(expected.Size() > 1);
+
+            Vector<NavigationPathPoint> result;
+            assert(navMesh->GetPathRequestState(requests[i]) == NAVPATHREQUEST_SUCCEEDED);
+            assert(navMesh->GetPathRequestResult(requests[i], result));
+            assert(completed.success_[requests[i]]);
+            const Vector<Vector3>& path = completed.paths_[requests[i]];
+            assert(path.Size() == result.Size());
+            for (i32 j = 0; j < result.Size(); ++j)
+                assert(path[j] == result[j].position_);
+
+            // The sliced search skips some revisits, so that a path may take the other way around a pillar
+            assert(result.Front().position_ == expected.Front().position_);
+            assert(result.Back().position_ == expected.Back().position_);
+            float length = 0.0f;
+            float expectedLength = 0.0f;
+            for (i32 j = 1; j < result.Size(); ++j)
+                length += (result[j].position_ - result[j - 1].position_).Length();
+            for (i32 j = 1; j < expected.Size(); ++j)
+                expectedLength += (expected[j].position_ - expected[j - 1].position_).Length();
+            assert(Abs(length - expectedLength) < expectedLength * 0.05f);
+            bool identical = result.Size() == expected.Size();
+            for (i32 j = 0; identical && j < result.Size(); ++j)
+                identical = result[j].position_ == expected[j].position_ && result[j].flag_ == expected[j].flag_;
+            if (identical)
+                ++numIdentical;
+        }
+        assert(numIdentical > requests.Size() * 3 / 4);
+
+        // The results are discarded on the update after delivery
+        scene->Update(1.0f / 60.0f);
+        assert(navMesh->GetPathRequestState(requests[0]) == NAVPATHREQUEST_NONE);
+        assert(navMesh->GetPathRequestStats().numDeliveredLastUpdate_ == 0);
+
+        // Cancelling, and requests surviving a rebuild of the navigation mesh
+        const u32 cancelled = navMesh->RequestPath(GetStart(1), GetEnd(1));
+        const u32 rebuilt = navMesh->RequestPath(GetStart(2), GetEnd(2));
+        assert(navMesh->CancelPathRequest(cancelled));
+        assert(!navMesh->CancelPathRequest(cancelled));
+        assert(navMesh->GetPathRequestState(cancelled) == NAVPATHREQUEST_NONE);
+        assert(navMesh->Build());
+
+        completed.requests_.Clear();
+        scene->Update(1.0f / 60.0f);
+        scene->Update(1.0f / 60.0f);
+        assert(completed.requests_.Size() == 1 && completed.requests_[0] == rebuilt);
+        assert(navMesh->GetPathRequestState(rebuilt) == NAVPATHREQUEST_SUCCEEDED);
+        assert(navMesh->GetPathRequestStats().numCancelled_ == 1);
+    }
+
+    // On the main thread only, higher priorities first and first come first served within a priority
+    {
+        SharedPtr<Context> serialContext(new Context());
+        serialContext->RegisterSubsystem(new WorkQueue(serialContext));
+        RegisterSceneLibrary(serialContext);
+        RegisterPhysicsLibrary(serialContext);
+        RegisterNavigationLibrary(serialContext);
+
+        SharedPtr<Scene> scene = CreateScene(serialContext);
+        auto* navMesh = scene->GetComponent<NavigationMesh>();
+        navMesh->SetPathRequestTimeSlice(1000000);
+        CompletedPaths completed;
+        SubscribeToCompleted(scene, navMesh, completed);
+
+        const u32 low = navMesh->RequestPath(GetStart(3), GetEnd(3), Vector3::ONE, -1);
+        const u32 normal = navMesh->RequestPath(GetStart(4), GetEnd(4));
+        const u32 high = navMesh->RequestPath(GetStart(5), GetEnd(5), Vector3::ONE, 10);
+        const u32 normalLater = navMesh->RequestPath(GetStart(6), GetEnd(6));
+        const u32 highLater = navMesh->RequestPath(GetStart(7), GetEnd(7), Vector3::ONE, 10);
+
+        scene->Update(1.0f / 60.0f);
+        scene->Update(1.0f / 60.0f);
+        assert(completed.requests_.Size() == 5);
+        assert(completed.requests_[0] == high && completed.requests_[1] == highLater);
+        assert(completed.requests_[2] == normal && completed.requests_[3] == normalLater);
+        assert(completed.requests_[4] == low);
+    }
+}
@@ -0,0 +1,206 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Navigation/DynamicNavigationMesh.h>
+#include <Urho3D/Navigation/Navigable.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Create a scene of a floor with pillars and a navigation mesh of many small tiles.
+template <class T> static SharedPtr<Scene> CreateScene(Context* context)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<PhysicsWorld>();
+
+    Node* floor = scene->CreateChild("Floor");
+    floor->SetScale(Vector3(60.0f, 1.0f, 60.0f));
+    floor->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+    floor->CreateComponent<Navigable>();
+    for (i32 i = 0; i < 9; ++i)
+    {
+        Node* pillar = scene->CreateChild("Pillar");
+        pillar->SetPosition(Vector3((i % 3 - 1) * 12.0f, 2.0f, (i / 3 - 1) * 12.0f));
+        pillar->SetScale(Vector3(3.0f, 4.0f, 3.0f));
+        pillar->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+        pillar->CreateComponent<Navigable>();
+    }
+
+    auto* navMesh = scene->CreateComponent<T>();
+    navMesh->SetPadding(Vector3(0.0f, 10.0f, 0.0f));
+    navMesh->SetTileSize(16);
+    return scene;
+}
+
+/// Return the data of all tiles of a navigation mesh.
+static Vector<Vector<byte>> GetAllTileData(NavigationMesh* navMesh)
+{
+    Vector<Vector<byte>> data;
+    const IntVector2 numTiles = navMesh->GetNumTiles();
+    for (i32 z = 0; z < numTiles.y_; ++z)
+    {
+        for (i32 x = 0; x < numTiles.x_; ++x)
+            data.Push(navMesh->GetTileData(IntVector2(x, z)));
+    }
+    return data;
+}
+
+/// Return the nearest navigation mesh points of a grid over the floor, which unlike the tile data do not depend on the order the tiles were added in.
+static Vector<Vector3> GetSamples(NavigationMesh* navMesh)
+{
+    Vector<Vector3> samples;
+    for (float z = -29.5f; z < 30.0f; z += 0.5f)
+    {
+        for (float x = -29.5f; x < 30.0f; x += 0.5f)
+            samples.Push(navMesh->FindNearestPoint(Vector3(x, 0.5f, z), Vector3(0.1f, 2.0f, 0.1f)));
+    }
+    return samples;
+}
+
+/// Return whether the samples of navigation meshes are equal.
+static bool SamplesEqual(const Vector<Vector3>& lhs, const Vector<Vector3>& rhs)
+{
+    if (lhs.Size() != rhs.Size())
+        return false;
+    for (i32 i = 0; i < lhs.Size(); ++i)
+    {
+        if (!lhs[i].Equals(rhs[i]))
+            return false;
+    }
+    return true;
+}
+
+/// Check that the tiles built on the work queue threads equal the tiles built on the main thread.
+template <class T> static void TestMultithreadedBuild(Context* context)
+{
+    SharedPtr<Scene> scene = CreateScene<T>(context);
+    auto* navMesh = scene->GetComponent<T>();
+
+    assert(navMesh->Build());
+    const Vector<Vector<byte>> expected = GetAllTileData(navMesh);
+    assert(navMesh->GetNumTiles().x_ * navMesh->GetNumTiles().y_ > 100);
+
+    navMesh->SetMultithreadedBuild(true);
+    assert(navMesh->Build());
+    assert(GetAllTileData(navMesh) == expected);
+
+    // Partial rebuilds on the threads too
+    const Vector<Vector3> samples = GetSamples(navMesh);
+    assert(navMesh->Build(BoundingBox(Vector3(-20.0f, -1.0f, -20.0f), Vector3(20.0f, 5.0f, 20.0f))));
+    assert(SamplesEqual(GetSamples(navMesh), samples));
+}
+
+/// Update the scene until no dirty tiles remain. Return number of updates.
+static i32 RebuildAll(Scene* scene, NavigationMesh* navMesh)
+{
+    i32 numUpdates = 0;
+    do
+    {
+        scene->Update(1.0f / 60.0f);
+        ++numUpdates;
+        assert(numUpdates < 1000);
+    } while (navMesh->GetNumDirtyTiles());
+    return numUpdates;
+}
+
+/// Check that the dirty tiles are rebuilt over several updates into the same tiles as a full build.
+template <class T> static void TestIncrementalRebuild(Context* context)
+{
+    SharedPtr<Scene> scene = CreateScene<T>(context);
+    auto* navMesh = scene->GetComponent<T>();
+    navMesh->SetMultithreadedBuild(true);
+    navMesh->SetIncrementalRebuild(true);
+    navMesh->SetRebuildBudget(0);
+    assert(navMesh->Build());
+    scene->Update(1.0f / 60.0f);
+    assert(navMesh->GetNumDirtyTiles() == 0);
+
+    // Moved pillar: the tiles under both positions are dirty, and rebuilt one tile per thread each update
+    Node* pillar = scene->GetChild("Pillar");
+    pillar->SetPosition(pillar->GetPosition() + Vector3(5.0f, 0.0f, 5.0f));
+    scene->Update(1.0f / 60.0f);
+    assert(navMesh->GetNumDirtyTiles() > 0);
+    assert(RebuildAll(scene, navMesh) > 1);
+    Vector<Vector3> rebuilt = GetSamples(navMesh);
+    assert(navMesh->Build());
+    assert(SamplesEqual(GetSamples(navMesh), rebuilt));
+
+    // Removed and disabled pillars
+    scene->GetChild("Pillar")->Remove();
+    assert(navMesh->GetNumDirtyTiles() > 0);
+    scene->GetChild("Pillar")->GetComponent<Navigable>()->SetEnabled(false);
+    RebuildAll(scene, navMesh);
+    rebuilt = GetSamples(navMesh);
+    assert(navMesh->Build());
+    assert(SamplesEqual(GetSamples(navMesh), rebuilt));
+
+    // The child nodes of a recursive Navigable on the navigation mesh node are tracked when added, moved and removed
+    scene->CreateComponent<Navigable>();
+    Node* group = scene->CreateChild("Group");
+    Node* crate = group->CreateChild("Crate");
+    crate->SetPosition(Vector3(20.0f, 2.0f, 20.0f));
+    crate->SetScale(Vector3(3.0f, 4.0f, 3.0f));
+    crate->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+    for (const Vector3& offset : {Vector3::ZERO, Vector3(-5.0f, 0.0f, 0.0f)})
+    {
+        crate->Translate(offset);
+        RebuildAll(scene, navMesh);
+        rebuilt = GetSamples(navMesh);
+        assert(navMesh->Build());
+        assert(SamplesEqual(GetSamples(navMesh), rebuilt));
+    }
+    group->Translate(Vector3(0.0f, 0.0f, -5.0f));
+    RebuildAll(scene, navMesh);
+    rebuilt = GetSamples(navMesh);
+    assert(navMesh->Build());
+    assert(SamplesEqual(GetSamples(navMesh), rebuilt));
+    crate->Remove();
+    RebuildAll(scene, navMesh);
+    rebuilt = GetSamples(navMesh);
+    assert(navMesh->Build());
+    assert(SamplesEqual(GetSamples(navMesh), rebuilt));
+
+    // Moving the navigation mesh node moves the geometry with it
+    scene->Translate(Vector3(1.0f, 0.0f, 0.0f));
+    scene->Update(1.0f / 60.0f);
+    assert(navMesh->GetNumDirtyTiles() == 0);
+    scene->Translate(Vector3(-1.0f, 0.0f, 0.0f));
+
+    // Without the incremental rebuild only the explicitly marked tiles are rebuilt
+    navMesh->SetIncrementalRebuild(false);
+    scene->GetChild("Pillar")->Translate(Vector3(3.0f, 0.0f, 0.0f));
+    scene->Update(1.0f / 60.0f);
+    assert(navMesh->GetNumDirtyTiles() == 0);
+    navMesh->SetRebuildBudget(M_MAX_INT);
+    navMesh->MarkTilesDirty(BoundingBox(Vector3(-30.0f, 0.0f, -30.0f), Vector3(30.0f, 4.0f, 30.0f)));
+    assert(navMesh->GetNumDirtyTiles() == navMesh->GetNumTiles().x_ * navMesh->GetNumTiles().y_);
+    assert(navMesh->RebuildDirtyTiles() > 0);
+    assert(navMesh->GetNumDirtyTiles() == 0);
+    rebuilt = GetSamples(navMesh);
+    assert(navMesh->Build());
+    assert(SamplesEqual(GetSamples(navMesh), rebuilt));
+}
+
+void Test_Navigation_TileBuild()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+    RegisterNavigationLibrary(context);
+
+    TestMultithreadedBuild<NavigationMesh>(context);
+    TestMultithreadedBuild<DynamicNavigationMesh>(context);
+    TestIncrementalRebuild<NavigationMesh>(context);
+    TestIncrementalRebuild<DynamicNavigationMesh>(context);
+}
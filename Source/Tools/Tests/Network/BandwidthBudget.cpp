@@ -0,0 +1,99 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkPriority.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const i32 NUM_NODES = 200;
+static const unsigned BANDWIDTH_LIMIT = 20000;
+static const float TIME_STEP = 0.05f;
+static const float POSITION_TOLERANCE = 0.001f;
+
+static void RunFrame(Network* network, Scene* scene, Scene* clientScene, bool move)
+{
+    if (move)
+    {
+        const Vector<SharedPtr<Node>>& children = scene->GetChildren();
+        for (i32 i = 0; i < children.Size(); ++i)
+            children[i]->Translate(Vector3(0.0f, 0.0f, 0.1f));
+    }
+
+    // Send the server update first, so that the client receives it within the same frame
+    network->PostUpdate(TIME_STEP);
+    network->Update(TIME_STEP);
+    clientScene->Update(TIME_STEP);
+}
+
+static bool MatchesServer(Node* serverNode, Scene* clientScene)
+{
+    Node* clientNode = clientScene->GetNode(serverNode->GetID());
+    return clientNode && (clientNode->GetPosition() - serverNode->GetPosition()).Length() < POSITION_TOLERANCE;
+}
+
+void Test_Network_BandwidthBudget()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new ResourceCache(context));
+    auto* network = new Network(context);
+    context->RegisterSubsystem(network);
+    RegisterSceneLibrary(context);
+
+    SharedPtr<Scene> serverScene(new Scene(context));
+    for (i32 i = 0; i < NUM_NODES; ++i)
+        serverScene->CreateChild("Node")->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+    Node* important = serverScene->GetChildren()[NUM_NODES / 2];
+    important->CreateComponent<NetworkPriority>()->SetBasePriority(10000.0f);
+    Node* ordinary = serverScene->GetChildren()[NUM_NODES - 1];
+
+    SharedPtr<Scene> clientScene(new Scene(context));
+    clientScene->SetSnapThreshold(0.0f);
+    Connection* connection = network->ConnectLoopback(clientScene);
+    connection->SetPosition(Vector3::ZERO);
+    Connection* serverConnection = connection->GetLoopback();
+    serverConnection->SetBandwidthLimit(BANDWIDTH_LIMIT);
+    serverConnection->SetScene(serverScene);
+
+    // The initial scene is sent within the budget too
+    for (i32 i = 0; i < 60; ++i)
+        RunFrame(network, serverScene, clientScene, false);
+    assert(clientScene->GetChildren().Size() == NUM_NODES);
+
+    // Moving nodes do not all fit, but the most important one is sent on every update
+    i32 ordinaryUpdates = 0;
+    for (i32 i = 0; i < 40; ++i)
+    {
+        RunFrame(network, serverScene, clientScene, true);
+        assert(serverConnection->GetNumDeferredNodes() > 0);
+        assert(MatchesServer(important, clientScene));
+        if (MatchesServer(ordinary, clientScene))
+            ++ordinaryUpdates;
+    }
+    assert(ordinaryUpdates > 0 && ordinaryUpdates < 40);
+
+    float bytesPerSec = serverConnection->GetMessageBytesPerSec();
+    assert(bytesPerSec > BANDWIDTH_LIMIT * 0.5f && bytesPerSec < BANDWIDTH_LIMIT * 1.25f);
+
+    // Deferred nodes catch up once the motion stops
+    for (i32 i = 0; i < 40; ++i)
+        RunFrame(network, serverScene, clientScene, false);
+    assert(serverConnection->GetNumDeferredNodes() == 0);
+    const Vector<SharedPtr<Node>>& children = serverScene->GetChildren();
+    for (i32 i = 0; i < children.Size(); ++i)
+        assert(MatchesServer(children[i], clientScene));
+
+    // Without a limit all nodes are sent on each update
+    serverConnection->SetBandwidthLimit(0);
+    RunFrame(network, serverScene, clientScene, true);
+    assert(serverConnection->GetNumDeferredNodes() == 0);
+    for (i32 i = 0; i < children.Size(); ++i)
+        assert(MatchesServer(children[i], clientScene));
+}
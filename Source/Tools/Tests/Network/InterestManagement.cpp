@@ -0,0 +1,141 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Network/InterestManager.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const i32 NUM_NODES = 100;
+static const float NODE_SPACING = 10.0f;
+static const float TIME_STEP = 0.05f;
+
+static void RunFrames(Network* network, i32 numFrames)
+{
+    for (i32 i = 0; i < numFrames; ++i)
+    {
+        network->Update(TIME_STEP);
+        network->PostUpdate(TIME_STEP);
+    }
+}
+
+/// Check that a client has exactly the nodes within the interest radius of its observer, with their children.
+static bool HasRelevantNodes(Scene* serverScene, Scene* clientScene, const Vector3& observer, float radius)
+{
+    const Vector<SharedPtr<Node>>& children = serverScene->GetChildren();
+    for (i32 i = 0; i < children.Size(); ++i)
+    {
+        Node* node = children[i];
+        bool relevant = (node->GetWorldPosition() - observer).Length() <= radius;
+        Node* clientNode = clientScene->GetNode(node->GetID());
+        if (relevant != (clientNode != nullptr))
+            return false;
+        if (relevant && !clientScene->GetNode(node->GetChildren()[0]->GetID()))
+            return false;
+    }
+
+    return true;
+}
+
+static void TestRelevance()
+{
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+    RegisterNetworkLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* interest = scene->CreateComponent<InterestManager>();
+    interest->SetCellSize(20.0f);
+    interest->SetInterestRadius(50.0f);
+    interest->SetLeaveMargin(10.0f);
+
+    for (i32 i = 0; i < NUM_NODES; ++i)
+        scene->CreateChild("Node")->SetPosition(Vector3(i * NODE_SPACING, 0.0f, 0.0f));
+    Node* global = scene->CreateChild("Global");
+    global->SetPosition(Vector3(0.0f, 0.0f, 5000.0f));
+    interest->SetAlwaysRelevant(global, true);
+    interest->UpdateGrid();
+    assert(interest->GetNumNodes() == NUM_NODES + 1);
+
+    // Nodes at 0...50 and the always relevant node
+    HashSet<unsigned> relevant;
+    interest->GetRelevantNodes(relevant, Vector3::ZERO, HashSet<unsigned>());
+    assert(relevant.Size() == 7);
+    assert(relevant.Contains(global->GetID()));
+
+    // Nodes that were relevant before stay so within the leave margin
+    HashSet<unsigned> next;
+    interest->GetRelevantNodes(next, Vector3(-10.0f, 0.0f, 0.0f), relevant);
+    assert(next.Size() == 7);
+    interest->GetRelevantNodes(next, Vector3(-10.0f, 0.0f, 0.0f), HashSet<unsigned>());
+    assert(next.Size() == 6);
+}
+
+static void TestReplication()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new ResourceCache(context));
+    auto* network = new Network(context);
+    context->RegisterSubsystem(network);
+    RegisterSceneLibrary(context);
+
+    const float radius = 100.0f;
+    SharedPtr<Scene> serverScene(new Scene(context));
+    auto* interest = serverScene->CreateComponent<InterestManager>(LOCAL);
+    interest->SetInterestRadius(radius);
+    for (i32 i = 0; i < NUM_NODES; ++i)
+    {
+        Node* node = serverScene->CreateChild("Node");
+        node->SetPosition(Vector3(i * NODE_SPACING, 0.0f, 0.0f));
+        node->CreateChild("Child")->SetPosition(Vector3(0.0f, 1.0f, 0.0f));
+    }
+
+    const Vector3 observers[] = { Vector3(0.0f, 0.0f, 0.0f), Vector3(505.0f, 0.0f, 0.0f) };
+    SharedPtr<Scene> clientScenes[2];
+    Connection* connections[2];
+    for (i32 i = 0; i < 2; ++i)
+    {
+        clientScenes[i] = new Scene(context);
+        connections[i] = network->ConnectLoopback(clientScenes[i]);
+        connections[i]->SetPosition(observers[i]);
+        connections[i]->GetLoopback()->SetScene(serverScene);
+    }
+
+    RunFrames(network, 10);
+    for (i32 i = 0; i < 2; ++i)
+        assert(HasRelevantNodes(serverScene, clientScenes[i], observers[i], radius));
+
+    // Moving the observer beyond the leave margin removes the nodes left behind and creates the ones entered
+    connections[0]->SetPosition(Vector3(900.0f, 0.0f, 0.0f));
+    RunFrames(network, 5);
+    assert(HasRelevantNodes(serverScene, clientScenes[0], Vector3(900.0f, 0.0f, 0.0f), radius));
+
+    // Moving nodes enter and leave too
+    Node* moved = serverScene->GetChildren()[0];
+    moved->SetPosition(Vector3(500.0f, 0.0f, 0.0f));
+    RunFrames(network, 5);
+    assert(clientScenes[1]->GetNode(moved->GetID()));
+    moved->SetPosition(Vector3(-500.0f, 0.0f, 0.0f));
+    RunFrames(network, 5);
+    assert(!clientScenes[1]->GetNode(moved->GetID()));
+    assert(!clientScenes[1]->GetNode(moved->GetChildren()[0]->GetID()));
+
+    // Without interest management all nodes are replicated again
+    interest->SetEnabled(false);
+    RunFrames(network, 5);
+    for (i32 i = 0; i < 2; ++i)
+        assert(clientScenes[i]->GetChildren().Size() == NUM_NODES);
+}
+
+void Test_Network_InterestManagement()
+{
+    TestRelevance();
+    TestReplication();
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkPriority.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const i32 NUM_CLIENTS = 8;
+static const i32 NUM_NODES = 50;
+static const float TIME_STEP = 0.05f;
+
+static void RunFrames(Network* network, Scene* scene, const Vector<SharedPtr<Scene>>& clientScenes, i32 numFrames, bool move)
+{
+    for (i32 i = 0; i < numFrames; ++i)
+    {
+        if (move)
+        {
+            const Vector<SharedPtr<Node>>& children = scene->GetChildren();
+            for (i32 j = 0; j < children.Size(); ++j)
+                children[j]->Translate(Vector3(0.1f * (j % 5), 0.0f, 0.2f));
+        }
+
+        network->Update(TIME_STEP);
+        network->PostUpdate(TIME_STEP);
+
+        // Apply the motion smoothing of received transforms
+        for (i32 j = 0; j < clientScenes.Size(); ++j)
+            clientScenes[j]->Update(TIME_STEP);
+    }
+}
+
+static bool MatchesServer(Scene* serverScene, Scene* clientScene)
+{
+    Vector<Node*> serverNodes = serverScene->GetChildren(true);
+    for (i32 i = 0; i < serverNodes.Size(); ++i)
+    {
+        Node* serverNode = serverNodes[i];
+        Node* clientNode = clientScene->GetNode(serverNode->GetID());
+        if (!clientNode || !clientNode->GetWorldPosition().Equals(serverNode->GetWorldPosition()))
+            return false;
+        if (serverNode->GetComponent<NetworkPriority>() && !clientNode->GetComponent<NetworkPriority>())
+            return false;
+    }
+
+    return true;
+}
+
+static void RunLoopbackReplication(bool parallel)
+{
+    SharedPtr<Context> context(new Context());
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(2);
+    context->RegisterSubsystem(new ResourceCache(context));
+    auto* network = new Network(context);
+    context->RegisterSubsystem(network);
+    RegisterSceneLibrary(context);
+    network->SetParallelServerUpdate(parallel);
+
+    SharedPtr<Scene> serverScene(new Scene(context));
+    for (i32 i = 0; i < NUM_NODES; ++i)
+    {
+        Node* node = serverScene->CreateChild("Node");
+        node->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+        // Children of moving parents have their world position calculated without updating the transform cache
+        Node* child = node->CreateChild("Child");
+        child->SetPosition(Vector3(0.0f, 1.0f, 0.0f));
+        if (i % 2)
+            child->CreateComponent<NetworkPriority>();
+    }
+
+    Vector<SharedPtr<Scene>> clientScenes;
+    for (i32 i = 0; i < NUM_CLIENTS; ++i)
+    {
+        SharedPtr<Scene> clientScene(new Scene(context));
+        clientScene->SetSnapThreshold(0.0f);
+        Connection* connection = network->ConnectLoopback(clientScene);
+        assert(connection && connection->GetLoopback());
+        connection->GetLoopback()->SetScene(serverScene);
+        clientScenes.Push(clientScene);
+    }
+
+    assert(network->GetClientConnections().Size() == NUM_CLIENTS);
+
+    // Let the clients load the scene, then replicate moving nodes
+    RunFrames(network, serverScene, clientScenes, 5, false);
+    Vector<SharedPtr<Connection>> connections = network->GetClientConnections();
+    for (i32 i = 0; i < connections.Size(); ++i)
+        assert(connections[i]->IsSceneLoaded());
+
+    RunFrames(network, serverScene, clientScenes, 20, true);
+    RunFrames(network, serverScene, clientScenes, 5, false);
+    for (i32 i = 0; i < clientScenes.Size(); ++i)
+        assert(MatchesServer(serverScene, clientScenes[i]));
+
+    // Removed nodes are removed from all clients
+    NodeId removedID = serverScene->GetChildren()[0]->GetID();
+    serverScene->GetChildren()[0]->Remove();
+    RunFrames(network, serverScene, clientScenes, 3, false);
+    for (i32 i = 0; i < clientScenes.Size(); ++i)
+        assert(!clientScenes[i]->GetNode(removedID));
+
+    network->DisconnectLoopback(connections[0]);
+    assert(network->GetClientConnections().Size() == NUM_CLIENTS - 1);
+    RunFrames(network, serverScene, clientScenes, 2, true);
+}
+
+void Test_Network_Loopback()
+{
+    RunLoopbackReplication(false);
+    RunLoopbackReplication(true);
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/PacketBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const i32 NUM_NODES = 200;
+static const float TIME_STEP = 0.05f;
+
+static void TestPool()
+{
+    PacketBufferPool pool;
+    SharedPtr<PacketBuffer> first = pool.Acquire();
+    first->GetBuffer().WriteU32(1);
+    SharedPtr<PacketBuffer> second = pool.Acquire();
+    assert(first != second);
+    assert(pool.GetNumBuffers() == 2);
+    assert(pool.GetNumUsed() == 2);
+
+    // A released buffer is reused empty, keeping its memory
+    PacketBuffer* released = first;
+    const byte* data = first->GetBuffer().GetData();
+    first.Reset();
+    assert(pool.GetNumUsed() == 1);
+    SharedPtr<PacketBuffer> reused = pool.Acquire();
+    assert(reused == released);
+    assert(reused->GetBuffer().GetSize() == 0);
+    reused->GetBuffer().WriteU32(2);
+    assert(reused->GetBuffer().GetData() == data);
+    assert(pool.GetNumBuffers() == 2);
+}
+
+static void TestLoopback()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new ResourceCache(context));
+    auto* network = new Network(context);
+    context->RegisterSubsystem(network);
+    RegisterSceneLibrary(context);
+
+    SharedPtr<Scene> serverScene(new Scene(context));
+    for (i32 i = 0; i < NUM_NODES; ++i)
+        serverScene->CreateChild("Node")->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+
+    SharedPtr<Scene> clientScene(new Scene(context));
+    Connection* connection = network->ConnectLoopback(clientScene);
+    connection->GetLoopback()->SetScene(serverScene);
+    Connection* serverConnection = connection->GetLoopback();
+
+    i32 numBuffers = 0;
+    for (i32 i = 0; i < 40; ++i)
+    {
+        const Vector<SharedPtr<Node>>& children = serverScene->GetChildren();
+        for (i32 j = 0; j < children.Size(); ++j)
+            children[j]->Translate(Vector3(0.0f, 0.1f, 0.0f));
+
+        network->Update(TIME_STEP);
+        network->PostUpdate(TIME_STEP);
+
+        // After the scene has been sent, the same buffers are reused every frame
+        if (i == 20)
+            numBuffers = serverConnection->GetNumPacketBuffers();
+    }
+
+    assert(numBuffers > 0);
+    assert(serverConnection->GetNumPacketBuffers() == numBuffers);
+    assert(clientScene->GetChildren().Size() == NUM_NODES);
+}
+
+void Test_Network_PacketBuffer()
+{
+    TestPool();
+    TestLoopback();
+}
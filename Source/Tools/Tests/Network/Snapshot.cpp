@@ -0,0 +1,167 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/Snapshot.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const i32 NUM_CLIENTS = 4;
+static const i32 NUM_NODES = 100;
+static const float TIME_STEP = 0.05f;
+static const float POSITION_TOLERANCE = 0.01f;
+
+static void TestSnapshotEncoding()
+{
+    Snapshot full;
+    full.sequence_ = 1;
+    for (i32 i = 0; i < NUM_NODES; ++i)
+        full.nodes_[i + 1] = SnapshotTransform(Vector3((float)i, 2.0f, -3.5f), Quaternion(i * 3.0f, Vector3::UP), DEFAULT_SNAPSHOT_PRECISION);
+
+    // Move a few nodes slightly and remove one
+    Snapshot next;
+    next.sequence_ = 2;
+    next.nodes_ = full.nodes_;
+    for (i32 i = 0; i < 5; ++i)
+        next.nodes_[i + 1] = SnapshotTransform(Vector3((float)i + 0.1f, 2.0f, -3.5f), Quaternion(i * 3.0f + 1.0f, Vector3::UP), DEFAULT_SNAPSHOT_PRECISION);
+    next.nodes_.Erase(NUM_NODES);
+
+    VectorBuffer fullData;
+    full.Write(fullData, nullptr);
+    VectorBuffer deltaData;
+    next.Write(deltaData, &full);
+    assert(deltaData.GetSize() * 10 < fullData.GetSize());
+
+    Snapshot received;
+    MemoryBuffer fullSource(fullData.GetBuffer());
+    assert(received.Read(fullSource, nullptr));
+    assert(received.nodes_.Size() == full.nodes_.Size());
+
+    Snapshot receivedNext;
+    MemoryBuffer deltaSource(deltaData.GetBuffer());
+    assert(receivedNext.Read(deltaSource, &received));
+    assert(receivedNext.nodes_.Size() == next.nodes_.Size());
+    for (HashMap<unsigned, SnapshotTransform>::ConstIterator i = next.nodes_.Begin(); i != next.nodes_.End(); ++i)
+        assert(receivedNext.nodes_[i->first_] == i->second_);
+
+    SnapshotTransform transform = next.nodes_[1];
+    assert((transform.GetPosition(DEFAULT_SNAPSHOT_PRECISION) - Vector3(0.1f, 2.0f, -3.5f)).Length() < 0.001f);
+    assert(Abs(transform.GetRotation().DotProduct(Quaternion(1.0f, Vector3::UP))) > 0.9999f);
+
+    // Only the snapshots that are still kept can be used as baselines
+    SnapshotBuffer buffer(4);
+    buffer.Add(1);
+    buffer.Add(5);
+    assert(!buffer.Find(1) && buffer.Find(5) && !buffer.Find(0));
+}
+
+static void RunFrames(Network* network, Scene* scene, const Vector<SharedPtr<Scene>>& clientScenes, i32 numFrames, bool move)
+{
+    for (i32 i = 0; i < numFrames; ++i)
+    {
+        if (move)
+        {
+            const Vector<SharedPtr<Node>>& children = scene->GetChildren();
+            for (i32 j = 0; j < children.Size(); ++j)
+            {
+                children[j]->Translate(Vector3(0.1f * (j % 5), 0.0f, 0.2f));
+                children[j]->Yaw(5.0f);
+            }
+        }
+
+        network->Update(TIME_STEP);
+        network->PostUpdate(TIME_STEP);
+
+        for (i32 j = 0; j < clientScenes.Size(); ++j)
+            clientScenes[j]->Update(TIME_STEP);
+
+        // Let the simulated latency pass
+        Time::Sleep(network->GetSimulatedLatency());
+    }
+}
+
+static bool MatchesServer(Scene* serverScene, Scene* clientScene)
+{
+    Vector<Node*> serverNodes = serverScene->GetChildren(true);
+    for (i32 i = 0; i < serverNodes.Size(); ++i)
+    {
+        Node* serverNode = serverNodes[i];
+        Node* clientNode = clientScene->GetNode(serverNode->GetID());
+        if (!clientNode || (clientNode->GetWorldPosition() - serverNode->GetWorldPosition()).Length() > POSITION_TOLERANCE)
+            return false;
+    }
+
+    return true;
+}
+
+static void TestSnapshotReplication()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new ResourceCache(context));
+    auto* network = new Network(context);
+    context->RegisterSubsystem(network);
+    RegisterSceneLibrary(context);
+
+    // Lose unreliable packets and delay all of them. Lost snapshots and acknowledgements must not prevent converging
+    network->SetSimulatedLatency(20);
+    network->SetSimulatedPacketLoss(0.3f);
+
+    SharedPtr<Scene> serverScene(new Scene(context));
+    for (i32 i = 0; i < NUM_NODES; ++i)
+    {
+        Node* node = serverScene->CreateChild("Node");
+        node->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+        Node* child = node->CreateChild("Child");
+        child->SetPosition(Vector3(0.0f, 1.0f, 0.0f));
+    }
+
+    Vector<SharedPtr<Scene>> clientScenes;
+    for (i32 i = 0; i < NUM_CLIENTS; ++i)
+    {
+        SharedPtr<Scene> clientScene(new Scene(context));
+        clientScene->SetSnapThreshold(0.0f);
+        Connection* connection = network->ConnectLoopback(clientScene);
+        connection->GetLoopback()->SetReplicationMode(REPLICATION_SNAPSHOT);
+        connection->GetLoopback()->SetScene(serverScene);
+        clientScenes.Push(clientScene);
+    }
+
+    RunFrames(network, serverScene, clientScenes, 10, false);
+    Vector<SharedPtr<Connection>> connections = network->GetClientConnections();
+    for (i32 i = 0; i < connections.Size(); ++i)
+        assert(connections[i]->IsSceneLoaded());
+
+    RunFrames(network, serverScene, clientScenes, 20, true);
+
+    // Nodes created while moving are replicated too
+    for (i32 i = 0; i < 5; ++i)
+        serverScene->CreateChild("Created")->SetPosition(Vector3(0.0f, (float)i, 5.0f));
+    RunFrames(network, serverScene, clientScenes, 10, true);
+    RunFrames(network, serverScene, clientScenes, 20, false);
+
+    for (i32 i = 0; i < clientScenes.Size(); ++i)
+        assert(MatchesServer(serverScene, clientScenes[i]));
+
+    // Snapshots are written against acknowledged baselines, so that static nodes cost nothing
+    for (i32 i = 0; i < connections.Size(); ++i)
+        assert(connections[i]->GetAckedSnapshot() > 0);
+
+    network->SetSimulatedLatency(0);
+    network->SetSimulatedPacketLoss(0.0f);
+}
+
+void Test_Network_Snapshot()
+{
+    TestSnapshotEncoding();
+    TestSnapshotReplication();
+}
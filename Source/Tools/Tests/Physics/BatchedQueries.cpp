@@ -0,0 +1,112 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Bullet/BulletCollision/CollisionShapes/btBoxShape.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Return whether two query results are the same.
+static bool IsSameResult(const PhysicsRaycastResult& lhs, const PhysicsRaycastResult& rhs)
+{
+    return lhs.body_ == rhs.body_ && lhs.position_.Equals(rhs.position_) && lhs.normal_.Equals(rhs.normal_) &&
+        (lhs.body_ ? Equals(lhs.distance_, rhs.distance_) : lhs.distance_ == rhs.distance_);
+}
+
+void Test_Physics_BatchedQueries()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* physicsWorld = scene->CreateComponent<PhysicsWorld>();
+
+    // Grid of static boxes on layers 1 and 2
+    for (i32 i = 0; i < 100; ++i)
+    {
+        Node* node = scene->CreateChild("Box");
+        node->SetPosition(Vector3((i % 10) * 3.0f, 0.0f, (i / 10) * 3.0f));
+        auto* body = node->CreateComponent<RigidBody>();
+        body->SetCollisionLayer(i % 2 ? 2 : 1);
+        node->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+    }
+    physicsWorld->UpdateCollisions();
+
+    // Rays and sphere sweeps downwards over the grid, some of them missing
+    Vector<PhysicsRaycastQuery> queries;
+    for (i32 i = 0; i < 400; ++i)
+    {
+        PhysicsRaycastQuery query;
+        query.ray_ = Ray(Vector3((i % 20) * 1.5f, 10.0f, (i / 20) * 1.5f), Vector3::DOWN);
+        query.maxDistance_ = 20.0f;
+        query.radius_ = i % 3 ? 0.0f : 0.25f;
+        query.collisionMask_ = i % 5 ? M_MAX_UNSIGNED : 2;
+        queries.Push(query);
+    }
+
+    Vector<PhysicsRaycastResult> results;
+    physicsWorld->RaycastSingleBatch(results, queries);
+    assert(results.Size() == queries.Size());
+
+    i32 numHits = 0;
+    for (i32 i = 0; i < queries.Size(); ++i)
+    {
+        const PhysicsRaycastQuery& query = queries[i];
+        PhysicsRaycastResult expected;
+        if (query.radius_ > 0.0f)
+            physicsWorld->SphereCast(expected, query.ray_, query.radius_, query.maxDistance_, query.collisionMask_);
+        else
+            physicsWorld->RaycastSingle(expected, query.ray_, query.maxDistance_, query.collisionMask_);
+
+        assert(IsSameResult(results[i], expected));
+        if (results[i].body_)
+        {
+            ++numHits;
+            assert(results[i].body_->GetCollisionLayer() & query.collisionMask_);
+        }
+    }
+    assert(numHits > 0 && numHits < queries.Size());
+
+    // Reusing the result array
+    queries.Resize(10);
+    physicsWorld->RaycastSingleBatch(results, queries);
+    assert(results.Size() == 10);
+
+    // Swept boxes
+    btBoxShape box(btVector3(0.5f, 0.5f, 0.5f));
+    Vector<PhysicsConvexCastQuery> convexQueries;
+    for (i32 i = 0; i < 100; ++i)
+    {
+        PhysicsConvexCastQuery query;
+        query.shape_ = &box;
+        query.startPos_ = Vector3((i % 10) * 3.0f + 0.7f, 10.0f, (i / 10) * 3.0f);
+        query.startRot_ = Quaternion(i * 10.0f, Vector3::UP);
+        query.endPos_ = query.startPos_ + Vector3(0.0f, -20.0f, 0.0f);
+        query.endRot_ = query.startRot_;
+        convexQueries.Push(query);
+    }
+
+    physicsWorld->ConvexCastBatch(results, convexQueries);
+    assert(results.Size() == convexQueries.Size());
+    for (i32 i = 0; i < convexQueries.Size(); ++i)
+    {
+        const PhysicsConvexCastQuery& query = convexQueries[i];
+        PhysicsRaycastResult expected;
+        physicsWorld->ConvexCast(expected, query.shape_, query.startPos_, query.startRot_, query.endPos_, query.endRot_);
+        assert(results[i].body_);
+        assert(IsSameResult(results[i], expected));
+    }
+}
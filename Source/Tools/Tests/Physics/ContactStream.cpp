@@ -0,0 +1,151 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsEvents.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Create a rigid body with a box shape.
+static RigidBody* CreateBox(Scene* scene, const Vector3& position, const Vector3& size, float mass, unsigned layer)
+{
+    Node* node = scene->CreateChild("Box");
+    node->SetPosition(position);
+    node->SetScale(size);
+    auto* body = node->CreateComponent<RigidBody>();
+    body->SetMass(mass);
+    body->SetCollisionLayer(layer);
+    node->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+    return body;
+}
+
+/// Return the contact stream record of a body pair, or null if not found.
+static const PhysicsContact* FindContact(PhysicsWorld* physicsWorld, RigidBody* body, RigidBody* other)
+{
+    for (const PhysicsContact& contact : physicsWorld->GetContacts())
+    {
+        if ((contact.bodyA_ == body && contact.bodyB_ == other) || (contact.bodyA_ == other && contact.bodyB_ == body))
+            return &contact;
+    }
+    return nullptr;
+}
+
+/// Return the number of contact stream records of a body.
+static i32 CountContacts(PhysicsWorld* physicsWorld, RigidBody* body)
+{
+    i32 count = 0;
+    for (const PhysicsContact& contact : physicsWorld->GetContacts())
+    {
+        if (contact.bodyA_ == body || contact.bodyB_ == body)
+            ++count;
+    }
+    return count;
+}
+
+void Test_Physics_ContactStream()
+{
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* physicsWorld = scene->CreateComponent<PhysicsWorld>();
+    physicsWorld->SetCollisionEventsEnabled(false);
+    physicsWorld->SetContactStreamEnabled(true);
+
+    i32 numEvents = 0;
+    scene->SubscribeToEvent(E_PHYSICSCOLLISION, [&numEvents](StringHash, VariantMap&) { ++numEvents; });
+
+    RigidBody* floor = CreateBox(scene, Vector3::ZERO, Vector3(20.0f, 1.0f, 20.0f), 0.0f, 1);
+    RigidBody* box = CreateBox(scene, Vector3(0.0f, 1.2f, 0.0f), Vector3::ONE, 1.0f, 2);
+    RigidBody* other = CreateBox(scene, Vector3(5.0f, 1.2f, 0.0f), Vector3::ONE, 1.0f, 4);
+    // Two shapes of a compound body touch the floor with separate manifolds
+    RigidBody* compound = CreateBox(scene, Vector3(-5.0f, 1.2f, 0.0f), Vector3::ONE, 1.0f, 8);
+    auto* secondShape = compound->GetNode()->CreateComponent<CollisionShape>();
+    secondShape->SetBox(Vector3::ONE, Vector3(2.0f, 0.0f, 0.0f));
+
+    // Step until the boxes land
+    const PhysicsContact* contact = nullptr;
+    for (i32 i = 0; i < 60 && !contact; ++i)
+    {
+        physicsWorld->Update(1.0f / 60.0f);
+        contact = FindContact(physicsWorld, box, floor);
+    }
+    assert(contact);
+    assert(contact->state_ == CONTACT_START);
+
+    for (i32 i = 0; i < 30; ++i)
+        physicsWorld->Update(1.0f / 60.0f);
+
+    contact = FindContact(physicsWorld, box, floor);
+    assert(contact);
+    assert(contact->state_ == CONTACT_STAY);
+    assert(contact->numPoints_ > 0);
+    assert(contact->firstPoint_ + contact->numPoints_ <= physicsWorld->GetContactPoints().Size());
+    float impulse = 0.0f;
+    for (i32 i = contact->firstPoint_; i < contact->firstPoint_ + contact->numPoints_; ++i)
+    {
+        const PhysicsContactPoint& point = physicsWorld->GetContactPoints()[i];
+        // The normal points towards body A
+        const float up = contact->bodyA_ == box ? 1.0f : -1.0f;
+        assert(point.normal_.y_ * up > 0.9f);
+        impulse += point.impulse_;
+    }
+    // The resting box is held up by the floor
+    assert(impulse > 0.0f);
+
+    // Filtering by collision layer
+    Vector<PhysicsContact> filtered;
+    physicsWorld->GetContacts(filtered, 4);
+    assert(filtered.Size() == 1);
+    assert(filtered[0].bodyA_ == other || filtered[0].bodyB_ == other);
+    physicsWorld->GetContacts(filtered, 1);
+    assert(filtered.Size() == 3);
+
+    // The compound body has one record with the points of both shapes
+    assert(CountContacts(physicsWorld, compound) == 1);
+    contact = FindContact(physicsWorld, compound, floor);
+    assert(contact->state_ == CONTACT_STAY);
+    assert(contact->numPoints_ > 4);
+
+    // The colliding bodies are found without the events
+    Vector<RigidBody*> colliding;
+    physicsWorld->GetCollidingBodies(colliding, floor);
+    assert(colliding.Size() == 3);
+    physicsWorld->GetCollidingBodies(colliding, box);
+    assert(colliding.Size() == 1 && colliding[0] == floor);
+
+    // Lifting the box ends the contact
+    box->SetPosition(Vector3(0.0f, 10.0f, 0.0f));
+    physicsWorld->Update(1.0f / 60.0f);
+    contact = FindContact(physicsWorld, box, floor);
+    assert(contact);
+    assert(contact->state_ == CONTACT_END);
+    assert(contact->numPoints_ == 0);
+    physicsWorld->Update(1.0f / 60.0f);
+    assert(!FindContact(physicsWorld, box, floor));
+
+    // Only recording the masked layers
+    physicsWorld->SetContactStreamMask(4);
+    physicsWorld->Update(1.0f / 60.0f);
+    assert(physicsWorld->GetContacts().Size() == 1);
+
+    // A removed body does not get an ending record
+    other->GetNode()->Remove();
+    physicsWorld->Update(1.0f / 60.0f);
+    assert(physicsWorld->GetContacts().Empty());
+
+    // The events were disabled throughout
+    assert(numEvents == 0);
+    physicsWorld->SetCollisionEventsEnabled(true);
+    physicsWorld->Update(1.0f / 60.0f);
+    assert(numEvents > 0);
+}
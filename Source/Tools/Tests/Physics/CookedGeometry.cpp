@@ -0,0 +1,292 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Bullet/BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <Bullet/BulletCollision/CollisionShapes/btTriangleInfoMap.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Create a model of a wavy grid from CPU-side geometry data.
+static SharedPtr<Model> CreateGridModel(Context* context, i32 size)
+{
+    const i32 numVertices = (size + 1) * (size + 1);
+    const i32 numIndices = size * size * 6;
+    SharedArrayPtr<byte> vertexData(new byte[numVertices * sizeof(Vector3)]);
+    SharedArrayPtr<byte> indexData(new byte[numIndices * sizeof(unsigned)]);
+
+    auto* vertices = reinterpret_cast<Vector3*>(vertexData.Get());
+    for (i32 z = 0; z <= size; ++z)
+    {
+        for (i32 x = 0; x <= size; ++x)
+            *vertices++ = Vector3((float)x, Sin(x * 20.0f) * Cos(z * 30.0f), (float)z);
+    }
+
+    auto* indices = reinterpret_cast<unsigned*>(indexData.Get());
+    for (i32 z = 0; z < size; ++z)
+    {
+        for (i32 x = 0; x < size; ++x)
+        {
+            const unsigned corner = z * (size + 1) + x;
+            *indices++ = corner;
+            *indices++ = corner + size + 1;
+            *indices++ = corner + 1;
+            *indices++ = corner + 1;
+            *indices++ = corner + size + 1;
+            *indices++ = corner + size + 2;
+        }
+    }
+
+    SharedPtr<Geometry> geometry(new Geometry(context));
+    geometry->SetRawVertexData(vertexData, VertexElements::Position);
+    geometry->SetRawIndexData(indexData, sizeof(unsigned));
+    geometry->SetDrawRange(TRIANGLE_LIST, 0, numIndices, 0, numVertices);
+
+    SharedPtr<Model> model(new Model(context));
+    model->SetNumGeometries(1);
+    model->SetGeometry(0, 0, geometry);
+    model->SetBoundingBox(BoundingBox(Vector3(0.0f, -1.0f, 0.0f), Vector3((float)size, 1.0f, (float)size)));
+    return model;
+}
+
+/// Create a scene with triangle mesh grids and a convex hull body of the model.
+static void CreateBodies(Scene* scene, Model* model, Vector<CollisionShape*>& shapes)
+{
+    shapes.Clear();
+    for (i32 i = 0; i < 3; ++i)
+    {
+        Node* node = scene->CreateChild("Grid");
+        node->SetPosition(Vector3(i * 100.0f, 0.0f, 0.0f));
+        node->CreateComponent<RigidBody>();
+        auto* shape = node->CreateComponent<CollisionShape>();
+        shape->SetTriangleMesh(model);
+        shapes.Push(shape);
+    }
+
+    Node* node = scene->CreateChild("Hull");
+    node->SetPosition(Vector3(0.0f, 20.0f, 0.0f));
+    node->CreateComponent<RigidBody>()->SetMass(1.0f);
+    auto* shape = node->CreateComponent<CollisionShape>();
+    shape->SetConvexHull(model);
+    shapes.Push(shape);
+}
+
+/// Return the cooked geometry files in a directory.
+static Vector<String> GetCookedFiles(FileSystem* fileSystem, const String& dir)
+{
+    Vector<String> files;
+    fileSystem->ScanDir(files, dir, "*.*", SCAN_FILES, false);
+    return files;
+}
+
+void Test_Physics_CookedGeometry()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    auto* fileSystem = context->GetSubsystem<FileSystem>();
+    const String dir = fileSystem->GetTemporaryDir() + "Urho3DCookedGeometryTest/";
+    for (const String& name : GetCookedFiles(fileSystem, dir))
+        fileSystem->Delete(dir + name);
+
+    SharedPtr<Model> model = CreateGridModel(context, 64);
+
+    // Cooking in the background, the shapes are created once the geometry has been cooked
+    SharedPtr<Scene> cookedScene(new Scene(context));
+    auto* cookedWorld = cookedScene->CreateComponent<PhysicsWorld>();
+    cookedWorld->SetBackgroundCooking(true);
+    cookedWorld->SetCookedGeometryDir(dir);
+
+    Vector<CollisionShape*> cookedShapes;
+    CreateBodies(cookedScene, model, cookedShapes);
+    assert(cookedWorld->IsCookingGeometry());
+    for (CollisionShape* shape : cookedShapes)
+        assert(!shape->GetCollisionShape());
+    assert(cookedShapes[0]->GetGeometryData() == cookedShapes[1]->GetGeometryData());
+    cookedShapes[2]->GetNode()->SetScale(2.0f);
+
+    // The dynamic body does not simulate without its shape
+    Node* hullNode = cookedShapes[3]->GetNode();
+    auto* hullBody = hullNode->GetComponent<RigidBody>();
+    for (i32 i = 0; i < 10; ++i)
+        cookedWorld->Update(1.0f / 60.0f);
+    assert(!hullBody->IsActive());
+    assert(hullNode->GetPosition() == Vector3(0.0f, 20.0f, 0.0f));
+
+    context->GetSubsystem<WorkQueue>()->Complete(0);
+    assert(!cookedWorld->IsCookingGeometry());
+    for (CollisionShape* shape : cookedShapes)
+        assert(shape->GetCollisionShape());
+    assert(cookedShapes[2]->GetCollisionShape()->getLocalScaling() == btVector3(2.0f, 2.0f, 2.0f));
+
+    // Once cooked, the body simulates
+    assert(hullBody->IsActive());
+    for (i32 i = 0; i < 10; ++i)
+        cookedWorld->Update(1.0f / 60.0f);
+    assert(hullNode->GetPosition().y_ < 20.0f);
+
+    // The BVH and the hull have been saved
+    const Vector<String> files = GetCookedFiles(fileSystem, dir);
+    assert(files.Size() == 2);
+    const String bvhFile = dir + (files[0].EndsWith(".bvh") ? files[0] : files[1]);
+    assert(bvhFile.EndsWith(".bvh") && (files[0].EndsWith(".hull") || files[1].EndsWith(".hull")));
+
+    // Loading the cooked geometry when creating the shapes
+    SharedPtr<Scene> loadedScene(new Scene(context));
+    auto* loadedWorld = loadedScene->CreateComponent<PhysicsWorld>();
+    loadedWorld->SetCookedGeometryDir(dir);
+
+    Vector<CollisionShape*> loadedShapes;
+    CreateBodies(loadedScene, model, loadedShapes);
+    assert(!loadedWorld->IsCookingGeometry());
+    for (CollisionShape* shape : loadedShapes)
+        assert(shape->GetCollisionShape());
+
+    auto* cookedMesh = static_cast<TriangleMeshData*>(cookedShapes[0]->GetGeometryData());
+    auto* loadedMesh = static_cast<TriangleMeshData*>(loadedShapes[0]->GetGeometryData());
+    assert(!cookedMesh->bvhData_ && loadedMesh->bvhData_);
+    assert(loadedMesh->shape_->getTriangleInfoMap() == loadedMesh->infoMap_.get());
+    assert(loadedMesh->infoMap_->size() == cookedMesh->infoMap_->size());
+
+    auto* cookedHull = static_cast<ConvexData*>(cookedShapes[3]->GetGeometryData());
+    auto* loadedHull = static_cast<ConvexData*>(loadedShapes[3]->GetGeometryData());
+    assert(cookedHull->vertexCount_ > 0 && loadedHull->vertexCount_ == cookedHull->vertexCount_);
+    assert(loadedHull->indexCount_ == cookedHull->indexCount_);
+    for (unsigned i = 0; i < cookedHull->vertexCount_; ++i)
+        assert(loadedHull->vertexData_[i] == cookedHull->vertexData_[i]);
+
+    // The loaded BVH gives the same hits
+    cookedWorld->UpdateCollisions();
+    loadedWorld->UpdateCollisions();
+    i32 numHits = 0;
+    for (i32 i = 0; i < 400; ++i)
+    {
+        const Ray ray(Vector3((i % 20) * 3.3f + 0.1f, 10.0f, (i / 20) * 3.3f + 0.2f), Vector3::DOWN);
+        PhysicsRaycastResult cookedResult;
+        PhysicsRaycastResult loadedResult;
+        cookedWorld->RaycastSingle(cookedResult, ray, 20.0f);
+        loadedWorld->RaycastSingle(loadedResult, ray, 20.0f);
+        assert(!cookedResult.body_ == !loadedResult.body_);
+        assert(cookedResult.position_ == loadedResult.position_);
+        if (cookedResult.body_)
+            ++numHits;
+    }
+    assert(numHits > 0);
+
+    // Invalid cooked data is cooked again and overwritten
+    SharedPtr<File> file(new File(context, bvhFile, FILE_READWRITE));
+    const i64 cookedSize = file->GetSize();
+    file->Seek(4);
+    file->WriteU32(0);
+    file->Close();
+
+    SharedPtr<Scene> recookedScene(new Scene(context));
+    auto* recookedWorld = recookedScene->CreateComponent<PhysicsWorld>();
+    recookedWorld->SetCookedGeometryDir(dir);
+
+    Vector<CollisionShape*> recookedShapes;
+    CreateBodies(recookedScene, model, recookedShapes);
+    assert(!recookedWorld->IsCookingGeometry());
+    assert(recookedShapes[0]->GetCollisionShape());
+    assert(!static_cast<TriangleMeshData*>(recookedShapes[0]->GetGeometryData())->bvhData_);
+    file = new File(context, bvhFile);
+    assert(file->GetSize() == cookedSize);
+    file->Close();
+
+    // A hull with an index outside its vertices is cooked again as well
+    const String hullFile = dir + (files[0].EndsWith(".hull") ? files[0] : files[1]);
+    const i64 firstIndexOffset = 20 + (i64)(cookedHull->vertexCount_ * sizeof(Vector3)) + 4;
+    file = new File(context, hullFile, FILE_READWRITE);
+    file->Seek(firstIndexOffset);
+    const u32 firstIndex = file->ReadU32();
+    file->Seek(firstIndexOffset);
+    file->WriteU32(cookedHull->vertexCount_);
+    file->Close();
+
+    SharedPtr<Scene> recookedHullScene(new Scene(context));
+    auto* recookedHullWorld = recookedHullScene->CreateComponent<PhysicsWorld>();
+    recookedHullWorld->SetCookedGeometryDir(dir);
+
+    Vector<CollisionShape*> recookedHullShapes;
+    CreateBodies(recookedHullScene, model, recookedHullShapes);
+    assert(!recookedHullWorld->IsCookingGeometry());
+    assert(recookedHullShapes[3]->GetCollisionShape());
+    auto* recookedHull = static_cast<ConvexData*>(recookedHullShapes[3]->GetGeometryData());
+    assert(recookedHull->indexCount_ == cookedHull->indexCount_);
+    for (unsigned i = 0; i < recookedHull->indexCount_; ++i)
+        assert(recookedHull->indexData_[i] < recookedHull->vertexCount_);
+    file = new File(context, hullFile);
+    file->Seek(firstIndexOffset);
+    assert(file->ReadU32() == firstIndex);
+    file->Close();
+
+    // Waiting for the cooking
+    SharedPtr<Model> otherModel = CreateGridModel(context, 32);
+    SharedPtr<Scene> waitingScene(new Scene(context));
+    auto* waitingWorld = waitingScene->CreateComponent<PhysicsWorld>();
+    waitingWorld->SetBackgroundCooking(true);
+
+    Vector<CollisionShape*> waitingShapes;
+    CreateBodies(waitingScene, otherModel, waitingShapes);
+    waitingWorld->CompleteCooking();
+    for (CollisionShape* shape : waitingShapes)
+        assert(shape->GetCollisionShape());
+
+    // A BVH cooked from a different mesh is rejected even if the checksum matches
+    SharedPtr<Scene> otherScene(new Scene(context));
+    auto* otherWorld = otherScene->CreateComponent<PhysicsWorld>();
+    otherWorld->SetCookedGeometryDir(dir);
+    Vector<CollisionShape*> otherShapes;
+    CreateBodies(otherScene, otherModel, otherShapes);
+    String otherBvhFile;
+    for (const String& name : GetCookedFiles(fileSystem, dir))
+    {
+        if (name.EndsWith(".bvh") && dir + name != bvhFile)
+            otherBvhFile = dir + name;
+    }
+    assert(!otherBvhFile.Empty());
+
+    file = new File(context, otherBvhFile);
+    file->Seek(8);
+    const u32 otherChecksum = file->ReadU32();
+    file->Close();
+    file = new File(context, bvhFile);
+    Vector<byte> data((i32)file->GetSize());
+    file->Read(data.Buffer(), data.Size());
+    file->Close();
+    memcpy(&data[8], &otherChecksum, sizeof otherChecksum);
+    file = new File(context, otherBvhFile, FILE_WRITE);
+    file->Write(data.Buffer(), data.Size());
+    file->Close();
+
+    SharedPtr<Scene> mismatchScene(new Scene(context));
+    auto* mismatchWorld = mismatchScene->CreateComponent<PhysicsWorld>();
+    mismatchWorld->SetCookedGeometryDir(dir);
+    Vector<CollisionShape*> mismatchShapes;
+    CreateBodies(mismatchScene, otherModel, mismatchShapes);
+    assert(mismatchShapes[0]->GetCollisionShape());
+    assert(!static_cast<TriangleMeshData*>(mismatchShapes[0]->GetGeometryData())->bvhData_);
+
+    for (const String& name : GetCookedFiles(fileSystem, dir))
+        fileSystem->Delete(dir + name);
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/Constraint.h>
+#include <Urho3D/Physics/PhysicsTaskScheduler.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btRigidBody.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Parallel sum body counting the iterations.
+struct CountIterations : public btIParallelSumBody
+{
+    btScalar sumLoop(int iBegin, int iEnd) const override { return (btScalar)(iEnd - iBegin); }
+};
+
+/// Create a box rigid body.
+static RigidBody* CreateBox(Scene* scene, const Vector3& position, const Vector3& size, float mass)
+{
+    Node* node = scene->CreateChild("Box");
+    node->SetPosition(position);
+    node->SetScale(size);
+    auto* body = node->CreateComponent<RigidBody>();
+    body->SetMass(mass);
+    node->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+    return body;
+}
+
+void Test_Physics_MultithreadedWorld()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    PhysicsTaskScheduler scheduler;
+    scheduler.SetWorkQueue(context->GetSubsystem<WorkQueue>());
+    assert(scheduler.getNumThreads() == scheduler.getMaxNumThreads());
+    assert(scheduler.parallelSum(0, 10000, 100, CountIterations()) == 10000);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* physicsWorld = scene->CreateComponent<PhysicsWorld>();
+    CreateBox(scene, Vector3::ZERO, Vector3(100.0f, 1.0f, 100.0f), 0.0f);
+
+    Vector<RigidBody*> boxes;
+    for (i32 i = 0; i < 64; ++i)
+        boxes.Push(CreateBox(scene, Vector3((i % 8) * 2.0f - 8.0f, 2.0f + (i / 8) * 1.5f, (i % 3) * 2.0f), Vector3::ONE, 1.0f));
+
+    auto* constraint = boxes[0]->GetNode()->CreateComponent<Constraint>();
+    constraint->SetConstraintType(CONSTRAINT_POINT);
+    constraint->SetOtherBody(boxes[1]);
+    constraint->SetDisableCollision(true);
+
+    physicsWorld->SetMultithreaded(true);
+    assert(physicsWorld->IsMultithreaded());
+#if BT_THREADSAFE
+    assert(physicsWorld->GetNumWorldThreads() == 3);
+#else
+    assert(physicsWorld->GetNumWorldThreads() == 0);
+#endif
+
+    for (i32 i = 0; i < 60; ++i)
+        physicsWorld->Update(1.0f / 60.0f);
+
+    // Switching mode in the middle of the simulation keeps all bodies and constraints
+    physicsWorld->SetMultithreaded(false);
+    assert(physicsWorld->GetNumWorldThreads() == 0);
+    assert(physicsWorld->GetWorld()->getNumCollisionObjects() == 65);
+    assert(physicsWorld->GetWorld()->getNumConstraints() == 1);
+    assert(boxes[0]->GetBody()->getNumConstraintRefs() == 1);
+
+    for (i32 i = 0; i < 60; ++i)
+        physicsWorld->Update(1.0f / 60.0f);
+
+    physicsWorld->SetMultithreaded(true);
+    for (i32 i = 0; i < 120; ++i)
+        physicsWorld->Update(1.0f / 60.0f);
+
+    for (i32 i = 0; i < boxes.Size(); ++i)
+    {
+        const float y = boxes[i]->GetNode()->GetPosition().y_;
+        // Fallen, but resting on the floor or on other boxes
+        assert(y > 0.9f);
+        assert(y < 2.0f + (i / 8) * 1.5f);
+    }
+}
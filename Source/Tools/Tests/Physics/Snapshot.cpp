@@ -0,0 +1,155 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/Constraint.h>
+#include <Urho3D/Physics/PhysicsEvents.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Bullet/BulletDynamics/Dynamics/btRigidBody.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Create a rigid body with a box or sphere shape.
+static RigidBody* CreateBody(Scene* scene, const Vector3& position, float mass, bool sphere)
+{
+    Node* node = scene->CreateChild("Body");
+    node->SetPosition(position);
+    node->SetRotation(Quaternion(position.x_ * 10.0f, Vector3::FORWARD));
+    auto* body = node->CreateComponent<RigidBody>();
+    body->SetMass(mass);
+    auto* shape = node->CreateComponent<CollisionShape>();
+    if (sphere)
+        shape->SetSphere(1.0f);
+    else
+        shape->SetBox(mass > 0.0f ? Vector3::ONE : Vector3(40.0f, 1.0f, 40.0f));
+    return body;
+}
+
+/// Save the exact simulation state of the bodies.
+static void SaveStates(const Vector<RigidBody*>& bodies, Vector<btTransform>& transforms, Vector<btVector3>& velocities)
+{
+    for (RigidBody* body : bodies)
+    {
+        transforms.Push(body->GetBody()->getWorldTransform());
+        velocities.Push(body->GetBody()->getLinearVelocity());
+        velocities.Push(body->GetBody()->getAngularVelocity());
+    }
+}
+
+void Test_Physics_Snapshot()
+{
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* physicsWorld = scene->CreateComponent<PhysicsWorld>();
+    physicsWorld->SetInterpolation(false);
+    physicsWorld->SetSnapshotHistorySize(32);
+    physicsWorld->SetDeterministicRollback(true);
+
+    CreateBody(scene, Vector3::ZERO, 0.0f, false);
+    Vector<RigidBody*> bodies;
+    for (i32 i = 0; i < 24; ++i)
+        bodies.Push(CreateBody(scene, Vector3((i % 4) * 1.1f - 2.0f, 1.5f + (i / 4) * 1.2f, (i % 3) * 0.3f), 1.0f, i % 5 == 0));
+
+    auto* constraint = bodies[1]->GetNode()->CreateComponent<Constraint>();
+    constraint->SetConstraintType(CONSTRAINT_HINGE);
+    constraint->SetOtherBody(bodies[2]);
+
+    // Player input applied before each step, replayed the same way when resimulating
+    scene->SubscribeToEvent(E_PHYSICSPRESTEP, [&](StringHash, VariantMap&)
+    {
+        if (physicsWorld->GetSimulationStep() % 7 == 0)
+            bodies[3]->ApplyImpulse(Vector3(1.0f, 0.5f, 0.0f));
+    });
+
+    const float timeStep = 1.0f / physicsWorld->GetFps();
+    for (i32 i = 0; i < 40; ++i)
+        physicsWorld->Update(timeStep);
+    assert(physicsWorld->GetSimulationStep() == 40);
+
+    // Original trajectory after step 40, with the bodies landing and colliding with each other
+    const u32 rollbackStep = physicsWorld->GetSimulationStep();
+    Vector<btTransform> transforms;
+    Vector<btVector3> velocities;
+    SaveStates(bodies, transforms, velocities);
+    for (i32 i = 0; i < 20; ++i)
+    {
+        physicsWorld->Update(timeStep);
+        SaveStates(bodies, transforms, velocities);
+    }
+    assert(physicsWorld->GetSimulationStep() == 60);
+    assert(bodies[0]->GetPosition().y_ < 1.5f);
+
+    // Older steps have dropped out of the history
+    assert(!physicsWorld->GetHistorySnapshot(60 - 32));
+    assert(physicsWorld->GetHistorySnapshot(60 - 31));
+    assert(!physicsWorld->GetHistorySnapshot(61));
+
+    Vector<btTransform> resimTransforms[2];
+    Vector<btVector3> resimVelocities[2];
+    for (i32 pass = 0; pass < 2; ++pass)
+    {
+        // Diverge from the first resimulation before rolling back again
+        if (pass == 1)
+        {
+            bodies[7]->ApplyImpulse(Vector3(0.0f, 5.0f, 0.0f));
+            physicsWorld->Resimulate(5);
+        }
+
+        assert(physicsWorld->Rollback(rollbackStep));
+        assert(physicsWorld->GetSimulationStep() == rollbackStep);
+        // The scene nodes follow the restored bodies
+        assert(bodies[5]->GetNode()->GetWorldPosition().Equals(bodies[5]->GetPosition()));
+
+        SaveStates(bodies, resimTransforms[pass], resimVelocities[pass]);
+        for (i32 i = 0; i < 20; ++i)
+        {
+            physicsWorld->Resimulate(1);
+            SaveStates(bodies, resimTransforms[pass], resimVelocities[pass]);
+        }
+        assert(physicsWorld->GetSimulationStep() == 60);
+        assert(resimTransforms[pass].Size() == transforms.Size());
+    }
+
+    // Resimulating from a snapshot is bit-identical to the original steps, no matter what was simulated before
+    for (i32 i = 0; i < transforms.Size(); ++i)
+    {
+        assert(resimTransforms[0][i] == transforms[i]);
+        assert(resimTransforms[1][i] == transforms[i]);
+    }
+    for (i32 i = 0; i < velocities.Size(); ++i)
+    {
+        assert(resimVelocities[0][i] == velocities[i]);
+        assert(resimVelocities[1][i] == velocities[i]);
+    }
+
+    // Manual snapshots
+    PhysicsWorldSnapshot snapshot;
+    physicsWorld->SaveSnapshot(snapshot);
+    assert(snapshot.step_ == 60);
+    assert(snapshot.bodies_.Size() == bodies.Size());
+    assert(!snapshot.manifolds_.Empty());
+    assert(snapshot.constraints_.Size() == 1);
+
+    physicsWorld->Resimulate(10);
+    assert(physicsWorld->GetSimulationStep() == 70);
+    assert(physicsWorld->GetHistorySnapshot(70));
+    physicsWorld->RestoreSnapshot(snapshot);
+    assert(physicsWorld->GetSimulationStep() == 60);
+    for (i32 i = 0; i < bodies.Size(); ++i)
+        assert(bodies[i]->GetBody()->getWorldTransform() == resimTransforms[1][transforms.Size() - bodies.Size() + i]);
+
+    // Removed bodies are skipped
+    bodies.Back()->GetNode()->Remove();
+    physicsWorld->RestoreSnapshot(snapshot);
+}
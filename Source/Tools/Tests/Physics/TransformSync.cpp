@@ -0,0 +1,72 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Create a falling sphere rigid body.
+static RigidBody* CreateSphere(Node* parent, const Vector3& position)
+{
+    Node* node = parent->CreateChild("Sphere");
+    node->SetPosition(position);
+    auto* body = node->CreateComponent<RigidBody>();
+    body->SetMass(1.0f);
+    node->CreateComponent<CollisionShape>()->SetSphere(1.0f);
+    return body;
+}
+
+void Test_Physics_TransformSync()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* physicsWorld = scene->CreateComponent<PhysicsWorld>();
+    // Without interpolation the nodes receive the simulated transforms as is
+    physicsWorld->SetInterpolation(false);
+    physicsWorld->SetParallelTransformSync(true);
+
+    // Top-level bodies are applied in worker threads, bodies under a plain node and bodies parented to other bodies
+    // from the main thread
+    Vector<RigidBody*> bodies;
+    for (i32 i = 0; i < 400; ++i)
+        bodies.Push(CreateSphere(scene, Vector3((i % 20) * 2.0f, 10.0f, (i / 20) * 2.0f)));
+
+    Node* group = scene->CreateChild("Group");
+    group->SetPosition(Vector3(0.0f, 5.0f, -10.0f));
+    for (i32 i = 0; i < 10; ++i)
+        bodies.Push(CreateSphere(group, Vector3(i * 2.0f, 0.0f, 0.0f)));
+
+    bodies.Push(CreateSphere(bodies[0]->GetNode(), Vector3(0.0f, 3.0f, 0.0f)));
+
+    for (i32 i = 0; i < 30; ++i)
+        physicsWorld->Update(1.0f / 60.0f);
+
+    for (RigidBody* body : bodies)
+    {
+        Node* node = body->GetNode();
+        assert(node->GetWorldPosition().Equals(body->GetPosition()));
+        assert(node->GetWorldRotation().Equals(body->GetRotation()));
+    }
+    // Falling for half a second
+    assert(bodies[0]->GetPosition().y_ < 9.0f);
+    assert(bodies[400]->GetNode()->GetWorldPosition().y_ < 4.0f);
+    assert(bodies.Back()->GetNode()->GetWorldPosition().y_ < 12.0f);
+
+    // Moving a node afterwards still moves the body
+    bodies[1]->GetNode()->SetWorldPosition(Vector3(100.0f, 100.0f, 100.0f));
+    assert(bodies[1]->GetPosition().Equals(Vector3(100.0f, 100.0f, 100.0f)));
+}
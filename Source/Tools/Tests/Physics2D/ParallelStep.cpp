@@ -0,0 +1,129 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Physics2D/CollisionBox2D.h>
+#include <Urho3D/Physics2D/CollisionCircle2D.h>
+#include <Urho3D/Physics2D/Physics2D.h>
+#include <Urho3D/Physics2D/PhysicsEvents2D.h>
+#include <Urho3D/Physics2D/PhysicsWorld2D.h>
+#include <Urho3D/Physics2D/RigidBody2D.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+#include <atomic>
+
+using namespace Urho3D;
+
+/// Loop body counting the executed items.
+static void CountItems(int32 begin, int32 end, void* context)
+{
+    *reinterpret_cast<std::atomic<i32>*>(context) += end - begin;
+}
+
+/// Create a 2D rigid body with a box or circle shape.
+static Node* CreateBody(Node* parent, const Vector2& position, BodyType2D type, bool circle, bool trigger = false)
+{
+    Node* node = parent->CreateChild("Body");
+    node->SetPosition2D(position);
+    node->CreateComponent<RigidBody2D>()->SetBodyType(type);
+    CollisionShape2D* shape;
+    if (circle)
+    {
+        auto* collisionCircle = node->CreateComponent<CollisionCircle2D>();
+        collisionCircle->SetRadius(0.5f);
+        shape = collisionCircle;
+    }
+    else
+    {
+        auto* collisionBox = node->CreateComponent<CollisionBox2D>();
+        collisionBox->SetSize(type == BT_DYNAMIC ? Vector2::ONE : Vector2(100.0f, 2.0f));
+        shape = collisionBox;
+    }
+    shape->SetDensity(1.0f);
+    shape->SetFriction(0.5f);
+    shape->SetTrigger(trigger);
+    return node;
+}
+
+/// Create a scene of bodies falling on the ground, a trigger, and some bodies under a node that is not the scene.
+static void CreateScene(Scene* scene, Vector<Node*>& bodies, i32& numBeginContacts)
+{
+    scene->CreateComponent<PhysicsWorld2D>();
+    CreateBody(scene, Vector2(0.0f, -1.0f), BT_STATIC, false);
+    CreateBody(scene, Vector2(0.0f, 1.0f), BT_STATIC, false, true)->SetScale2D(Vector2(0.1f, 1.0f));
+
+    Node* group = scene->CreateChild("Group");
+    group->SetPosition2D(Vector2(-20.0f, 0.0f));
+    for (i32 i = 0; i < 800; ++i)
+    {
+        Node* parent = i < 40 ? group : scene;
+        const Vector2 position((i % 40) * 1.1f - 22.0f + (i / 40) * 0.05f, 1.0f + (i / 40) * 1.2f);
+        bodies.Push(CreateBody(parent, parent == group ? position + Vector2(20.0f, 0.0f) : position, BT_DYNAMIC, i % 3 == 0));
+    }
+
+    numBeginContacts = 0;
+    scene->SubscribeToEvent(E_PHYSICSBEGINCONTACT2D, [&numBeginContacts](StringHash, VariantMap&) { ++numBeginContacts; });
+}
+
+void Test_Physics2D_ParallelStep()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(2);
+    RegisterSceneLibrary(context);
+    RegisterPhysics2DLibrary(context);
+
+    Vector<Node*> serialBodies;
+    i32 serialBeginContacts;
+    SharedPtr<Scene> serialScene(new Scene(context));
+    CreateScene(serialScene, serialBodies, serialBeginContacts);
+    auto* serialWorld = serialScene->GetComponent<PhysicsWorld2D>();
+
+    Vector<Node*> parallelBodies;
+    i32 parallelBeginContacts;
+    SharedPtr<Scene> parallelScene(new Scene(context));
+    CreateScene(parallelScene, parallelBodies, parallelBeginContacts);
+    auto* parallelWorld = parallelScene->GetComponent<PhysicsWorld2D>();
+    parallelWorld->SetMultithreaded(true);
+    parallelWorld->SetParallelTransformSync(true);
+
+    // Every item of a parallel loop is executed once
+    std::atomic<i32> count{0};
+    parallelWorld->ParallelFor(10000, 64, CountItems, &count);
+    assert(count == 10000);
+
+    // The contacts are updated in the same order, so the simulation is identical to the serial one
+    for (i32 i = 0; i < 180; ++i)
+    {
+        serialWorld->Update(1.0f / 60.0f);
+        parallelWorld->Update(1.0f / 60.0f);
+    }
+    assert(parallelWorld->GetWorld()->GetTaskExecutor() == parallelWorld);
+
+    assert(serialBeginContacts > serialBodies.Size());
+    assert(parallelBeginContacts == serialBeginContacts);
+    assert(parallelWorld->GetWorld()->GetContactCount() == serialWorld->GetWorld()->GetContactCount());
+    for (i32 i = 0; i < serialBodies.Size(); ++i)
+    {
+        assert(parallelBodies[i]->GetWorldPosition() == serialBodies[i]->GetWorldPosition());
+        assert(parallelBodies[i]->GetWorldRotation() == serialBodies[i]->GetWorldRotation());
+        assert(serialBodies[i]->GetWorldPosition().y_ < 30.0f);
+    }
+
+    // The nodes follow the bodies
+    RigidBody2D* body = parallelBodies[0]->GetComponent<RigidBody2D>();
+    const b2Vec2& position = body->GetBody()->GetPosition();
+    assert(parallelBodies[0]->GetWorldPosition().x_ == position.x && parallelBodies[0]->GetWorldPosition().y_ == position.y);
+    body = parallelBodies.Back()->GetComponent<RigidBody2D>();
+    assert(parallelBodies.Back()->GetWorldPosition().x_ == body->GetBody()->GetPosition().x);
+
+    // Switching back to serial updates
+    parallelWorld->SetMultithreaded(false);
+    parallelWorld->Update(1.0f / 60.0f);
+    assert(!parallelWorld->GetWorld()->GetTaskExecutor());
+}
@@ -0,0 +1,170 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#include <atomic>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Resource whose file lists the resources it background loads as dependencies, one per line. The line
+/// "WaitForBoost" waits until the resource has been raised to the maximum priority before requesting the following
+/// dependencies.
+class DependentResource : public Resource
+{
+    URHO3D_OBJECT(DependentResource, Resource);
+
+public:
+    explicit DependentResource(Context* context) :
+        Resource(context)
+    {
+    }
+
+    bool BeginLoad(Deserializer& source) override
+    {
+        auto* cache = GetSubsystem<ResourceCache>();
+
+        while (!source.IsEof())
+        {
+            const String line = source.ReadLine();
+            if (line == "WaitForBoost")
+            {
+                // Give up eventually so that a missing boost fails the test instead of hanging it
+                HiresTimer timer;
+                while (cache->GetBackgroundLoadPriority(GetType(), GetName()) < M_MAX_INT && timer.GetUSec(false) < 5000000)
+                    Time::Sleep(1);
+            }
+            else if (!line.Empty())
+                cache->BackgroundLoadResource<DependentResource>(line, true, this);
+        }
+
+        return true;
+    }
+};
+
+/// Resource that holds BeginLoad() until a full batch of resources is loading, and tracks how many are loading
+/// concurrently.
+class SlowResource : public Resource
+{
+    URHO3D_OBJECT(SlowResource, Resource);
+
+public:
+    explicit SlowResource(Context* context) :
+        Resource(context)
+    {
+    }
+
+    bool BeginLoad(Deserializer& source) override
+    {
+        const i32 loading = ++numLoading_;
+        i32 maxLoading = maxLoading_;
+        while (loading > maxLoading && !maxLoading_.compare_exchange_weak(maxLoading, loading))
+            ;
+
+        // Count the start after the loading count, so that all of a started batch is counted as loading. Wait for the
+        // rest of the batch to start, but give up eventually so that loads which are not concurrent fail the test
+        // instead of hanging it
+        const i32 started = numStarted_++;
+        const i32 batchEnd = (started / batchSize_ + 1) * batchSize_;
+        HiresTimer timer;
+        while (numStarted_ < batchEnd && timer.GetUSec(false) < 5000000)
+            Time::Sleep(1);
+
+        --numLoading_;
+        return source.ReadLine() == "Slow";
+    }
+
+    /// Number of resources that must be in BeginLoad() at the same time before any of them finishes.
+    static i32 batchSize_;
+    /// Number of resources that have entered BeginLoad().
+    static std::atomic<i32> numStarted_;
+    /// Number of resources in BeginLoad().
+    static std::atomic<i32> numLoading_;
+    /// Maximum number of resources that were in BeginLoad() at the same time.
+    static std::atomic<i32> maxLoading_;
+};
+
+i32 SlowResource::batchSize_ = 1;
+std::atomic<i32> SlowResource::numStarted_{0};
+std::atomic<i32> SlowResource::numLoading_{0};
+std::atomic<i32> SlowResource::maxLoading_{0};
+
+static void WriteResourceFile(Context* context, const String& fileName, const String& contents)
+{
+    File file(context, fileName, FILE_WRITE);
+    assert(file.IsOpen());
+    file.WriteLine(contents);
+}
+
+static void WaitUntilQueued(ResourceCache* cache, const String& name)
+{
+    while (cache->GetBackgroundLoadPriority(DependentResource::GetTypeStatic(), name) == M_MIN_INT)
+        Time::Sleep(1);
+}
+
+void Test_Resource_BackgroundLoad()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterFactory<DependentResource>();
+    context->RegisterFactory<SlowResource>();
+
+    auto* fileSystem = context->GetSubsystem<FileSystem>();
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    const String dir = fileSystem->GetTemporaryDir() + "Urho3DBackgroundLoadTest/";
+    fileSystem->CreateDir(dir);
+    WriteResourceFile(context, dir + "A.dep", "B.dep");
+    WriteResourceFile(context, dir + "B.dep", "WaitForBoost\nC.dep");
+    WriteResourceFile(context, dir + "C.dep", "");
+    cache->AddResourceDir(dir);
+
+    // Dependencies are prioritized above their callers
+    cache->BackgroundLoadResource<DependentResource>("A.dep");
+    WaitUntilQueued(cache, "B.dep");
+    assert(cache->GetBackgroundLoadPriority(DependentResource::GetTypeStatic(), "A.dep") == 0);
+    assert(cache->GetBackgroundLoadPriority(DependentResource::GetTypeStatic(), "B.dep") == 1);
+
+    // Waiting for a resource raises its loading dependencies along with it, and dependencies requested by them are
+    // saturated at the maximum priority
+    assert(cache->GetResource<DependentResource>("A.dep"));
+    assert(cache->GetBackgroundLoadPriority(DependentResource::GetTypeStatic(), "A.dep") == M_MIN_INT);
+    assert(cache->GetBackgroundLoadPriority(DependentResource::GetTypeStatic(), "B.dep") == M_MAX_INT);
+    assert(cache->GetBackgroundLoadPriority(DependentResource::GetTypeStatic(), "C.dep") == M_MAX_INT);
+    assert(cache->GetResource<DependentResource>("B.dep"));
+    assert(cache->GetResource<DependentResource>("C.dep"));
+    assert(!cache->GetNumBackgroundLoadResources());
+
+    // Independent resources run BeginLoad() concurrently on the load threads
+    const i32 numSlowResources = 8;
+    for (i32 i = 0; i < numSlowResources; ++i)
+        WriteResourceFile(context, dir + String(i) + ".slow", "Slow");
+
+    // Every resource waits in BeginLoad() until a batch as large as the number of load threads is loading, so all
+    // threads must be loading at the same time for the batches to finish before the timeout
+    const i32 numThreads = 4;
+    cache->SetNumBackgroundLoadThreads(numThreads);
+    SlowResource::batchSize_ = numThreads;
+    for (i32 i = 0; i < numSlowResources; ++i)
+        assert(cache->BackgroundLoadResource<SlowResource>(String(i) + ".slow"));
+    for (i32 i = 0; i < numSlowResources; ++i)
+        assert(cache->GetResource<SlowResource>(String(i) + ".slow"));
+    assert(!cache->GetNumBackgroundLoadResources());
+    assert(SlowResource::numLoading_ == 0);
+    assert(SlowResource::numStarted_ == numSlowResources);
+    assert(SlowResource::maxLoading_ == numThreads);
+
+    cache->RemoveResourceDir(dir);
+    for (const char* name : {"A.dep", "B.dep", "C.dep"})
+        fileSystem->Delete(dir + name);
+    for (i32 i = 0; i < numSlowResources; ++i)
+        fileSystem->Delete(dir + String(i) + ".slow");
+}
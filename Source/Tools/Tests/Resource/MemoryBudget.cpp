@@ -0,0 +1,125 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/JSONFile.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Records the resource cache budget events.
+class BudgetListener : public Object
+{
+    URHO3D_OBJECT(BudgetListener, Object);
+
+public:
+    explicit BudgetListener(Context* context) :
+        Object(context)
+    {
+        SubscribeToEvent(E_RESOURCEEVICTED, [this](StringHash, VariantMap& eventData)
+        {
+            evicted_.Push(eventData[ResourceEvicted::P_RESOURCENAME].GetString());
+        });
+        SubscribeToEvent(E_RESOURCEBUDGETEXCEEDED, [this](StringHash, VariantMap& eventData)
+        {
+            exceeded_.Push(eventData[ResourceBudgetExceeded::P_RESOURCETYPE].GetStringHash());
+        });
+    }
+
+    /// Names of the evicted resources.
+    Vector<String> evicted_;
+    /// Types of the exceeded budgets, zero for the total budget.
+    Vector<StringHash> exceeded_;
+};
+
+template <class T> static SharedPtr<T> AddResource(ResourceCache* cache, const String& name, i32 memoryUse)
+{
+    SharedPtr<T> resource(new T(cache->GetContext()));
+    resource->SetName(name);
+    resource->SetMemoryUse(memoryUse);
+    assert(cache->AddManualResource(resource));
+    return resource;
+}
+
+void Test_Resource_MemoryBudget()
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    SharedPtr<BudgetListener> listener(new BudgetListener(context));
+
+    // The least recently used resource of the type is evicted when the per-type budget is exceeded
+    cache->SetMemoryBudget(XMLFile::GetTypeStatic(), 250);
+    AddResource<XMLFile>(cache, "A.xml", 100);
+    AddResource<XMLFile>(cache, "B.xml", 100);
+    cache->SendEvent(E_BEGINFRAME);
+    assert(cache->GetExistingResource<XMLFile>("A.xml"));
+    AddResource<XMLFile>(cache, "C.xml", 100);
+    assert(listener->evicted_.Size() == 1 && listener->evicted_[0] == "B.xml");
+    assert(!cache->GetExistingResource<XMLFile>("B.xml"));
+    assert(cache->GetMemoryUse(XMLFile::GetTypeStatic()) == 200);
+    assert(cache->GetNumEvictedResources() == 1 && cache->GetEvictedMemory() == 100);
+    assert(!cache->IsOverMemoryBudget());
+
+    // Resources in use or pinned are not evicted
+    cache->GetExistingResource<XMLFile>("A.xml")->SetPinned(true);
+    SharedPtr<XMLFile> heldC(cache->GetExistingResource<XMLFile>("C.xml"));
+    SharedPtr<XMLFile> heldD = AddResource<XMLFile>(cache, "D.xml", 100);
+    assert(listener->evicted_.Size() == 1);
+    assert(cache->IsOverMemoryBudget());
+    assert(listener->exceeded_.Size() == 1 && listener->exceeded_[0] == XMLFile::GetTypeStatic());
+
+    // The exceeded event is sent only once
+    cache->SendEvent(E_ENDFRAME);
+    assert(listener->exceeded_.Size() == 1);
+
+    // Once a resource is released elsewhere, the budget is enforced again at the end of the frame
+    heldC.Reset();
+    assert(cache->GetExistingResource<XMLFile>("C.xml"));
+    cache->SendEvent(E_BEGINFRAME);
+    cache->SendEvent(E_ENDFRAME);
+    assert(listener->evicted_.Size() == 2 && listener->evicted_[1] == "C.xml");
+    assert(cache->GetMemoryUse(XMLFile::GetTypeStatic()) == 200);
+    assert(!cache->IsOverMemoryBudget());
+
+    // The total budget evicts the least recently used resource of any type
+    cache->GetExistingResource<XMLFile>("A.xml")->SetPinned(false);
+    cache->SetMemoryBudget(XMLFile::GetTypeStatic(), 0);
+    cache->SetTotalMemoryBudget(350);
+    cache->SendEvent(E_BEGINFRAME);
+    AddResource<JSONFile>(cache, "E.json", 100);
+    assert(listener->evicted_.Size() == 2);
+    cache->SendEvent(E_BEGINFRAME);
+    AddResource<JSONFile>(cache, "F.json", 100);
+    assert(listener->evicted_.Size() == 3 && listener->evicted_[2] == "A.xml");
+    assert(cache->GetTotalMemoryUse() == 300);
+    assert(cache->GetExistingResource<XMLFile>("D.xml"));
+
+    // Growing memory use of a loaded resource is caught at the end of the frame
+    heldD->SetMemoryUse(200);
+    assert(cache->GetTotalMemoryUse() == 400);
+    assert(listener->evicted_.Size() == 3);
+    cache->SendEvent(E_BEGINFRAME);
+    cache->SendEvent(E_ENDFRAME);
+    assert(listener->evicted_.Size() == 4 && listener->evicted_[3] == "E.json");
+    assert(cache->GetTotalMemoryUse() == 300);
+    assert(!cache->IsOverMemoryBudget());
+
+    // Releasing a resource stops counting its memory use
+    const unsigned long long xmlMemoryUse = cache->GetMemoryUse(XMLFile::GetTypeStatic());
+    heldD.Reset();
+    cache->ReleaseResource<XMLFile>("D.xml");
+    assert(!cache->GetExistingResource<XMLFile>("D.xml"));
+    assert(cache->GetMemoryUse(XMLFile::GetTypeStatic()) == xmlMemoryUse - 200);
+    assert(cache->GetTotalMemoryUse() == 100);
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/ReplicationState.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Return the name of the only dirty attribute of a node or component after the network update, or empty if not exactly one.
+static String GetDirtyAttribute(Scene* scene, Serializable* object, DirtyBits& dirtyAttributes)
+{
+    dirtyAttributes.ClearAll();
+    scene->PrepareNetworkUpdate();
+    if (dirtyAttributes.Count() != 1)
+        return String::EMPTY;
+
+    const Vector<AttributeInfo>* attributes = object->GetNetworkAttributes();
+    for (i32 i = 0; i < attributes->Size(); ++i)
+    {
+        if (dirtyAttributes.IsSet(i))
+            return attributes->At(i).name_;
+    }
+
+    return String::EMPTY;
+}
+
+void Test_Scene_NetworkChangeJournal()
+{
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    SceneReplicationState sceneState;
+    NodeReplicationState nodeState;
+    nodeState.sceneState_ = &sceneState;
+
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->SetNetworkChangeJournal(true);
+    Node* node = scene->CreateChild("Node");
+    scene->PrepareNetworkUpdate();
+    node->AddReplicationState(&nodeState);
+
+    // The setters record the attributes they change
+    node->SetPosition(Vector3(1.0f, 2.0f, 3.0f));
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Network Position");
+    node->Rotate(Quaternion(45.0f, Vector3::UP));
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Network Rotation");
+    node->SetScale(2.0f);
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Scale");
+    node->SetName("Renamed");
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Name");
+    node->AddTag("Tag");
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Tags");
+    node->SetEnabled(false);
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Is Enabled");
+
+    // Recorded attributes are still compared, so setting the same value does not send an update
+    node->SetPosition(Vector3(1.0f, 2.0f, 3.0f));
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_).Empty());
+    assert(nodeState.dirtyAttributes_.Count() == 0);
+
+    // Changes invalidate the serialized updates shared by the connections
+    NetworkState* networkState = node->GetNetworkState();
+    networkState->latestDataUpdate_.WriteU8(1);
+    node->Translate(Vector3::ONE);
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Network Position");
+    assert(networkState->latestDataUpdate_.GetSize() == 0);
+
+    // Changes without an attribute index compare all attributes
+    node->SetTransform(Vector3::ZERO, Quaternion::IDENTITY, Vector3::ONE);
+    scene->PrepareNetworkUpdate();
+    Node* parent = scene->CreateChild("Parent");
+    node->SetParent(parent);
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Network Parent Node");
+
+    // Without the journal all attributes are compared as before
+    scene->SetNetworkChangeJournal(false);
+    node->SetPosition(Vector3::ONE);
+    assert(GetDirtyAttribute(scene, node, nodeState.dirtyAttributes_) == "Network Position");
+
+    // Components record the attributes of their setters
+    scene->SetNetworkChangeJournal(true);
+    node->SetEnabled(true);
+    scene->CreateComponent<PhysicsWorld>();
+    auto* body = node->CreateComponent<RigidBody>();
+    auto* model = node->CreateComponent<AnimatedModel>();
+    ComponentReplicationState bodyState;
+    bodyState.nodeState_ = &nodeState;
+    ComponentReplicationState modelState;
+    modelState.nodeState_ = &nodeState;
+    scene->PrepareNetworkUpdate();
+    body->AddReplicationState(&bodyState);
+    model->AddReplicationState(&modelState);
+
+    body->SetFriction(0.25f);
+    assert(GetDirtyAttribute(scene, body, bodyState.dirtyAttributes_) == "Friction");
+    body->SetMass(2.0f);
+    assert(GetDirtyAttribute(scene, body, bodyState.dirtyAttributes_) == "Mass");
+    body->SetCollisionLayerAndMask(2, 3);
+    assert(GetDirtyAttribute(scene, body, bodyState.dirtyAttributes_).Empty());
+    assert(bodyState.dirtyAttributes_.Count() == 2);
+    model->SetUpdateInvisible(true);
+    assert(!model->GetNetworkState()->compareAll_);
+    assert(GetDirtyAttribute(scene, model, modelState.dirtyAttributes_) == "Update When Invisible");
+
+    // The indices of a base class setter do not apply to the attributes of a subclass, so they are all compared
+    model->SetMaterial(nullptr);
+    assert(model->GetNetworkState()->compareAll_);
+    scene->PrepareNetworkUpdate();
+    assert(!model->GetNetworkState()->compareAll_);
+
+    model->RemoveReplicationState(&modelState);
+    body->RemoveReplicationState(&bodyState);
+    node->RemoveReplicationState(&nodeState);
+}
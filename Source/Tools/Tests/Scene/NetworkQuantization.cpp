@@ -0,0 +1,70 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const Vector3 POSITION(123.456f, -7.5f, 300.0f);
+
+/// Write the latest data update of a new node.
+static void WriteLatestData(Scene* scene, VectorBuffer& dest)
+{
+    Node* node = scene->CreateChild("Node");
+    node->SetPosition(POSITION);
+    node->PrepareNetworkUpdate();
+    node->WriteLatestDataUpdate(dest, 0);
+}
+
+void Test_Scene_NetworkQuantization()
+{
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    VectorBuffer full;
+    WriteLatestData(scene, full);
+
+    // Quantize positions within a 2 km box to 20 bits per component, about 2 mm precision
+    context->SetAttributeMetadata<Node>("Network Position", AttributeMetadata::P_QUANTIZE_BITS, 20);
+
+    // Without the range the position is sent unquantized
+    VectorBuffer unranged;
+    WriteLatestData(scene, unranged);
+    assert(unranged.GetSize() == full.GetSize());
+
+    context->SetAttributeMetadata<Node>("Network Position", AttributeMetadata::P_QUANTIZE_MIN, -1000.0f);
+    context->SetAttributeMetadata<Node>("Network Position", AttributeMetadata::P_QUANTIZE_MAX, 1000.0f);
+
+    VectorBuffer quantized;
+    WriteLatestData(scene, quantized);
+    assert(quantized.GetSize() + 4 == full.GetSize());
+
+    Node* received = scene->CreateChild("Received");
+    MemoryBuffer latestData(quantized.GetBuffer());
+    assert(received->ReadLatestDataUpdate(latestData));
+    assert((received->GetPosition() - POSITION).Length() < 0.005f);
+
+    // Delta updates pack the other attributes after the quantized ones
+    Node* node = scene->CreateChild("Delta");
+    node->SetPosition(POSITION);
+    node->SetVar("Key", 1);
+    node->PrepareNetworkUpdate();
+    VectorBuffer delta;
+    node->WriteInitialDeltaUpdate(delta, 0);
+    delta.WriteString("Trailing");
+
+    Node* deltaReceived = scene->CreateChild();
+    MemoryBuffer deltaData(delta.GetBuffer());
+    assert(deltaReceived->ReadDeltaUpdate(deltaData));
+    assert(deltaReceived->GetName() == "Delta");
+    assert((deltaReceived->GetPosition() - POSITION).Length() < 0.005f);
+    assert(deltaData.ReadString() == "Trailing");
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../ForceAssert.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SmoothedTransform.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const float SEND_INTERVAL = 0.1f;
+static const float TIME_STEP = 0.02f;
+static const float SPEED = 10.0f;
+static const float MAX_EXTRAPOLATION = 0.1f;
+
+/// Receive the updates sent by a given time, with every other update arriving late. The server clock starts at the base time.
+static void ReceiveUpdates(Scene* scene, SmoothedTransform* transform, i32& numReceived, i32 numSent, float clientTime,
+    double baseTime)
+{
+    while (numReceived < numSent)
+    {
+        float sendTime = numReceived * SEND_INTERVAL;
+        float arrivalTime = sendTime + (numReceived % 2 ? 0.04f : 0.0f);
+        if (arrivalTime > clientTime)
+            break;
+
+        scene->SetNetworkUpdateTime(baseTime + sendTime);
+        transform->SetTargetPosition(Vector3(sendTime * SPEED, 0.0f, 0.0f));
+        ++numReceived;
+    }
+}
+
+/// Send updates for a while and check that the motion stays smooth although they arrive with jitter.
+static void CheckSmoothMotion(Scene* scene, SmoothedTransform* transform, i32 numSent, double baseTime)
+{
+    Node* node = transform->GetNode();
+    i32 numReceived = 0;
+    float clientTime = 0.0f;
+    float lastX = 0.0f;
+    for (i32 i = 0; clientTime < numSent * SEND_INTERVAL; ++i)
+    {
+        ReceiveUpdates(scene, transform, numReceived, Min((i32)(clientTime / SEND_INTERVAL) + 1, numSent), clientTime,
+            baseTime);
+        scene->Update(TIME_STEP);
+        clientTime += TIME_STEP;
+
+        float x = node->GetPosition().x_;
+        if (clientTime > 0.5f)
+        {
+            float step = x - lastX;
+            assert(step > SPEED * TIME_STEP * 0.5f && step < SPEED * TIME_STEP * 1.5f);
+        }
+        lastX = x;
+    }
+    assert(transform->GetNumSamples() < numSent);
+}
+
+void Test_Scene_TransformInterpolation()
+{
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->SetInterpolationDelay(0.15f);
+    scene->SetMaxExtrapolation(MAX_EXTRAPOLATION);
+    Node* node = scene->CreateChild("Node");
+    auto* transform = node->CreateComponent<SmoothedTransform>();
+
+    // Motion stays smooth although the updates arrive with jitter
+    const i32 numSent = 20;
+    CheckSmoothMotion(scene, transform, numSent, 0.0);
+
+    // When updates stop, extrapolation continues the motion for a bounded time and then returns to the latest update
+    const float lastSent = (numSent - 1) * SEND_INTERVAL * SPEED;
+    float maxX = 0.0f;
+    for (i32 i = 0; i < 50; ++i)
+    {
+        scene->Update(TIME_STEP);
+        maxX = Max(maxX, node->GetPosition().x_);
+    }
+    assert(maxX > lastSent && maxX <= lastSent + SPEED * MAX_EXTRAPOLATION + 0.01f);
+    assert(Equals(node->GetPosition().x_, lastSent));
+    assert(!transform->IsInProgress());
+
+    // Snapping ends the interpolation at the latest target
+    scene->SetNetworkUpdateTime(numSent * SEND_INTERVAL);
+    transform->SetTargetPosition(Vector3(100.0f, 0.0f, 0.0f));
+    scene->SetNetworkUpdateTime((numSent + 1) * SEND_INTERVAL);
+    transform->SetTargetPosition(Vector3(200.0f, 0.0f, 0.0f));
+    assert(transform->GetNumSamples() == 3);
+    transform->Update(1.0f, 0.0f);
+    assert(transform->GetNumSamples() == 1);
+    assert(node->GetPosition().x_ == 200.0f);
+
+    // Without a delay targets are smoothed exponentially
+    scene->SetInterpolationDelay(0.0f);
+    transform->SetTargetPosition(Vector3::ZERO);
+    assert(transform->GetNumSamples() == 0);
+    transform->Update(1.0f, 0.0f);
+    assert(node->GetPosition() == Vector3::ZERO);
+
+    // The server time keeps its resolution on long sessions, here 100 hours, where single precision seconds could no
+    // longer tell the frames apart
+    SharedPtr<Scene> longScene(new Scene(context));
+    longScene->SetInterpolationDelay(0.15f);
+    longScene->SetMaxExtrapolation(MAX_EXTRAPOLATION);
+    auto* longTransform = longScene->CreateChild("Node")->CreateComponent<SmoothedTransform>();
+    CheckSmoothMotion(longScene, longTransform, numSent, 100.0 * 3600.0);
+}
@@ -11826,8 +11826,8 @@ template <class T> void RegisterMembers_ResourceCache(asIScriptEngine* engine, c
     // bool ResourceCache::AddResourceDir(const String& pathName, i32 priority = PRIORITY_LAST)
     engine->RegisterObjectMethod(className, "bool AddResourceDir(const String&in, int = PRIORITY_LAST)", AS_METHODPR(T, AddResourceDir, (const String&, i32), bool), AS_CALL_THISCALL);
 
-    // bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr)
-    engine->RegisterObjectMethod(className, "bool BackgroundLoadResource(StringHash, const String&in, bool = true, Resource@+ = null)", AS_METHODPR(T, BackgroundLoadResource, (StringHash, const String&, bool, Resource*), bool), AS_CALL_THISCALL);
+    // bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, i32 priority = 0)
+    engine->RegisterObjectMethod(className, "bool BackgroundLoadResource(StringHash, const String&in, bool = true, Resource@+ = null, int = 0)", AS_METHODPR(T, BackgroundLoadResource, (StringHash, const String&, bool, Resource*, i32), bool), AS_CALL_THISCALL);
 
     // bool ResourceCache::Exists(const String& name) const
     engine->RegisterObjectMethod(className, "bool Exists(const String&in) const", AS_METHODPR(T, Exists, (const String&) const, bool), AS_CALL_THISCALL);
@@ -11955,7 +11955,7 @@ template <class T> void RegisterMembers_ResourceCache(asIScriptEngine* engine, c
     // void ResourceCache::StoreResourceDependency(Resource* resource, const String& dependency)
     engine->RegisterObjectMethod(className, "void StoreResourceDependency(Resource@+, const String&in)", AS_METHODPR(T, StoreResourceDependency, (Resource*, const String&), void), AS_CALL_THISCALL);
 
-    // template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr)
+    // template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, i32 priority = 0)
     // Not registered because template
     // template <class T> T* ResourceCache::GetExistingResource(const String& name)
     // Not registered because template
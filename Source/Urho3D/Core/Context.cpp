@@ -219,6 +219,23 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
         info->defaultValue_ = defaultValue;
 }
 
+void Context::SetAttributeMetadata(StringHash objectType, const char* name, StringHash key, const Variant& value)
+{
+    AttributeInfo* info = GetAttribute(objectType, name);
+    if (info)
+        info->metadata_[key] = value;
+
+    HashMap<StringHash, Vector<AttributeInfo>>::Iterator i = networkAttributes_.Find(objectType);
+    if (i != networkAttributes_.End())
+    {
+        for (AttributeInfo& networkInfo : i->second_)
+        {
+            if (!networkInfo.name_.Compare(name, true))
+                networkInfo.metadata_[key] = value;
+        }
+    }
+}
+
 VariantMap& Context::GetEventDataMap()
 {
     unsigned nestingLevel = eventSenders_.Size();
@@ -77,6 +77,8 @@ public:
     void RemoveAllAttributes(StringHash objectType);
     /// Update object attribute's default value.
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
+    /// Set metadata of an already registered object attribute, including its network replication copy.
+    void SetAttributeMetadata(StringHash objectType, const char* name, StringHash key, const Variant& value);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
     /// Initialises the specified SDL systems, if not already. Returns true if successful. This call must be matched with ReleaseSDL() when SDL functions are no longer required, even if this call fails.
@@ -110,6 +112,8 @@ public:
     template <class T, class U> void CopyBaseAttributes();
     /// Template version of updating an object attribute's default value.
     template <class T> void UpdateAttributeDefaultValue(const char* name, const Variant& defaultValue);
+    /// Template version of setting an object attribute's metadata.
+    template <class T> void SetAttributeMetadata(const char* name, StringHash key, const Variant& value);
 
     /// Return subsystem by type.
     Object* GetSubsystem(StringHash type) const;
@@ -260,4 +264,9 @@ template <class T> void Context::UpdateAttributeDefaultValue(const char* name, c
     UpdateAttributeDefaultValue(T::GetTypeStatic(), name, defaultValue);
 }
 
+template <class T> void Context::SetAttributeMetadata(const char* name, StringHash key, const Variant& value)
+{
+    SetAttributeMetadata(T::GetTypeStatic(), name, key, value);
+}
+
 }
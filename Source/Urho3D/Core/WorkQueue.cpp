@@ -12,6 +12,12 @@
 namespace Urho3D
 {
 
+/// Number of work items per thread a parallel loop is split into, for load balancing.
+static const i32 RANGES_PER_THREAD = 4;
+
+/// Index of the work queue thread running on the current thread. 0 for the main thread.
+static thread_local i32 currentThreadIndex = 0;
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -283,6 +289,38 @@ void WorkQueue::Complete(i32 priority)
     completing_ = false;
 }
 
+void WorkQueue::ParallelFor(i32 begin, i32 end, i32 minRange, const ParallelForFunction& body)
+{
+    const i32 count = end - begin;
+    if (count <= 0)
+        return;
+
+    // Only the main thread can complete work, and it can not complete more work while already doing so
+    const i32 numThreads = threads_.Size() + 1; // Worker threads + main thread
+    minRange = Max(minRange, 1);
+    if (count <= minRange || numThreads <= 1 || !Thread::IsMainThread() || completing_)
+    {
+        body(begin, end, currentThreadIndex);
+        return;
+    }
+
+    const i32 numRanges = Min((count + minRange - 1) / minRange, numThreads * RANGES_PER_THREAD);
+    const i32 rangeSize = (count + numRanges - 1) / numRanges;
+    parallelRanges_.Clear();
+    for (i32 rangeBegin = begin; rangeBegin < end; rangeBegin += rangeSize)
+        parallelRanges_.Push(ParallelRange{&body, rangeBegin, Min(rangeBegin + rangeSize, end)});
+
+    for (ParallelRange& range : parallelRanges_)
+    {
+        SharedPtr<WorkItem> item = GetFreeItem();
+        item->priority_ = WI_MAX_PRIORITY;
+        item->workFunction_ = ExecuteParallelRange;
+        item->start_ = &range;
+        AddWorkItem(item);
+    }
+    Complete(WI_MAX_PRIORITY);
+}
+
 bool WorkQueue::IsCompleted(i32 priority) const
 {
     assert(priority >= 0);
@@ -298,6 +336,7 @@ bool WorkQueue::IsCompleted(i32 priority) const
 void WorkQueue::ProcessItems(i32 threadIndex)
 {
     assert(threadIndex >= 0);
+    currentThreadIndex = threadIndex;
 
     bool wasActive = false;
 
@@ -416,4 +455,10 @@ void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
     PurgePool();
 }
 
+void WorkQueue::ExecuteParallelRange(const WorkItem* item, i32 threadIndex)
+{
+    auto* range = reinterpret_cast<ParallelRange*>(item->start_);
+    (*range->body_)(range->begin_, range->end_, threadIndex);
+}
+
 }
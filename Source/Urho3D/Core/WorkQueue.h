@@ -8,6 +8,7 @@
 #include "../Core/Object.h"
 
 #include <atomic>
+#include <functional>
 
 namespace Urho3D
 {
@@ -22,6 +23,9 @@ inline constexpr i32 WI_MAX_PRIORITY = M_MAX_INT;
 
 class WorkerThread;
 
+/// Body of a parallel loop. Called with a range of the loop and the index of the thread running it (0 = main thread).
+using ParallelForFunction = std::function<void(i32 begin, i32 end, i32 threadIndex)>;
+
 /// Work queue item.
 /// @nobind
 struct WorkItem : public RefCounted
@@ -77,6 +81,8 @@ public:
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(i32 priority);
+    /// Run a loop body over ranges of the items from begin to end in the worker threads and the main thread, and wait for it to finish. The ranges have at least minRange items, with a few ranges per thread for load balancing. Small loops, loops without worker threads and loops started outside the main thread or from work being completed run on the calling thread.
+    void ParallelFor(i32 begin, i32 end, i32 minRange, const ParallelForFunction& body);
 
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
@@ -109,6 +115,19 @@ private:
     void ReturnToPool(SharedPtr<WorkItem>& item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Execute a range of a parallel loop in a work item.
+    static void ExecuteParallelRange(const WorkItem* item, i32 threadIndex);
+
+    /// Range of a parallel loop executed by one work item.
+    struct ParallelRange
+    {
+        /// Loop body.
+        const ParallelForFunction* body_;
+        /// First item.
+        i32 begin_;
+        /// One past the last item.
+        i32 end_;
+    };
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread>> threads_;
@@ -134,6 +153,8 @@ private:
     i32 lastSize_;
     /// Maximum milliseconds per frame to spend on low-priority work, when there are no worker threads.
     int maxNonThreadedWorkMs_;
+    /// Ranges of the parallel loop being executed. Only one loop at a time is split, as nested loops run on the calling thread.
+    Vector<ParallelRange> parallelRanges_;
 };
 
 }
@@ -30,6 +30,12 @@ namespace Urho3D
 
 extern const char* GEOMETRY_CATEGORY;
 
+/// Indices of the animated model network attributes recorded by the setters in network change journal mode. Looked up by
+/// name on registration, NINDEX if not found.
+static i32 networkAttrUpdateInvisible = NINDEX;
+static i32 networkAttrAnimationLodBias = NINDEX;
+static i32 networkAttrMorphs = NINDEX;
+
 static const StringVector animationStatesStructureElementNames =
 {
     "Anim State Count",
@@ -104,6 +110,11 @@ void AnimatedModel::RegisterObject(Context* context)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, animationStatesStructureElementNames);
     URHO3D_ACCESSOR_ATTRIBUTE("Morphs", GetMorphsAttr, SetMorphsAttr, Variant::emptyBuffer,
         AM_DEFAULT | AM_NOEDIT);
+
+    const StringHash type = GetTypeStatic();
+    networkAttrUpdateInvisible = GetNetworkAttributeIndex(context, type, "Update When Invisible");
+    networkAttrAnimationLodBias = GetNetworkAttributeIndex(context, type, "Animation LOD Bias");
+    networkAttrMorphs = GetNetworkAttributeIndex(context, type, "Morphs");
 }
 
 bool AnimatedModel::Load(Deserializer& source)
@@ -524,13 +535,13 @@ void AnimatedModel::RemoveAllAnimationStates()
 void AnimatedModel::SetAnimationLodBias(float bias)
 {
     animationLodBias_ = Max(bias, 0.0f);
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrAnimationLodBias);
 }
 
 void AnimatedModel::SetUpdateInvisible(bool enable)
 {
     updateInvisible_ = enable;
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrUpdateInvisible);
 }
 
 
@@ -564,7 +575,7 @@ void AnimatedModel::SetMorphWeight(i32 index, float weight)
         }
 
         MarkMorphsDirty();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrMorphs);
     }
 }
 
@@ -611,7 +622,7 @@ void AnimatedModel::ResetMorphWeights()
     }
 
     MarkMorphsDirty();
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrMorphs);
 }
 
 float AnimatedModel::GetMorphWeight(i32 index) const
@@ -16,6 +16,7 @@
 #include "../Graphics/Renderer.h"
 #include "../Graphics/RenderPath.h"
 #include "../Graphics/Technique.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../Graphics/View.h"
 #include "../Graphics/Zone.h"
 #include "../GraphicsAPI/GraphicsImpl.h"
@@ -244,7 +245,8 @@ inline Vector<VertexElement> CreateInstancingBufferElements(unsigned numExtraEle
 
 Renderer::Renderer(Context* context) :
     Object(context),
-    defaultZone_(new Zone(context))
+    defaultZone_(new Zone(context)),
+    textureStreamer_(new TextureStreamer(context))
 {
     SubscribeToEvent(E_SCREENMODE, URHO3D_HANDLER(Renderer, HandleScreenMode));
 
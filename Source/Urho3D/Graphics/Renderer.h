@@ -33,6 +33,7 @@ class Technique;
 class Texture;
 class Texture2D;
 class TextureCube;
+class TextureStreamer;
 class View;
 class Zone;
 struct BatchQueue;
@@ -306,6 +307,10 @@ public:
     /// @property
     MaterialQuality GetMaterialQuality() const { return materialQuality_; }
 
+    /// Return texture streaming subsystem.
+    /// @property
+    TextureStreamer* GetTextureStreamer() const { return textureStreamer_; }
+
     /// Return shadow map resolution.
     /// @property
     int GetShadowMapSize() const { return shadowMapSize_; }
@@ -546,6 +551,8 @@ private:
     SharedPtr<TextureCube> faceSelectCubeMap_;
     /// Indirection cube map for shadowed pointlights.
     SharedPtr<TextureCube> indirectionCubeMap_;
+    /// Texture streaming subsystem.
+    SharedPtr<TextureStreamer> textureStreamer_;
     /// Reusable scene nodes with shadow camera components.
     Vector<SharedPtr<Node>> shadowCameraNodes_;
     /// Reusable occlusion buffers.
@@ -25,6 +25,12 @@ namespace Urho3D
 
 extern const char* GEOMETRY_CATEGORY;
 
+/// Indices of the static model network attributes recorded by the setters in network change journal mode. Looked up by
+/// name on registration, NINDEX if not found.
+static i32 networkAttrModel = NINDEX;
+static i32 networkAttrMaterial = NINDEX;
+static i32 networkAttrOcclusionLodLevel = NINDEX;
+
 StaticModel::StaticModel(Context* context) :
     Drawable(context, DrawableTypes::Geometry),
     occlusionLodLevel_(NINDEX),
@@ -50,6 +56,11 @@ void StaticModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, 1.0f, AM_DEFAULT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_ATTRIBUTE("Occlusion LOD Level", occlusionLodLevel_, NINDEX, AM_DEFAULT);
+
+    const StringHash type = GetTypeStatic();
+    networkAttrModel = GetNetworkAttributeIndex(context, type, "Model");
+    networkAttrMaterial = GetNetworkAttributeIndex(context, type, "Material");
+    networkAttrOcclusionLodLevel = GetNetworkAttributeIndex(context, type, "Occlusion LOD Level");
 }
 
 void StaticModel::ProcessRayQuery(const RayOctreeQuery& query, Vector<RayQueryResult>& results)
@@ -253,7 +264,8 @@ void StaticModel::SetModel(Model* model)
         SetBoundingBox(BoundingBox());
     }
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrModel);
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrMaterial);
 }
 
 void StaticModel::SetMaterial(Material* material)
@@ -261,7 +273,7 @@ void StaticModel::SetMaterial(Material* material)
     for (unsigned i = 0; i < batches_.Size(); ++i)
         batches_[i].material_ = material;
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrMaterial);
 }
 
 bool StaticModel::SetMaterial(unsigned index, Material* material)
@@ -273,7 +285,7 @@ bool StaticModel::SetMaterial(unsigned index, Material* material)
     }
 
     batches_[index].material_ = material;
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrMaterial);
     return true;
 }
 
@@ -282,7 +294,7 @@ void StaticModel::SetOcclusionLodLevel(i32 level)
     assert(level >= 0 || level == NINDEX);
 
     occlusionLodLevel_ = level;
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrOcclusionLodLevel);
 }
 
 void StaticModel::ApplyMaterialList(const String& fileName)
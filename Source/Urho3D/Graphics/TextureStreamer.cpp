@@ -0,0 +1,382 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../Precompiled.h"
+
+#include "../Core/CoreEvents.h"
+#include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Drawable.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/TextureStreamer.h"
+#include "../GraphicsAPI/Texture2D.h"
+#include "../IO/Log.h"
+#include "../Resource/Image.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned long long DEFAULT_STREAMING_BUDGET = 256 * 1024 * 1024;
+static const int DEFAULT_MIN_RESIDENT_SIZE = 64;
+static const i32 DEFAULT_MAX_PENDING_LOADS = 4;
+static const i32 DEFAULT_REQUEST_TIMEOUT = 60;
+
+TextureStreamer::TextureStreamer(Context* context) :
+    Object(context),
+    memoryBudget_(DEFAULT_STREAMING_BUDGET),
+    minResidentSize_(DEFAULT_MIN_RESIDENT_SIZE),
+    maxPendingLoads_(DEFAULT_MAX_PENDING_LOADS),
+    requestTimeout_(DEFAULT_REQUEST_TIMEOUT),
+    levelBias_(0),
+    enabled_(false)
+{
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(TextureStreamer, HandleEndFrame));
+    SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(TextureStreamer, HandleResourceBackgroundLoaded));
+}
+
+TextureStreamer::~TextureStreamer() = default;
+
+void TextureStreamer::SetEnabled(bool enable)
+{
+    enabled_ = enable;
+}
+
+void TextureStreamer::SetMemoryBudget(unsigned long long budget)
+{
+    memoryBudget_ = budget;
+}
+
+void TextureStreamer::SetMinResidentSize(int size)
+{
+    minResidentSize_ = Max(size, 1);
+}
+
+void TextureStreamer::SetMaxPendingLoads(i32 num)
+{
+    maxPendingLoads_ = Max(num, 1);
+}
+
+void TextureStreamer::SetRequestTimeout(i32 frames)
+{
+    requestTimeout_ = Max(frames, 0);
+}
+
+bool TextureStreamer::AddTexture(Texture2D* texture, Image* image)
+{
+    if (!texture || !image)
+        return false;
+
+    Vector<unsigned> levelSizes;
+    int width = image->GetWidth();
+    int height = image->GetHeight();
+
+    if (image->IsCompressed())
+    {
+        for (unsigned i = 0; i < image->GetNumCompressedLevels(); ++i)
+            levelSizes.Push(image->GetCompressedLevel(i).dataSize_);
+    }
+    else
+    {
+        unsigned levels = Texture::CheckMaxLevels(width, height, 0);
+        for (unsigned i = 0; i < levels; ++i)
+            levelSizes.Push(Max(width >> i, 1) * Max(height >> i, 1) * image->GetComponents());
+    }
+
+    // Find the first mip level small enough to be always resident
+    unsigned minLevel = 0;
+    while (minLevel + 1 < levelSizes.Size() && Max(width >> minLevel, height >> minLevel) > minResidentSize_)
+        ++minLevel;
+
+    // Nothing to stream if the texture is small or has no mip levels
+    if (!minLevel || texture->GetUsage() != TEXTURE_STATIC)
+    {
+        RemoveTexture(texture);
+        return false;
+    }
+
+    StreamedTexture& streamed = textures_[texture];
+    streamed.texture_ = texture;
+    streamed.levelSizes_ = levelSizes;
+    streamed.size_ = Max(width, height);
+    streamed.minLevel_ = minLevel;
+    streamed.residentLevel_ = minLevel;
+    streamed.requiredLevel_ = minLevel;
+    streamed.targetLevel_ = minLevel;
+    streamed.loading_ = false;
+
+    texture->SetStreamed(true);
+    texture->SetStreamingLevel(minLevel);
+    return true;
+}
+
+void TextureStreamer::RemoveTexture(Texture2D* texture)
+{
+    HashMap<Texture2D*, StreamedTexture>::Iterator i = textures_.Find(texture);
+    if (i != textures_.End())
+    {
+        texture->SetStreamed(false);
+        textures_.Erase(i);
+    }
+}
+
+void TextureStreamer::RequestMaterial(Material* material, float screenSize, i32 frameNumber)
+{
+    const HashMap<TextureUnit, SharedPtr<Texture>>& textures = material->GetTextures();
+
+    for (HashMap<TextureUnit, SharedPtr<Texture>>::ConstIterator i = textures.Begin(); i != textures.End(); ++i)
+    {
+        Texture* texture = i->second_.Get();
+        if (texture && texture->GetType() == Texture2D::GetTypeStatic())
+        {
+            auto* tex2D = static_cast<Texture2D*>(texture);
+            if (tex2D->IsStreamed())
+                tex2D->RequestStreaming(screenSize, frameNumber);
+        }
+    }
+}
+
+void TextureStreamer::Update(i32 frameNumber)
+{
+    URHO3D_PROFILE(UpdateTextureStreaming);
+
+    // Determine the mip levels required by the views. Textures not visible for a while fall back to the lowest detail
+    for (HashMap<Texture2D*, StreamedTexture>::Iterator i = textures_.Begin(); i != textures_.End();)
+    {
+        Texture2D* texture = i->second_.texture_;
+        if (!texture)
+        {
+            i = textures_.Erase(i);
+            continue;
+        }
+
+        StreamedTexture& streamed = i->second_;
+        i32 requestFrame = texture->GetStreamingFrame();
+        if (requestFrame >= 0 && frameNumber - requestFrame <= requestTimeout_)
+        {
+            unsigned level = CalculateRequiredLevel(streamed.size_, texture->GetStreamingScreenSize(), streamed.levelSizes_.Size());
+            streamed.requiredLevel_ = Min(level, streamed.minLevel_);
+        }
+        else
+            streamed.requiredLevel_ = streamed.minLevel_;
+
+        ++i;
+    }
+
+    // Find the smallest uniform mip level bias that fits the required levels within the memory budget
+    levelBias_ = 0;
+    for (;;)
+    {
+        unsigned long long totalMemory = 0;
+        bool canReduce = false;
+
+        for (HashMap<Texture2D*, StreamedTexture>::ConstIterator i = textures_.Begin(); i != textures_.End(); ++i)
+        {
+            const StreamedTexture& streamed = i->second_;
+            unsigned level = Min(streamed.requiredLevel_ + levelBias_, streamed.minLevel_);
+            totalMemory += GetLevelsMemory(streamed.levelSizes_, level);
+            if (level < streamed.minLevel_)
+                canReduce = true;
+        }
+
+        if (totalMemory <= memoryBudget_ || !canReduce)
+            break;
+
+        ++levelBias_;
+    }
+
+    for (HashMap<Texture2D*, StreamedTexture>::Iterator i = textures_.Begin(); i != textures_.End(); ++i)
+        i->second_.targetLevel_ = Min(i->second_.requiredLevel_ + levelBias_, i->second_.minLevel_);
+
+    // Start image loads for textures whose resident levels differ from the target. Stream out first to free memory
+    i32 numPendingLoads = GetNumPendingLoads();
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        bool streamOut = pass == 0;
+
+        for (HashMap<Texture2D*, StreamedTexture>::Iterator i = textures_.Begin(); i != textures_.End() &&
+            numPendingLoads < maxPendingLoads_; ++i)
+        {
+            StreamedTexture& streamed = i->second_;
+            if (streamed.loading_ || streamed.targetLevel_ == streamed.residentLevel_ ||
+                (streamed.targetLevel_ > streamed.residentLevel_) != streamOut)
+                continue;
+
+            RequestLevelData(streamed);
+            if (streamed.loading_)
+                ++numPendingLoads;
+        }
+    }
+}
+
+bool TextureStreamer::SetLevelData(Texture2D* texture, Image* image)
+{
+    HashMap<Texture2D*, StreamedTexture>::Iterator i = textures_.Find(texture);
+    if (i == textures_.End() || !image)
+        return false;
+
+    StreamedTexture& streamed = i->second_;
+    streamed.loading_ = false;
+
+    texture->SetStreamingLevel(streamed.targetLevel_);
+    // In headless mode there is no GPU data to update
+    bool success = !texture->GetGraphics() || texture->SetData(image);
+    if (success)
+        streamed.residentLevel_ = streamed.targetLevel_;
+    else
+    {
+        URHO3D_LOGERROR("Failed to stream mip levels of texture " + texture->GetName());
+        texture->SetStreamingLevel(streamed.residentLevel_);
+    }
+
+    return success;
+}
+
+unsigned long long TextureStreamer::GetMemoryUse() const
+{
+    unsigned long long totalMemory = 0;
+    for (HashMap<Texture2D*, StreamedTexture>::ConstIterator i = textures_.Begin(); i != textures_.End(); ++i)
+        totalMemory += GetLevelsMemory(i->second_.levelSizes_, i->second_.residentLevel_);
+    return totalMemory;
+}
+
+unsigned long long TextureStreamer::GetTargetMemoryUse() const
+{
+    unsigned long long totalMemory = 0;
+    for (HashMap<Texture2D*, StreamedTexture>::ConstIterator i = textures_.Begin(); i != textures_.End(); ++i)
+        totalMemory += GetLevelsMemory(i->second_.levelSizes_, i->second_.targetLevel_);
+    return totalMemory;
+}
+
+i32 TextureStreamer::GetNumPendingLoads() const
+{
+    i32 numPendingLoads = 0;
+    for (HashMap<Texture2D*, StreamedTexture>::ConstIterator i = textures_.Begin(); i != textures_.End(); ++i)
+    {
+        if (i->second_.loading_)
+            ++numPendingLoads;
+    }
+    return numPendingLoads;
+}
+
+const StreamedTexture* TextureStreamer::GetTexture(Texture2D* texture) const
+{
+    HashMap<Texture2D*, StreamedTexture>::ConstIterator i = textures_.Find(texture);
+    return i != textures_.End() ? &i->second_ : nullptr;
+}
+
+unsigned long long TextureStreamer::GetLevelsMemory(const Vector<unsigned>& levelSizes, unsigned level)
+{
+    unsigned long long totalMemory = 0;
+    for (unsigned i = level; i < (unsigned)levelSizes.Size(); ++i)
+        totalMemory += levelSizes[i];
+    return totalMemory;
+}
+
+unsigned TextureStreamer::CalculateRequiredLevel(int textureSize, float screenSize, unsigned numLevels)
+{
+    if (!numLevels)
+        return 0;
+    if (screenSize < 1.0f)
+        return numLevels - 1;
+
+    // Each mip level halves the texture size, so the level is the base two logarithm of the texel to pixel ratio
+    float ratio = (float)textureSize / screenSize;
+    unsigned level = ratio >= 2.0f ? LogBaseTwo((unsigned)ratio) : 0;
+    return Min(level, numLevels - 1);
+}
+
+float TextureStreamer::CalculateScreenSize(Drawable* drawable, Camera* camera, int viewHeight)
+{
+    if (!drawable || !camera || viewHeight <= 0)
+        return 0.0f;
+
+    Vector3 size = drawable->GetWorldBoundingBox().Size();
+    float extent = Max(Max(size.x_, size.y_), size.z_);
+
+    float viewExtent;
+    if (camera->IsOrthographic())
+        viewExtent = camera->GetOrthoSize();
+    else
+        viewExtent = 2.0f * Max(drawable->GetDistance(), camera->GetNearClip()) * Tan(camera->GetFov() * 0.5f);
+    viewExtent /= camera->GetZoom();
+
+    return viewExtent > M_EPSILON ? extent / viewExtent * viewHeight : (float)viewHeight;
+}
+
+void TextureStreamer::RequestLevelData(StreamedTexture& streamed)
+{
+    Texture2D* texture = streamed.texture_;
+    auto* cache = GetSubsystem<ResourceCache>();
+    if (!cache || texture->GetName().Empty())
+        return;
+
+    // Load the image data in the background for both streaming in and out. Streaming out to a smaller mip level frees
+    // texture memory, so it gets the higher background load priority
+    const String& name = texture->GetName();
+    streamed.loading_ = true;
+    cache->BackgroundLoadResource<Image>(name, true, nullptr, streamed.targetLevel_ > streamed.residentLevel_ ? 1 : 0);
+
+    // If the image is already loaded, or was loaded synchronously without threading support, use it immediately
+    Image* image = cache->GetExistingResource<Image>(name);
+    if (image)
+    {
+        SetLevelData(texture, image);
+        cache->ReleaseResource<Image>(name);
+    }
+}
+
+void TextureStreamer::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    if (textures_.Empty())
+        return;
+
+    auto* time = GetSubsystem<Time>();
+    if (time)
+        Update(time->GetFrameNumber());
+}
+
+void TextureStreamer::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    auto* resource = static_cast<Resource*>(eventData[P_RESOURCE].GetPtr());
+    if (!resource || resource->GetType() != Image::GetTypeStatic())
+        return;
+
+    bool success = eventData[P_SUCCESS].GetBool();
+    bool found = false;
+
+    for (HashMap<Texture2D*, StreamedTexture>::Iterator i = textures_.Begin(); i != textures_.End(); ++i)
+    {
+        StreamedTexture& streamed = i->second_;
+        Texture2D* texture = streamed.texture_;
+        if (!streamed.loading_ || !texture || texture->GetNameHash() != resource->GetNameHash())
+            continue;
+
+        found = true;
+        if (success)
+            SetLevelData(texture, static_cast<Image*>(resource));
+        else
+        {
+            // Stop streaming the texture if its image can not be loaded
+            URHO3D_LOGWARNING("Could not load image data to stream texture " + texture->GetName());
+            streamed.loading_ = false;
+            streamed.minLevel_ = streamed.residentLevel_;
+        }
+    }
+
+    // Do not keep the image data in the resource cache unless it is used elsewhere
+    if (found && success)
+    {
+        auto* cache = GetSubsystem<ResourceCache>();
+        if (cache)
+            cache->ReleaseResource<Image>(resource->GetName());
+    }
+}
+
+}
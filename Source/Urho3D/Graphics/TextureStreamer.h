@@ -0,0 +1,151 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+class Camera;
+class Drawable;
+class Image;
+class Material;
+class Texture2D;
+
+/// Mip residency state of a streamed texture.
+struct StreamedTexture
+{
+    /// Texture.
+    WeakPtr<Texture2D> texture_;
+    /// Memory use in bytes of each mip level of the source image.
+    Vector<unsigned> levelSizes_;
+    /// Larger dimension of the source image.
+    int size_{};
+    /// Lowest detail mip level, which is always resident.
+    unsigned minLevel_{};
+    /// Highest detail mip level currently resident.
+    unsigned residentLevel_{};
+    /// Mip level the views want resident.
+    unsigned requiredLevel_{};
+    /// Mip level to stream to within the memory budget.
+    unsigned targetLevel_{};
+    /// Image data load in progress flag.
+    bool loading_{};
+};
+
+/// %Texture streaming subsystem. Keeps only the low detail mip levels of Texture2D resources resident, and streams higher mip levels in and out through the background loader according to their screen-space size and a memory budget.
+class URHO3D_API TextureStreamer : public Object
+{
+    URHO3D_OBJECT(TextureStreamer, Object);
+
+public:
+    /// Construct.
+    explicit TextureStreamer(Context* context);
+    /// Destruct.
+    ~TextureStreamer() override;
+
+    /// Enable or disable streaming of textures loaded afterward. Default false.
+    /// @property
+    void SetEnabled(bool enable);
+    /// Set memory budget in bytes for the streamed textures. Default 256 MB.
+    /// @property
+    void SetMemoryBudget(unsigned long long budget);
+    /// Set the size in pixels at and below which mip levels are always resident. Default 64.
+    /// @property
+    void SetMinResidentSize(int size);
+    /// Set maximum number of image loads in progress. Default 4.
+    /// @property
+    void SetMaxPendingLoads(i32 num);
+    /// Set how many frames a texture keeps its required mip level after it was last visible. Default 60.
+    /// @property
+    void SetRequestTimeout(i32 frames);
+
+    /// Register a texture for streaming from its loaded image data and set the initially resident mip level. Return true if the texture is streamed.
+    bool AddTexture(Texture2D* texture, Image* image);
+    /// Unregister a texture. Its resident mip levels are kept.
+    void RemoveTexture(Texture2D* texture);
+    /// Request the mip levels of the streamed textures in a material for a drawable's screen-space size in pixels. Called by View.
+    void RequestMaterial(Material* material, float screenSize, i32 frameNumber);
+    /// Update required and target mip levels and start the necessary image loads. Called on end of frame.
+    void Update(i32 frameNumber);
+    /// Upload the target mip levels of a streamed texture from loaded image data. Return true if successful.
+    bool SetLevelData(Texture2D* texture, Image* image);
+
+    /// Return whether streaming is enabled.
+    /// @property
+    bool IsEnabled() const { return enabled_; }
+
+    /// Return memory budget.
+    /// @property
+    unsigned long long GetMemoryBudget() const { return memoryBudget_; }
+
+    /// Return memory use of the resident mip levels.
+    /// @property
+    unsigned long long GetMemoryUse() const;
+    /// Return memory use of the target mip levels.
+    unsigned long long GetTargetMemoryUse() const;
+
+    /// Return the size at and below which mip levels are always resident.
+    /// @property
+    int GetMinResidentSize() const { return minResidentSize_; }
+
+    /// Return maximum number of image loads in progress.
+    /// @property
+    i32 GetMaxPendingLoads() const { return maxPendingLoads_; }
+
+    /// Return number of image loads in progress.
+    /// @property
+    i32 GetNumPendingLoads() const;
+
+    /// Return how many frames a texture keeps its required mip level after it was last visible.
+    /// @property
+    i32 GetRequestTimeout() const { return requestTimeout_; }
+
+    /// Return number of mip levels dropped from all required levels to fit the memory budget.
+    /// @property
+    unsigned GetLevelBias() const { return levelBias_; }
+
+    /// Return number of streamed textures.
+    /// @property
+    i32 GetNumTextures() const { return textures_.Size(); }
+
+    /// Return streaming state of a texture, or null if not streamed.
+    const StreamedTexture* GetTexture(Texture2D* texture) const;
+
+    /// Return memory use of an image's mip levels from the specified level onward.
+    static unsigned long long GetLevelsMemory(const Vector<unsigned>& levelSizes, unsigned level);
+    /// Return mip level for displaying a texture of the specified size at a screen-space size in pixels.
+    static unsigned CalculateRequiredLevel(int textureSize, float screenSize, unsigned numLevels);
+    /// Return approximate screen-space size in pixels of a drawable.
+    static float CalculateScreenSize(Drawable* drawable, Camera* camera, int viewHeight);
+
+private:
+    /// Start loading image data for a texture.
+    void RequestLevelData(StreamedTexture& streamed);
+    /// Handle end of frame.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle background loaded resource.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+
+    /// Streamed textures.
+    HashMap<Texture2D*, StreamedTexture> textures_;
+    /// Memory budget.
+    unsigned long long memoryBudget_;
+    /// Size at and below which mip levels are always resident.
+    int minResidentSize_;
+    /// Maximum number of image loads in progress.
+    i32 maxPendingLoads_;
+    /// Frames to keep the required mip level after last visible.
+    i32 requestTimeout_;
+    /// Mip levels dropped from required levels to fit the budget.
+    unsigned levelBias_;
+    /// Enabled flag.
+    bool enabled_;
+};
+
+}
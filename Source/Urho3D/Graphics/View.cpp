@@ -18,6 +18,7 @@
 #include "../Graphics/RenderPath.h"
 #include "../Graphics/Skybox.h"
 #include "../Graphics/Technique.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../Graphics/View.h"
 #include "../GraphicsAPI/GraphicsImpl.h"
 #include "../GraphicsAPI/ShaderVariation.h"
@@ -1173,9 +1174,14 @@ void View::GetBaseBatches()
 {
     URHO3D_PROFILE(GetBaseBatches);
 
+    TextureStreamer* streamer = renderer_->GetTextureStreamer();
+    if (!streamer->IsEnabled())
+        streamer = nullptr;
+
     for (Vector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
     {
         Drawable* drawable = *i;
+        float screenSize = -1.0f;
         UpdateGeometryType type = drawable->GetUpdateGeometryType();
         if (type == UPDATE_MAIN_THREAD)
             nonThreadedGeometries_.Push(drawable);
@@ -1194,6 +1200,14 @@ void View::GetBaseBatches()
             if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
                 CheckMaterialForAuxView(srcBatch.material_);
 
+            // Request streamed texture mip levels according to the drawable's screen-space size
+            if (streamer && srcBatch.material_)
+            {
+                if (screenSize < 0.0f)
+                    screenSize = TextureStreamer::CalculateScreenSize(drawable, cullCamera_, viewSize_.y_);
+                streamer->RequestMaterial(srcBatch.material_, screenSize, frame_.frameNumber_);
+            }
+
             Technique* tech = GetTechnique(drawable, srcBatch.material_);
             if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
                 continue;
@@ -8,6 +8,7 @@
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsEvents.h"
 #include "../Graphics/Renderer.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../GraphicsAPI/GraphicsImpl.h"
 #include "../GraphicsAPI/Texture2D.h"
 #include "../IO/FileSystem.h"
@@ -83,6 +84,13 @@ bool Texture2D::EndLoad()
     CheckTextureBudget(GetTypeStatic());
 
     SetParameters(loadParameters_);
+
+    // If texture streaming is enabled, upload only the low detail mip levels for now
+    auto* renderer = GetSubsystem<Renderer>();
+    TextureStreamer* streamer = renderer ? renderer->GetTextureStreamer() : nullptr;
+    if (streamer && streamer->IsEnabled())
+        streamer->AddTexture(this, loadImage_);
+
     bool success = SetData(loadImage_);
 
     loadImage_.Reset();
@@ -155,6 +163,17 @@ bool Texture2D::GetImage(Image& image) const
     return true;
 }
 
+void Texture2D::RequestStreaming(float screenSize, i32 frameNumber)
+{
+    if (frameNumber != streamingFrame_)
+    {
+        streamingFrame_ = frameNumber;
+        streamingScreenSize_ = screenSize;
+    }
+    else if (screenSize > streamingScreenSize_)
+        streamingScreenSize_ = screenSize;
+}
+
 SharedPtr<Image> Texture2D::GetImage() const
 {
     auto rawImage = MakeShared<Image>(context_);
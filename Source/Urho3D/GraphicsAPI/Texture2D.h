@@ -55,10 +55,29 @@ public:
     /// Get image data from zero mip level. Only RGB and RGBA textures are supported.
     SharedPtr<Image> GetImage() const;
 
+    /// Set whether mip levels are streamed by TextureStreamer. Called by TextureStreamer.
+    void SetStreamed(bool enable) { streamed_ = enable; }
+    /// Set the source image mip level to upload image data from. Called by TextureStreamer.
+    void SetStreamingLevel(unsigned level) { streamingLevel_ = level; }
+    /// Request streamed mip levels for a screen-space size in pixels. The largest size requested on a frame is kept.
+    void RequestStreaming(float screenSize, i32 frameNumber);
+
     /// Return render surface.
     /// @property
     RenderSurface* GetRenderSurface() const { return renderSurface_; }
 
+    /// Return whether mip levels are streamed.
+    bool IsStreamed() const { return streamed_; }
+
+    /// Return the source image mip level image data is uploaded from.
+    unsigned GetStreamingLevel() const { return streamingLevel_; }
+
+    /// Return the largest requested screen-space size on the last requested frame.
+    float GetStreamingScreenSize() const { return streamingScreenSize_; }
+
+    /// Return the frame number of the last streaming request.
+    i32 GetStreamingFrame() const { return streamingFrame_; }
+
 protected:
     /// Create the GPU texture.
     bool Create() override;
@@ -86,6 +105,8 @@ private:
 
     /// Handle render surface update event.
     void HandleRenderSurfaceUpdate(StringHash eventType, VariantMap& eventData);
+    /// Return number of source image mip levels to skip when setting data from an image.
+    unsigned GetImageMipsToSkip(MaterialQuality quality) const { return Max(mipsToSkip_[quality], streamingLevel_); }
 
     /// Render surface.
     SharedPtr<RenderSurface> renderSurface_;
@@ -93,6 +114,14 @@ private:
     SharedPtr<Image> loadImage_;
     /// Parameter file acquired during BeginLoad.
     SharedPtr<XMLFile> loadParameters_;
+    /// Source image mip level to upload from when streamed.
+    unsigned streamingLevel_{};
+    /// Largest requested screen-space size.
+    float streamingScreenSize_{};
+    /// Frame number of the last streaming request.
+    i32 streamingFrame_{-1};
+    /// Streamed flag.
+    bool streamed_{};
 };
 
 }
@@ -0,0 +1,179 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../Precompiled.h"
+
+#include "../IO/BitStream.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Return the largest value of a number of bits.
+static u32 GetMaxQuantizedValue(i32 bits)
+{
+    return bits >= 32 ? 0xffffffffu : (1u << (u32)bits) - 1u;
+}
+
+u32 QuantizeFloat(float value, float min, float max, i32 bits)
+{
+    if (max <= min)
+        return 0;
+
+    // Also maps NaN to the minimum
+    double t = ((double)value - min) / ((double)max - min);
+    if (!(t > 0.0))
+        return 0;
+    if (t >= 1.0)
+        return GetMaxQuantizedValue(bits);
+
+    return (u32)(t * GetMaxQuantizedValue(bits) + 0.5);
+}
+
+float DequantizeFloat(u32 value, float min, float max, i32 bits)
+{
+    return (float)(min + (double)value / GetMaxQuantizedValue(bits) * ((double)max - min));
+}
+
+BitWriter::BitWriter(Serializer& dest) :
+    dest_(dest),
+    pending_(0),
+    numPending_(0),
+    numBits_(0)
+{
+}
+
+BitWriter::~BitWriter()
+{
+    Flush();
+}
+
+i32 BitWriter::Write(const void* data, i32 size)
+{
+    if (size <= 0)
+        return 0;
+
+    // When byte aligned, pass the bytes through
+    if (!numPending_)
+    {
+        numBits_ += (i64)size * 8;
+        return dest_.Write(data, size);
+    }
+
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (i32 i = 0; i < size; ++i)
+        WriteBits(bytes[i], 8);
+
+    return size;
+}
+
+void BitWriter::WriteBits(u32 value, i32 numBits)
+{
+    if (numBits <= 0)
+        return;
+    if (numBits < 32)
+        value &= (1u << (u32)numBits) - 1u;
+    else
+        numBits = 32;
+
+    pending_ |= (u64)value << (u32)numPending_;
+    numPending_ += numBits;
+    numBits_ += numBits;
+
+    while (numPending_ >= 8)
+    {
+        dest_.WriteU8((u8)(pending_ & 0xffu));
+        pending_ >>= 8u;
+        numPending_ -= 8;
+    }
+}
+
+void BitWriter::WriteQuantizedFloat(float value, float min, float max, i32 bits)
+{
+    WriteBits(QuantizeFloat(value, min, max, bits), bits);
+}
+
+void BitWriter::Flush()
+{
+    if (numPending_)
+    {
+        dest_.WriteU8((u8)(pending_ & 0xffu));
+        numBits_ += 8 - numPending_;
+        pending_ = 0;
+        numPending_ = 0;
+    }
+}
+
+BitReader::BitReader(Deserializer& source) :
+    Deserializer(source.GetSize()),
+    source_(source),
+    pending_(0),
+    numPending_(0)
+{
+    position_ = source_.GetPosition();
+}
+
+i32 BitReader::Read(void* dest, i32 size)
+{
+    if (size <= 0)
+        return 0;
+
+    // When byte aligned, read the bytes directly
+    if (!numPending_)
+    {
+        i32 read = source_.Read(dest, size);
+        position_ = source_.GetPosition();
+        return read;
+    }
+
+    auto* bytes = static_cast<unsigned char*>(dest);
+    i32 read = 0;
+    for (; read < size && !IsEof(); ++read)
+        bytes[read] = (unsigned char)ReadBits(8);
+
+    return read;
+}
+
+i64 BitReader::Seek(i64 position)
+{
+    pending_ = 0;
+    numPending_ = 0;
+    position_ = source_.Seek(position);
+    return position_;
+}
+
+u32 BitReader::ReadBits(i32 numBits)
+{
+    if (numBits <= 0)
+        return 0;
+    if (numBits > 32)
+        numBits = 32;
+
+    while (numPending_ < numBits)
+    {
+        if (source_.IsEof())
+        {
+            // Pad with zero bits past the end
+            numPending_ = numBits;
+            break;
+        }
+
+        pending_ |= (u64)source_.ReadU8() << (u32)numPending_;
+        numPending_ += 8;
+    }
+
+    position_ = source_.GetPosition();
+
+    u32 value = (u32)(pending_ & (numBits < 32 ? (1ull << (u32)numBits) - 1ull : 0xffffffffull));
+    pending_ >>= (u32)numBits;
+    numPending_ -= numBits;
+    return value;
+}
+
+float BitReader::ReadQuantizedFloat(float min, float max, i32 bits)
+{
+    return DequantizeFloat(ReadBits(bits), min, max, bits);
+}
+
+}
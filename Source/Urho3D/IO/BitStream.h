@@ -0,0 +1,86 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+
+namespace Urho3D
+{
+
+/// Return quantized value of a float in a range, using a number of bits (1-32).
+URHO3D_API u32 QuantizeFloat(float value, float min, float max, i32 bits);
+/// Return float from a value quantized in a range.
+URHO3D_API float DequantizeFloat(u32 value, float min, float max, i32 bits);
+
+/// Bit-level writer on top of another stream. Bytes written through the Serializer interface are packed after the preceding bits. The last partial byte is written on Flush() or destruction.
+/// @nobind
+class URHO3D_API BitWriter : public Serializer
+{
+public:
+    /// Construct with the destination stream, which must not go out of scope before the writer.
+    explicit BitWriter(Serializer& dest);
+    /// Destruct. Flush the remaining bits.
+    ~BitWriter() override;
+
+    /// Write bytes after the preceding bits. Return number of bytes actually written.
+    i32 Write(const void* data, i32 size) override;
+
+    /// Write the lowest bits of a value (1-32).
+    void WriteBits(u32 value, i32 numBits);
+    /// Write a single bit.
+    void WriteBit(bool value) { WriteBits(value ? 1u : 0u, 1); }
+    /// Write a float quantized in a range using a number of bits (1-32).
+    void WriteQuantizedFloat(float value, float min, float max, i32 bits);
+    /// Pad the last partial byte with zero bits and write it.
+    void Flush();
+
+    /// Return number of bits written.
+    i64 GetNumBits() const { return numBits_; }
+
+private:
+    /// Destination stream.
+    Serializer& dest_;
+    /// Bits not yet written to the destination, least significant first.
+    u64 pending_;
+    /// Number of pending bits.
+    i32 numPending_;
+    /// Number of bits written.
+    i64 numBits_;
+};
+
+/// Bit-level reader on top of another stream, for reading data written by BitWriter. The remaining bits of the last partial byte are skipped when the reader is destroyed.
+/// @nobind
+class URHO3D_API BitReader : public Deserializer
+{
+public:
+    /// Construct with the source stream, which must not go out of scope before the reader.
+    explicit BitReader(Deserializer& source);
+
+    /// Read bytes after the preceding bits. Return number of bytes actually read.
+    i32 Read(void* dest, i32 size) override;
+    /// Set position in the source stream, discarding any pending bits. Return actual new position.
+    i64 Seek(i64 position) override;
+    /// Return whether the end of the source stream has been reached and no bits are pending.
+    bool IsEof() const override { return !numPending_ && source_.IsEof(); }
+
+    /// Read bits (1-32) into the lowest bits of a value. Missing bits past the end of the stream read as zero.
+    u32 ReadBits(i32 numBits);
+    /// Read a single bit.
+    bool ReadBit() { return ReadBits(1) != 0; }
+    /// Read a float quantized in a range using a number of bits (1-32).
+    float ReadQuantizedFloat(float min, float max, i32 bits);
+
+private:
+    /// Source stream.
+    Deserializer& source_;
+    /// Bits read from the source but not yet consumed, least significant first.
+    u64 pending_;
+    /// Number of pending bits.
+    i32 numPending_;
+};
+
+}
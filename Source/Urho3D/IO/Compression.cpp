@@ -6,15 +6,146 @@
 #include "../Container/ArrayPtr.h"
 #include "../IO/Compression.h"
 #include "../IO/Deserializer.h"
+#include "../IO/Log.h"
 #include "../IO/Serializer.h"
 #include "../IO/VectorBuffer.h"
 
 #include <LZ4/lz4.h>
 #include <LZ4/lz4hc.h>
+#include <ZStd/zdict.h>
+#include <ZStd/zstd.h>
+
+#include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Per-thread Zstandard contexts, reused between calls to avoid allocating workspace for every payload.
+struct ZStdContexts
+{
+    /// Construct.
+    ZStdContexts() :
+        compress_(ZSTD_createCCtx()),
+        decompress_(ZSTD_createDCtx())
+    {
+    }
+
+    /// Destruct.
+    ~ZStdContexts()
+    {
+        ZSTD_freeCCtx(compress_);
+        ZSTD_freeDCtx(decompress_);
+    }
+
+    /// Compression context.
+    ZSTD_CCtx* compress_;
+    /// Decompression context.
+    ZSTD_DCtx* decompress_;
+};
+
+static ZStdContexts& GetZStdContexts()
+{
+    static thread_local ZStdContexts contexts;
+    return contexts;
+}
+
+CompressionDictionary::CompressionDictionary() :
+    compressDict_(nullptr),
+    decompressDict_(nullptr),
+    id_(0),
+    level_(DEFAULT_ZSTD_COMPRESSION_LEVEL)
+{
+}
+
+CompressionDictionary::~CompressionDictionary()
+{
+    Release();
+}
+
+bool CompressionDictionary::SetData(const void* data, unsigned size, int level)
+{
+    Release();
+
+    if (!data || !size)
+        return false;
+
+    data_.Resize(size);
+    memcpy(data_.Buffer(), data, size);
+    level_ = level;
+    id_ = ZSTD_getDictID_fromDict(data_.Buffer(), data_.Size());
+    compressDict_ = ZSTD_createCDict(data_.Buffer(), data_.Size(), level_);
+    decompressDict_ = ZSTD_createDDict(data_.Buffer(), data_.Size());
+
+    if (!IsValid())
+    {
+        URHO3D_LOGERROR("Failed to create compression dictionary");
+        Release();
+        return false;
+    }
+
+    return true;
+}
+
+bool CompressionDictionary::Train(const Vector<Vector<byte>>& samples, unsigned maxSize, int level)
+{
+    if (samples.Empty() || !maxSize)
+        return false;
+
+    Vector<byte> sampleData;
+    Vector<size_t> sampleSizes;
+    sampleSizes.Reserve(samples.Size());
+    for (const Vector<byte>& sample : samples)
+    {
+        if (sample.Empty())
+            continue;
+        unsigned offset = sampleData.Size();
+        sampleData.Resize(offset + sample.Size());
+        memcpy(sampleData.Buffer() + offset, sample.Buffer(), sample.Size());
+        sampleSizes.Push(sample.Size());
+    }
+
+    Vector<byte> dictBuffer(maxSize);
+    size_t dictSize = ZDICT_trainFromBuffer(dictBuffer.Buffer(), dictBuffer.Size(), sampleData.Buffer(), sampleSizes.Buffer(),
+        sampleSizes.Size());
+    if (ZDICT_isError(dictSize))
+    {
+        URHO3D_LOGERRORF("Failed to train compression dictionary: %s", ZDICT_getErrorName(dictSize));
+        return false;
+    }
+
+    return SetData(dictBuffer.Buffer(), (unsigned)dictSize, level);
+}
+
+bool CompressionDictionary::Save(Serializer& dest) const
+{
+    if (!dest.WriteVLE(data_.Size()))
+        return false;
+    return dest.Write(data_.Buffer(), data_.Size()) == data_.Size();
+}
+
+bool CompressionDictionary::Load(Deserializer& source, int level)
+{
+    unsigned size = source.ReadVLE();
+    if (!size || size > source.GetSize() - source.GetPosition())
+        return false;
+
+    Vector<byte> data(size);
+    if (source.Read(data.Buffer(), size) != size)
+        return false;
+
+    return SetData(data.Buffer(), size, level);
+}
+
+void CompressionDictionary::Release()
+{
+    ZSTD_freeCDict((ZSTD_CDict*)compressDict_);
+    ZSTD_freeDDict((ZSTD_DDict*)decompressDict_);
+    compressDict_ = nullptr;
+    decompressDict_ = nullptr;
+    data_.Clear();
+    id_ = 0;
+}
+
 unsigned EstimateCompressBound(unsigned srcSize)
 {
     return (unsigned)LZ4_compressBound(srcSize);
@@ -103,4 +234,127 @@ VectorBuffer DecompressVectorBuffer(VectorBuffer& src)
     return ret;
 }
 
+unsigned EstimateCompressBound(unsigned srcSize, CompressionCodec codec)
+{
+    if (codec == COMPRESSION_ZSTD)
+        return (unsigned)ZSTD_compressBound(srcSize);
+    else
+        return (unsigned)LZ4_compressBound(srcSize);
+}
+
+unsigned CompressData(void* dest, unsigned destCapacity, const void* src, unsigned srcSize, CompressionCodec codec,
+    CompressionDictionary* dictionary, int level)
+{
+    if (!dest || !src || !srcSize)
+        return 0;
+
+    if (codec == COMPRESSION_ZSTD)
+    {
+        ZSTD_CCtx* context = GetZStdContexts().compress_;
+        size_t ret;
+        if (dictionary && dictionary->IsValid())
+            ret = ZSTD_compress_usingCDict(context, dest, destCapacity, src, srcSize, (const ZSTD_CDict*)dictionary->GetCompressDict());
+        else
+            ret = ZSTD_compressCCtx(context, dest, destCapacity, src, srcSize, level);
+        return ZSTD_isError(ret) ? 0 : (unsigned)ret;
+    }
+    else
+        return (unsigned)LZ4_compress_HC((const char*)src, (char*)dest, srcSize, destCapacity, 0);
+}
+
+unsigned DecompressData(void* dest, unsigned destSize, const void* src, unsigned srcSize, CompressionCodec codec,
+    CompressionDictionary* dictionary)
+{
+    if (!dest || !src || !destSize || !srcSize)
+        return 0;
+
+    if (codec == COMPRESSION_ZSTD)
+    {
+        ZSTD_DCtx* context = GetZStdContexts().decompress_;
+        size_t ret;
+        if (dictionary && dictionary->IsValid())
+            ret = ZSTD_decompress_usingDDict(context, dest, destSize, src, srcSize, (const ZSTD_DDict*)dictionary->GetDecompressDict());
+        else
+            ret = ZSTD_decompressDCtx(context, dest, destSize, src, srcSize);
+        return ZSTD_isError(ret) ? 0 : (unsigned)ret;
+    }
+    else
+    {
+        int ret = LZ4_decompress_safe((const char*)src, (char*)dest, srcSize, destSize);
+        return ret < 0 ? 0 : (unsigned)ret;
+    }
+}
+
+bool CompressStream(Serializer& dest, Deserializer& src, CompressionCodec codec, CompressionDictionary* dictionary)
+{
+    unsigned srcSize = src.GetSize() - src.GetPosition();
+    // Prepend the source and dest. data size in the stream so that we know to buffer & uncompress the right amount
+    if (!srcSize)
+    {
+        dest.WriteU32(0);
+        dest.WriteU32(0);
+        return true;
+    }
+
+    unsigned maxDestSize = EstimateCompressBound(srcSize, codec);
+    SharedArrayPtr<unsigned char> srcBuffer(new unsigned char[srcSize]);
+    SharedArrayPtr<unsigned char> destBuffer(new unsigned char[maxDestSize]);
+
+    if (src.Read(srcBuffer, srcSize) != srcSize)
+        return false;
+
+    unsigned destSize = CompressData(destBuffer.Get(), maxDestSize, srcBuffer.Get(), srcSize, codec, dictionary);
+    if (!destSize)
+        return false;
+
+    bool success = true;
+    success &= dest.WriteU32(srcSize);
+    success &= dest.WriteU32(destSize);
+    success &= dest.Write(destBuffer, destSize) == destSize;
+    return success;
+}
+
+bool DecompressStream(Serializer& dest, Deserializer& src, CompressionCodec codec, CompressionDictionary* dictionary)
+{
+    if (src.IsEof())
+        return false;
+
+    unsigned destSize = src.ReadU32();
+    unsigned srcSize = src.ReadU32();
+    if (!srcSize || !destSize)
+        return true; // No data
+
+    if (srcSize > src.GetSize())
+        return false; // Illegal source (packed data) size reported, possibly not valid data
+
+    SharedArrayPtr<unsigned char> srcBuffer(new unsigned char[srcSize]);
+    SharedArrayPtr<unsigned char> destBuffer(new unsigned char[destSize]);
+
+    if (src.Read(srcBuffer, srcSize) != srcSize)
+        return false;
+
+    if (DecompressData(destBuffer.Get(), destSize, srcBuffer.Get(), srcSize, codec, dictionary) != destSize)
+        return false;
+
+    return dest.Write(destBuffer, destSize) == destSize;
+}
+
+VectorBuffer CompressVectorBuffer(VectorBuffer& src, CompressionCodec codec, CompressionDictionary* dictionary)
+{
+    VectorBuffer ret;
+    src.Seek(0);
+    CompressStream(ret, src, codec, dictionary);
+    ret.Seek(0);
+    return ret;
+}
+
+VectorBuffer DecompressVectorBuffer(VectorBuffer& src, CompressionCodec codec, CompressionDictionary* dictionary)
+{
+    VectorBuffer ret;
+    src.Seek(0);
+    DecompressStream(ret, src, codec, dictionary);
+    ret.Seek(0);
+    return ret;
+}
+
 }
@@ -3,11 +3,8 @@
 
 #pragma once
 
-#ifdef URHO3D_IS_BUILDING
-#include "Urho3D.h"
-#else
-#include <Urho3D/Urho3D.h>
-#endif
+#include "../Container/Ptr.h"
+#include "../Container/Vector.h"
 
 namespace Urho3D
 {
@@ -16,6 +13,74 @@ class Deserializer;
 class Serializer;
 class VectorBuffer;
 
+/// Compression codec.
+enum CompressionCodec
+{
+    /// LZ4 high compression. Fastest decompression, moderate ratio.
+    COMPRESSION_LZ4 = 0,
+    /// Zstandard. Higher ratio, supports trained dictionaries for small payloads.
+    COMPRESSION_ZSTD,
+    /// Number of codecs.
+    MAX_COMPRESSION_CODECS
+};
+
+/// Default Zstandard compression level.
+static const int DEFAULT_ZSTD_COMPRESSION_LEVEL = 9;
+/// Default maximum size of a trained compression dictionary in bytes.
+static const unsigned DEFAULT_COMPRESSION_DICTIONARY_SIZE = 16384;
+
+/// Trained Zstandard dictionary for improving the compression ratio of small payloads such as network scene updates. Both the compressing and decompressing side must use the same dictionary.
+class URHO3D_API CompressionDictionary : public RefCounted
+{
+public:
+    /// Construct empty.
+    CompressionDictionary();
+    /// Destruct.
+    ~CompressionDictionary() override;
+
+    /// Prevent copy construction.
+    CompressionDictionary(const CompressionDictionary& rhs) = delete;
+    /// Prevent assignment.
+    CompressionDictionary& operator =(const CompressionDictionary& rhs) = delete;
+
+    /// Set from previously trained dictionary data. Return true on success.
+    bool SetData(const void* data, unsigned size, int level = DEFAULT_ZSTD_COMPRESSION_LEVEL);
+    /// Train from sample payloads. Return true on success. Zstandard needs a reasonable amount of samples (ideally hundreds) for the training to succeed.
+    bool Train(const Vector<Vector<byte>>& samples, unsigned maxSize = DEFAULT_COMPRESSION_DICTIONARY_SIZE, int level = DEFAULT_ZSTD_COMPRESSION_LEVEL);
+    /// Save the dictionary data to a stream. Return true on success.
+    bool Save(Serializer& dest) const;
+    /// Load the dictionary data from a stream. Return true on success.
+    bool Load(Deserializer& source, int level = DEFAULT_ZSTD_COMPRESSION_LEVEL);
+    /// Release the dictionary.
+    void Release();
+
+    /// Return the dictionary data.
+    const Vector<byte>& GetData() const { return data_; }
+    /// Return the dictionary ID embedded in the data, or 0 if none.
+    unsigned GetID() const { return id_; }
+    /// Return the compression level the dictionary was digested for.
+    int GetLevel() const { return level_; }
+    /// Return whether the dictionary is ready for use.
+    bool IsValid() const { return compressDict_ != nullptr && decompressDict_ != nullptr; }
+
+    /// Return the digested compression dictionary. Used internally.
+    void* GetCompressDict() const { return compressDict_; }
+    /// Return the digested decompression dictionary. Used internally.
+    void* GetDecompressDict() const { return decompressDict_; }
+
+private:
+    /// Dictionary data.
+    Vector<byte> data_;
+    /// Digested compression dictionary (ZSTD_CDict).
+    void* compressDict_;
+    /// Digested decompression dictionary (ZSTD_DDict).
+    void* decompressDict_;
+    /// Dictionary ID.
+    unsigned id_;
+    /// Compression level.
+    int level_;
+};
+
 /// Estimate and return worst case LZ4 compressed output size in bytes for given input size.
 URHO3D_API unsigned EstimateCompressBound(unsigned srcSize);
 /// Compress data using the LZ4 algorithm and return the compressed data size. The needed destination buffer worst-case size is given by EstimateCompressBound().
@@ -31,4 +96,21 @@ URHO3D_API VectorBuffer CompressVectorBuffer(VectorBuffer& src);
 /// Decompress a VectorBuffer produced using CompressVectorBuffer().
 URHO3D_API VectorBuffer DecompressVectorBuffer(VectorBuffer& src);
 
+/// Estimate and return worst case compressed output size in bytes for given input size and codec.
+URHO3D_API unsigned EstimateCompressBound(unsigned srcSize, CompressionCodec codec);
+/// Compress data using the specified codec and optional dictionary (Zstandard only). Return the compressed data size, or 0 on failure.
+URHO3D_API unsigned CompressData(void* dest, unsigned destCapacity, const void* src, unsigned srcSize, CompressionCodec codec,
+    CompressionDictionary* dictionary = nullptr, int level = DEFAULT_ZSTD_COMPRESSION_LEVEL);
+/// Decompress data using the specified codec and optional dictionary. The uncompressed data size must be known. Return the number of bytes decompressed, or 0 on failure.
+URHO3D_API unsigned DecompressData(void* dest, unsigned destSize, const void* src, unsigned srcSize, CompressionCodec codec,
+    CompressionDictionary* dictionary = nullptr);
+/// Compress a source stream (from current position to the end) to the destination stream using the specified codec. Return true on success.
+URHO3D_API bool CompressStream(Serializer& dest, Deserializer& src, CompressionCodec codec, CompressionDictionary* dictionary = nullptr);
+/// Decompress a source stream produced using CompressStream() with the same codec and dictionary. Return true on success.
+URHO3D_API bool DecompressStream(Serializer& dest, Deserializer& src, CompressionCodec codec, CompressionDictionary* dictionary = nullptr);
+/// Compress a VectorBuffer using the specified codec and return the compressed result buffer.
+URHO3D_API VectorBuffer CompressVectorBuffer(VectorBuffer& src, CompressionCodec codec, CompressionDictionary* dictionary = nullptr);
+/// Decompress a VectorBuffer produced using CompressVectorBuffer() with the same codec and dictionary.
+URHO3D_API VectorBuffer DecompressVectorBuffer(VectorBuffer& src, CompressionCodec codec, CompressionDictionary* dictionary = nullptr);
+
 }
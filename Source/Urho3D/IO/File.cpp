@@ -15,7 +15,6 @@
 #endif
 
 #include <cstdio>
-#include <LZ4/lz4.h>
 
 #include "../DebugNew.h"
 
@@ -79,6 +78,7 @@ File::File(Context* context) :
     readBufferSize_(0),
     offset_(0),
     checksum_(0),
+    codec_(COMPRESSION_LZ4),
     compressed_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
@@ -96,6 +96,7 @@ File::File(Context* context, const String& fileName, FileMode mode) :
     readBufferSize_(0),
     offset_(0),
     checksum_(0),
+    codec_(COMPRESSION_LZ4),
     compressed_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
@@ -114,6 +115,7 @@ File::File(Context* context, PackageFile* package, const String& fileName) :
     readBufferSize_(0),
     offset_(0),
     checksum_(0),
+    codec_(COMPRESSION_LZ4),
     compressed_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
@@ -152,6 +154,7 @@ bool File::Open(PackageFile* package, const String& fileName)
     checksum_ = entry->checksum_;
     size_ = entry->size_;
     compressed_ = package->IsCompressed();
+    codec_ = package->GetCompressionCodec();
 
     // Seek to beginning of package entry's file data
     SeekInternal(offset_);
@@ -224,7 +227,11 @@ i32 File::Read(void* dest, i32 size)
             if (!readBuffer_ || readBufferOffset_ >= readBufferSize_)
             {
                 u8 blockHeaderBytes[4];
-                ReadInternal(blockHeaderBytes, sizeof blockHeaderBytes);
+                if (!ReadInternal(blockHeaderBytes, sizeof blockHeaderBytes))
+                {
+                    URHO3D_LOGERROR("Error while reading from file " + GetName());
+                    return 0;
+                }
 
                 MemoryBuffer blockHeader(&blockHeaderBytes[0], sizeof blockHeaderBytes);
                 i32 unpackedSize = blockHeader.ReadU16();
@@ -233,12 +240,18 @@ i32 File::Read(void* dest, i32 size)
                 if (!readBuffer_)
                 {
                     readBuffer_ = new u8[unpackedSize];
-                    inputBuffer_ = new u8[LZ4_compressBound(unpackedSize)];
+                    inputBuffer_ = new u8[EstimateCompressBound(unpackedSize, codec_)];
                 }
 
-                /// \todo Handle errors
-                ReadInternal(inputBuffer_.Get(), packedSize);
-                LZ4_decompress_fast((const char*)inputBuffer_.Get(), (char*)readBuffer_.Get(), unpackedSize);
+                // A truncated or corrupt block must fail the read instead of handing out stale buffer contents
+                if (!ReadInternal(inputBuffer_.Get(), packedSize) ||
+                    DecompressData(readBuffer_.Get(), unpackedSize, inputBuffer_.Get(), packedSize, codec_) != (unsigned)unpackedSize)
+                {
+                    readBufferSize_ = 0;
+                    readBufferOffset_ = 0;
+                    URHO3D_LOGERROR("Error while decompressing file " + GetName());
+                    return 0;
+                }
 
                 readBufferSize_ = unpackedSize;
                 readBufferOffset_ = 0;
@@ -434,6 +447,7 @@ bool File::OpenInternal(const String& fileName, FileMode mode, bool fromPackage)
     Close();
 
     compressed_ = false;
+    codec_ = COMPRESSION_LZ4;
     readSyncNeeded_ = false;
     writeSyncNeeded_ = false;
 
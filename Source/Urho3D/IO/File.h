@@ -8,6 +8,7 @@
 #include "../Container/ArrayPtr.h"
 #include "../Core/Object.h"
 #include "../IO/AbstractFile.h"
+#include "../IO/Compression.h"
 
 #ifdef __ANDROID__
 struct SDL_RWops;
@@ -116,6 +117,8 @@ private:
     i64 offset_;
     /// Content checksum.
     hash32 checksum_;
+    /// Compression codec when reading from a compressed package file.
+    CompressionCodec codec_;
     /// Compression flag.
     bool compressed_;
     /// Synchronization needed before read -flag.
@@ -15,6 +15,7 @@ PackageFile::PackageFile(Context* context) :
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
+    codec_(COMPRESSION_LZ4),
     compressed_(false)
 {
 }
@@ -24,6 +25,7 @@ PackageFile::PackageFile(Context* context, const String& fileName, unsigned star
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
+    codec_(COMPRESSION_LZ4),
     compressed_(false)
 {
     Open(fileName, startOffset);
@@ -40,7 +42,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     // Check ID, then read the directory
     file->Seek(startOffset);
     String id = file->ReadFileID();
-    if (id != "UPAK" && id != "ULZ4")
+    if (id != "UPAK" && id != "ULZ4" && id != "UZST")
     {
         // If start offset has not been explicitly specified, also try to read package size from the end of file
         // to know how much we must rewind to find the package start
@@ -57,7 +59,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
             }
         }
 
-        if (id != "UPAK" && id != "ULZ4")
+        if (id != "UPAK" && id != "ULZ4" && id != "UZST")
         {
             URHO3D_LOGERROR(fileName + " is not a valid package file");
             return false;
@@ -67,7 +69,8 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     fileName_ = fileName;
     nameHash_ = fileName_;
     totalSize_ = file->GetSize();
-    compressed_ = id == "ULZ4";
+    compressed_ = id == "ULZ4" || id == "UZST";
+    codec_ = id == "UZST" ? COMPRESSION_ZSTD : COMPRESSION_LZ4;
 
     unsigned numFiles = file->ReadU32();
     checksum_ = file->ReadU32();
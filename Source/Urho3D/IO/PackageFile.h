@@ -4,6 +4,7 @@
 #pragma once
 
 #include "../Core/Object.h"
+#include "../IO/Compression.h"
 
 namespace Urho3D
 {
@@ -71,6 +72,9 @@ public:
     /// @property
     bool IsCompressed() const { return compressed_; }
 
+    /// Return the codec used for compressed file data. Only meaningful if the files are compressed.
+    CompressionCodec GetCompressionCodec() const { return codec_; }
+
     /// Return list of file names in the package.
     const Vector<String> GetEntryNames() const { return entries_.Keys(); }
 
@@ -87,6 +91,8 @@ private:
     unsigned totalDataSize_;
     /// Package file checksum.
     hash32 checksum_;
+    /// Compression codec.
+    CompressionCodec codec_;
     /// Compressed flag.
     bool compressed_;
 };
@@ -451,6 +451,21 @@ void CrowdAgent::SetNavigationPushiness(NavigationPushiness val)
     }
 }
 
+void CrowdAgent::SetCrowdManager(CrowdManager* crowdManager)
+{
+    if (!crowdManager || crowdManager == crowdManager_)
+        return;
+    if (crowdManager->GetScene() != GetScene())
+    {
+        URHO3D_LOGERROR("CrowdAgent can only join a crowd manager of its own scene");
+        return;
+    }
+
+    RemoveAgentFromCrowd();
+    crowdManager_ = crowdManager;
+    AddAgentToCrowd();
+}
+
 Vector3 CrowdAgent::GetPosition() const
 {
     const dtCrowdAgent* agent = GetDetourCrowdAgent();
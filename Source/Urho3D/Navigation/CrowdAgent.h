@@ -112,6 +112,9 @@ public:
     /// Set the agent's navigation pushiness.
     /// @property
     void SetNavigationPushiness(NavigationPushiness val);
+    /// Move the agent to the crowd of another crowd manager of the scene. By default the agent joins the first crowd manager of the scene.
+    /// @property
+    void SetCrowdManager(CrowdManager* crowdManager);
 
     /// Return the agent's position.
     /// @property
@@ -149,6 +152,10 @@ public:
     /// Return the agent id.
     int GetAgentCrowdId() const { return agentCrowdId_; }
 
+    /// Return the crowd manager of the agent's crowd.
+    /// @property
+    CrowdManager* GetCrowdManager() const { return crowdManager_; }
+
     /// Get the agent's max acceleration.
     /// @property
     float GetMaxAccel() const { return maxAccel_; }
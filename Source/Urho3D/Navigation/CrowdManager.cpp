@@ -5,6 +5,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../Navigation/CrowdAgent.h"
@@ -55,6 +56,33 @@ void CrowdAgentUpdateCallback(dtCrowdAgent* ag, float dt)
     static_cast<CrowdAgent*>(ag->params.userData)->OnCrowdUpdate(ag, dt);
 }
 
+/// Runs the agent update phases of a Detour crowd on the work queue.
+class CrowdTaskExecutor : public dtCrowdTaskExecutor
+{
+public:
+    /// Construct.
+    explicit CrowdTaskExecutor(WorkQueue* queue) :
+        queue_(queue)
+    {
+    }
+
+    /// Return the number of threads including the main thread.
+    int getThreadCount() const override { return queue_->GetNumThreads() + 1; }
+
+    /// Run the loop body over ranges of the items in the work queue threads and the main thread.
+    void parallelFor(int count, int minRange, dtCrowdTaskCallback task, void* context) override
+    {
+        queue_->ParallelFor(0, count, minRange, [task, context](i32 begin, i32 end, i32 threadIndex)
+        {
+            task(begin, end, threadIndex, context);
+        });
+    }
+
+private:
+    /// Work queue.
+    WorkQueue* queue_;
+};
+
 CrowdManager::CrowdManager(Context* context) :
     Component(context),
     maxAgents_(DEFAULT_MAX_AGENTS),
@@ -85,6 +113,7 @@ void CrowdManager::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Obstacle Avoidance Types", GetObstacleAvoidanceTypesAttr, SetObstacleAvoidanceTypesAttr,
         Variant::emptyVariantVector, AM_DEFAULT)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, obstacleAvoidanceTypesStructureElementNames);
+    URHO3D_ATTRIBUTE("Multithreaded", multithreaded_, false, AM_FILE);
 }
 
 void CrowdManager::ApplyAttributes()
@@ -532,16 +561,14 @@ Vector<CrowdAgent*> CrowdManager::GetAgents(Node* node, bool inCrowdFilter) cons
         node = GetScene();
     Vector<CrowdAgent*> agents;
     node->GetComponents<CrowdAgent>(agents, true);
-    if (inCrowdFilter)
+    // Skip the agents of the other crowds in the scene
+    Vector<CrowdAgent*>::Iterator i = agents.Begin();
+    while (i != agents.End())
     {
-        Vector<CrowdAgent*>::Iterator i = agents.Begin();
-        while (i != agents.End())
-        {
-            if ((*i)->IsInCrowd())
-                ++i;
-            else
-                i = agents.Erase(i);
-        }
+        if ((*i)->crowdManager_ == this && (!inCrowdFilter || (*i)->IsInCrowd()))
+            ++i;
+        else
+            i = agents.Erase(i);
     }
     return agents;
 }
@@ -660,9 +687,68 @@ void CrowdManager::Update(float delta)
 {
     assert(crowd_ && navigationMesh_);
     URHO3D_PROFILE(UpdateCrowd);
+    UpdateTaskExecutor(multithreaded_);
     crowd_->update(delta, nullptr);
 }
 
+void CrowdManager::UpdateCrowds(const Vector<CrowdManager*>& crowdManagers, float delta)
+{
+    Vector<WeakPtr<CrowdManager>> updated;
+    for (CrowdManager* crowdManager : crowdManagers)
+    {
+        if (crowdManager->crowd_ && crowdManager->navigationMesh_)
+            updated.Push(WeakPtr<CrowdManager>(crowdManager));
+    }
+    if (updated.Empty())
+        return;
+
+    // With fewer crowds than threads, rather split the agents of each crowd across the threads
+    auto* queue = updated[0]->GetSubsystem<WorkQueue>();
+    if (updated.Size() < 2 || !queue || updated.Size() < queue->GetNumThreads() + 1)
+    {
+        for (const WeakPtr<CrowdManager>& crowdManager : updated)
+        {
+            if (crowdManager)
+                crowdManager->Update(delta);
+        }
+        return;
+    }
+
+    // The crowds only read the navigation meshes, so they can be updated concurrently with their phases run serially
+    for (const WeakPtr<CrowdManager>& crowdManager : updated)
+    {
+        crowdManager->UpdateTaskExecutor(false);
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = WI_MAX_PRIORITY;
+        item->workFunction_ = UpdateCrowdWork;
+        item->start_ = &delta;
+        item->aux_ = crowdManager->crowd_;
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(WI_MAX_PRIORITY);
+
+    // Send the agent events in crowd order. Event handlers may remove crowd managers
+    for (const WeakPtr<CrowdManager>& crowdManager : updated)
+    {
+        if (crowdManager && crowdManager->crowd_)
+            crowdManager->crowd_->finishUpdate(delta);
+    }
+}
+
+void CrowdManager::UpdateTaskExecutor(bool enable)
+{
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (enable && queue && queue->GetNumThreads())
+    {
+        if (!taskExecutor_)
+            taskExecutor_ = std::make_unique<CrowdTaskExecutor>(queue);
+        if (!crowd_->setTaskExecutor(taskExecutor_.get()))
+            URHO3D_LOGERROR("Could not allocate the queries for a multithreaded crowd update");
+    }
+    else
+        crowd_->setTaskExecutor(nullptr);
+}
+
 const dtCrowdAgent* CrowdManager::GetDetourCrowdAgent(int agent) const
 {
     return crowd_ ? crowd_->getAgent(agent) : nullptr;
@@ -680,11 +766,39 @@ void CrowdManager::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap&
     {
         using namespace SceneSubsystemUpdate;
 
-        if (IsEnabledEffective())
-            Update(eventData[P_TIMESTEP].GetFloat());
+        if (!IsEnabledEffective())
+            return;
+
+        const float timeStep = eventData[P_TIMESTEP].GetFloat();
+        if (!multithreaded_)
+        {
+            Update(timeStep);
+            return;
+        }
+
+        // The first multithreaded crowd manager of the scene updates all of them, so that they can run concurrently
+        Vector<CrowdManager*> crowdManagers;
+        GetScene()->GetComponents<CrowdManager>(crowdManagers);
+        Vector<CrowdManager*>::Iterator i = crowdManagers.Begin();
+        while (i != crowdManagers.End())
+        {
+            if ((*i)->multithreaded_ && (*i)->crowd_ && (*i)->navigationMesh_ && (*i)->IsEnabledEffective())
+                ++i;
+            else
+                i = crowdManagers.Erase(i);
+        }
+
+        if (crowdManagers.Front() == this)
+            UpdateCrowds(crowdManagers, timeStep);
     }
 }
 
+void CrowdManager::UpdateCrowdWork(const WorkItem* item, i32 threadIndex)
+{
+    auto* crowd = reinterpret_cast<dtCrowd*>(item->aux_);
+    crowd->updateAgents(*reinterpret_cast<float*>(item->start_), nullptr);
+}
+
 void CrowdManager::HandleNavMeshChanged(StringHash eventType, VariantMap& eventData)
 {
     NavigationMesh* navMesh;
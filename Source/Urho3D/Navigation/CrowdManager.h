@@ -5,6 +5,8 @@
 
 #include "../Scene/Component.h"
 
+#include <memory>
+
 #ifdef DT_POLYREF64
 using dtPolyRef = uint64_t;
 #else
@@ -19,7 +21,9 @@ namespace Urho3D
 {
 
 class CrowdAgent;
+class CrowdTaskExecutor;
 class NavigationMesh;
+struct WorkItem;
 
 /// Parameter structure for obstacle avoidance params (copied from DetourObstacleAvoidance.h in order to hide Detour header from Urho3D library users).
 /// @pod
@@ -37,7 +41,7 @@ struct CrowdObstacleAvoidanceParams
     u8 adaptiveDepth;    ///< adaptive
 };
 
-/// Crowd manager scene component. Should be added only to the root scene node.
+/// Crowd manager scene component. Should be added only to the root scene node. A scene may have several crowd managers, also sharing a navigation mesh.
 class URHO3D_API CrowdManager : public Component
 {
     URHO3D_OBJECT(CrowdManager, Component);
@@ -87,6 +91,13 @@ public:
     void SetObstacleAvoidanceTypesAttr(const VariantVector& value);
     /// Set the params for the specified obstacle avoidance type.
     void SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, const CrowdObstacleAvoidanceParams& params);
+    /// Set whether to update the agents on the work queue threads. The multithreaded crowd managers of a scene are also updated concurrently with each other. The agent events are still sent from the main thread. Disabled by default.
+    /// @property
+    void SetMultithreaded(bool enable) { multithreaded_ = enable; }
+
+    /// Update several crowds at once. With at least as many crowds as work queue threads the crowds are updated concurrently, otherwise the agents of each crowd are split across the threads if it is multithreaded. The agent events are sent afterwards from the main thread, crowd by crowd.
+    /// @nobind
+    static void UpdateCrowds(const Vector<CrowdManager*>& crowdManagers, float delta);
 
     /// Get all the crowd agent components in the specified node hierarchy. If the node is not specified then use scene node. When inCrowdFilter is set to true then only get agents that are in the crowd.
     Vector<CrowdAgent*> GetAgents(Node* node = nullptr, bool inCrowdFilter = true) const;
@@ -113,6 +124,10 @@ public:
     /// @property
     float GetMaxAgentRadius() const { return maxAgentRadius_; }
 
+    /// Return whether the agents are updated on the work queue threads.
+    /// @property
+    bool IsMultithreaded() const { return multithreaded_; }
+
     /// Get the Navigation mesh assigned to the crowd.
     /// @property{get_navMesh}
     NavigationMesh* GetNavigationMesh() const { return navigationMesh_; }
@@ -155,6 +170,8 @@ protected:
     void OnSceneSet(Scene* scene) override;
     /// Update the crowd simulation.
     void Update(float delta);
+    /// Set or clear the task executor of the internal Detour crowd depending on the multithreaded flag and the work queue threads.
+    void UpdateTaskExecutor(bool enable);
     /// Get the detour crowd agent.
     const dtCrowdAgent* GetDetourCrowdAgent(int agent) const;
     /// Get the detour query filter.
@@ -170,6 +187,8 @@ private:
     void HandleNavMeshChanged(StringHash eventType, VariantMap& eventData);
     /// Handle component added in the scene to check for late addition of the navmesh.
     void HandleComponentAdded(StringHash eventType, VariantMap& eventData);
+    /// Update the agents of a crowd in a work item.
+    static void UpdateCrowdWork(const WorkItem* item, i32 threadIndex);
 
     /// Internal Detour crowd object.
     dtCrowd* crowd_{};
@@ -187,6 +206,10 @@ private:
     Vector<unsigned> numAreas_;
     /// Number of obstacle avoidance types configured in the crowd. Limit to DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS.
     unsigned numObstacleAvoidanceTypes_{};
+    /// Runs the agent update phases on the work queue.
+    std::unique_ptr<CrowdTaskExecutor> taskExecutor_;
+    /// Multithreaded update flag.
+    bool multithreaded_{};
 };
 
 }
@@ -89,8 +89,6 @@ public:
     bool GetDrawObstacles() const { return drawObstacles_; }
 
 protected:
-    struct TileCacheData;
-
     /// Subscribe to events when assigned to a scene.
     void OnSceneSet(Scene* scene) override;
     /// Trigger the tile cache to make updates to the nav mesh if necessary.
@@ -103,10 +101,12 @@ protected:
     /// Used by Obstacle class to remove itself from the tile cache, if 'silent' an event will not be raised.
     void RemoveObstacle(Obstacle*, bool silent = false);
 
-    /// Build one tile of the navigation mesh. Return true if successful.
-    int BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles);
-    /// Build tiles in the rectangular area. Return number of built tiles.
-    unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Create the build data of a tile and gather its geometry.
+    std::unique_ptr<NavBuildData> CreateTileBuildData(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& tile) override;
+    /// Build the compressed tile cache layers of a tile from its gathered geometry. Return true if successful.
+    bool BuildTileData(NavBuildData* build) const override;
+    /// Replace the layers of a tile in the tile cache and the navigation mesh with the built layers. Return number of added layers.
+    unsigned AddTileData(NavBuildData* build) override;
     /// Off-mesh connections to be rebuilt in the mesh processor.
     Vector<OffMeshConnection*> CollectOffMeshConnections(const BoundingBox& bounds);
     /// Release the navigation mesh, query, and tile cache.
@@ -5,6 +5,7 @@
 
 #include "../Navigation/NavBuildData.h"
 
+#include <Detour/DetourAlloc.h>
 #include <DetourTileCache/DetourTileCacheBuilder.h>
 #include <Recast/Recast.h>
 
@@ -12,6 +13,7 @@ namespace Urho3D
 {
 
 NavBuildData::NavBuildData() :
+    success_(false),
     ctx_(new rcContext(true)),
     heightField_(nullptr),
     compactHeightField_(nullptr)
@@ -32,7 +34,9 @@ SimpleNavBuildData::SimpleNavBuildData() :
     NavBuildData(),
     contourSet_(nullptr),
     polyMesh_(nullptr),
-    polyMeshDetail_(nullptr)
+    polyMeshDetail_(nullptr),
+    navData_(nullptr),
+    navDataSize_(0)
 {
 }
 
@@ -44,6 +48,8 @@ SimpleNavBuildData::~SimpleNavBuildData()
     polyMesh_ = nullptr;
     rcFreePolyMeshDetail(polyMeshDetail_);
     polyMeshDetail_ = nullptr;
+    dtFree(navData_);
+    navData_ = nullptr;
 }
 
 DynamicNavBuildData::DynamicNavBuildData(dtTileCacheAlloc* allocator) :
@@ -64,6 +70,9 @@ DynamicNavBuildData::~DynamicNavBuildData()
     polyMesh_ = nullptr;
     rcFreeHeightfieldLayerSet(heightFieldLayers_);
     heightFieldLayers_ = nullptr;
+    for (unsigned char* data : layerData_)
+        dtFree(data);
+    layerData_.Clear();
 }
 
 }
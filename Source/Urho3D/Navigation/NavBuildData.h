@@ -5,6 +5,7 @@
 
 #include "../Container/Vector.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 
 class rcContext;
@@ -41,6 +42,10 @@ struct URHO3D_API NavBuildData
 
     /// World-space bounding box of the navigation mesh tile.
     BoundingBox worldBoundingBox_;
+    /// Index of the tile being built.
+    IntVector2 tile_;
+    /// Whether the tile was built successfully. Set by the thread building it.
+    bool success_;
     /// Vertices from geometries.
     Vector<Vector3> vertices_;
     /// Triangle indices from geometries.
@@ -78,6 +83,10 @@ struct SimpleNavBuildData : public NavBuildData
     rcPolyMesh* polyMesh_;
     /// Recast detail poly mesh.
     rcPolyMeshDetail* polyMeshDetail_;
+    /// Detour tile data built from the meshes, freed unless added to the navigation mesh.
+    unsigned char* navData_;
+    /// Size of the Detour tile data.
+    int navDataSize_;
 };
 
 /// @nobind
@@ -96,6 +105,10 @@ struct DynamicNavBuildData : public NavBuildData
     rcHeightfieldLayerSet* heightFieldLayers_;
     /// Allocator from DynamicNavigationMesh instance.
     dtTileCacheAlloc* alloc_;
+    /// Compressed tile cache layers built from the heightfield layers, freed unless added to the tile cache.
+    Vector<unsigned char*> layerData_;
+    /// Sizes of the compressed tile cache layers.
+    Vector<int> layerDataSizes_;
 };
 
 }
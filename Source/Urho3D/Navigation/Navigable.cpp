@@ -5,6 +5,8 @@
 
 #include "../Core/Context.h"
 #include "../Navigation/Navigable.h"
+#include "../Navigation/NavigationMesh.h"
+#include "../Scene/Node.h"
 
 #include "../DebugNew.h"
 
@@ -19,7 +21,11 @@ Navigable::Navigable(Context* context) :
 {
 }
 
-Navigable::~Navigable() = default;
+Navigable::~Navigable()
+{
+    if (ownerMesh_)
+        ownerMesh_->NavigableRemoved(this);
+}
 
 void Navigable::RegisterObject(Context* context)
 {
@@ -29,9 +35,38 @@ void Navigable::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Recursive", recursive_, true, AM_DEFAULT);
 }
 
+void Navigable::OnSetEnabled()
+{
+    if (ownerMesh_)
+        ownerMesh_->NavigableChanged(this);
+}
+
 void Navigable::SetRecursive(bool enable)
 {
     recursive_ = enable;
+    if (ownerMesh_)
+        ownerMesh_->NavigableChanged(this);
+}
+
+void Navigable::OnSceneSet(Scene* scene)
+{
+    if (scene)
+    {
+        if (!ownerMesh_)
+        {
+            ownerMesh_ = node_->GetDerivedComponent<NavigationMesh>();
+            if (!ownerMesh_)
+                ownerMesh_ = node_->GetParentDerivedComponent<NavigationMesh>(true);
+        }
+        if (ownerMesh_)
+            ownerMesh_->NavigableChanged(this);
+    }
+    else
+    {
+        if (ownerMesh_)
+            ownerMesh_->NavigableRemoved(this);
+        ownerMesh_.Reset();
+    }
 }
 
 }
@@ -8,6 +8,8 @@
 namespace Urho3D
 {
 
+class NavigationMesh;
+
 /// Component which tags geometry for inclusion in the navigation mesh. Optionally auto-includes geometry from child nodes.
 class URHO3D_API Navigable : public Component
 {
@@ -22,6 +24,9 @@ public:
     /// @nobind
     static void RegisterObject(Context* context);
 
+    /// Handle enabled/disabled state change.
+    void OnSetEnabled() override;
+
     /// Set whether geometry is automatically collected from child nodes. Default true.
     /// @property
     void SetRecursive(bool enable);
@@ -30,9 +35,17 @@ public:
     /// @property
     bool IsRecursive() const { return recursive_; }
 
+protected:
+    /// Handle scene being assigned, identify our NavigationMesh.
+    void OnSceneSet(Scene* scene) override;
+
 private:
+    friend class NavigationMesh;
+
     /// Recursive flag.
     bool recursive_;
+    /// Navigation mesh we are rebuilt into when changed.
+    WeakPtr<NavigationMesh> ownerMesh_;
 };
 
 }
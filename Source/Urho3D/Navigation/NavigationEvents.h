@@ -47,6 +47,16 @@ URHO3D_EVENT(E_NAVIGATION_ALL_TILES_REMOVED, NavigationAllTilesRemoved)
     URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
 }
 
+/// Asynchronous path request has been searched.
+URHO3D_EVENT(E_NAVIGATION_PATH_COMPLETED, NavigationPathCompleted)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_REQUEST, Request); // unsigned
+    URHO3D_PARAM(P_SUCCESS, Success); // bool
+    URHO3D_PARAM(P_PATH, Path); // VariantVector of Vector3
+}
+
 /// Crowd agent formation.
 URHO3D_EVENT(E_CROWD_AGENT_FORMATION, CrowdAgentFormation)
 {
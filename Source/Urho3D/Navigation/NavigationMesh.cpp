@@ -4,7 +4,10 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -27,6 +30,7 @@
 #include "../Physics/CollisionShape.h"
 #endif
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/DetourNavMesh.h>
@@ -61,8 +65,12 @@ static const float DEFAULT_EDGE_MAX_LENGTH = 12.0f;
 static const float DEFAULT_EDGE_MAX_ERROR = 1.3f;
 static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
+static const int DEFAULT_PATH_REQUEST_TIME_SLICE = 1000;
+static const int DEFAULT_REBUILD_BUDGET = 2000;
 
 static const int MAX_POLYS = 2048;
+/// Tiles per thread gathered at a time for a multithreaded build.
+static const i32 TILES_PER_THREAD = 4;
 
 
 /// Temporary data for finding a path.
@@ -78,12 +86,181 @@ struct FindPathData
     unsigned char pathFlags_[MAX_POLYS]{};
 };
 
+/// Asynchronous path request.
+struct PathRequest
+{
+    /// Request ID.
+    u32 id_{};
+    /// Priority. Higher priorities are searched first.
+    int priority_{};
+    /// Start point in local space.
+    Vector3 start_;
+    /// End point in local space.
+    Vector3 end_;
+    /// Search extents for the nearest polygons of the start and end points.
+    Vector3 extents_;
+    /// Query filter.
+    dtQueryFilter filter_;
+    /// Polygon of the end point, set when the search starts.
+    dtPolyRef endRef_{};
+    /// State.
+    NavigationPathRequestState state_{NAVPATHREQUEST_QUEUED};
+    /// Whether a path was found.
+    bool success_{};
+    /// Path points in local space, set when the search finishes.
+    Vector<Vector3> localPoints_;
+    /// Path point flags, set when the search finishes.
+    Vector<unsigned char> flags_;
+    /// Path in world space, set when delivered.
+    Vector<NavigationPathPoint> path_;
+};
+
+/// Query searching one asynchronous path request at a time. The sliced search state lives in the query, so a request stays in the same slot until it finishes.
+struct PathQuerySlot
+{
+    /// Destruct.
+    ~PathQuerySlot() { dtFreeNavMeshQuery(query_); }
+
+    /// Detour query.
+    dtNavMeshQuery* query_{};
+    /// Request being searched, or null if none.
+    PathRequest* request_{};
+    /// Requests finished in the last update, to be delivered in the next.
+    Vector<u32> finished_;
+    /// Search iterations in the last update.
+    i32 numIterations_{};
+    /// Temporary data for finishing the path.
+    FindPathData pathData_;
+};
+
+/// Asynchronous path requests of a navigation mesh.
+struct PathRequestQueue
+{
+    /// Requests by ID. Pointers to the requests stay valid until they are erased.
+    HashMap<u32, PathRequest> requests_;
+    /// Queued requests, the next one to search at the back.
+    Vector<PathRequest*> queue_;
+    /// Mutex for taking requests from the queue during the search.
+    Mutex queueMutex_;
+    /// Query slots, one per thread.
+    Vector<std::unique_ptr<PathQuerySlot>> slots_;
+    /// Requests delivered in the last update, discarded in the next.
+    Vector<u32> delivered_;
+    /// Search time per update and slot in microseconds.
+    long long timeSlice_{};
+    /// Statistics.
+    NavigationPathRequestStats stats_;
+    /// Next request ID.
+    u32 nextId_{1};
+};
+
+/// Search iterations between checks of the time slice.
+static const int PATH_SEARCH_ITERATIONS = 32;
+
+/// Add a request to the queue after the queued requests of higher or equal priority, or before them when requeued.
+static void QueuePathRequest(PathRequestQueue* queue, PathRequest* request, bool requeue)
+{
+    i32 index = 0;
+    while (index < queue->queue_.Size() && (queue->queue_[index]->priority_ < request->priority_ ||
+        (requeue && queue->queue_[index]->priority_ == request->priority_)))
+        ++index;
+    queue->queue_.Insert(index, request);
+    request->state_ = NAVPATHREQUEST_QUEUED;
+}
+
+/// Finish the search of the request in a slot.
+static void FinishPathRequest(PathQuerySlot* slot, bool success)
+{
+    PathRequest* request = slot->request_;
+    request->success_ = success && !request->localPoints_.Empty();
+    slot->finished_.Push(request->id_);
+    slot->request_ = nullptr;
+}
+
+/// Search path requests in a slot until the queue is empty or the time slice is used up.
+static void SearchPathRequests(PathRequestQueue* queue, PathQuerySlot* slot)
+{
+    dtNavMeshQuery* query = slot->query_;
+    FindPathData& data = slot->pathData_;
+    HiresTimer timer;
+
+    while (timer.GetUSec(false) < queue->timeSlice_)
+    {
+        if (!slot->request_)
+        {
+            {
+                MutexLock lock(queue->queueMutex_);
+                if (queue->queue_.Empty())
+                    return;
+                slot->request_ = queue->queue_.Back();
+                queue->queue_.Pop();
+            }
+
+            PathRequest* request = slot->request_;
+            request->state_ = NAVPATHREQUEST_SEARCHING;
+            request->localPoints_.Clear();
+            request->flags_.Clear();
+
+            dtPolyRef startRef;
+            query->findNearestPoly(&request->start_.x_, &request->extents_.x_, &request->filter_, &startRef, nullptr);
+            query->findNearestPoly(&request->end_.x_, &request->extents_.x_, &request->filter_, &request->endRef_, nullptr);
+            if (!startRef || !request->endRef_ || dtStatusFailed(query->initSlicedFindPath(startRef, request->endRef_,
+                &request->start_.x_, &request->end_.x_, &request->filter_)))
+            {
+                FinishPathRequest(slot, false);
+                continue;
+            }
+        }
+
+        int numIterations = 0;
+        dtStatus status = query->updateSlicedFindPath(PATH_SEARCH_ITERATIONS, &numIterations);
+        slot->numIterations_ += numIterations;
+        if (dtStatusInProgress(status))
+            continue;
+
+        // The search fails also if the polygons on the path were removed from the navigation mesh meanwhile
+        int numPolys = 0;
+        if (dtStatusFailed(status) || dtStatusFailed(query->finalizeSlicedFindPath(data.polys_, &numPolys, MAX_POLYS)) ||
+            !numPolys)
+        {
+            FinishPathRequest(slot, false);
+            continue;
+        }
+
+        // If full path was not found, clamp end point to the end polygon
+        PathRequest* request = slot->request_;
+        Vector3 actualEnd = request->end_;
+        if (data.polys_[numPolys - 1] != request->endRef_)
+            query->closestPointOnPoly(data.polys_[numPolys - 1], &request->end_.x_, &actualEnd.x_, nullptr);
+
+        int numPathPoints = 0;
+        query->findStraightPath(&request->start_.x_, &actualEnd.x_, data.polys_, numPolys, &data.pathPoints_[0].x_,
+            data.pathFlags_, data.pathPolys_, &numPathPoints, MAX_POLYS);
+
+        request->localPoints_.Resize(numPathPoints);
+        request->flags_.Resize(numPathPoints);
+        for (int i = 0; i < numPathPoints; ++i)
+        {
+            request->localPoints_[i] = data.pathPoints_[i];
+            request->flags_[i] = data.pathFlags_[i];
+        }
+        FinishPathRequest(slot, true);
+    }
+}
+
+/// Work item function for searching path requests.
+static void SearchPathRequestsWork(const WorkItem* item, i32 threadIndex)
+{
+    SearchPathRequests(reinterpret_cast<PathRequestQueue*>(item->aux_), reinterpret_cast<PathQuerySlot*>(item->start_));
+}
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(nullptr),
     navMeshQuery_(nullptr),
     queryFilter_(new dtQueryFilter()),
     pathData_(new FindPathData()),
+    pathRequestTimeSlice_(DEFAULT_PATH_REQUEST_TIME_SLICE),
     tileSize_(DEFAULT_TILE_SIZE),
     cellSize_(DEFAULT_CELL_SIZE),
     cellHeight_(DEFAULT_CELL_HEIGHT),
@@ -103,7 +280,12 @@ NavigationMesh::NavigationMesh(Context* context) :
     partitionType_(NAVMESH_PARTITION_WATERSHED),
     keepInterResults_(false),
     drawOffMeshConnections_(false),
-    drawNavAreas_(false)
+    drawNavAreas_(false),
+    multithreadedBuild_(false),
+    incrementalRebuild_(false),
+    rebuildBudget_(DEFAULT_REBUILD_BUDGET),
+    geometryTracked_(false),
+    trackedGeometryDirty_(false)
 {
 }
 
@@ -138,6 +320,9 @@ void NavigationMesh::RegisterObject(Context* context)
         NAVMESH_PARTITION_WATERSHED, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw OffMeshConnections", GetDrawOffMeshConnections, SetDrawOffMeshConnections, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw NavAreas", GetDrawNavAreas, SetDrawNavAreas, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Multithreaded Build", IsMultithreadedBuild, SetMultithreadedBuild, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Incremental Rebuild", IsIncrementalRebuild, SetIncrementalRebuild, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Rebuild Budget", GetRebuildBudget, SetRebuildBudget, DEFAULT_REBUILD_BUDGET, AM_DEFAULT);
 }
 
 void NavigationMesh::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -376,6 +561,7 @@ bool NavigationMesh::Build()
 
     Vector<NavigationGeometryInfo> geometryList;
     CollectGeometries(geometryList);
+    changedNodes_.Clear();
 
     if (geometryList.Empty())
         return true; // Nothing to do
@@ -501,6 +687,93 @@ bool NavigationMesh::Build(const IntVector2& from, const IntVector2& to)
     return true;
 }
 
+void NavigationMesh::MarkTilesDirty(const BoundingBox& boundingBox)
+{
+    if (node_)
+        AddDirtyTiles(boundingBox.Transformed(node_->GetWorldTransform().Inverse()));
+}
+
+unsigned NavigationMesh::RebuildDirtyTiles()
+{
+    if (!navMesh_)
+        return 0;
+
+    // Start tracking the geometry if it was not collected yet, for example after loading the navigation data
+    if (incrementalRebuild_ && !geometryTracked_)
+    {
+        Vector<NavigationGeometryInfo> geometryList;
+        CollectGeometries(geometryList);
+    }
+
+    if (dirtyTiles_.Empty() && changedNodes_.Empty())
+        return 0;
+
+    URHO3D_PROFILE(RebuildDirtyTiles);
+
+    HiresTimer timer;
+
+    // The tiles under both the previous and the current geometry of the changed nodes are dirty
+    HashSet<WeakPtr<Node>> changedNodes;
+    changedNodes.Swap(changedNodes_);
+    for (const WeakPtr<Node>& node : changedNodes)
+    {
+        if (!node)
+            continue;
+
+        RemoveNodeGeometry(node);
+        if (node == node_ || node->IsChildOf(node_))
+        {
+            Vector<NavigationGeometryInfo> geometryList;
+            CollectNodeGeometries(geometryList, node);
+            for (const NavigationGeometryInfo& info : geometryList)
+                AddDirtyTiles(info.boundingBox_);
+        }
+    }
+
+    if (dirtyTiles_.Empty())
+        return 0;
+
+    // Use the tracked geometry instead of collecting the whole geometry again for every rebuild
+    Vector<NavigationGeometryInfo> collectedGeometry;
+    Vector<NavigationGeometryInfo>& geometryList = geometryTracked_ ? trackedGeometry_ : collectedGeometry;
+    if (!geometryTracked_)
+        CollectGeometries(collectedGeometry);
+    else if (trackedGeometryDirty_)
+    {
+        trackedGeometry_.Clear();
+        for (HashMap<Node*, Vector<NavigationGeometryInfo>>::ConstIterator i = nodeGeometries_.Begin(); i != nodeGeometries_.End(); ++i)
+            trackedGeometry_.Push(i->second_);
+        UpdateNavAreas(trackedGeometry_);
+        trackedGeometryDirty_ = false;
+    }
+
+    // Rebuild one tile per thread at a time until the budget is used up, always at least once
+    auto* queue = GetSubsystem<WorkQueue>();
+    const i32 batchSize = multithreadedBuild_ && queue ? queue->GetNumThreads() + 1 : 1;
+    unsigned numTiles = 0;
+    i32 next = 0;
+    while (next < dirtyTiles_.Size())
+    {
+        Vector<IntVector2> batch;
+        while (next < dirtyTiles_.Size() && batch.Size() < batchSize)
+        {
+            // Tiles rebuilt meanwhile by other means are no longer in the set
+            const IntVector2& tile = dirtyTiles_[next++];
+            if (dirtyTileSet_.Contains(tile))
+                batch.Push(tile);
+        }
+
+        numTiles += BuildTiles(geometryList, batch);
+        if (timer.GetUSec(false) >= rebuildBudget_)
+            break;
+    }
+    dirtyTiles_.Erase(0, next);
+
+    URHO3D_LOGDEBUG("Rebuilt " + String(numTiles) + " dirty tiles of the navigation mesh, " + String(dirtyTiles_.Size()) +
+        " remaining");
+    return numTiles;
+}
+
 Vector<byte> NavigationMesh::GetTileData(const IntVector2& tile) const
 {
     VectorBuffer ret;
@@ -689,34 +962,221 @@ void NavigationMesh::FindPath(Vector<NavigationPathPoint>& dest, const Vector3&
         NavigationPathPoint pt;
         pt.position_ = transform * pathData_->pathPoints_[i];
         pt.flag_ = (NavigationPathPointFlag)pathData_->pathFlags_[i];
+        pt.areaID_ = GetNavAreaID(pt.position_);
+
+        dest.Push(pt);
+    }
+}
+
+u32 NavigationMesh::RequestPath(const Vector3& start, const Vector3& end, const Vector3& extents, int priority,
+    const dtQueryFilter* filter)
+{
+    if (!InitializeQuery())
+        return 0;
+
+    if (!pathRequests_)
+        pathRequests_ = std::make_unique<PathRequestQueue>();
+
+    // The requests are searched and delivered on the scene post-update
+    SubscribeToScenePostUpdate();
+
+    const u32 requestId = pathRequests_->nextId_++;
+    if (!pathRequests_->nextId_)
+        pathRequests_->nextId_ = 1;
+
+    // Navigation data is in local space
+    const Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+    PathRequest& request = pathRequests_->requests_[requestId];
+    request.id_ = requestId;
+    request.priority_ = priority;
+    request.start_ = inverse * start;
+    request.end_ = inverse * end;
+    request.extents_ = extents;
+    request.filter_ = filter ? *filter : *queryFilter_;
+    QueuePathRequest(pathRequests_.get(), &request, false);
+
+    return requestId;
+}
+
+bool NavigationMesh::CancelPathRequest(u32 requestId)
+{
+    if (!pathRequests_)
+        return false;
+
+    HashMap<u32, PathRequest>::Iterator i = pathRequests_->requests_.Find(requestId);
+    if (i == pathRequests_->requests_.End())
+        return false;
+
+    PathRequest* request = &i->second_;
+    const bool pending = request->state_ == NAVPATHREQUEST_QUEUED || request->state_ == NAVPATHREQUEST_SEARCHING;
+    if (request->state_ == NAVPATHREQUEST_QUEUED)
+        pathRequests_->queue_.Remove(request);
+    else if (request->state_ == NAVPATHREQUEST_SEARCHING)
+    {
+        // Abandon an unfinished search. A finished one is skipped when delivering
+        for (const std::unique_ptr<PathQuerySlot>& slot : pathRequests_->slots_)
+        {
+            if (slot->request_ == request)
+                slot->request_ = nullptr;
+        }
+    }
+    else
+        pathRequests_->delivered_.Remove(requestId);
+
+    pathRequests_->requests_.Erase(i);
+    if (pending)
+        ++pathRequests_->stats_.numCancelled_;
+    return pending;
+}
+
+void NavigationMesh::UpdatePathRequests()
+{
+    if (!pathRequests_)
+        return;
+
+    URHO3D_PROFILE(UpdatePathRequests);
+
+    HiresTimer timer;
+    WeakPtr<NavigationMesh> self(this);
+    DeliverPathRequests();
+    // Event handlers may have removed the navigation mesh
+    if (self.Expired())
+        return;
 
-        // Walk through all NavAreas and find nearest
-        unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
-        float nearestDistance = M_LARGE_VALUE;
+    NavigationPathRequestStats& stats = pathRequests_->stats_;
+    stats.numIterationsLastUpdate_ = 0;
 
-        for (const WeakPtr<NavArea>& area : areas_)
+    if (!pathRequests_->queue_.Empty() || pathRequests_->delivered_.Size() + pathRequests_->queue_.Size() <
+        pathRequests_->requests_.Size())
+    {
+        if (InitializeQuery())
         {
-            if (area && area->IsEnabledEffective())
+            auto* queue = GetSubsystem<WorkQueue>();
+            const i32 numSlots = queue ? queue->GetNumThreads() + 1 : 1;
+            while (pathRequests_->slots_.Size() < numSlots)
+                pathRequests_->slots_.Push(std::make_unique<PathQuerySlot>());
+
+            pathRequests_->timeSlice_ = pathRequestTimeSlice_;
+
+            // Each slot is searched by one thread at a time, the main thread included
+            Vector<PathQuerySlot*> searched;
+            i32 numQueued = pathRequests_->queue_.Size();
+            for (const std::unique_ptr<PathQuerySlot>& slot : pathRequests_->slots_)
             {
-                BoundingBox bb = area->GetWorldBoundingBox();
-                if (bb.IsInside(pt.position_) == INSIDE)
+                if (!slot->request_ && !numQueued)
+                    continue;
+                if (!slot->request_)
+                    --numQueued;
+
+                if (!slot->query_)
                 {
-                    Vector3 areaWorldCenter = area->GetNode()->GetWorldPosition();
-                    float distance = (areaWorldCenter - pt.position_).LengthSquared();
-                    if (distance < nearestDistance)
+                    slot->query_ = dtAllocNavMeshQuery();
+                    if (!slot->query_ || dtStatusFailed(slot->query_->init(navMesh_, MAX_POLYS)))
                     {
-                        nearestDistance = distance;
-                        nearestNavAreaID = area->GetAreaID();
+                        URHO3D_LOGERROR("Could not init navigation mesh query for path requests");
+                        dtFreeNavMeshQuery(slot->query_);
+                        slot->query_ = nullptr;
+                        continue;
                     }
                 }
+
+                slot->numIterations_ = 0;
+                searched.Push(slot.get());
             }
+
+            if (searched.Size() == 1 || !queue || !queue->GetNumThreads())
+            {
+                for (PathQuerySlot* slot : searched)
+                    SearchPathRequests(pathRequests_.get(), slot);
+            }
+            else if (!searched.Empty())
+            {
+                for (PathQuerySlot* slot : searched)
+                {
+                    SharedPtr<WorkItem> item = queue->GetFreeItem();
+                    item->priority_ = WI_MAX_PRIORITY;
+                    item->workFunction_ = SearchPathRequestsWork;
+                    item->start_ = slot;
+                    item->aux_ = pathRequests_.get();
+                    queue->AddWorkItem(item);
+                }
+                queue->Complete(WI_MAX_PRIORITY);
+            }
+
+            for (PathQuerySlot* slot : searched)
+                stats.numIterationsLastUpdate_ += slot->numIterations_;
         }
-        pt.areaID_ = (unsigned char)nearestNavAreaID;
+    }
 
-        dest.Push(pt);
+    stats.lastUpdateUSec_ = timer.GetUSec(false);
+}
+
+void NavigationMesh::SetIncrementalRebuild(bool enable)
+{
+    incrementalRebuild_ = enable;
+    if (enable)
+    {
+        // The geometry is collected for tracking on the next update, unless built before that
+        SubscribeToScenePostUpdate();
+    }
+    else
+    {
+        UnsubscribeFromEvent(E_NODEADDED);
+        UnsubscribeFromEvent(E_NODEREMOVED);
+        UnsubscribeFromEvent(E_COMPONENTADDED);
+        UnsubscribeFromEvent(E_COMPONENTREMOVED);
+        geometryTracked_ = false;
+        nodeGeometries_.Clear();
+        trackedGeometry_.Clear();
+        trackedGeometryDirty_ = false;
+        changedNodes_.Clear();
     }
 }
 
+void NavigationMesh::SetRebuildBudget(int usec)
+{
+    rebuildBudget_ = Max(usec, 0);
+}
+
+void NavigationMesh::SetPathRequestTimeSlice(int usec)
+{
+    pathRequestTimeSlice_ = Max(usec, 1);
+}
+
+NavigationPathRequestState NavigationMesh::GetPathRequestState(u32 requestId) const
+{
+    if (!pathRequests_)
+        return NAVPATHREQUEST_NONE;
+
+    HashMap<u32, PathRequest>::ConstIterator i = pathRequests_->requests_.Find(requestId);
+    return i != pathRequests_->requests_.End() ? i->second_.state_ : NAVPATHREQUEST_NONE;
+}
+
+bool NavigationMesh::GetPathRequestResult(u32 requestId, Vector<NavigationPathPoint>& dest) const
+{
+    dest.Clear();
+    if (!pathRequests_)
+        return false;
+
+    HashMap<u32, PathRequest>::ConstIterator i = pathRequests_->requests_.Find(requestId);
+    if (i == pathRequests_->requests_.End() || i->second_.state_ != NAVPATHREQUEST_SUCCEEDED)
+        return false;
+
+    dest = i->second_.path_;
+    return true;
+}
+
+NavigationPathRequestStats NavigationMesh::GetPathRequestStats() const
+{
+    if (!pathRequests_)
+        return NavigationPathRequestStats();
+
+    NavigationPathRequestStats stats = pathRequests_->stats_;
+    stats.numQueued_ = pathRequests_->queue_.Size();
+    stats.numSearching_ = pathRequests_->requests_.Size() - stats.numQueued_ - pathRequests_->delivered_.Size();
+    return stats;
+}
+
 Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
 {
     if (!InitializeQuery())
@@ -934,14 +1394,69 @@ void NavigationMesh::CollectGeometries(Vector<NavigationGeometryInfo>& geometryL
 {
     URHO3D_PROFILE(CollectNavigationGeometry);
 
+    // The geometry is tracked again from scratch. The tiles under the previous geometry of the pending changes are still
+    // dirty, as the changes are not known to be covered by the build
+    for (const WeakPtr<Node>& node : changedNodes_)
+    {
+        if (node)
+            RemoveNodeGeometry(node);
+    }
+    nodeGeometries_.Clear();
+
+    CollectNodeGeometries(geometryList, node_);
+    UpdateNavAreas(geometryList);
+
+    if (incrementalRebuild_)
+    {
+        geometryTracked_ = true;
+        trackedGeometry_ = geometryList;
+        trackedGeometryDirty_ = false;
+
+        Scene* scene = GetScene();
+        if (scene && !HasSubscribedToEvent(scene, E_NODEADDED))
+        {
+            SubscribeToEvent(scene, E_NODEADDED, URHO3D_HANDLER(NavigationMesh, HandleNodeAdded));
+            SubscribeToEvent(scene, E_NODEREMOVED, URHO3D_HANDLER(NavigationMesh, HandleNodeRemoved));
+            SubscribeToEvent(scene, E_COMPONENTADDED, URHO3D_HANDLER(NavigationMesh, HandleComponentAdded));
+            SubscribeToEvent(scene, E_COMPONENTREMOVED, URHO3D_HANDLER(NavigationMesh, HandleComponentRemoved));
+        }
+    }
+}
+
+void NavigationMesh::CollectNodeGeometries(Vector<NavigationGeometryInfo>& geometryList, Node* node)
+{
+    const i32 start = geometryList.Size();
+    HashSet<Node*> processedNodes;
+
+    // A recursive Navigable above the node includes all of its geometry. Obstacles and crowd agents exclude the nodes
+    // under them
+    if (node != node_)
+    {
+        for (Node* parent = node->GetParent(); parent; parent = parent->GetParent())
+        {
+            if (parent->HasComponent<Obstacle>() || parent->HasComponent<CrowdAgent>())
+                break;
+
+            auto* navigable = parent->GetComponent<Navigable>();
+            if (navigable && navigable->IsEnabledEffective() && navigable->IsRecursive())
+            {
+                CollectGeometries(geometryList, node, processedNodes, true);
+                break;
+            }
+
+            if (parent == node_)
+                break;
+        }
+    }
+
     // Get Navigable components from child nodes, not from whole scene. This makes it possible to partition
     // the scene into several navigation meshes
     Vector<Navigable*> navigables;
-    node_->GetComponents<Navigable>(navigables, true);
+    node->GetComponents<Navigable>(navigables, true);
 
-    HashSet<Node*> processedNodes;
-    for (const Navigable* navigable : navigables)
+    for (Navigable* navigable : navigables)
     {
+        navigable->ownerMesh_ = this;
         if (navigable->IsEnabledEffective())
             CollectGeometries(geometryList, navigable->GetNode(), processedNodes, navigable->IsRecursive());
     }
@@ -949,7 +1464,7 @@ void NavigationMesh::CollectGeometries(Vector<NavigationGeometryInfo>& geometryL
     // Get offmesh connections
     Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
     Vector<OffMeshConnection*> connections;
-    node_->GetComponents<OffMeshConnection>(connections, true);
+    node->GetComponents<OffMeshConnection>(connections, true);
 
     for (OffMeshConnection* connection : connections)
     {
@@ -967,8 +1482,7 @@ void NavigationMesh::CollectGeometries(Vector<NavigationGeometryInfo>& geometryL
 
     // Get nav area volumes
     Vector<NavArea*> navAreas;
-    node_->GetComponents<NavArea>(navAreas, true);
-    areas_.Clear();
+    node->GetComponents<NavArea>(navAreas, true);
     for (NavArea* area : navAreas)
     {
         if (area->IsEnabledEffective())
@@ -977,9 +1491,30 @@ void NavigationMesh::CollectGeometries(Vector<NavigationGeometryInfo>& geometryL
             info.component_ = area;
             info.boundingBox_ = area->GetWorldBoundingBox();
             geometryList.Push(info);
-            areas_.Push(WeakPtr<NavArea>(area));
         }
     }
+
+    // Track the geometry by node, and listen to the nodes so that their movement marks the tiles dirty
+    if (incrementalRebuild_)
+    {
+        for (i32 i = start; i < geometryList.Size(); ++i)
+        {
+            Node* geometryNode = geometryList[i].component_->GetNode();
+            nodeGeometries_[geometryNode].Push(geometryList[i]);
+            geometryNode->AddListener(this);
+        }
+        trackedGeometryDirty_ = true;
+    }
+}
+
+void NavigationMesh::UpdateNavAreas(const Vector<NavigationGeometryInfo>& geometryList)
+{
+    areas_.Clear();
+    for (const NavigationGeometryInfo& info : geometryList)
+    {
+        if (info.component_->GetType() == NavArea::GetTypeStatic())
+            areas_.Push(WeakPtr<NavArea>(static_cast<NavArea*>(info.component_)));
+    }
 }
 
 void NavigationMesh::CollectGeometries(Vector<NavigationGeometryInfo>& geometryList, Node* node, HashSet<Node*>& processedNodes,
@@ -1065,6 +1600,10 @@ void NavigationMesh::GetTileGeometry(NavBuildData* build, Vector<NavigationGeome
 
     for (const NavigationGeometryInfo& navGeometry : geometryList)
     {
+        // Tracked geometry may have been disabled since it was collected
+        if (!navGeometry.component_->IsEnabledEffective())
+            continue;
+
         if (box.IsInsideFast(navGeometry.boundingBox_) != OUTSIDE)
         {
             const Matrix3x4& transform = navGeometry.transform_;
@@ -1114,7 +1653,8 @@ void NavigationMesh::GetTileGeometry(NavBuildData* build, Vector<NavigationGeome
                 case SHAPE_CONVEXHULL:
                     {
                         auto* data = static_cast<ConvexData*>(shape->GetGeometryData());
-                        if (!data)
+                        // Skip hulls still being cooked in the background
+                        if (!data || !data->cooked_)
                             continue;
 
                         unsigned numVertices = data->vertexCount_;
@@ -1227,6 +1767,180 @@ void NavigationMesh::AddTriMeshGeometry(NavBuildData* build, Geometry* geometry,
     }
 }
 
+void NavigationMesh::OnMarkedDirty(Node* node)
+{
+    if (!incrementalRebuild_ || !navMesh_)
+        return;
+
+    Scene* scene = GetScene();
+    /// \hack If scene already unassigned, or if it's being destroyed, do nothing
+    if (!scene || scene->Refs() == 0)
+        return;
+
+    // If within threaded update, remember the node and handle it later. The scene calls this again with the own node
+    if (scene->IsThreadedUpdate())
+    {
+        MutexLock lock(delayedDirtyNodesMutex_);
+        if (delayedDirtyNodes_.Empty())
+            scene->DelayedMarkedDirty(this);
+        delayedDirtyNodes_.Push(node);
+        return;
+    }
+
+    if (!delayedDirtyNodes_.Empty())
+    {
+        Vector<Node*> nodes;
+        nodes.Swap(delayedDirtyNodes_);
+        for (Node* delayedNode : nodes)
+            NodeMoved(delayedNode);
+        return;
+    }
+
+    NodeMoved(node);
+}
+
+void NavigationMesh::HandleNodeAdded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace NodeAdded;
+
+    MarkNodeChanged(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+}
+
+void NavigationMesh::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
+{
+    using namespace NodeRemoved;
+
+    RemoveNodeGeometry(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+}
+
+/// Return whether a component is collected as navigation geometry or affects which geometry is collected.
+static bool IsNavigationGeometryComponent(Component* component)
+{
+#ifdef URHO3D_PHYSICS
+    if (component->IsInstanceOf<CollisionShape>())
+        return true;
+#endif
+    return component->IsInstanceOf<StaticModel>() || component->IsInstanceOf<TerrainPatch>() ||
+        component->IsInstanceOf<Navigable>() || component->IsInstanceOf<OffMeshConnection>() ||
+        component->IsInstanceOf<NavArea>() || component->IsInstanceOf<Obstacle>() || component->IsInstanceOf<CrowdAgent>();
+}
+
+void NavigationMesh::HandleComponentAdded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ComponentAdded;
+
+    if (IsNavigationGeometryComponent(static_cast<Component*>(eventData[P_COMPONENT].GetPtr())))
+        MarkNodeChanged(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+}
+
+void NavigationMesh::HandleComponentRemoved(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ComponentRemoved;
+
+    // The component is destroyed after the event, so forget its geometry right away
+    if (IsNavigationGeometryComponent(static_cast<Component*>(eventData[P_COMPONENT].GetPtr())))
+    {
+        auto* node = static_cast<Node*>(eventData[P_NODE].GetPtr());
+        RemoveNodeGeometry(node);
+        MarkNodeChanged(node);
+    }
+}
+
+void NavigationMesh::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (!node_)
+        return;
+
+    // Rebuild first, so that the path searches see the changed tiles
+    RebuildDirtyTiles();
+    UpdatePathRequests();
+}
+
+void NavigationMesh::DeliverPathRequests()
+{
+    PathRequestQueue* queue = pathRequests_.get();
+    NavigationPathRequestStats& stats = queue->stats_;
+
+    // Results can be read until the next update
+    for (u32 requestId : queue->delivered_)
+        queue->requests_.Erase(requestId);
+    queue->delivered_.Clear();
+
+    for (const std::unique_ptr<PathQuerySlot>& slot : queue->slots_)
+    {
+        queue->delivered_.Push(slot->finished_);
+        slot->finished_.Clear();
+    }
+    // Skip the requests cancelled after finishing
+    Vector<u32>::Iterator i = queue->delivered_.Begin();
+    while (i != queue->delivered_.End())
+    {
+        if (queue->requests_.Contains(*i))
+            ++i;
+        else
+            i = queue->delivered_.Erase(i);
+    }
+    stats.numDeliveredLastUpdate_ = queue->delivered_.Size();
+    if (queue->delivered_.Empty())
+        return;
+
+    // Transform path result back to world space
+    const Matrix3x4& transform = node_->GetWorldTransform();
+    for (u32 requestId : queue->delivered_)
+    {
+        PathRequest& request = queue->requests_[requestId];
+        request.path_.Clear();
+        for (i32 j = 0; j < request.localPoints_.Size(); ++j)
+        {
+            NavigationPathPoint pt;
+            pt.position_ = transform * request.localPoints_[j];
+            pt.flag_ = (NavigationPathPointFlag)request.flags_[j];
+            pt.areaID_ = GetNavAreaID(pt.position_);
+            request.path_.Push(pt);
+        }
+        request.localPoints_.Clear();
+        request.flags_.Clear();
+
+        if (request.success_)
+        {
+            request.state_ = NAVPATHREQUEST_SUCCEEDED;
+            ++stats.numSucceeded_;
+        }
+        else
+        {
+            request.state_ = NAVPATHREQUEST_FAILED;
+            ++stats.numFailed_;
+        }
+    }
+
+    // Event handlers may request, cancel or even remove the navigation mesh, so iterate a copy
+    const Vector<u32> delivered = queue->delivered_;
+    WeakPtr<NavigationMesh> self(this);
+
+    using namespace NavigationPathCompleted;
+    for (u32 requestId : delivered)
+    {
+        if (self.Expired())
+            return;
+
+        HashMap<u32, PathRequest>::ConstIterator j = pathRequests_->requests_.Find(requestId);
+        if (j == pathRequests_->requests_.End())
+            continue;
+
+        VariantVector path;
+        for (const NavigationPathPoint& pt : j->second_.path_)
+            path.Push(pt.position_);
+
+        VariantMap& eventData = GetContext()->GetEventDataMap();
+        eventData[P_NODE] = GetNode();
+        eventData[P_MESH] = this;
+        eventData[P_REQUEST] = requestId;
+        eventData[P_SUCCESS] = j->second_.state_ == NAVPATHREQUEST_SUCCEEDED;
+        eventData[P_PATH] = path;
+        SendEvent(E_NAVIGATION_PATH_COMPLETED, eventData);
+    }
+}
+
 void NavigationMesh::WriteTile(Serializer& dest, int x, int z) const
 {
     const dtNavMesh* navMesh = navMesh_;
@@ -1276,18 +1990,10 @@ bool NavigationMesh::ReadTile(Deserializer& source, bool silent)
     return true;
 }
 
-bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z)
+void NavigationMesh::InitTileConfig(rcConfig& cfg, const IntVector2& tile) const
 {
-    URHO3D_PROFILE(BuildNavigationMeshTile);
-
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), nullptr, nullptr);
+    const BoundingBox tileBoundingBox = GetTileBoundingBox(tile);
 
-    const BoundingBox tileBoundingBox = GetTileBoundingBox(IntVector2(x, z));
-
-    SimpleNavBuildData build;
-
-    rcConfig cfg;       // NOLINT(hicpp-member-init)
     memset(&cfg, 0, sizeof cfg);
     cfg.cs = cellSize_;
     cfg.ch = cellHeight_;
@@ -1313,9 +2019,29 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     cfg.bmin[2] -= cfg.borderSize * cfg.cs;
     cfg.bmax[0] += cfg.borderSize * cfg.cs;
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
+}
+
+std::unique_ptr<NavBuildData> NavigationMesh::CreateTileBuildData(Vector<NavigationGeometryInfo>& geometryList,
+    const IntVector2& tile)
+{
+    auto build = std::make_unique<SimpleNavBuildData>();
+    build->tile_ = tile;
 
+    rcConfig cfg;       // NOLINT(hicpp-member-init)
+    InitTileConfig(cfg, tile);
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    GetTileGeometry(build.get(), geometryList, expandedBox);
+    return build;
+}
+
+bool NavigationMesh::BuildTileData(NavBuildData* buildData) const
+{
+    SimpleNavBuildData& build = *static_cast<SimpleNavBuildData*>(buildData);
+    const int x = build.tile_.x_;
+    const int z = build.tile_.y_;
+
+    rcConfig cfg;       // NOLINT(hicpp-member-init)
+    InitTileConfig(cfg, build.tile_);
 
     if (build.vertices_.Empty() || build.indices_.Empty())
         return true; // Nothing to do
@@ -1439,9 +2165,6 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
             build.polyMesh_->flags[i] = 0x1;
     }
 
-    unsigned char* navData = nullptr;
-    int navDataSize = 0;
-
     dtNavMeshCreateParams params;       // NOLINT(hicpp-member-init)
     memset(&params, 0, sizeof params);
     params.verts = build.polyMesh_->verts;
@@ -1478,21 +2201,37 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         params.offMeshConDir = &build.offMeshDir_[0];
     }
 
-    if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+    if (!dtCreateNavMeshData(&params, &build.navData_, &build.navDataSize_))
     {
         URHO3D_LOGERROR("Could not build navigation mesh tile data");
         return false;
     }
 
-    if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+    return true;
+}
+
+unsigned NavigationMesh::AddTileData(NavBuildData* buildData)
+{
+    auto* build = static_cast<SimpleNavBuildData*>(buildData);
+    const IntVector2& tile = build->tile_;
+
+    // Remove previous tile (if any)
+    navMesh_->removeTile(navMesh_->getTileRefAt(tile.x_, tile.y_, 0), nullptr, nullptr);
+    if (!build->navData_)
+        return 0;
+
+    if (dtStatusFailed(navMesh_->addTile(build->navData_, build->navDataSize_, DT_TILE_FREE_DATA, 0, nullptr)))
     {
         URHO3D_LOGERROR("Failed to add navigation mesh tile");
-        dtFree(navData);
-        return false;
+        return 0;
     }
+    // The navigation mesh owns the data now
+    build->navData_ = nullptr;
 
     // Send a notification of the rebuild of this tile to anyone interested
     {
+        const BoundingBox tileBoundingBox = GetTileBoundingBox(tile);
+
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
@@ -1501,24 +2240,75 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
         SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
-    return true;
+    return 1;
 }
 
-unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const Vector<IntVector2>& tiles)
 {
+    URHO3D_PROFILE(BuildNavigationMeshTiles);
+
+    auto* queue = GetSubsystem<WorkQueue>();
+    const bool multithreaded = multithreadedBuild_ && queue && queue->GetNumThreads();
+    // Gather the geometry for a few tiles per thread at a time, so that the geometry of large meshes is not all held at once
+    const i32 batchSize = multithreaded ? (queue->GetNumThreads() + 1) * TILES_PER_THREAD : 1;
     unsigned numTiles = 0;
 
-    for (int z = from.y_; z <= to.y_; ++z)
+    for (i32 batchStart = 0; batchStart < tiles.Size(); batchStart += batchSize)
     {
-        for (int x = from.x_; x <= to.x_; ++x)
+        const i32 batchEnd = Min(batchStart + batchSize, tiles.Size());
+        Vector<std::unique_ptr<NavBuildData>> builds;
+        for (i32 i = batchStart; i < batchEnd; ++i)
+            builds.Push(CreateTileBuildData(geometryList, tiles[i]));
+
+        if (builds.Size() > 1 && multithreaded)
         {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
+            for (const std::unique_ptr<NavBuildData>& build : builds)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = WI_MAX_PRIORITY;
+                item->workFunction_ = BuildTileWork;
+                item->start_ = build.get();
+                item->aux_ = this;
+                queue->AddWorkItem(item);
+            }
+            queue->Complete(WI_MAX_PRIORITY);
+        }
+        else
+        {
+            for (const std::unique_ptr<NavBuildData>& build : builds)
+                build->success_ = BuildTileData(build.get());
+        }
+
+        // Replace the tiles in order, so that the events are sent as without threads. Failed tiles are removed
+        for (const std::unique_ptr<NavBuildData>& build : builds)
+        {
+            numTiles += AddTileData(build.get());
+            dirtyTileSet_.Erase(build->tile_);
         }
     }
+
+    // Searches in progress may refer to the replaced tiles
+    RestartPathRequests(false);
     return numTiles;
 }
 
+unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+{
+    Vector<IntVector2> tiles;
+    for (int z = from.y_; z <= to.y_; ++z)
+    {
+        for (int x = from.x_; x <= to.x_; ++x)
+            tiles.Push(IntVector2(x, z));
+    }
+    return BuildTiles(geometryList, tiles);
+}
+
+void NavigationMesh::BuildTileWork(const WorkItem* item, i32 threadIndex)
+{
+    auto* build = reinterpret_cast<NavBuildData*>(item->start_);
+    build->success_ = reinterpret_cast<NavigationMesh*>(item->aux_)->BuildTileData(build);
+}
+
 bool NavigationMesh::InitializeQuery()
 {
     if (!navMesh_ || !node_)
@@ -1545,6 +2335,11 @@ bool NavigationMesh::InitializeQuery()
 
 void NavigationMesh::ReleaseNavigationMesh()
 {
+    // The path request queries refer to the navigation mesh. Unfinished searches start over on the next one
+    RestartPathRequests(true);
+    dirtyTiles_.Clear();
+    dirtyTileSet_.Clear();
+
     dtFreeNavMesh(navMesh_);
     navMesh_ = nullptr;
 
@@ -1556,6 +2351,159 @@ void NavigationMesh::ReleaseNavigationMesh()
     boundingBox_.Clear();
 }
 
+void NavigationMesh::NavigableChanged(Navigable* navigable)
+{
+    MarkNodeChanged(navigable->GetNode());
+}
+
+void NavigationMesh::NavigableRemoved(Navigable* navigable)
+{
+    // The geometry may be destroyed along with the Navigable, so forget it right away, and collect what other
+    // Navigables include of it later
+    Node* node = navigable->GetNode();
+    if (node)
+    {
+        RemoveNodeGeometry(node);
+        MarkNodeChanged(node);
+    }
+}
+
+void NavigationMesh::NodeMoved(Node* node)
+{
+    if (!node_)
+        return;
+
+    // The children of a node are dirtied along with it, while the parent of the node that moved was not dirty, so find
+    // the topmost dirty node
+    Node* moved = node;
+    while (moved->GetParent() && moved->GetParent()->IsDirty())
+        moved = moved->GetParent();
+
+    // Moving the navigation mesh node or its parents does not change the geometry in its space
+    if (moved != node_ && moved->IsChildOf(node_))
+        MarkNodeChanged(moved);
+}
+
+void NavigationMesh::MarkNodeChanged(Node* node)
+{
+    if (!incrementalRebuild_ || !navMesh_ || !node)
+        return;
+
+    changedNodes_.Insert(WeakPtr<Node>(node));
+    SubscribeToScenePostUpdate();
+}
+
+void NavigationMesh::RemoveNodeGeometry(Node* node)
+{
+    if (nodeGeometries_.Empty())
+        return;
+
+    Vector<Node*> nodes;
+    node->GetChildren(nodes, true);
+    nodes.Push(node);
+
+    for (Node* geometryNode : nodes)
+    {
+        HashMap<Node*, Vector<NavigationGeometryInfo>>::Iterator i = nodeGeometries_.Find(geometryNode);
+        if (i != nodeGeometries_.End())
+        {
+            for (const NavigationGeometryInfo& info : i->second_)
+                AddDirtyTiles(info.boundingBox_);
+            nodeGeometries_.Erase(i);
+            trackedGeometryDirty_ = true;
+        }
+    }
+}
+
+void NavigationMesh::AddDirtyTiles(const BoundingBox& geometryBox)
+{
+    if (!navMesh_ || !geometryBox.Defined())
+        return;
+
+    // The tiles gather geometry from within their border, so the geometry affects the tiles next to it too
+    const float border = (float)(CeilToInt(agentRadius_ / cellSize_) + 3) * cellSize_;
+    BoundingBox box(geometryBox);
+    box.min_ -= Vector3(border, 0.0f, border);
+    box.max_ += Vector3(border, 0.0f, border);
+    if (box.max_.x_ < boundingBox_.min_.x_ || box.max_.z_ < boundingBox_.min_.z_ || box.min_.x_ > boundingBox_.max_.x_ ||
+        box.min_.z_ > boundingBox_.max_.z_)
+        return;
+
+    const float tileEdgeLength = (float)tileSize_ * cellSize_;
+    const int sx = Clamp((int)((box.min_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
+    const int sz = Clamp((int)((box.min_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
+    const int ex = Clamp((int)((box.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
+    const int ez = Clamp((int)((box.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
+
+    for (int z = sz; z <= ez; ++z)
+    {
+        for (int x = sx; x <= ex; ++x)
+        {
+            const IntVector2 tile(x, z);
+            if (!dirtyTileSet_.Contains(tile))
+            {
+                dirtyTileSet_.Insert(tile);
+                dirtyTiles_.Push(tile);
+            }
+        }
+    }
+    SubscribeToScenePostUpdate();
+}
+
+void NavigationMesh::SubscribeToScenePostUpdate()
+{
+    // Do nothing while the scene is being destroyed
+    Scene* scene = GetScene();
+    if (scene && scene->Refs() > 0 && !HasSubscribedToEvent(scene, E_SCENEPOSTUPDATE))
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(NavigationMesh, HandleScenePostUpdate));
+}
+
+void NavigationMesh::RestartPathRequests(bool releaseQueries)
+{
+    if (!pathRequests_)
+        return;
+
+    for (const std::unique_ptr<PathQuerySlot>& slot : pathRequests_->slots_)
+    {
+        if (slot->request_)
+        {
+            QueuePathRequest(pathRequests_.get(), slot->request_, true);
+            slot->request_ = nullptr;
+        }
+        if (releaseQueries)
+        {
+            dtFreeNavMeshQuery(slot->query_);
+            slot->query_ = nullptr;
+        }
+    }
+}
+
+unsigned char NavigationMesh::GetNavAreaID(const Vector3& position) const
+{
+    // Walk through all NavAreas and find nearest
+    unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
+    float nearestDistance = M_LARGE_VALUE;
+
+    for (const WeakPtr<NavArea>& area : areas_)
+    {
+        if (area && area->IsEnabledEffective())
+        {
+            BoundingBox bb = area->GetWorldBoundingBox();
+            if (bb.IsInside(position) == INSIDE)
+            {
+                Vector3 areaWorldCenter = area->GetNode()->GetWorldPosition();
+                float distance = (areaWorldCenter - position).LengthSquared();
+                if (distance < nearestDistance)
+                {
+                    nearestDistance = distance;
+                    nearestNavAreaID = area->GetAreaID();
+                }
+            }
+        }
+    }
+    return (unsigned char)nearestNavAreaID;
+}
+
 void NavigationMesh::SetPartitionType(NavmeshPartitionType partitionType)
 {
     partitionType_ = partitionType;
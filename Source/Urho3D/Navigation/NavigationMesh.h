@@ -7,6 +7,7 @@
 
 #include "../Container/ArrayPtr.h"
 #include "../Container/HashSet.h"
+#include "../Core/Mutex.h"
 #include "../Math/BoundingBox.h"
 #include "../Math/Matrix3x4.h"
 #include "../Scene/Component.h"
@@ -22,6 +23,7 @@ using dtPolyRef = unsigned int;
 class dtNavMesh;
 class dtNavMeshQuery;
 class dtQueryFilter;
+struct rcConfig;
 
 namespace Urho3D
 {
@@ -34,9 +36,12 @@ enum NavmeshPartitionType
 
 class Geometry;
 class NavArea;
+class Navigable;
 
 struct FindPathData;
 struct NavBuildData;
+struct PathRequestQueue;
+struct WorkItem;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -71,12 +76,44 @@ struct URHO3D_API NavigationPathPoint
     unsigned char areaID_;
 };
 
+/// State of an asynchronous path request.
+enum NavigationPathRequestState
+{
+    NAVPATHREQUEST_NONE = 0,    ///< Unknown request, cancelled or its result already discarded.
+    NAVPATHREQUEST_QUEUED,      ///< Waiting for a query to search it.
+    NAVPATHREQUEST_SEARCHING,   ///< Being searched, or searched but not delivered yet.
+    NAVPATHREQUEST_SUCCEEDED,   ///< Path delivered. The path may end at the polygon closest to the end point if the end can not be reached.
+    NAVPATHREQUEST_FAILED       ///< No path found.
+};
+
+/// Statistics of the asynchronous path requests of a navigation mesh.
+struct URHO3D_API NavigationPathRequestStats
+{
+    /// Requests waiting for a query.
+    i32 numQueued_{};
+    /// Requests being searched or waiting for delivery.
+    i32 numSearching_{};
+    /// Successful requests delivered in total.
+    u32 numSucceeded_{};
+    /// Failed requests delivered in total.
+    u32 numFailed_{};
+    /// Requests cancelled in total.
+    u32 numCancelled_{};
+    /// Requests delivered in the last update.
+    i32 numDeliveredLastUpdate_{};
+    /// Search iterations in the last update, summed over the threads.
+    i32 numIterationsLastUpdate_{};
+    /// Time the last update took on the main thread in microseconds, including the delivery events.
+    i64 lastUpdateUSec_{};
+};
+
 /// Navigation mesh component. Collects the navigation geometry from child nodes with the Navigable component and responds to path queries.
 class URHO3D_API NavigationMesh : public Component
 {
     URHO3D_OBJECT(NavigationMesh, Component);
 
     friend class CrowdManager;
+    friend class Navigable;
 
 public:
     /// Construct.
@@ -142,6 +179,10 @@ public:
     virtual bool Build(const BoundingBox& boundingBox);
     /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
     virtual bool Build(const IntVector2& from, const IntVector2& to);
+    /// Mark the tiles intersecting the world-space bounding box to be rebuilt over the next scene post-updates within the rebuild budget.
+    void MarkTilesDirty(const BoundingBox& boundingBox);
+    /// Rebuild dirty tiles until the rebuild budget is used up. Called on the scene post-update. Return number of rebuilt tiles.
+    unsigned RebuildDirtyTiles();
     /// Return tile data.
     /// @manualbind
     virtual Vector<byte> GetTileData(const IntVector2& tile) const;
@@ -170,6 +211,16 @@ public:
     void FindPath
         (Vector<NavigationPathPoint>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
             const dtQueryFilter* filter = nullptr);
+    /// Request a path between world space points to be searched asynchronously. The searches run in time slices on the work queue threads during the scene post-update, higher priorities first. The result is delivered with the E_NAVIGATION_PATH_COMPLETED event on the frame after the search finishes, and can be read until the next update. The filter is copied. Return the request ID, or 0 if the navigation mesh is not initialized.
+    u32 RequestPath(const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE, int priority = 0,
+        const dtQueryFilter* filter = nullptr);
+    /// Cancel an asynchronous path request. Return true if it was still queued or being searched.
+    bool CancelPathRequest(u32 requestId);
+    /// Deliver the finished asynchronous path requests and search the queued ones for one time slice. Called on the scene post-update.
+    void UpdatePathRequests();
+    /// Set the time the asynchronous path searches may take per update on each thread, in microseconds. Default 1000.
+    /// @property
+    void SetPathRequestTimeSlice(int usec);
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint(const dtQueryFilter* filter = nullptr, dtPolyRef* randomRef = nullptr);
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -187,6 +238,17 @@ public:
     /// Add debug geometry to the debug renderer.
     void DrawDebugGeometry(bool depthTest);
 
+    /// Return the state of an asynchronous path request.
+    NavigationPathRequestState GetPathRequestState(u32 requestId) const;
+    /// Return the path of a delivered asynchronous path request. Return true if the request succeeded.
+    bool GetPathRequestResult(u32 requestId, Vector<NavigationPathPoint>& dest) const;
+    /// Return statistics of the asynchronous path requests.
+    NavigationPathRequestStats GetPathRequestStats() const;
+
+    /// Return the time the asynchronous path searches may take per update on each thread, in microseconds.
+    /// @property
+    int GetPathRequestTimeSlice() const { return pathRequestTimeSlice_; }
+
     /// Return the given name of this navigation mesh.
     String GetMeshName() const { return meshName_; }
 
@@ -276,6 +338,34 @@ public:
     /// @property
     NavmeshPartitionType GetPartitionType() const { return partitionType_; }
 
+    /// Set whether to build the tiles on the work queue threads. Default false.
+    /// @property
+    void SetMultithreadedBuild(bool enable) { multithreadedBuild_ = enable; }
+
+    /// Return whether the tiles are built on the work queue threads.
+    /// @property
+    bool IsMultithreadedBuild() const { return multithreadedBuild_; }
+
+    /// Set whether changes of the navigation geometry mark the tiles under it dirty, so that they are rebuilt incrementally. Tracks moving, adding and removing the nodes and components collected under Navigable components, including child nodes of recursive Navigables, and enabling or disabling Navigables. Default false.
+    /// @property
+    void SetIncrementalRebuild(bool enable);
+
+    /// Return whether changed Navigables mark tiles dirty.
+    /// @property
+    bool IsIncrementalRebuild() const { return incrementalRebuild_; }
+
+    /// Set the time the dirty tiles may take to rebuild per update in microseconds. At least one tile per thread is rebuilt each update. Default 2000.
+    /// @property
+    void SetRebuildBudget(int usec);
+
+    /// Return the time the dirty tiles may take to rebuild per update in microseconds.
+    /// @property
+    int GetRebuildBudget() const { return rebuildBudget_; }
+
+    /// Return number of tiles waiting to be rebuilt.
+    /// @property
+    i32 GetNumDirtyTiles() const { return dirtyTileSet_.Size(); }
+
     /// Set navigation data attribute.
     virtual void SetNavigationDataAttr(const Vector<byte>& value);
     /// Return navigation data attribute.
@@ -298,28 +388,74 @@ public:
     bool GetDrawNavAreas() const { return drawNavAreas_; }
 
 private:
+    /// Handle the scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle a node being added to the scene, which may add navigation geometry.
+    void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
+    /// Handle a node being removed from the scene, which removes its navigation geometry.
+    void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
+    /// Handle a component being added to the scene, which may add navigation geometry.
+    void HandleComponentAdded(StringHash eventType, VariantMap& eventData);
+    /// Handle a component being removed from the scene, which may remove navigation geometry.
+    void HandleComponentRemoved(StringHash eventType, VariantMap& eventData);
+    /// Deliver the asynchronous path requests finished in the last update and discard the previously delivered ones.
+    void DeliverPathRequests();
     /// Write tile data.
     void WriteTile(Serializer& dest, int x, int z) const;
     /// Read tile data to the navigation mesh.
     bool ReadTile(Deserializer& source, bool silent);
 
 protected:
+    /// Handle the transform of a node with collected geometry being dirtied.
+    void OnMarkedDirty(Node* node) override;
     /// Collect geometry from under Navigable components.
     void CollectGeometries(Vector<NavigationGeometryInfo>& geometryList);
+    /// Collect the geometry of a node and its children that is included in the navigation mesh.
+    void CollectNodeGeometries(Vector<NavigationGeometryInfo>& geometryList, Node* node);
     /// Visit nodes and collect navigable geometry.
     void CollectGeometries(Vector<NavigationGeometryInfo>& geometryList, Node* node, HashSet<Node*>& processedNodes, bool recursive);
     /// Get geometry data within a bounding box.
     void GetTileGeometry(NavBuildData* build, Vector<NavigationGeometryInfo>& geometryList, BoundingBox& box);
     /// Add a triangle mesh to the geometry data.
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
-    /// Build one tile of the navigation mesh. Return true if successful.
-    virtual bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// Fill the Recast configuration for building a tile.
+    void InitTileConfig(rcConfig& cfg, const IntVector2& tile) const;
+    /// Create the build data of a tile and gather its geometry.
+    virtual std::unique_ptr<NavBuildData> CreateTileBuildData(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& tile);
+    /// Build the navigation data of a tile from its gathered geometry. May be called on a work queue thread, so must not access the scene. Return true if successful.
+    virtual bool BuildTileData(NavBuildData* build) const;
+    /// Replace a tile of the navigation mesh with the built navigation data. Return number of added tiles.
+    virtual unsigned AddTileData(NavBuildData* build);
+    /// Build tiles in batches: the geometry is gathered on the main thread, the tiles are built on the work queue threads if multithreaded build is enabled, and added in order. Return number of built tiles.
+    unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const Vector<IntVector2>& tiles);
     /// Build tiles in the rectangular area. Return number of built tiles.
     unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Work item function for building a tile.
+    static void BuildTileWork(const WorkItem* item, i32 threadIndex);
+    /// Used by Navigable to report a possible change of its geometry.
+    void NavigableChanged(Navigable* navigable);
+    /// Used by Navigable to report its removal.
+    void NavigableRemoved(Navigable* navigable);
+    /// Handle a node with collected geometry having moved, unless it moved along with the navigation mesh node.
+    void NodeMoved(Node* node);
+    /// Queue the geometry of a node and its children to be collected again on the next rebuild of the dirty tiles.
+    void MarkNodeChanged(Node* node);
+    /// Mark the tiles under the tracked geometry of a node and its children dirty, and forget the geometry.
+    void RemoveNodeGeometry(Node* node);
+    /// Update the NavAreas from the collected geometry.
+    void UpdateNavAreas(const Vector<NavigationGeometryInfo>& geometryList);
+    /// Add the tiles whose geometry includes the local space bounding box, with the tile border, to the dirty tiles.
+    void AddDirtyTiles(const BoundingBox& geometryBox);
+    /// Subscribe to the scene post-update, which rebuilds the dirty tiles and updates the path requests.
+    void SubscribeToScenePostUpdate();
+    /// Queue the path requests being searched again, as their search state would refer to replaced tiles. Optionally free the queries.
+    void RestartPathRequests(bool releaseQueries);
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
     /// Release the navigation mesh and the query.
     virtual void ReleaseNavigationMesh();
+    /// Return the area ID of the nearest enabled NavArea containing a world space point, or 0 if none.
+    unsigned char GetNavAreaID(const Vector3& position) const;
 
     /// Identifying name for this navigation mesh.
     String meshName_;
@@ -336,6 +472,11 @@ protected:
     /// Temporary data for finding a path.
     std::unique_ptr<FindPathData> pathData_;
 
+    /// Asynchronous path requests and the queries searching them.
+    std::unique_ptr<PathRequestQueue> pathRequests_;
+    /// Search time per update and thread for the asynchronous path requests in microseconds.
+    int pathRequestTimeSlice_;
+
     /// Tile size.
     int tileSize_;
     /// Cell size.
@@ -380,6 +521,30 @@ protected:
     bool drawNavAreas_;
     /// NavAreas for this NavMesh.
     Vector<WeakPtr<NavArea>> areas_;
+    /// Multithreaded tile build flag.
+    bool multithreadedBuild_;
+    /// Incremental rebuild of changed Navigables flag.
+    bool incrementalRebuild_;
+    /// Time budget of the dirty tile rebuild per update in microseconds.
+    int rebuildBudget_;
+    /// Tiles waiting to be rebuilt, in order.
+    Vector<IntVector2> dirtyTiles_;
+    /// Set of the tiles waiting to be rebuilt.
+    HashSet<IntVector2> dirtyTileSet_;
+    /// Whether the collected geometry is tracked for the incremental rebuild.
+    bool geometryTracked_;
+    /// Tracked geometry by node, in navigation mesh node space.
+    HashMap<Node*, Vector<NavigationGeometryInfo>> nodeGeometries_;
+    /// Tracked geometry of all nodes, used to rebuild the dirty tiles without collecting the geometry again.
+    Vector<NavigationGeometryInfo> trackedGeometry_;
+    /// Whether the tracked geometry of all nodes needs to be updated from the node geometry.
+    bool trackedGeometryDirty_;
+    /// Nodes whose geometry is collected again on the next rebuild of the dirty tiles.
+    HashSet<WeakPtr<Node>> changedNodes_;
+    /// Nodes with collected geometry that were dirtied during a threaded scene update.
+    Vector<Node*> delayedDirtyNodes_;
+    /// Mutex for the nodes dirtied during a threaded scene update.
+    Mutex delayedDirtyNodesMutex_;
 };
 
 /// Register Navigation library objects.
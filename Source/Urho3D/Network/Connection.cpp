@@ -3,13 +3,17 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Sort.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
+#include "../Math/Random.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestManager.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -35,6 +39,35 @@ namespace Urho3D
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
+static const unsigned DEFAULT_COMPRESSION_THRESHOLD = 64;
+static const float DEFAULT_RELEVANCE_DISTANCE = 100.0f;
+/// Maximum unused bandwidth budget carried over, as a multiple of one update's budget.
+static const float MAX_BANDWIDTH_CREDIT = 2.0f;
+/// Size of the message ID and message size preceding each packed message.
+static const unsigned PACKED_MESSAGE_PREFIX_SIZE = 2 * sizeof(unsigned);
+/// Size of the RakNet message ID byte and the Urho3D message ID preceding the packed messages.
+static const unsigned PACKED_MESSAGE_HEADER_SIZE = sizeof(unsigned char) + sizeof(unsigned);
+
+/// Return world position of a node without updating its cached world transform, as the scene must not be modified during a parallel server update.
+static Vector3 CalculateWorldPosition(const Node* node)
+{
+    if (!node->IsDirty())
+        return node->GetWorldPosition();
+
+    // Assume the root node (scene) has identity transform, same as Node
+    Vector3 position = node->GetPosition();
+    const Node* parent = node->GetParent();
+    while (parent && parent != node->GetScene())
+    {
+        if (!parent->IsDirty())
+            return parent->GetWorldTransform() * position;
+
+        position = parent->GetTransform() * position;
+        parent = parent->GetParent();
+    }
+
+    return position;
+}
 
 PackageDownload::PackageDownload() :
     totalFragments_(0),
@@ -43,6 +76,30 @@ PackageDownload::PackageDownload() :
 {
 }
 
+/// Apply a node transform received in a snapshot through motion smoothing if the node has it.
+static void ApplySnapshotTransform(Node* node, const Vector3& position, const Quaternion& rotation)
+{
+    auto* transform = node->GetComponent<SmoothedTransform>();
+    if (transform)
+    {
+        transform->SetTargetPosition(position);
+        transform->SetTargetRotation(rotation);
+    }
+    else
+        node->SetTransform(position, rotation);
+}
+
+/// Add the IDs of a replicated node and its replicated children to a dirty node set.
+static void MarkNodeTreeDirty(Node* node, HashSet<unsigned>& dirtyNodes)
+{
+    if (node->IsReplicated())
+        dirtyNodes.Insert(node->GetID());
+
+    const Vector<SharedPtr<Node>>& children = node->GetChildren();
+    for (i32 i = 0; i < children.Size(); ++i)
+        MarkNodeTreeDirty(children[i], dirtyNodes);
+}
+
 PackageUpload::PackageUpload() :
     fragment_(0),
     totalFragments_(0)
@@ -59,8 +116,33 @@ Connection::Connection(Context* context, bool isClient, const SLNet::AddressOrGU
     sceneLoaded_(false),
     logStatistics_(false),
     address_(nullptr),
-    packedMessageLimit_(1024)
-{
+    packedMessageLimit_(1024),
+    compressionCodec_(COMPRESSION_ZSTD),
+    compressionThreshold_(DEFAULT_COMPRESSION_THRESHOLD),
+    uncompressedBytesOut_(0),
+    compressedBytesOut_(0),
+    queuePackets_(false),
+    replicationMode_(REPLICATION_LATESTDATA),
+    snapshotPrecision_(DEFAULT_SNAPSHOT_PRECISION),
+    snapshotSequence_(0),
+    ackedSnapshot_(0),
+    snapshotAckPending_(false),
+    simulatedLatency_(0),
+    simulatedPacketLoss_(0.0f),
+    bandwidthLimit_(0),
+    relevanceDistance_(DEFAULT_RELEVANCE_DISTANCE),
+    bandwidthCredit_(0.0f),
+    updateBytes_(0),
+    measuredBytes_(0),
+    measuredTime_(0.0f),
+    messageBytesPerSec_(0.0f),
+    numDeferredNodes_(0),
+    serverTime_(0),
+    serverTimeValid_(false)
+{
+    for (bool& compress : compressPacketType_)
+        compress = false;
+
     sceneState_.connection_ = this;
     port_ = address.systemAddress.GetPort();
     SetAddressOrGUID(address);
@@ -104,20 +186,24 @@ void Connection::SendMessage(int msgID, bool reliable, bool inOrder, const byte*
     }
 
     PacketType type = GetPacketType(reliable, inOrder);
-    VectorBuffer& buffer = outgoingBuffer_[type];
-
-    if (buffer.GetSize() + numBytes >= packedMessageLimit_)
+    if (outgoingBuffers_[type] && outgoingBuffers_[type]->GetBuffer().GetSize() + numBytes >= packedMessageLimit_)
         SendBuffer(type);
 
-    if (buffer.GetSize() == 0)
+    if (!outgoingBuffers_[type])
     {
+        outgoingBuffers_[type] = packetPool_.Acquire();
+        VectorBuffer& buffer = outgoingBuffers_[type]->GetBuffer();
         buffer.WriteU8((unsigned char)DefaultMessageIDTypes::ID_USER_PACKET_ENUM);
         buffer.WriteU32((unsigned int)MSG_PACKED_MESSAGE);
     }
 
+    VectorBuffer& buffer = outgoingBuffers_[type]->GetBuffer();
     buffer.WriteU32((unsigned int) msgID);
     buffer.WriteU32(numBytes);
     buffer.Write(data, numBytes);
+
+    updateBytes_ += numBytes + PACKED_MESSAGE_PREFIX_SIZE;
+    measuredBytes_ += numBytes + PACKED_MESSAGE_PREFIX_SIZE;
 }
 
 void Connection::SendRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData)
@@ -166,6 +252,8 @@ void Connection::SetScene(Scene* newScene)
 
     scene_ = newScene;
     sceneLoaded_ = false;
+    ResetSnapshots();
+    nodeStaleness_.Clear();
     UnsubscribeFromEvent(E_ASYNCLOADFINISHED);
 
     if (!scene_)
@@ -232,31 +320,113 @@ void Connection::SetLogStatistics(bool enable)
     logStatistics_ = enable;
 }
 
+void Connection::SetReplicationMode(ReplicationMode mode)
+{
+    if (mode == replicationMode_)
+        return;
+
+    replicationMode_ = mode;
+    ResetSnapshots();
+}
+
+void Connection::SetSnapshotPrecision(float precision)
+{
+    snapshotPrecision_ = Max(precision, M_EPSILON);
+}
+
+void Connection::SetBandwidthLimit(unsigned bytesPerSec)
+{
+    bandwidthLimit_ = bytesPerSec;
+    bandwidthCredit_ = 0.0f;
+    if (!bandwidthLimit_)
+        nodeStaleness_.Clear();
+}
+
+void Connection::SetRelevanceDistance(float distance)
+{
+    relevanceDistance_ = Max(distance, M_EPSILON);
+}
+
 void Connection::Disconnect(int waitMSec)
 {
-    peer_->CloseConnection(*address_, true);
+    if (peer_)
+        peer_->CloseConnection(*address_, true);
 }
 
 void Connection::SendServerUpdate()
+{
+    BuildServerUpdate();
+    FinishServerUpdate();
+}
+
+void Connection::BuildServerUpdate()
 {
     if (!scene_ || !sceneLoaded_)
         return;
 
+    // Packets that fill up are queued instead of sent, so that no SLikeNet calls are made from worker threads
+    queuePackets_ = true;
+    updateBytes_ = 0;
+
+    auto* network = GetSubsystem<Network>();
+    float interval = network ? 1.0f / network->GetUpdateFps() : 0.0f;
+    serverTime_ = network ? network->GetServerTime() : 0;
+    if (bandwidthLimit_)
+    {
+        float updateBudget = bandwidthLimit_ * interval;
+        bandwidthCredit_ = Min(bandwidthCredit_ + updateBudget, updateBudget * MAX_BANDWIDTH_CREDIT);
+    }
+
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
     nodesToProcess_.Insert(sceneID);
     ProcessNode(sceneID);
 
+    // Mark nodes that entered or left the client's area of interest dirty for creating or removing them
+    UpdateInterest();
+
     // Then go through all dirtied nodes
     nodesToProcess_.Insert(sceneState_.dirtyNodes_);
     nodesToProcess_.Erase(sceneID); // Do not process the root node twice
 
-    while (nodesToProcess_.Size())
+    if (bandwidthLimit_)
+        ProcessPrioritizedNodes(bandwidthCredit_ > 0.0f ? (unsigned)bandwidthCredit_ : 0);
+    else
+    {
+        numDeferredNodes_ = 0;
+        while (nodesToProcess_.Size())
+        {
+            unsigned nodeID = nodesToProcess_.Front();
+            ProcessNode(nodeID);
+        }
+    }
+
+    if (replicationMode_ == REPLICATION_SNAPSHOT)
+        WriteSnapshot();
+
+    // The last node of an update may overshoot the budget. It is not paid back, so that a burst of new nodes does not stall the following updates
+    if (bandwidthLimit_)
+        bandwidthCredit_ = Max(bandwidthCredit_ - updateBytes_, 0.0f);
+
+    measuredTime_ += interval;
+    if (measuredTime_ >= 1.0f)
     {
-        unsigned nodeID = nodesToProcess_.Front();
-        ProcessNode(nodeID);
+        messageBytesPerSec_ = measuredBytes_ / measuredTime_;
+        measuredBytes_ = 0;
+        measuredTime_ = 0.0f;
     }
+
+    queuePackets_ = false;
+}
+
+void Connection::FinishServerUpdate()
+{
+    for (i32 i = 0; i < queuedPackets_.Size(); ++i)
+        SendPacket(queuedPackets_[i].first_, queuedPackets_[i].second_);
+
+    // Release the references so that the buffers return to the pool
+    queuedPackets_.Clear();
 }
 
 void Connection::SendClientUpdate()
@@ -276,6 +446,15 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    // Acknowledge the latest applied snapshot, so that the server writes the next ones against it
+    if (snapshotAckPending_)
+    {
+        msg_.Clear();
+        msg_.WriteU32(snapshotSequence_);
+        SendMessage(MSG_SNAPSHOTACK, false, false, msg_);
+        snapshotAckPending_ = false;
+    }
+
     ++timeStamp_;
 }
 
@@ -358,27 +537,81 @@ void Connection::SendPackages()
 
 void Connection::SendBuffer(PacketType type)
 {
-    VectorBuffer& buffer = outgoingBuffer_[type];
-    if (buffer.GetSize() == 0)
+    if (!outgoingBuffers_[type])
         return;
 
-    PacketReliability reliability = PacketReliability::UNRELIABLE;
-    if (type == PT_UNRELIABLE_ORDERED)
-        reliability = PacketReliability::UNRELIABLE_SEQUENCED;
+    // Hand the buffer over instead of copying it. A new one is acquired from the pool for the next message
+    SharedPtr<PacketBuffer> packet;
+    packet.Swap(outgoingBuffers_[type]);
+    const VectorBuffer& buffer = packet->GetBuffer();
+
+    if (compressPacketType_[type] && buffer.GetSize() >= PACKED_MESSAGE_HEADER_SIZE + compressionThreshold_)
+    {
+        unsigned payloadSize = buffer.GetSize() - PACKED_MESSAGE_HEADER_SIZE;
+        unsigned bound = EstimateCompressBound(payloadSize, compressionCodec_);
+
+        SharedPtr<PacketBuffer> compressed = packetPool_.Acquire();
+        VectorBuffer& compressedBuffer = compressed->GetBuffer();
+        compressedBuffer.WriteU8((unsigned char)DefaultMessageIDTypes::ID_USER_PACKET_ENUM);
+        compressedBuffer.WriteU32((unsigned)MSG_PACKED_COMPRESSED_MESSAGE);
+        compressedBuffer.WriteU8((unsigned char)compressionCodec_);
+        compressedBuffer.WriteVLE(payloadSize);
+        unsigned headerSize = compressedBuffer.GetSize();
+        compressedBuffer.Resize(headerSize + bound);
+
+        unsigned compressedSize = CompressData(compressedBuffer.GetModifiableData() + headerSize, bound,
+            buffer.GetData() + PACKED_MESSAGE_HEADER_SIZE, payloadSize, compressionCodec_, compressionDictionary_);
+        // Only send compressed if it actually saves space
+        if (compressedSize && headerSize + compressedSize < buffer.GetSize())
+        {
+            compressedBuffer.Resize(headerSize + compressedSize);
+            packet = compressed;
+        }
 
-    if (type == PT_RELIABLE_ORDERED)
-        reliability = PacketReliability::RELIABLE_ORDERED;
+        uncompressedBytesOut_ += payloadSize;
+        compressedBytesOut_ += packet->GetBuffer().GetSize() - PACKED_MESSAGE_HEADER_SIZE;
+    }
 
-    if (type == PT_RELIABLE_UNORDERED)
-        reliability = PacketReliability::RELIABLE;
+    SendPacket(type, packet);
+}
 
-    if (peer_) {
-        peer_->Send((const char *) buffer.GetData(), (int) buffer.GetSize(), HIGH_PRIORITY, reliability, (char) 0,
+void Connection::SendPacket(PacketType type, PacketBuffer* packet)
+{
+    if (queuePackets_)
+    {
+        queuedPackets_.Push(MakePair(type, SharedPtr<PacketBuffer>(packet)));
+        return;
+    }
+
+    const VectorBuffer& data = packet->GetBuffer();
+    if (peer_)
+    {
+        PacketReliability reliability = PacketReliability::UNRELIABLE;
+        if (type == PT_UNRELIABLE_ORDERED)
+            reliability = PacketReliability::UNRELIABLE_SEQUENCED;
+
+        if (type == PT_RELIABLE_ORDERED)
+            reliability = PacketReliability::RELIABLE_ORDERED;
+
+        if (type == PT_RELIABLE_UNORDERED)
+            reliability = PacketReliability::RELIABLE;
+
+        peer_->Send((const char *) data.GetData(), (int) data.GetSize(), HIGH_PRIORITY, reliability, (char) 0,
                     *address_, false);
         tempPacketCounter_.y_++;
     }
+    else if (loopback_)
+    {
+        // Simulate loss of unreliable packets only, as there is no resending
+        tempPacketCounter_.y_++;
+        if (simulatedPacketLoss_ > 0.0f && (type == PT_UNRELIABLE_ORDERED || type == PT_UNRELIABLE_UNORDERED) &&
+            Random() < simulatedPacketLoss_)
+            return;
 
-    buffer.Clear();
+        // The receiver references the same buffer, which returns to the pool once processed
+        unsigned deliveryTime = Time::GetSystemTime() + simulatedLatency_;
+        loopback_->loopbackPackets_.Push(MakePair(deliveryTime, SharedPtr<PacketBuffer>(packet)));
+    }
 }
 
 void Connection::SendAllBuffers()
@@ -395,14 +628,16 @@ void Connection::ProcessPendingLatestData()
         return;
 
     // Iterate through pending node data and see if we can find the nodes now
-    for (HashMap<unsigned, Vector<byte>>::Iterator i = nodeLatestData_.Begin(); i != nodeLatestData_.End();)
+    for (HashMap<unsigned, SharedPtr<PacketBuffer>>::Iterator i = nodeLatestData_.Begin(); i != nodeLatestData_.End();)
     {
-        HashMap<unsigned, Vector<byte>>::Iterator current = i++;
+        HashMap<unsigned, SharedPtr<PacketBuffer>>::Iterator current = i++;
         Node* node = scene_->GetNode(current->first_);
         if (node)
         {
-            MemoryBuffer msg(current->second_);
+            const VectorBuffer& data = current->second_->GetBuffer();
+            MemoryBuffer msg(data.GetData(), data.GetSize());
             msg.ReadNetID(); // Skip the node ID
+            ApplyServerTime(msg.ReadU16());
             node->ReadLatestDataUpdate(msg);
             // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
             // Furthermore it would propagate to components and child nodes, which is not desired in this case
@@ -411,13 +646,14 @@ void Connection::ProcessPendingLatestData()
     }
 
     // Iterate through pending component data and see if we can find the components now
-    for (HashMap<unsigned, Vector<byte>>::Iterator i = componentLatestData_.Begin(); i != componentLatestData_.End();)
+    for (HashMap<unsigned, SharedPtr<PacketBuffer>>::Iterator i = componentLatestData_.Begin(); i != componentLatestData_.End();)
     {
-        HashMap<unsigned, Vector<byte>>::Iterator current = i++;
+        HashMap<unsigned, SharedPtr<PacketBuffer>>::Iterator current = i++;
         Component* component = scene_->GetComponent(current->first_);
         if (component)
         {
-            MemoryBuffer msg(current->second_);
+            const VectorBuffer& data = current->second_->GetBuffer();
+            MemoryBuffer msg(data.GetData(), data.GetSize());
             msg.ReadNetID(); // Skip the component ID
             if (component->ReadLatestDataUpdate(msg))
                 component->ApplyAttributes();
@@ -432,14 +668,26 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& buffer)
     if (buffer.GetSize() == 0)
         return false;
 
+    if (msgID == MSG_PACKED_COMPRESSED_MESSAGE)
+    {
+        ProcessCompressedMessage(buffer);
+        return true;
+    }
+
     if (msgID != MSG_PACKED_MESSAGE)
     {
         ProcessUnknownMessage(msgID, buffer);
         return true;
     }
 
+    ProcessPackedMessage(buffer);
+    return true;
+}
+
+void Connection::ProcessPackedMessage(MemoryBuffer& buffer)
+{
     while (!buffer.IsEof()) {
-        msgID = buffer.ReadU32();
+        int msgID = buffer.ReadU32();
         unsigned int packetSize = buffer.ReadU32();
         MemoryBuffer msg(buffer.GetData() + buffer.GetPosition(), packetSize);
         buffer.Seek(buffer.GetPosition() + packetSize);
@@ -490,12 +738,81 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& buffer)
             case MSG_PACKAGEINFO:
                 ProcessPackageInfo(msgID, msg);
                 break;
+
+            case MSG_SNAPSHOT:
+                ProcessSnapshot(msgID, msg);
+                break;
+
+            case MSG_SNAPSHOTACK:
+                ProcessSnapshotAck(msgID, msg);
+                break;
+
             default:
                 ProcessUnknownMessage(msgID, msg);
                 break;
         }
     }
-    return true;
+}
+
+void Connection::ProcessCompressedMessage(MemoryBuffer& buffer)
+{
+    auto codec = (CompressionCodec)buffer.ReadU8();
+    unsigned uncompressedSize = buffer.ReadVLE();
+    if (codec >= MAX_COMPRESSION_CODECS || !uncompressedSize || uncompressedSize > MAX_DECOMPRESSED_PACKET_SIZE || buffer.IsEof())
+    {
+        URHO3D_LOGWARNING("Discarding malformed compressed message from " + ToString());
+        return;
+    }
+
+    if (decompressedBuffer_.Size() < (i32)uncompressedSize)
+        decompressedBuffer_.Resize(uncompressedSize);
+
+    unsigned compressedSize = buffer.GetSize() - buffer.GetPosition();
+    if (DecompressData(decompressedBuffer_.Buffer(), uncompressedSize, buffer.GetData() + buffer.GetPosition(), compressedSize,
+        codec, compressionDictionary_) != uncompressedSize)
+    {
+        URHO3D_LOGWARNING("Failed to decompress message from " + ToString());
+        return;
+    }
+
+    MemoryBuffer packed(decompressedBuffer_.Buffer(), uncompressedSize);
+    ProcessPackedMessage(packed);
+}
+
+void Connection::ProcessLoopbackPackets()
+{
+    if (loopbackPackets_.Empty())
+        return;
+
+    // Packets sent in response are processed on the next call, same as when received from the network.
+    // Packets delayed by simulated latency are kept in order until their delivery time
+    deliveredPackets_.Swap(loopbackPackets_);
+
+    unsigned now = Time::GetSystemTime();
+    i32 numDelivered = 0;
+    while (numDelivered < deliveredPackets_.Size() && (int)(deliveredPackets_[numDelivered].first_ - now) <= 0)
+        ++numDelivered;
+    for (i32 i = numDelivered; i < deliveredPackets_.Size(); ++i)
+        loopbackPackets_.Push(deliveredPackets_[i]);
+    deliveredPackets_.Resize(numDelivered);
+
+    for (i32 i = 0; i < deliveredPackets_.Size(); ++i)
+    {
+        const VectorBuffer& packet = deliveredPackets_[i].second_->GetBuffer();
+        if (packet.GetSize() < PACKED_MESSAGE_HEADER_SIZE)
+            continue;
+
+        lastHeardTimer_.Reset();
+
+        // Skip the SLikeNet packet ID, then read the message ID like Network does for received packets
+        unsigned msgID;
+        memcpy(&msgID, packet.GetData() + sizeof(unsigned char), sizeof msgID);
+        MemoryBuffer buffer(packet.GetData() + PACKED_MESSAGE_HEADER_SIZE, packet.GetSize() - PACKED_MESSAGE_HEADER_SIZE);
+        ProcessMessage((int)msgID, buffer);
+    }
+
+    // Release the buffers back to the sender's pool
+    deliveredPackets_.Clear();
 }
 
 void Connection::Ban()
@@ -527,6 +844,8 @@ void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
     nodeLatestData_.Clear();
     componentLatestData_.Clear();
     downloads_.Clear();
+    ResetSnapshots();
+    serverTimeValid_ = false;
 
     // In case we have joined other scenes in this session, remove first all downloaded package files from the resource system
     // to prevent resource conflicts
@@ -594,8 +913,15 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
                 node->CreateComponent<SmoothedTransform>(LOCAL);
             }
 
-            // Read initial attributes, then snap the motion smoothing immediately to the end
+            // Read initial attributes, then snap the motion smoothing immediately to the end.
+            // A snapshot may have arrived before the node was created
             node->ReadDeltaUpdate(msg);
+            HashMap<unsigned, Pair<Vector3, Quaternion>>::Iterator pending = pendingSnapshotTransforms_.Find(nodeID);
+            if (pending != pendingSnapshotTransforms_.End())
+            {
+                ApplySnapshotTransform(node, pending->second_.first_, pending->second_.second_);
+                pendingSnapshotTransforms_.Erase(pending);
+            }
             auto* transform = node->GetComponent<SmoothedTransform>();
             if (transform)
                 transform->Update(1.0f, 0.0f);
@@ -669,16 +995,19 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             Node* node = scene_->GetNode(nodeID);
             if (node)
             {
+                ApplyServerTime(msg.ReadU16());
                 node->ReadLatestDataUpdate(msg);
                 // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
                 // Furthermore it would propagate to components and child nodes, which is not desired in this case
             }
             else
             {
-                // Latest data messages may be received out-of-order relative to node creation, so cache if necessary
-                Vector<byte>& data = nodeLatestData_[nodeID];
-                data.Resize(msg.GetSize());
-                memcpy(&data[0], msg.GetData(), msg.GetSize());
+                // Latest data messages may be received out-of-order relative to node creation, so cache if necessary.
+                // The cache buffers come from a pool, so that their memory is reused once the data has been applied
+                SharedPtr<PacketBuffer>& data = nodeLatestData_[nodeID];
+                if (!data)
+                    data = latestDataPool_.Acquire();
+                data->GetBuffer().SetData(msg.GetData(), msg.GetSize());
             }
         }
         break;
@@ -690,6 +1019,7 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             if (node)
                 node->Remove();
             nodeLatestData_.Erase(nodeID);
+            pendingSnapshotTransforms_.Erase(nodeID);
         }
         break;
 
@@ -753,9 +1083,10 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             else
             {
                 // Latest data messages may be received out-of-order relative to component creation, so cache if necessary
-                Vector<byte>& data = componentLatestData_[componentID];
-                data.Resize(msg.GetSize());
-                memcpy(&data[0], msg.GetData(), msg.GetSize());
+                SharedPtr<PacketBuffer>& data = componentLatestData_[componentID];
+                if (!data)
+                    data = latestDataPool_.Acquire();
+                data->GetBuffer().SetData(msg.GetData(), msg.GetSize());
             }
         }
         break;
@@ -956,9 +1287,15 @@ void Connection::ProcessControls(int msgID, MemoryBuffer& msg)
 
     // Client may or may not send observer position & rotation for interest management
     if (!msg.IsEof())
+    {
         position_ = msg.ReadVector3();
+        sendMode_ = OPSM_POSITION;
+    }
     if (!msg.IsEof())
+    {
         rotation_ = msg.ReadPackedQuaternion();
+        sendMode_ = OPSM_POSITION_ROTATION;
+    }
 }
 
 void Connection::ProcessSceneLoaded(int msgID, MemoryBuffer& msg)
@@ -996,6 +1333,134 @@ void Connection::ProcessSceneLoaded(int msgID, MemoryBuffer& msg)
     }
 }
 
+void Connection::ProcessSnapshot(int msgID, MemoryBuffer& msg)
+{
+    if (IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected Snapshot message from client " + ToString());
+        return;
+    }
+
+    if (!scene_ || !sceneLoaded_)
+        return;
+
+    unsigned sequence = msg.ReadU32();
+    unsigned baselineSequence = msg.ReadU32();
+    u16 time = msg.ReadU16();
+    float precision = msg.ReadFloat();
+    if (!sequence || sequence <= snapshotSequence_ || snapshots_.Find(sequence))
+        return;
+
+    // The baseline must be found before adding the new snapshot, which may replace it. If the baseline is no longer
+    // kept, the snapshot can not be decoded; a later one written against a newer acknowledgement will be
+    const Snapshot* baseline = nullptr;
+    if (baselineSequence)
+    {
+        if (baselineSequence >= sequence || sequence - baselineSequence >= DEFAULT_SNAPSHOT_BUFFER_SIZE)
+            return;
+        baseline = snapshots_.Find(baselineSequence);
+        if (!baseline)
+            return;
+    }
+
+    Snapshot& snapshot = snapshots_.Add(sequence);
+    if (!snapshot.Read(msg, baseline))
+    {
+        URHO3D_LOGWARNING("Discarding malformed Snapshot message from " + ToString());
+        snapshot.sequence_ = 0;
+        return;
+    }
+
+    ApplyServerTime(time);
+
+    // Apply the transforms that differ from the previously applied snapshot. This is not necessarily the baseline,
+    // as the server may not have received the latest acknowledgement yet
+    const Snapshot* applied = snapshots_.Find(snapshotSequence_);
+    for (HashMap<unsigned, SnapshotTransform>::ConstIterator i = snapshot.nodes_.Begin(); i != snapshot.nodes_.End(); ++i)
+    {
+        if (applied)
+        {
+            HashMap<unsigned, SnapshotTransform>::ConstIterator j = applied->nodes_.Find(i->first_);
+            if (j != applied->nodes_.End() && j->second_ == i->second_)
+                continue;
+        }
+
+        Vector3 position = i->second_.GetPosition(precision);
+        Quaternion rotation = i->second_.GetRotation();
+        Node* node = scene_->GetNode(i->first_);
+        if (node)
+            ApplySnapshotTransform(node, position, rotation);
+        else
+            pendingSnapshotTransforms_[i->first_] = MakePair(position, rotation);
+    }
+
+    snapshotSequence_ = sequence;
+    snapshotAckPending_ = true;
+}
+
+void Connection::ProcessSnapshotAck(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected SnapshotAck message from server");
+        return;
+    }
+
+    // Acknowledgements are unreliable and may arrive out of order. Use only newer ones that are still kept as baselines
+    unsigned sequence = msg.ReadU32();
+    if (sequence > ackedSnapshot_ && sequence <= snapshotSequence_ && snapshots_.Find(sequence))
+        ackedSnapshot_ = sequence;
+}
+
+void Connection::WriteSnapshot()
+{
+    URHO3D_PROFILE(WriteSnapshot);
+
+    // Include the nodes the client has received. Ones created during this update are included too, in which case
+    // the client keeps the transform until the creation message arrives
+    Snapshot& snapshot = snapshots_.Add(++snapshotSequence_);
+    for (HashMap<unsigned, NodeReplicationState>::ConstIterator i = sceneState_.nodeStates_.Begin();
+         i != sceneState_.nodeStates_.End(); ++i)
+    {
+        Node* node = i->second_.node_;
+        if (node && node != scene_)
+            snapshot.nodes_[i->first_] = SnapshotTransform(node->GetPosition(), node->GetRotation(), snapshotPrecision_);
+    }
+
+    const Snapshot* baseline = snapshots_.Find(ackedSnapshot_);
+
+    msg_.Clear();
+    msg_.WriteU32(snapshotSequence_);
+    msg_.WriteU32(baseline ? baseline->sequence_ : 0);
+    msg_.WriteU16((u16)serverTime_);
+    msg_.WriteFloat(snapshotPrecision_);
+    snapshot.Write(msg_, baseline);
+    SendMessage(MSG_SNAPSHOT, false, false, msg_);
+}
+
+void Connection::ApplyServerTime(u16 time)
+{
+    // Unwrap to the nearest value from the previous time. Only differences of the times matter to the client
+    if (!serverTimeValid_)
+    {
+        serverTime_ = time;
+        serverTimeValid_ = true;
+    }
+    else
+        serverTime_ += (unsigned)(int)(i16)(u16)(time - (u16)serverTime_);
+
+    scene_->SetNetworkUpdateTime(serverTime_ * 0.001);
+}
+
+void Connection::ResetSnapshots()
+{
+    snapshots_.Clear();
+    pendingSnapshotTransforms_.Clear();
+    snapshotSequence_ = 0;
+    ackedSnapshot_ = 0;
+    snapshotAckPending_ = false;
+}
+
 void Connection::ProcessRemoteEvent(int msgID, MemoryBuffer& msg)
 {
     using namespace RemoteEventData;
@@ -1048,6 +1513,9 @@ Scene* Connection::GetScene() const
 
 bool Connection::IsConnected() const
 {
+    if (loopback_)
+        return true;
+
     return peer_ && peer_->IsActive();
 }
 
@@ -1156,6 +1624,8 @@ void Connection::SendPackageToClient(PackageFile* package)
 
 void Connection::ConfigureNetworkSimulator(int latencyMs, float packetLoss)
 {
+    simulatedLatency_ = Max(latencyMs, 0);
+    simulatedPacketLoss_ = Clamp(packetLoss, 0.0f, 1.0f);
     if (peer_)
         peer_->ApplyNetworkSimulator(packetLoss, latencyMs, 0);
 }
@@ -1165,6 +1635,28 @@ void Connection::SetPacketSizeLimit(int limit)
     packedMessageLimit_ = limit;
 }
 
+void Connection::SetCompression(PacketType type, bool enable)
+{
+    if (type < MAX_PACKET_TYPES)
+        compressPacketType_[type] = enable;
+}
+
+void Connection::SetCompressionCodec(CompressionCodec codec)
+{
+    if (codec < MAX_COMPRESSION_CODECS)
+        compressionCodec_ = codec;
+}
+
+void Connection::SetCompressionDictionary(CompressionDictionary* dictionary)
+{
+    compressionDictionary_ = dictionary;
+}
+
+void Connection::SetCompressionThreshold(unsigned bytes)
+{
+    compressionThreshold_ = bytes;
+}
+
 void Connection::HandleAsyncLoadFinished(StringHash eventType, VariantMap& eventData)
 {
     sceneLoaded_ = true;
@@ -1200,23 +1692,167 @@ void Connection::ProcessNode(unsigned nodeID)
             SendMessage(MSG_REMOVENODE, true, true, msg_);
             sceneState_.nodeStates_.Erase(nodeID);
         }
+        else if (!IsRelevant(node))
+            RemoveIrrelevantNode(node, i->second_);
         else
             ProcessExistingNode(node, i->second_);
     }
     else
     {
-        // Replication state not found: this is a new node
+        // Replication state not found: this is a new node. Nodes outside the area of interest are created once they enter it
         Node* node = scene_->GetNode(nodeID);
-        if (node)
+        if (node && IsRelevant(node))
             ProcessNewNode(node);
         else
         {
-            // Did not find the new node (may have been created, then removed immediately): erase from dirty set.
+            // Did not find the new node (may have been created, then removed immediately), or it is not relevant:
+            // erase from dirty set.
             sceneState_.dirtyNodes_.Erase(nodeID);
         }
     }
 }
 
+void Connection::ProcessPrioritizedNodes(unsigned budget)
+{
+    URHO3D_PROFILE(ProcessPrioritizedNodes);
+
+    prioritizedNodes_.Clear();
+    for (HashSet<unsigned>::ConstIterator i = nodesToProcess_.Begin(); i != nodesToProcess_.End(); ++i)
+        prioritizedNodes_.Push(MakePair(GetNodePriority(*i), *i));
+
+    Sort(prioritizedNodes_.Begin(), prioritizedNodes_.End(),
+        [](const Pair<float, unsigned>& lhs, const Pair<float, unsigned>& rhs) { return lhs.first_ > rhs.first_; });
+
+    // Nodes that do not fit stay dirty and gain priority for the next update
+    numDeferredNodes_ = 0;
+    for (i32 i = 0; i < prioritizedNodes_.Size(); ++i)
+    {
+        unsigned nodeID = prioritizedNodes_[i].second_;
+        if (nodesToProcess_.Contains(nodeID) && updateBytes_ >= budget)
+        {
+            ++nodeStaleness_[nodeID];
+            ++numDeferredNodes_;
+        }
+        else
+        {
+            // Also forget staleness of the nodes already processed as dependencies
+            ProcessNode(nodeID);
+            nodeStaleness_.Erase(nodeID);
+        }
+    }
+
+    nodesToProcess_.Clear();
+}
+
+float Connection::GetNodePriority(unsigned nodeID) const
+{
+    // Removals are sent first
+    HashMap<unsigned, NodeReplicationState>::ConstIterator i = sceneState_.nodeStates_.Find(nodeID);
+    Node* node = i != sceneState_.nodeStates_.End() ? i->second_.node_.Get() : scene_->GetNode(nodeID);
+    if (!node)
+        return M_INFINITY;
+
+    HashMap<unsigned, unsigned>::ConstIterator staleness = nodeStaleness_.Find(nodeID);
+    float priority = 1.0f + (staleness != nodeStaleness_.End() ? (float)staleness->second_ : 0.0f);
+
+    // Importance is relative to the default base priority of 100
+    auto* networkPriority = node->GetComponent<NetworkPriority>();
+    if (networkPriority)
+        priority *= networkPriority->GetBasePriority() / 100.0f;
+
+    if (sendMode_ != OPSM_NONE)
+        priority /= 1.0f + (CalculateWorldPosition(node) - position_).Length() / relevanceDistance_;
+
+    return priority;
+}
+
+void Connection::UpdateInterest()
+{
+    // Interest management needs the observer position from the client
+    auto* interest = scene_->GetComponent<InterestManager>();
+    if (!interest || !interest->IsEnabledEffective() || sendMode_ == OPSM_NONE)
+    {
+        if (sceneState_.interestManaged_)
+        {
+            // All nodes are relevant again, check them for creating the missing ones
+            sceneState_.interestManaged_ = false;
+            sceneState_.relevantNodes_.Clear();
+            MarkNodeTreeDirty(scene_, sceneState_.dirtyNodes_);
+        }
+        return;
+    }
+
+    if (!sceneState_.interestManaged_)
+    {
+        // Check the nodes the client has already received for removing the irrelevant ones
+        sceneState_.interestManaged_ = true;
+        for (HashMap<unsigned, NodeReplicationState>::ConstIterator i = sceneState_.nodeStates_.Begin();
+             i != sceneState_.nodeStates_.End(); ++i)
+            sceneState_.dirtyNodes_.Insert(i->first_);
+    }
+
+    interest->GetRelevantNodes(relevantNodes_, position_, sceneState_.relevantNodes_);
+
+    for (HashSet<unsigned>::ConstIterator i = relevantNodes_.Begin(); i != relevantNodes_.End(); ++i)
+    {
+        if (!sceneState_.relevantNodes_.Contains(*i))
+        {
+            Node* node = scene_->GetNode(*i);
+            if (node)
+                MarkNodeTreeDirty(node, sceneState_.dirtyNodes_);
+        }
+    }
+
+    // Removed nodes are already dirty
+    for (HashSet<unsigned>::ConstIterator i = sceneState_.relevantNodes_.Begin(); i != sceneState_.relevantNodes_.End(); ++i)
+    {
+        if (!relevantNodes_.Contains(*i))
+        {
+            Node* node = scene_->GetNode(*i);
+            if (node)
+                MarkNodeTreeDirty(node, sceneState_.dirtyNodes_);
+        }
+    }
+
+    sceneState_.relevantNodes_.Swap(relevantNodes_);
+}
+
+bool Connection::IsRelevant(Node* node) const
+{
+    if (!sceneState_.interestManaged_ || node == scene_)
+        return true;
+
+    // Children share the relevance of their root level node. Nodes owned by the client are always relevant
+    Node* parent = node->GetParent();
+    while (parent && parent != scene_)
+    {
+        node = parent;
+        parent = node->GetParent();
+    }
+
+    return node->GetOwner() == this || sceneState_.relevantNodes_.Contains(node->GetID());
+}
+
+void Connection::RemoveIrrelevantNode(Node* node, NodeReplicationState& nodeState)
+{
+    unsigned nodeID = node->GetID();
+    node->RemoveReplicationState(&nodeState);
+    for (HashMap<unsigned, ComponentReplicationState>::Iterator i = nodeState.componentStates_.Begin();
+         i != nodeState.componentStates_.End(); ++i)
+    {
+        Component* component = i->second_.component_;
+        if (component)
+            component->RemoveReplicationState(&i->second_);
+    }
+
+    msg_.Clear();
+    msg_.WriteNetID(nodeID);
+    SendMessage(MSG_REMOVENODE, true, true, msg_);
+
+    sceneState_.nodeStates_.Erase(nodeID);
+    sceneState_.dirtyNodes_.Erase(nodeID);
+}
+
 void Connection::ProcessNewNode(Node* node)
 {
     // Process depended upon nodes first, if they are dirty
@@ -1292,7 +1928,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     auto* priority = node->GetComponent<NetworkPriority>();
     if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
     {
-        float distance = (node->GetWorldPosition() - position_).Length();
+        float distance = (CalculateWorldPosition(node) - position_).Length();
         if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
             return;
     }
@@ -1313,11 +1949,12 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             }
         }
 
-        // Send latestdata message if necessary
-        if (hasLatestData)
+        // Send latestdata message if necessary. In snapshot mode the transform is sent in the snapshot instead
+        if (hasLatestData && replicationMode_ != REPLICATION_SNAPSHOT)
         {
             msg_.Clear();
             msg_.WriteNetID(node->GetID());
+            msg_.WriteU16((u16)serverTime_);
             node->WriteLatestDataUpdate(msg_, timeStamp_);
 
             SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
@@ -1641,6 +2278,12 @@ String Connection::GetAddress() const
     return String(address_->ToString(false /*write port*/));
 }
 
+void Connection::SetLoopback(Connection* remote)
+{
+    loopback_ = remote;
+    loopbackPackets_.Clear();
+}
+
 void Connection::SetAddressOrGUID(const SLNet::AddressOrGUID& addr)
 {
     delete address_;
@@ -9,7 +9,10 @@
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
 #include "../Input/Controls.h"
+#include "../IO/Compression.h"
 #include "../IO/VectorBuffer.h"
+#include "../Network/PacketBuffer.h"
+#include "../Network/Snapshot.h"
 #include "../Scene/ReplicationState.h"
 
 namespace SLNet
@@ -87,12 +90,22 @@ enum ObserverPositionSendMode
     OPSM_POSITION_ROTATION
 };
 
+/// Replication modes for node transforms.
+enum ReplicationMode
+{
+    /// Send node transforms as reliable latest data messages.
+    REPLICATION_LATESTDATA = 0,
+    /// Send node transforms in unreliable snapshots, delta-compressed against the last snapshot the client acknowledged.
+    REPLICATION_SNAPSHOT
+};
+
 /// Packet types for outgoing buffers. Outgoing messages are grouped by their type
 enum PacketType {
     PT_UNRELIABLE_UNORDERED,
     PT_UNRELIABLE_ORDERED,
     PT_RELIABLE_UNORDERED,
-    PT_RELIABLE_ORDERED
+    PT_RELIABLE_ORDERED,
+    MAX_PACKET_TYPES
 };
 
 /// %Connection to a remote network host.
@@ -138,6 +151,10 @@ public:
     void Disconnect(int waitMSec = 0);
     /// Send scene update messages. Called by Network.
     void SendServerUpdate();
+    /// Build scene update messages into queued packets without sending them. Can be called for different connections in parallel while the scene is not modified. Called by Network.
+    void BuildServerUpdate();
+    /// Send the packets queued by BuildServerUpdate(). Called by Network.
+    void FinishServerUpdate();
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
     /// Send queued remote events. Called by Network.
@@ -152,6 +169,8 @@ public:
     void ProcessPendingLatestData();
     /// Process a message from the server or client. Called by Network.
     bool ProcessMessage(int msgID, MemoryBuffer& buffer);
+    /// Process packets received from the loopback connection. Called by Network.
+    void ProcessLoopbackPackets();
     /// Ban this connections IP address.
     void Ban();
     /// Return the RakNet address/guid.
@@ -160,6 +179,11 @@ public:
     void SetAddressOrGUID(const SLNet::AddressOrGUID& addr);
     /// Return client identity.
     VariantMap& GetIdentity() { return identity_; }
+    /// Deliver sent packets directly to another connection in the same process instead of through the network. Used for headless testing.
+    void SetLoopback(Connection* remote);
+
+    /// Return the connection sent packets are delivered to in the same process, or null if not a loopback connection.
+    Connection* GetLoopback() const { return loopback_; }
 
     /// Return the scene used by this connection.
     /// @property
@@ -249,6 +273,71 @@ public:
     void ConfigureNetworkSimulator(int latencyMs, float packetLoss);
     /// Buffered packet size limit, when reached, packet is sent out immediately
     void SetPacketSizeLimit(int limit);
+    /// Enable or disable compression of outgoing packets of the given type. The remote end decompresses automatically, but must use the same dictionary if one is set.
+    void SetCompression(PacketType type, bool enable);
+    /// Set the codec used for compressing outgoing packets.
+    void SetCompressionCodec(CompressionCodec codec);
+    /// Set a trained dictionary for Zstandard compression, or null to compress without one. Both ends of the connection must use the same dictionary.
+    void SetCompressionDictionary(CompressionDictionary* dictionary);
+    /// Set the minimum packet payload size in bytes for which compression is attempted.
+    void SetCompressionThreshold(unsigned bytes);
+
+    /// Return whether outgoing packets of the given type are compressed.
+    bool GetCompression(PacketType type) const { return compressPacketType_[type]; }
+    /// Return the codec used for compressing outgoing packets.
+    CompressionCodec GetCompressionCodec() const { return compressionCodec_; }
+    /// Return the dictionary used for Zstandard compression.
+    CompressionDictionary* GetCompressionDictionary() const { return compressionDictionary_; }
+    /// Return the minimum packet payload size for which compression is attempted.
+    unsigned GetCompressionThreshold() const { return compressionThreshold_; }
+    /// Set how node transforms are replicated to the client. Called on the server.
+    /// @property
+    void SetReplicationMode(ReplicationMode mode);
+    /// Set position precision of snapshots in world units. Called on the server. Default 0.001.
+    /// @property
+    void SetSnapshotPrecision(float precision);
+
+    /// Return how node transforms are replicated to the client.
+    /// @property
+    ReplicationMode GetReplicationMode() const { return replicationMode_; }
+
+    /// Return position precision of snapshots.
+    /// @property
+    float GetSnapshotPrecision() const { return snapshotPrecision_; }
+
+    /// Set bandwidth budget of scene updates in bytes per second. Node updates that do not fit are deferred, the most important ones being sent first. Zero (default) is unlimited. Called on the server.
+    /// @property
+    void SetBandwidthLimit(unsigned bytesPerSec);
+    /// Set distance from the observer position at which node update priority is halved when bandwidth limited. Default 100.
+    /// @property
+    void SetRelevanceDistance(float distance);
+
+    /// Return bandwidth budget of scene updates in bytes per second.
+    /// @property
+    unsigned GetBandwidthLimit() const { return bandwidthLimit_; }
+
+    /// Return distance from the observer position at which node update priority is halved.
+    /// @property
+    float GetRelevanceDistance() const { return relevanceDistance_; }
+
+    /// Return message bytes sent per second, measured over the last second of server updates.
+    /// @property
+    float GetMessageBytesPerSec() const { return messageBytesPerSec_; }
+
+    /// Return number of dirty nodes deferred by the bandwidth budget on the last server update.
+    /// @property
+    i32 GetNumDeferredNodes() const { return numDeferredNodes_; }
+    /// Return number of pooled outgoing packet buffers, including those in use.
+    i32 GetNumPacketBuffers() const { return packetPool_.GetNumBuffers(); }
+
+    /// Return sequence number of the latest snapshot sent, or received and applied. Zero if none.
+    unsigned GetSnapshotSequence() const { return snapshotSequence_; }
+    /// Return sequence number of the latest snapshot acknowledged by the client. Zero if none.
+    unsigned GetAckedSnapshot() const { return ackedSnapshot_; }
+    /// Return total payload bytes of outgoing packets before compression.
+    unsigned long long GetUncompressedBytesOut() const { return uncompressedBytesOut_; }
+    /// Return total payload bytes of outgoing packets after compression.
+    unsigned long long GetCompressedBytesOut() const { return compressedBytesOut_; }
 
     /// Current controls.
     Controls controls_;
@@ -274,6 +363,20 @@ private:
     void ProcessControls(int msgID, MemoryBuffer& msg);
     /// Process a SceneLoaded message from the client. Called by Network.
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
+    /// Process a Snapshot message from the server.
+    void ProcessSnapshot(int msgID, MemoryBuffer& msg);
+    /// Process a SnapshotAck message from the client.
+    void ProcessSnapshotAck(int msgID, MemoryBuffer& msg);
+    /// Write the snapshot of the nodes the client has received.
+    void WriteSnapshot();
+    /// Clear snapshot state when the scene changes.
+    void ResetSnapshots();
+    /// Set the time of the network update being applied to the scene from a server time sent as the low 16 bits of milliseconds.
+    void ApplyServerTime(u16 time);
+    /// Process dirty nodes in priority order until the bandwidth budget of the update is used.
+    void ProcessPrioritizedNodes(unsigned budget);
+    /// Return update priority of a dirty node for spending the bandwidth budget.
+    float GetNodePriority(unsigned nodeID) const;
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
@@ -282,8 +385,20 @@ private:
     void ProcessNewNode(Node* node);
     /// Process a node that the client has already received.
     void ProcessExistingNode(Node* node, NodeReplicationState& nodeState);
+    /// Update the nodes relevant to the client if the scene has interest management, and mark the ones that entered or left dirty.
+    void UpdateInterest();
+    /// Return whether a node is relevant to the client.
+    bool IsRelevant(Node* node) const;
+    /// Remove a node that is no longer relevant from the client.
+    void RemoveIrrelevantNode(Node* node, NodeReplicationState& nodeState);
     /// Process a SyncPackagesInfo message from server.
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
+    /// Process the messages contained in a packed message.
+    void ProcessPackedMessage(MemoryBuffer& buffer);
+    /// Decompress a compressed packed message and process the messages inside.
+    void ProcessCompressedMessage(MemoryBuffer& buffer);
+    /// Send or queue a finished packet.
+    void SendPacket(PacketType type, PacketBuffer* packet);
     /// Process unknown message. All unknown messages are forwarded as an events
     void ProcessUnknownMessage(int msgID, MemoryBuffer& msg);
     /// Check a package list received from server and initiate package downloads as necessary. Return true on success, or false if failed to initialze downloads (cache dir not set).
@@ -308,11 +423,15 @@ private:
     /// Ongoing package send transfers.
     HashMap<StringHash, PackageUpload> uploads_;
     /// Pending latest data for not yet received nodes.
-    HashMap<unsigned, Vector<byte>> nodeLatestData_;
+    HashMap<unsigned, SharedPtr<PacketBuffer>> nodeLatestData_;
     /// Pending latest data for not yet received components.
-    HashMap<unsigned, Vector<byte>> componentLatestData_;
+    HashMap<unsigned, SharedPtr<PacketBuffer>> componentLatestData_;
+    /// Pool of pending latest data buffers, reused once the data has been applied.
+    PacketBufferPool latestDataPool_;
     /// Node ID's to process during a replication update.
     HashSet<unsigned> nodesToProcess_;
+    /// Root level node ID's relevant to the client during a replication update.
+    HashSet<unsigned> relevantNodes_;
     /// Reusable message buffer.
     VectorBuffer msg_;
     /// Queued remote events.
@@ -349,10 +468,78 @@ private:
     Timer packetCounterTimer_;
     /// Last heard timer, resets when new packet is incoming.
     Timer lastHeardTimer_;
-    /// Outgoing packet buffer which can contain multiple messages
-    HashMap<int, VectorBuffer> outgoingBuffer_;
+    /// Outgoing packet buffers by packet type which can contain multiple messages.
+    SharedPtr<PacketBuffer> outgoingBuffers_[MAX_PACKET_TYPES];
+    /// Pool of outgoing packet buffers, reused once sent or delivered.
+    PacketBufferPool packetPool_;
     /// Outgoing packet size limit
     int packedMessageLimit_;
+    /// Per packet type compression enable flags.
+    bool compressPacketType_[MAX_PACKET_TYPES];
+    /// Codec for outgoing packet compression.
+    CompressionCodec compressionCodec_;
+    /// Dictionary for Zstandard packet compression.
+    SharedPtr<CompressionDictionary> compressionDictionary_;
+    /// Minimum payload size for attempting compression.
+    unsigned compressionThreshold_;
+    /// Reusable buffer for decompressed incoming packets.
+    Vector<byte> decompressedBuffer_;
+    /// Outgoing payload bytes before compression.
+    unsigned long long uncompressedBytesOut_;
+    /// Outgoing payload bytes after compression.
+    unsigned long long compressedBytesOut_;
+    /// Packets built during the server update, waiting to be sent.
+    Vector<Pair<PacketType, SharedPtr<PacketBuffer>>> queuedPackets_;
+    /// Queue finished packets instead of sending flag.
+    bool queuePackets_;
+    /// Connection to deliver sent packets to in the same process.
+    WeakPtr<Connection> loopback_;
+    /// Packets received from the loopback connection with their delivery times.
+    Vector<Pair<unsigned, SharedPtr<PacketBuffer>>> loopbackPackets_;
+    /// Loopback packets being delivered. Kept to reuse its memory.
+    Vector<Pair<unsigned, SharedPtr<PacketBuffer>>> deliveredPackets_;
+    /// Recent snapshots sent to or received from the remote end.
+    SnapshotBuffer snapshots_;
+    /// Snapshot transforms received for nodes the client has not created yet.
+    HashMap<unsigned, Pair<Vector3, Quaternion>> pendingSnapshotTransforms_;
+    /// Node transform replication mode.
+    ReplicationMode replicationMode_;
+    /// Snapshot position precision.
+    float snapshotPrecision_;
+    /// Latest snapshot sent, or received and applied.
+    unsigned snapshotSequence_;
+    /// Latest snapshot acknowledged by the client.
+    unsigned ackedSnapshot_;
+    /// Snapshot acknowledgement to send flag.
+    bool snapshotAckPending_;
+    /// Simulated latency of loopback packets in milliseconds.
+    int simulatedLatency_;
+    /// Simulated loss probability of unreliable loopback packets.
+    float simulatedPacketLoss_;
+    /// Dirty node ID's with their update priorities, sorted for spending the bandwidth budget.
+    Vector<Pair<float, unsigned>> prioritizedNodes_;
+    /// Number of server updates each deferred node has waited.
+    HashMap<unsigned, unsigned> nodeStaleness_;
+    /// Bandwidth budget in bytes per second.
+    unsigned bandwidthLimit_;
+    /// Distance at which node update priority is halved.
+    float relevanceDistance_;
+    /// Unused bandwidth budget carried over from previous updates in bytes.
+    float bandwidthCredit_;
+    /// Message bytes sent since the server update started.
+    unsigned updateBytes_;
+    /// Message bytes sent during the current measurement period.
+    unsigned measuredBytes_;
+    /// Length of the current measurement period in seconds.
+    float measuredTime_;
+    /// Message bytes per second over the last measurement period.
+    float messageBytesPerSec_;
+    /// Number of nodes deferred on the last server update.
+    i32 numDeferredNodes_;
+    /// Server time in milliseconds of the update being built, or of the latest update received.
+    unsigned serverTime_;
+    /// Server time received flag.
+    bool serverTimeValid_;
 };
 
 }
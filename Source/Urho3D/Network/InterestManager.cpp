@@ -0,0 +1,177 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Network/InterestManager.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* NETWORK_CATEGORY;
+
+static const float DEFAULT_CELL_SIZE = 50.0f;
+static const float DEFAULT_INTEREST_RADIUS = 100.0f;
+static const float DEFAULT_LEAVE_MARGIN = 10.0f;
+
+/// Add the nodes within the enter distance, or within the leave distance if they were relevant before.
+static void CollectRelevantNodes(HashSet<unsigned>& dest, const Vector<Node*>& nodes, const Vector3& position,
+    const HashSet<unsigned>& previous, float enterDistanceSquared, float leaveDistanceSquared)
+{
+    // World positions were made current by UpdateGrid(), so reading them does not modify the nodes
+    for (Node* node : nodes)
+    {
+        unsigned nodeID = node->GetID();
+        float distanceSquared = (node->GetWorldPosition() - position).LengthSquared();
+        if (distanceSquared <= (previous.Contains(nodeID) ? leaveDistanceSquared : enterDistanceSquared))
+            dest.Insert(nodeID);
+    }
+}
+
+InterestManager::InterestManager(Context* context) :
+    Component(context),
+    cellSize_(DEFAULT_CELL_SIZE),
+    interestRadius_(DEFAULT_INTEREST_RADIUS),
+    leaveMargin_(DEFAULT_LEAVE_MARGIN),
+    numNodes_(0)
+{
+}
+
+InterestManager::~InterestManager() = default;
+
+void InterestManager::RegisterObject(Context* context)
+{
+    context->RegisterFactory<InterestManager>(NETWORK_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cell Size", GetCellSize, SetCellSize, DEFAULT_CELL_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Interest Radius", GetInterestRadius, SetInterestRadius, DEFAULT_INTEREST_RADIUS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Leave Margin", GetLeaveMargin, SetLeaveMargin, DEFAULT_LEAVE_MARGIN, AM_DEFAULT);
+}
+
+void InterestManager::SetCellSize(float size)
+{
+    cellSize_ = Max(size, M_EPSILON);
+    cells_.Clear();
+    MarkNetworkUpdate();
+}
+
+void InterestManager::SetInterestRadius(float radius)
+{
+    interestRadius_ = Max(radius, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void InterestManager::SetLeaveMargin(float margin)
+{
+    leaveMargin_ = Max(margin, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void InterestManager::SetAlwaysRelevant(Node* node, bool enable)
+{
+    if (!node)
+        return;
+
+    if (enable)
+        alwaysRelevant_.Insert(node->GetID());
+    else
+        alwaysRelevant_.Erase(node->GetID());
+}
+
+bool InterestManager::IsAlwaysRelevant(Node* node) const
+{
+    return node && alwaysRelevant_.Contains(node->GetID());
+}
+
+void InterestManager::UpdateGrid()
+{
+    URHO3D_PROFILE(UpdateInterestGrid);
+
+    // Keep the cell vectors to avoid reallocating them every update
+    for (HashMap<IntVector3, Vector<Node*>>::Iterator i = cells_.Begin(); i != cells_.End(); ++i)
+        i->second_.Clear();
+
+    numNodes_ = 0;
+
+    if (node_)
+    {
+        // Only the root level nodes are placed in the grid. Their children share their relevance,
+        // so that the client never receives a node without its parent
+        const Vector<SharedPtr<Node>>& children = node_->GetChildren();
+        for (i32 i = 0; i < children.Size(); ++i)
+        {
+            Node* child = children[i];
+            if (!child->IsReplicated())
+                continue;
+
+            cells_[GetCell(child->GetWorldPosition())].Push(child);
+            ++numNodes_;
+        }
+    }
+
+    for (HashMap<IntVector3, Vector<Node*>>::Iterator i = cells_.Begin(); i != cells_.End();)
+    {
+        if (i->second_.Empty())
+            i = cells_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+void InterestManager::GetRelevantNodes(HashSet<unsigned>& dest, const Vector3& position, const HashSet<unsigned>& previous) const
+{
+    dest.Clear();
+
+    for (HashSet<unsigned>::ConstIterator i = alwaysRelevant_.Begin(); i != alwaysRelevant_.End(); ++i)
+        dest.Insert(*i);
+
+    float enterDistanceSquared = interestRadius_ * interestRadius_;
+    float leaveDistance = interestRadius_ + leaveMargin_;
+    float leaveDistanceSquared = leaveDistance * leaveDistance;
+
+    IntVector3 minCell = GetCell(position - Vector3(leaveDistance, leaveDistance, leaveDistance));
+    IntVector3 maxCell = GetCell(position + Vector3(leaveDistance, leaveDistance, leaveDistance));
+    i64 numQueryCells = (i64)(maxCell.x_ - minCell.x_ + 1) * (maxCell.y_ - minCell.y_ + 1) * (maxCell.z_ - minCell.z_ + 1);
+
+    // Look up the cells within the leave distance, or go through the occupied cells if there are less of them
+    if (numQueryCells <= cells_.Size())
+    {
+        for (int z = minCell.z_; z <= maxCell.z_; ++z)
+        {
+            for (int y = minCell.y_; y <= maxCell.y_; ++y)
+            {
+                for (int x = minCell.x_; x <= maxCell.x_; ++x)
+                {
+                    HashMap<IntVector3, Vector<Node*>>::ConstIterator i = cells_.Find(IntVector3(x, y, z));
+                    if (i != cells_.End())
+                        CollectRelevantNodes(dest, i->second_, position, previous, enterDistanceSquared, leaveDistanceSquared);
+                }
+            }
+        }
+    }
+    else
+    {
+        for (HashMap<IntVector3, Vector<Node*>>::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            const IntVector3& cell = i->first_;
+            if (cell.x_ < minCell.x_ || cell.y_ < minCell.y_ || cell.z_ < minCell.z_ || cell.x_ > maxCell.x_ ||
+                cell.y_ > maxCell.y_ || cell.z_ > maxCell.z_)
+                continue;
+
+            CollectRelevantNodes(dest, i->second_, position, previous, enterDistanceSquared, leaveDistanceSquared);
+        }
+    }
+}
+
+IntVector3 InterestManager::GetCell(const Vector3& position) const
+{
+    return IntVector3(FloorToInt(position.x_ / cellSize_), FloorToInt(position.y_ / cellSize_), FloorToInt(position.z_ / cellSize_));
+}
+
+}
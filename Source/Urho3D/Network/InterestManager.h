@@ -0,0 +1,83 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#pragma once
+
+#include "../Container/HashSet.h"
+#include "../Math/Vector3.h"
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class Connection;
+
+/// %Network interest management component. Place in the scene root node to replicate to each client only the nodes near its observer position.
+class URHO3D_API InterestManager : public Component
+{
+    URHO3D_OBJECT(InterestManager, Component);
+
+public:
+    /// Construct.
+    explicit InterestManager(Context* context);
+    /// Destruct.
+    ~InterestManager() override;
+    /// Register object factory.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Set grid cell size. Should be in the order of the interest radius. Default 50.
+    /// @property
+    void SetCellSize(float size);
+    /// Set distance from the observer position within which nodes become relevant. Default 100.
+    /// @property
+    void SetInterestRadius(float radius);
+    /// Set additional distance nodes must move beyond the interest radius before they become irrelevant again. Default 10.
+    /// @property
+    void SetLeaveMargin(float margin);
+    /// Set whether a root level node and its children are always relevant regardless of distance.
+    void SetAlwaysRelevant(Node* node, bool enable);
+
+    /// Return grid cell size.
+    /// @property
+    float GetCellSize() const { return cellSize_; }
+
+    /// Return interest radius.
+    /// @property
+    float GetInterestRadius() const { return interestRadius_; }
+
+    /// Return leave margin.
+    /// @property
+    float GetLeaveMargin() const { return leaveMargin_; }
+
+    /// Return whether a node is always relevant.
+    bool IsAlwaysRelevant(Node* node) const;
+    /// Return number of nodes in the grid.
+    i32 GetNumNodes() const { return numNodes_; }
+    /// Return number of occupied grid cells.
+    i32 GetNumCells() const { return cells_.Size(); }
+
+    /// Rebuild the grid from the root level replicated nodes. Called by Network before the server update.
+    void UpdateGrid();
+    /// Return the IDs of the root level nodes relevant to an observer position. Nodes in the previous set stay relevant until beyond the leave margin. Called by Connection, possibly from worker threads.
+    void GetRelevantNodes(HashSet<unsigned>& dest, const Vector3& position, const HashSet<unsigned>& previous) const;
+
+private:
+    /// Return grid cell of a position.
+    IntVector3 GetCell(const Vector3& position) const;
+
+    /// Grid cells with the root level nodes inside them.
+    HashMap<IntVector3, Vector<Node*>> cells_;
+    /// Always relevant root level node IDs.
+    HashSet<unsigned> alwaysRelevant_;
+    /// Grid cell size.
+    float cellSize_;
+    /// Interest radius.
+    float interestRadius_;
+    /// Leave margin.
+    float leaveMargin_;
+    /// Number of nodes in the grid.
+    i32 numNodes_;
+};
+
+}
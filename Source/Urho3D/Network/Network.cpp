@@ -6,6 +6,7 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
@@ -13,6 +14,7 @@
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Network/HttpRequest.h"
+#include "../Network/InterestManager.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -174,6 +176,11 @@ static const char* RAKNET_MESSAGEID_STRINGS[] = {
 static const int DEFAULT_UPDATE_FPS = 30;
 static const int SERVER_TIMEOUT_TIME = 10000;
 
+static void BuildServerUpdateWork(const WorkItem* item, i32 threadIndex)
+{
+    static_cast<Connection*>(item->aux_)->BuildServerUpdate();
+}
+
 Network::Network(Context* context) :
     Object(context),
     updateFps_(DEFAULT_UPDATE_FPS),
@@ -181,6 +188,10 @@ Network::Network(Context* context) :
     simulatedPacketLoss_(0.0f),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
     updateAcc_(0.0f),
+    serverTime_(0),
+    serverTimeAcc_(0.0f),
+    parallelServerUpdate_(true),
+    loopbackPort_(0),
     isServer_(false),
     scene_(nullptr),
     natPunchServerAddress_(nullptr),
@@ -256,6 +267,7 @@ Network::~Network()
     serverConnection_.Reset();
 
     clientConnections_.Clear();
+    loopbackConnections_.Clear();
 
     delete natPunchthroughServerClient_;
     natPunchthroughServerClient_ = nullptr;
@@ -399,6 +411,50 @@ void Network::Disconnect(int waitMSec)
     serverConnection_->Disconnect(waitMSec);
 }
 
+Connection* Network::ConnectLoopback(Scene* scene, const VariantMap& identity)
+{
+    if (!scene)
+    {
+        URHO3D_LOGERROR("Can not connect a loopback client without a scene");
+        return nullptr;
+    }
+
+    // Loopback connections are told apart by low port numbers, which real clients do not use
+    SLNet::AddressOrGUID address;
+    address.systemAddress.FromStringExplicitPort("127.0.0.1", ++loopbackPort_);
+
+    SharedPtr<Connection> clientConnection(new Connection(context_, false, address, nullptr));
+    SharedPtr<Connection> serverConnection(new Connection(context_, true, address, nullptr));
+    clientConnection->SetLoopback(serverConnection);
+    serverConnection->SetLoopback(clientConnection);
+    serverConnection->identity_ = identity;
+    clientConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+    serverConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+    clientConnection->SetScene(scene);
+    loopbackConnections_.Push(clientConnection);
+    clientConnections_[address] = serverConnection;
+    URHO3D_LOGINFO("Loopback client " + serverConnection->ToString() + " connected");
+
+    using namespace ClientConnected;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_CONNECTION] = serverConnection;
+    serverConnection->SendEvent(E_CLIENTCONNECTED, eventData);
+
+    return clientConnection;
+}
+
+void Network::DisconnectLoopback(Connection* connection)
+{
+    if (!connection || !connection->GetLoopback())
+        return;
+
+    SharedPtr<Connection> clientConnection(connection->IsClient() ? connection->GetLoopback() : connection);
+    loopbackConnections_.Remove(clientConnection);
+    ClientDisconnected(clientConnection->GetAddressOrGUID());
+    clientConnection->SetScene(nullptr);
+}
+
 bool Network::StartServer(unsigned short port, unsigned int maxConnections)
 {
     if (IsServerRunning())
@@ -431,6 +487,7 @@ bool Network::StartServer(unsigned short port, unsigned int maxConnections)
 void Network::StopServer()
 {
     clientConnections_.Clear();
+    loopbackConnections_.Clear();
 
     if (!rakPeer_)
         return;
@@ -551,6 +608,11 @@ void Network::BroadcastRemoteEvent(Node* node, StringHash eventType, bool inOrde
     }
 }
 
+void Network::SetParallelServerUpdate(bool enable)
+{
+    parallelServerUpdate_ = enable;
+}
+
 void Network::SetUpdateFps(int fps)
 {
     updateFps_ = Max(fps, 1);
@@ -890,12 +952,29 @@ void Network::Update(float timeStep)
             rakPeerClient_->DeallocatePacket(packet);
         }
     }
+
+    // Process the packets of in-process loopback clients on both ends
+    if (!loopbackConnections_.Empty())
+    {
+        Vector<SharedPtr<Connection>> connections = GetClientConnections();
+        for (i32 i = 0; i < connections.Size(); ++i)
+            connections[i]->ProcessLoopbackPackets();
+
+        connections = loopbackConnections_;
+        for (i32 i = 0; i < connections.Size(); ++i)
+            connections[i]->ProcessLoopbackPackets();
+    }
 }
 
 void Network::PostUpdate(float timeStep)
 {
     URHO3D_PROFILE(PostUpdateNetwork);
 
+    serverTimeAcc_ += timeStep * 1000.0f;
+    auto elapsedMs = (unsigned)serverTimeAcc_;
+    serverTime_ += elapsedMs;
+    serverTimeAcc_ -= elapsedMs;
+
     // Check if periodic update should happen now
     updateAcc_ += timeStep;
     bool updateNow = updateAcc_ >= updateInterval_;
@@ -905,7 +984,7 @@ void Network::PostUpdate(float timeStep)
         SendEvent(E_NETWORKUPDATE);
         updateAcc_ = fmodf(updateAcc_, updateInterval_);
 
-        if (IsServerRunning())
+        if (IsServerRunning() || !loopbackConnections_.Empty())
         {
             // Collect and prepare all networked scenes
             {
@@ -921,17 +1000,25 @@ void Network::PostUpdate(float timeStep)
                 }
 
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+                {
                     (*i)->PrepareNetworkUpdate();
+
+                    auto* interest = (*i)->GetComponent<InterestManager>();
+                    if (interest && interest->IsEnabledEffective())
+                        interest->UpdateGrid();
+                }
             }
 
             {
                 URHO3D_PROFILE(SendServerUpdate);
 
-                // Then send server updates for each client connection
+                // Then build server updates for each client connection, and send them on the main thread
+                BuildServerUpdates();
+
                 for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
                      i != clientConnections_.End(); ++i)
                 {
-                    i->second_->SendServerUpdate();
+                    i->second_->FinishServerUpdate();
                     i->second_->SendRemoteEvents();
                     i->second_->SendPackages();
                     i->second_->SendAllBuffers();
@@ -947,6 +1034,14 @@ void Network::PostUpdate(float timeStep)
             serverConnection_->SendAllBuffers();
         }
 
+        for (i32 i = 0; i < loopbackConnections_.Size(); ++i)
+        {
+            Connection* connection = loopbackConnections_[i];
+            connection->SendClientUpdate();
+            connection->SendRemoteEvents();
+            connection->SendAllBuffers();
+        }
+
         // Notify that the update was sent
         SendEvent(E_NETWORKUPDATESENT);
     }
@@ -966,6 +1061,45 @@ void Network::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
     PostUpdate(eventData[P_TIMESTEP].GetFloat());
 }
 
+void Network::BuildServerUpdates()
+{
+    updateConnections_.Clear();
+    for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
+         i != clientConnections_.End(); ++i)
+    {
+        if (i->second_->GetScene() && i->second_->IsSceneLoaded())
+            updateConnections_.Push(i->second_);
+    }
+
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (!parallelServerUpdate_ || !queue || !queue->GetNumThreads() || updateConnections_.Size() < 2)
+    {
+        for (i32 i = 0; i < updateConnections_.Size(); ++i)
+            updateConnections_[i]->BuildServerUpdate();
+        return;
+    }
+
+    // The scenes are only read while the updates are built. Threaded update mode makes adding replication states to
+    // nodes and components thread-safe
+    for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+        (*i)->BeginThreadedUpdate();
+
+    // Build each connection's update in its own work item, as their costs vary with the nodes visible to each client
+    for (i32 i = 0; i < updateConnections_.Size(); ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = WI_MAX_PRIORITY;
+        item->workFunction_ = BuildServerUpdateWork;
+        item->aux_ = updateConnections_[i];
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(WI_MAX_PRIORITY);
+
+    for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+        (*i)->EndThreadedUpdate();
+}
+
 void Network::OnServerConnected(const SLNet::AddressOrGUID& address)
 {
     serverConnection_->SetConnectPending(false);
@@ -1011,10 +1145,14 @@ void Network::ConfigureNetworkSimulator()
     for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
          i != clientConnections_.End(); ++i)
         i->second_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+
+    for (i32 i = 0; i < loopbackConnections_.Size(); ++i)
+        loopbackConnections_[i]->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
 }
 
 void RegisterNetworkLibrary(Context* context)
 {
+    InterestManager::RegisterObject(context);
     NetworkPriority::RegisterObject(context);
 }
 
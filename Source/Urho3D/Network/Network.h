@@ -45,6 +45,10 @@ public:
     bool Connect(const String& address, unsigned short port, Scene* scene, const VariantMap& identity = Variant::emptyVariantMap);
     /// Disconnect the connection to the server. If wait time is non-zero, will block while waiting for disconnect to finish.
     void Disconnect(int waitMSec = 0);
+    /// Connect an in-process client to this network instance acting as server, without sockets. The client side connection replicates into the scene and is returned, while the server side connection is added to the client connections. Used for headless load testing.
+    Connection* ConnectLoopback(Scene* scene, const VariantMap& identity = Variant::emptyVariantMap);
+    /// Disconnect an in-process client, given either its client or server side connection.
+    void DisconnectLoopback(Connection* connection);
     /// Start a server on a port using UDP protocol. Return true if successful.
     bool StartServer(unsigned short port, unsigned int maxConnections = 128);
     /// Stop the server.
@@ -69,6 +73,9 @@ public:
     /// Set network update FPS.
     /// @property
     void SetUpdateFps(int fps);
+    /// Set whether to build the server updates of client connections in parallel on worker threads. Default true.
+    /// @property
+    void SetParallelServerUpdate(bool enable);
     /// Set simulated latency in milliseconds. This adds a fixed delay before sending each packet.
     /// @property
     void SetSimulatedLatency(int ms);
@@ -94,6 +101,13 @@ public:
     /// @property
     int GetUpdateFps() const { return updateFps_; }
 
+    /// Return server time in milliseconds, which is sent to clients for interpolating node transforms. Advanced by PostUpdate().
+    unsigned GetServerTime() const { return serverTime_; }
+
+    /// Return whether server updates are built in parallel on worker threads.
+    /// @property
+    bool GetParallelServerUpdate() const { return parallelServerUpdate_; }
+
     /// Return simulated latency in milliseconds.
     /// @property
     int GetSimulatedLatency() const { return simulatedLatency_; }
@@ -134,6 +148,8 @@ private:
     void OnServerConnected(const SLNet::AddressOrGUID& address);
     /// Handle server disconnection.
     void OnServerDisconnected(const SLNet::AddressOrGUID& address);
+    /// Build the server updates of client connections, in parallel if enabled.
+    void BuildServerUpdates();
     /// Reconfigure network simulator parameters on all existing connections.
     void ConfigureNetworkSimulator();
     /// All incoming packages are handled here.
@@ -151,8 +167,12 @@ private:
     HashSet<StringHash> allowedRemoteEvents_;
     /// Remote event fixed blacklist.
     HashSet<StringHash> blacklistedRemoteEvents_;
+    /// Client side connections of in-process loopback clients.
+    Vector<SharedPtr<Connection>> loopbackConnections_;
     /// Networked scenes.
     HashSet<Scene*> networkScenes_;
+    /// Client connections to build server updates for.
+    Vector<Connection*> updateConnections_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
@@ -163,6 +183,14 @@ private:
     float updateInterval_;
     /// Update time accumulator.
     float updateAcc_;
+    /// Server time in milliseconds.
+    unsigned serverTime_;
+    /// Server time accumulator for fractions of a millisecond.
+    float serverTimeAcc_;
+    /// Parallel server update flag.
+    bool parallelServerUpdate_;
+    /// Port number of the last created loopback connection, used to make their addresses unique.
+    unsigned short loopbackPort_;
     /// Package cache directory.
     String packageCacheDir_;
     /// Whether we started as server or not.
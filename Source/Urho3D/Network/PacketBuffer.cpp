@@ -0,0 +1,48 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../Precompiled.h"
+
+#include "../Network/PacketBuffer.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+PacketBufferPool::PacketBufferPool() :
+    next_(0)
+{
+}
+
+SharedPtr<PacketBuffer> PacketBufferPool::Acquire()
+{
+    // Buffers are released in roughly the order they were acquired, so continue from the last one found
+    for (i32 i = 0; i < buffers_.Size(); ++i)
+    {
+        i32 index = (next_ + i) % buffers_.Size();
+        if (buffers_[index]->Refs() == 1)
+        {
+            next_ = index + 1;
+            buffers_[index]->GetBuffer().Clear();
+            return buffers_[index];
+        }
+    }
+
+    buffers_.Push(SharedPtr<PacketBuffer>(new PacketBuffer()));
+    return buffers_.Back();
+}
+
+i32 PacketBufferPool::GetNumUsed() const
+{
+    i32 used = 0;
+    for (i32 i = 0; i < buffers_.Size(); ++i)
+    {
+        if (buffers_[i]->Refs() > 1)
+            ++used;
+    }
+
+    return used;
+}
+
+}
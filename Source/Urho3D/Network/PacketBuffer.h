@@ -0,0 +1,50 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../IO/VectorBuffer.h"
+
+namespace Urho3D
+{
+
+/// Reference-counted data of a network packet. Can be handed from the outgoing message buffer to the send queue and to an in-process receiver without copying.
+class URHO3D_API PacketBuffer : public RefCounted
+{
+public:
+    /// Return the packet data.
+    VectorBuffer& GetBuffer() { return buffer_; }
+    /// Return the packet data.
+    const VectorBuffer& GetBuffer() const { return buffer_; }
+
+private:
+    /// Packet data.
+    VectorBuffer buffer_;
+};
+
+/// Pool of packet buffers. A buffer is reused once the pool holds the only reference to it, keeping its allocated memory. Not thread-safe.
+class URHO3D_API PacketBufferPool
+{
+public:
+    /// Construct.
+    PacketBufferPool();
+
+    /// Return an empty buffer, reusing a released one if possible.
+    SharedPtr<PacketBuffer> Acquire();
+
+    /// Return number of buffers in the pool.
+    i32 GetNumBuffers() const { return buffers_.Size(); }
+    /// Return number of buffers referenced outside the pool.
+    i32 GetNumUsed() const;
+
+private:
+    /// Buffers, both used and released.
+    Vector<SharedPtr<PacketBuffer>> buffers_;
+    /// Index to start searching released buffers from.
+    i32 next_;
+};
+
+}
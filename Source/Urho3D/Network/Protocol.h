@@ -47,6 +47,12 @@ static const int MSG_PACKAGEINFO = 0x98;
 
 /// Packet that includes all the above messages
 static const int MSG_PACKED_MESSAGE = 0x99;
+/// Packed message that has been compressed as a whole.
+static const int MSG_PACKED_COMPRESSED_MESSAGE = 0x9A;
+/// Server->client: unreliable snapshot of node transforms, delta-compressed against an acknowledged snapshot.
+static const int MSG_SNAPSHOT = 0x9B;
+/// Client->server: acknowledge the latest received snapshot.
+static const int MSG_SNAPSHOTACK = 0x9C;
 
 /// Used to define custom messages, usually of the form MSG_USER + x, where x is an integer value.
 static const int MSG_USER = 0x200;
@@ -55,5 +61,7 @@ static const int MSG_USER = 0x200;
 static const unsigned CONTROLS_CONTENT_ID = 1;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
+/// Maximum accepted uncompressed size of a compressed packed message.
+static const unsigned MAX_DECOMPRESSED_PACKET_SIZE = 16 * 1024 * 1024;
 
 }
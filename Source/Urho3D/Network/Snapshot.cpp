@@ -0,0 +1,235 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../Precompiled.h"
+
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+#include "../Network/Snapshot.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Transform entry flag: position written.
+static const unsigned char SNAPSHOT_POSITION = 0x1;
+/// Transform entry flag: rotation written.
+static const unsigned char SNAPSHOT_ROTATION = 0x2;
+/// Transform entry flag: values written in full instead of as differences to the baseline.
+static const unsigned char SNAPSHOT_ABSOLUTE = 0x4;
+/// Largest zigzag encoded difference that fits a VLE.
+static const unsigned MAX_SNAPSHOT_DELTA = 0x1fffffff;
+
+static unsigned EncodeDelta(i64 delta)
+{
+    return (unsigned)((delta << 1) ^ (delta >> 63));
+}
+
+static i64 DecodeDelta(unsigned value)
+{
+    return (i64)(value >> 1u) ^ -(i64)(value & 1u);
+}
+
+/// Return whether the differences of a transform to its baseline can be written as VLEs.
+static bool CanWriteDelta(const SnapshotTransform& transform, const SnapshotTransform& baseline)
+{
+    for (i32 i = 0; i < 3; ++i)
+    {
+        if (EncodeDelta((i64)transform.position_[i] - baseline.position_[i]) > MAX_SNAPSHOT_DELTA)
+            return false;
+    }
+
+    return true;
+}
+
+SnapshotTransform::SnapshotTransform(const Vector3& position, const Quaternion& rotation, float precision)
+{
+    const float* positionData = position.Data();
+    for (i32 i = 0; i < 3; ++i)
+        position_[i] = (i32)Clamp((double)roundf(positionData[i] / precision), -2147483647.0, 2147483647.0);
+
+    // Keep w non-negative so that the same orientation always quantizes the same
+    Quaternion normalized = rotation.Normalized();
+    if (normalized.w_ < 0.0f)
+        normalized = -normalized;
+
+    const float* rotationData = normalized.Data();
+    for (i32 i = 0; i < 4; ++i)
+        rotation_[i] = (i16)roundf(Clamp(rotationData[i], -1.0f, 1.0f) * 32767.0f);
+}
+
+bool SnapshotTransform::operator ==(const SnapshotTransform& rhs) const
+{
+    return !memcmp(position_, rhs.position_, sizeof position_) && !memcmp(rotation_, rhs.rotation_, sizeof rotation_);
+}
+
+Vector3 SnapshotTransform::GetPosition(float precision) const
+{
+    return Vector3(position_[0] * precision, position_[1] * precision, position_[2] * precision);
+}
+
+Quaternion SnapshotTransform::GetRotation() const
+{
+    return Quaternion(rotation_[0] / 32767.0f, rotation_[1] / 32767.0f, rotation_[2] / 32767.0f, rotation_[3] / 32767.0f).Normalized();
+}
+
+void Snapshot::Write(Serializer& dest, const Snapshot* baseline) const
+{
+    unsigned numChanged = 0;
+    for (HashMap<unsigned, SnapshotTransform>::ConstIterator i = nodes_.Begin(); i != nodes_.End(); ++i)
+    {
+        HashMap<unsigned, SnapshotTransform>::ConstIterator j;
+        if (!baseline || (j = baseline->nodes_.Find(i->first_)) == baseline->nodes_.End() || j->second_ != i->second_)
+            ++numChanged;
+    }
+
+    dest.WriteVLE(numChanged);
+
+    for (HashMap<unsigned, SnapshotTransform>::ConstIterator i = nodes_.Begin(); i != nodes_.End(); ++i)
+    {
+        const SnapshotTransform& transform = i->second_;
+        const SnapshotTransform* base = nullptr;
+        if (baseline)
+        {
+            HashMap<unsigned, SnapshotTransform>::ConstIterator j = baseline->nodes_.Find(i->first_);
+            if (j != baseline->nodes_.End())
+            {
+                if (j->second_ == transform)
+                    continue;
+                base = &j->second_;
+            }
+        }
+
+        dest.WriteNetID(i->first_);
+
+        if (!base || !CanWriteDelta(transform, *base))
+        {
+            dest.WriteU8(SNAPSHOT_POSITION | SNAPSHOT_ROTATION | SNAPSHOT_ABSOLUTE);
+            for (i32 k = 0; k < 3; ++k)
+                dest.WriteI32(transform.position_[k]);
+            for (i32 k = 0; k < 4; ++k)
+                dest.WriteI16(transform.rotation_[k]);
+            continue;
+        }
+
+        // Write only the differences of the changed parts. Small movements take a byte per component
+        bool positionChanged = memcmp(transform.position_, base->position_, sizeof transform.position_) != 0;
+        bool rotationChanged = memcmp(transform.rotation_, base->rotation_, sizeof transform.rotation_) != 0;
+        dest.WriteU8((positionChanged ? SNAPSHOT_POSITION : 0) | (rotationChanged ? SNAPSHOT_ROTATION : 0));
+        if (positionChanged)
+        {
+            for (i32 k = 0; k < 3; ++k)
+                dest.WriteVLE(EncodeDelta((i64)transform.position_[k] - base->position_[k]));
+        }
+        if (rotationChanged)
+        {
+            for (i32 k = 0; k < 4; ++k)
+                dest.WriteVLE(EncodeDelta((i64)transform.rotation_[k] - base->rotation_[k]));
+        }
+    }
+
+    // Nodes that are no longer in the snapshot, for example removed ones
+    unsigned numRemoved = 0;
+    if (baseline)
+    {
+        for (HashMap<unsigned, SnapshotTransform>::ConstIterator i = baseline->nodes_.Begin(); i != baseline->nodes_.End(); ++i)
+        {
+            if (!nodes_.Contains(i->first_))
+                ++numRemoved;
+        }
+    }
+
+    dest.WriteVLE(numRemoved);
+
+    if (numRemoved)
+    {
+        for (HashMap<unsigned, SnapshotTransform>::ConstIterator i = baseline->nodes_.Begin(); i != baseline->nodes_.End(); ++i)
+        {
+            if (!nodes_.Contains(i->first_))
+                dest.WriteNetID(i->first_);
+        }
+    }
+}
+
+bool Snapshot::Read(Deserializer& source, const Snapshot* baseline)
+{
+    if (baseline)
+        nodes_ = baseline->nodes_;
+    else
+        nodes_.Clear();
+
+    unsigned numChanged = source.ReadVLE();
+    for (unsigned i = 0; i < numChanged; ++i)
+    {
+        if (source.IsEof())
+            return false;
+
+        unsigned nodeID = source.ReadNetID();
+        unsigned char flags = source.ReadU8();
+
+        SnapshotTransform& transform = nodes_[nodeID];
+        if (flags & SNAPSHOT_ABSOLUTE)
+        {
+            for (i32 k = 0; k < 3; ++k)
+                transform.position_[k] = source.ReadI32();
+            for (i32 k = 0; k < 4; ++k)
+                transform.rotation_[k] = source.ReadI16();
+        }
+        else
+        {
+            if (flags & SNAPSHOT_POSITION)
+            {
+                for (i32 k = 0; k < 3; ++k)
+                    transform.position_[k] = (i32)(transform.position_[k] + DecodeDelta(source.ReadVLE()));
+            }
+            if (flags & SNAPSHOT_ROTATION)
+            {
+                for (i32 k = 0; k < 4; ++k)
+                    transform.rotation_[k] = (i16)(transform.rotation_[k] + DecodeDelta(source.ReadVLE()));
+            }
+        }
+    }
+
+    unsigned numRemoved = source.ReadVLE();
+    for (unsigned i = 0; i < numRemoved; ++i)
+        nodes_.Erase(source.ReadNetID());
+
+    return true;
+}
+
+SnapshotBuffer::SnapshotBuffer(i32 size)
+{
+    snapshots_.Resize(Max(size, 1));
+}
+
+Snapshot& SnapshotBuffer::Add(unsigned sequence)
+{
+    Snapshot& snapshot = snapshots_[sequence % snapshots_.Size()];
+    snapshot.sequence_ = sequence;
+    snapshot.nodes_.Clear();
+    return snapshot;
+}
+
+void SnapshotBuffer::Clear()
+{
+    for (i32 i = 0; i < snapshots_.Size(); ++i)
+    {
+        snapshots_[i].sequence_ = 0;
+        snapshots_[i].nodes_.Clear();
+    }
+}
+
+Snapshot* SnapshotBuffer::Find(unsigned sequence)
+{
+    Snapshot& snapshot = snapshots_[sequence % snapshots_.Size()];
+    return sequence && snapshot.sequence_ == sequence ? &snapshot : nullptr;
+}
+
+const Snapshot* SnapshotBuffer::Find(unsigned sequence) const
+{
+    const Snapshot& snapshot = snapshots_[sequence % snapshots_.Size()];
+    return sequence && snapshot.sequence_ == sequence ? &snapshot : nullptr;
+}
+
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Math/Quaternion.h"
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+
+/// Default position precision of snapshots in world units.
+static const float DEFAULT_SNAPSHOT_PRECISION = 0.001f;
+/// Default number of snapshots kept as baselines.
+static const i32 DEFAULT_SNAPSHOT_BUFFER_SIZE = 32;
+
+/// Quantized parent space transform of a node in a replication snapshot.
+struct URHO3D_API SnapshotTransform
+{
+    /// Construct undefined.
+    SnapshotTransform() = default;
+    /// Construct by quantizing a position and rotation.
+    SnapshotTransform(const Vector3& position, const Quaternion& rotation, float precision);
+
+    /// Test for equality with another transform.
+    bool operator ==(const SnapshotTransform& rhs) const;
+    /// Test for inequality with another transform.
+    bool operator !=(const SnapshotTransform& rhs) const { return !(*this == rhs); }
+
+    /// Return the dequantized position.
+    Vector3 GetPosition(float precision) const;
+    /// Return the dequantized rotation.
+    Quaternion GetRotation() const;
+
+    /// Position in units of the snapshot precision.
+    i32 position_[3]{};
+    /// Rotation components in signed 16-bit range.
+    i16 rotation_[4]{};
+};
+
+/// Quantized node transforms of a scene at one network update. Both ends of a connection keep recent snapshots as baselines for delta compression.
+struct URHO3D_API Snapshot
+{
+    /// Write the transforms that differ from a baseline, and the nodes that are missing compared to it. Write all transforms if there is no baseline.
+    void Write(Serializer& dest, const Snapshot* baseline) const;
+    /// Read transforms written against a baseline, which must be the same snapshot the writer used. Return true if successful.
+    bool Read(Deserializer& source, const Snapshot* baseline);
+
+    /// Sequence number. Zero if unused.
+    unsigned sequence_{};
+    /// Transforms by node ID.
+    HashMap<unsigned, SnapshotTransform> nodes_;
+};
+
+/// Ring buffer of the most recent snapshots by sequence number.
+class URHO3D_API SnapshotBuffer
+{
+public:
+    /// Construct with size.
+    explicit SnapshotBuffer(i32 size = DEFAULT_SNAPSHOT_BUFFER_SIZE);
+
+    /// Start a new snapshot, replacing the oldest one, and return it.
+    Snapshot& Add(unsigned sequence);
+    /// Remove all snapshots.
+    void Clear();
+
+    /// Return a snapshot by sequence number, or null if it is no longer kept.
+    Snapshot* Find(unsigned sequence);
+    /// Return a snapshot by sequence number, or null if it is no longer kept.
+    const Snapshot* Find(unsigned sequence) const;
+
+private:
+    /// Snapshots.
+    Vector<Snapshot> snapshots_;
+};
+
+}
@@ -4,6 +4,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/CustomGeometry.h"
 #include "../Graphics/DebugRenderer.h"
@@ -13,8 +14,11 @@
 #include "../Graphics/Terrain.h"
 #include "../GraphicsAPI/IndexBuffer.h"
 #include "../GraphicsAPI/VertexBuffer.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
 #include "../Physics/CollisionShape.h"
+#include "../Physics/CookedCollisionGeometry.h"
 #include "../Physics/PhysicsUtils.h"
 #include "../Physics/PhysicsWorld.h"
 #include "../Physics/RigidBody.h"
@@ -30,9 +34,11 @@
 #include <Bullet/BulletCollision/CollisionShapes/btConvexHullShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btCylinderShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <Bullet/BulletCollision/CollisionShapes/btOptimizedBvh.h>
 #include <Bullet/BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
+#include <Bullet/BulletCollision/CollisionShapes/btTriangleInfoMap.h>
 #include <Bullet/BulletCollision/CollisionShapes/btStaticPlaneShape.h>
 #include <Bullet/BulletCollision/Gimpact/btGImpactShape.h>
 #include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
@@ -46,6 +52,12 @@ namespace Urho3D
 static const float DEFAULT_COLLISION_MARGIN = 0.04f;
 static const unsigned QUANTIZE_MAX_TRIANGLES = 1000000;
 
+/// Alignment of the serialized BVH data.
+static const i32 BVH_DATA_ALIGNMENT = 16;
+
+/// StanHull uses static scratch variables, so convex hulls are built one at a time.
+static Mutex hullMutex;
+
 static const btVector3 WHITE(1.0f, 1.0f, 1.0f);
 static const btVector3 GREEN(0.0f, 1.0f, 0.0f);
 
@@ -181,25 +193,119 @@ private:
     Vector<SharedArrayPtr<byte>> dataArrays_;
 };
 
-TriangleMeshData::TriangleMeshData(Model* model, i32 lodLevel)
+TriangleMeshData::TriangleMeshData(Model* model, i32 lodLevel, bool cook)
 {
     assert(lodLevel >= 0);
     meshInterface_ = make_unique<TriangleMeshInterface>(model, lodLevel);
-    shape_ = make_unique<btBvhTriangleMeshShape>(meshInterface_.get(), meshInterface_->useQuantize_, true);
-
-    infoMap_ = make_unique<btTriangleInfoMap>();
-    btGenerateInternalEdgeInfo(shape_.get(), infoMap_.get());
+    if (cook)
+        Cook();
 }
 
 TriangleMeshData::TriangleMeshData(CustomGeometry* custom)
 {
     meshInterface_ = make_unique<TriangleMeshInterface>(custom);
+    Cook();
+}
+
+void TriangleMeshData::Cook()
+{
     shape_ = make_unique<btBvhTriangleMeshShape>(meshInterface_.get(), meshInterface_->useQuantize_, true);
 
     infoMap_ = make_unique<btTriangleInfoMap>();
     btGenerateInternalEdgeInfo(shape_.get(), infoMap_.get());
 }
 
+/// Return number of triangles and vertices of a triangle mesh.
+static void GetMeshCounts(const btTriangleIndexVertexArray& mesh, i32& numTriangles, i32& numVertices)
+{
+    numTriangles = 0;
+    numVertices = 0;
+    const IndexedMeshArray& meshes = mesh.getIndexedMeshArray();
+    for (i32 i = 0; i < meshes.size(); ++i)
+    {
+        numTriangles += meshes[i].m_numTriangles;
+        numVertices += meshes[i].m_numVertices;
+    }
+}
+
+bool TriangleMeshData::LoadCooked(Deserializer& source)
+{
+    // The BVH refers to the triangles by index, so it must have been built from the same mesh layout. Check this
+    // beyond the geometry checksum, as using a mismatching BVH would read out of bounds
+    i32 numTriangles, numVertices;
+    GetMeshCounts(*meshInterface_, numTriangles, numVertices);
+    const i32 cookedTriangles = source.ReadI32();
+    const i32 cookedVertices = source.ReadI32();
+    const bool cookedQuantize = source.ReadBool();
+    if (cookedTriangles != numTriangles || cookedVertices != numVertices || cookedQuantize != meshInterface_->useQuantize_)
+        return false;
+
+    const u32 bvhSize = source.ReadU32();
+    if (!bvhSize || bvhSize > source.GetSize() - source.GetPosition())
+        return false;
+
+    // The BVH is deserialized in place, so keep it in an aligned buffer for the lifetime of the shape
+    SharedArrayPtr<byte> bvhData(new byte[bvhSize + BVH_DATA_ALIGNMENT]);
+    void* alignedData = reinterpret_cast<void*>(
+        ((size_t)bvhData.Get() + BVH_DATA_ALIGNMENT - 1) & ~(size_t)(BVH_DATA_ALIGNMENT - 1));
+    if (source.Read(alignedData, (i32)bvhSize) != (i32)bvhSize)
+        return false;
+    auto* bvh = static_cast<btOptimizedBvh*>(btOptimizedBvh::deSerializeInPlace(alignedData, bvhSize, false));
+    if (!bvh || bvh->isQuantized() != meshInterface_->useQuantize_)
+        return false;
+
+    const i32 numInfos = source.ReadI32();
+    if (numInfos < 0 || numInfos > (source.GetSize() - source.GetPosition()) / (2 * sizeof(i32) + 3 * sizeof(float)))
+        return false;
+
+    auto infoMap = make_unique<btTriangleInfoMap>();
+    for (i32 i = 0; i < numInfos; ++i)
+    {
+        const i32 key = source.ReadI32();
+        btTriangleInfo info;
+        info.m_flags = source.ReadI32();
+        info.m_edgeV0V1Angle = source.ReadFloat();
+        info.m_edgeV1V2Angle = source.ReadFloat();
+        info.m_edgeV2V0Angle = source.ReadFloat();
+        infoMap->insert(key, info);
+    }
+
+    bvhData_ = bvhData;
+    shape_ = make_unique<btBvhTriangleMeshShape>(meshInterface_.get(), meshInterface_->useQuantize_, false);
+    shape_->setOptimizedBvh(bvh);
+    infoMap_ = std::move(infoMap);
+    shape_->setTriangleInfoMap(infoMap_.get());
+    return true;
+}
+
+void TriangleMeshData::SaveCooked(Serializer& dest) const
+{
+    i32 numTriangles, numVertices;
+    GetMeshCounts(*meshInterface_, numTriangles, numVertices);
+    dest.WriteI32(numTriangles);
+    dest.WriteI32(numVertices);
+    dest.WriteBool(meshInterface_->useQuantize_);
+
+    const btOptimizedBvh* bvh = shape_->getOptimizedBvh();
+    const u32 bvhSize = bvh->calculateSerializeBufferSize();
+    void* bvhData = btAlignedAlloc(bvhSize, BVH_DATA_ALIGNMENT);
+    bvh->serialize(bvhData, bvhSize, false);
+    dest.WriteU32(bvhSize);
+    dest.Write(bvhData, (i32)bvhSize);
+    btAlignedFree(bvhData);
+
+    dest.WriteI32(infoMap_->size());
+    for (i32 i = 0; i < infoMap_->size(); ++i)
+    {
+        const btTriangleInfo* info = infoMap_->getAtIndex(i);
+        dest.WriteI32(infoMap_->getKeyAtIndex(i).getUid1());
+        dest.WriteI32(info->m_flags);
+        dest.WriteFloat(info->m_edgeV0V1Angle);
+        dest.WriteFloat(info->m_edgeV1V2Angle);
+        dest.WriteFloat(info->m_edgeV2V0Angle);
+    }
+}
+
 GImpactMeshData::GImpactMeshData(Model* model, i32 lodLevel)
 {
     assert(lodLevel >= 0);
@@ -211,10 +317,9 @@ GImpactMeshData::GImpactMeshData(CustomGeometry* custom)
     meshInterface_ = make_unique<TriangleMeshInterface>(custom);
 }
 
-ConvexData::ConvexData(Model* model, i32 lodLevel)
+ConvexData::ConvexData(Model* model, i32 lodLevel, bool cook)
 {
     assert(lodLevel >= 0);
-    Vector<Vector3> vertices;
     unsigned numGeometries = model->GetNumGeometries();
 
     for (unsigned i = 0; i < numGeometries; ++i)
@@ -246,11 +351,12 @@ ConvexData::ConvexData(Model* model, i32 lodLevel)
         for (unsigned j = 0; j < vertexCount; ++j)
         {
             const Vector3& v = *((const Vector3*)(&vertexData[(vertexStart + j) * vertexSize]));
-            vertices.Push(v);
+            sourceVertices_.Push(v);
         }
     }
 
-    BuildHull(vertices);
+    if (cook)
+        Cook();
 }
 
 ConvexData::ConvexData(CustomGeometry* custom)
@@ -267,10 +373,62 @@ ConvexData::ConvexData(CustomGeometry* custom)
     BuildHull(vertices);
 }
 
+void ConvexData::Cook()
+{
+    BuildHull(sourceVertices_);
+    sourceVertices_.Clear();
+    sourceVertices_.Compact();
+}
+
+bool ConvexData::LoadCooked(Deserializer& source)
+{
+    // The hull is drawn and collided using its triangle indices, so reject truncated data and indices outside the
+    // vertex data instead of trusting the file
+    const u32 vertexCount = source.ReadU32();
+    if (vertexCount > (source.GetSize() - source.GetPosition()) / sizeof(Vector3))
+        return false;
+    SharedArrayPtr<Vector3> vertexData(new Vector3[vertexCount]);
+    const i32 vertexDataSize = (i32)(vertexCount * sizeof(Vector3));
+    if (source.Read(vertexData.Get(), vertexDataSize) != vertexDataSize)
+        return false;
+
+    const u32 indexCount = source.ReadU32();
+    if (indexCount % 3 || (indexCount && !vertexCount) ||
+        indexCount > (source.GetSize() - source.GetPosition()) / sizeof(unsigned))
+        return false;
+    SharedArrayPtr<unsigned> indexData(new unsigned[indexCount]);
+    const i32 indexDataSize = (i32)(indexCount * sizeof(unsigned));
+    if (source.Read(indexData.Get(), indexDataSize) != indexDataSize)
+        return false;
+    for (u32 i = 0; i < indexCount; ++i)
+    {
+        if (indexData[i] >= vertexCount)
+            return false;
+    }
+
+    vertexData_ = vertexData;
+    vertexCount_ = vertexCount;
+    indexData_ = indexData;
+    indexCount_ = indexCount;
+    sourceVertices_.Clear();
+    sourceVertices_.Compact();
+    return true;
+}
+
+void ConvexData::SaveCooked(Serializer& dest) const
+{
+    dest.WriteU32(vertexCount_);
+    dest.Write(vertexData_.Get(), vertexCount_ * sizeof(Vector3));
+    dest.WriteU32(indexCount_);
+    dest.Write(indexData_.Get(), indexCount_ * sizeof(unsigned));
+}
+
 void ConvexData::BuildHull(const Vector<Vector3>& vertices)
 {
     if (vertices.Size())
     {
+        MutexLock lock(hullMutex);
+
         // Build the convex hull from the raw geometry
         StanHull::HullDesc desc;
         desc.SetHullFlag(StanHull::QF_TRIANGLES);
@@ -402,6 +560,92 @@ CollisionGeometryData* CreateCollisionGeometryData(ShapeType shapeType, Model* m
     }
 }
 
+/// Return checksum of the model geometry that a triangle mesh or convex hull is cooked from.
+static hash32 GetCookingChecksum(ShapeType shapeType, Model* model, i32 lodLevel)
+{
+    hash32 checksum = shapeType;
+    unsigned numGeometries = model->GetNumGeometries();
+
+    for (unsigned i = 0; i < numGeometries; ++i)
+    {
+        Geometry* geometry = model->GetGeometry(i, lodLevel);
+        if (!geometry)
+            continue;
+
+        const byte* vertexData;
+        const byte* indexData;
+        i32 vertexSize;
+        i32 indexSize;
+        const Vector<VertexElement>* elements;
+
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+        if (!vertexData || VertexBuffer::GetElementOffset(*elements, TYPE_VECTOR3, SEM_POSITION) != 0)
+            continue;
+
+        const i32 vertexStart = geometry->GetVertexStart();
+        const i32 vertexCount = geometry->GetVertexCount();
+        for (i32 j = 0; j < vertexCount; ++j)
+        {
+            const byte* position = &vertexData[(vertexStart + j) * vertexSize];
+            for (i32 k = 0; k < (i32)sizeof(Vector3); ++k)
+                checksum = SDBMHash(checksum, position[k]);
+        }
+
+        if (shapeType == SHAPE_TRIANGLEMESH && indexData)
+        {
+            const byte* indices = &indexData[geometry->GetIndexStart() * indexSize];
+            const i32 indicesSize = geometry->GetIndexCount() * indexSize;
+            checksum = SDBMHash(checksum, (u8)indexSize);
+            for (i32 j = 0; j < indicesSize; ++j)
+                checksum = SDBMHash(checksum, indices[j]);
+        }
+    }
+
+    return checksum;
+}
+
+/// Create triangle mesh or convex hull data from a model. Load it from the cooked geometry directory of the physics world if found there, otherwise cook it through the physics world.
+static CollisionGeometryData* CreateCookedCollisionGeometryData(ShapeType shapeType, Model* model, i32 lodLevel,
+    PhysicsWorld* physicsWorld)
+{
+    CollisionGeometryData* geometry;
+    if (shapeType == SHAPE_TRIANGLEMESH)
+        geometry = new TriangleMeshData(model, lodLevel, false);
+    else
+        geometry = new ConvexData(model, lodLevel, false);
+
+    auto* cache = physicsWorld->GetSubsystem<ResourceCache>();
+    const String& cookedDir = physicsWorld->GetCookedGeometryDir();
+    if (cache && !cookedDir.Empty())
+    {
+        geometry->checksum_ = GetCookingChecksum(shapeType, model, lodLevel);
+        const String name = AddTrailingSlash(cookedDir) + ToStringHex(geometry->checksum_) +
+            (shapeType == SHAPE_TRIANGLEMESH ? ".bvh" : ".hull");
+
+        if (cache->Exists(name))
+        {
+            SharedPtr<CookedCollisionGeometry> cooked = cache->GetTempResource<CookedCollisionGeometry>(name, false);
+            if (cooked && cooked->GetChecksum() == geometry->checksum_)
+            {
+                MemoryBuffer source(cooked->GetData().GetBuffer());
+                if (geometry->LoadCooked(source))
+                    return geometry;
+            }
+
+            URHO3D_LOGWARNING("Could not load cooked collision geometry " + name + ", cooking again");
+        }
+
+        // Save next to the resources when the cooked geometry directory is relative
+        if (IsAbsolutePath(name))
+            geometry->cookedFileName_ = name;
+        else if (!cache->GetResourceDirs().Empty())
+            geometry->cookedFileName_ = cache->GetResourceDirs()[0] + name;
+    }
+
+    physicsWorld->CookGeometry(geometry);
+    return geometry;
+}
+
 CollisionGeometryData* CreateCollisionGeometryData(ShapeType shapeType, CustomGeometry* custom)
 {
     switch (shapeType)
@@ -870,6 +1114,9 @@ void CollisionShape::NotifyRigidBody(bool updateMass)
         if (updateMass)
             rigidBody_->UpdateMass();
     }
+
+    if (updateMass && compound)
+        rigidBody_->UpdateCookingState();
 }
 
 void CollisionShape::SetModelAttr(const ResourceRef& value)
@@ -885,6 +1132,12 @@ ResourceRef CollisionShape::GetModelAttr() const
     return GetResourceRef(model_, Model::GetTypeStatic());
 }
 
+void CollisionShape::ApplyCookedGeometry()
+{
+    UpdateShape();
+    NotifyRigidBody();
+}
+
 void CollisionShape::ReleaseShape()
 {
     btCompoundShape* compound = GetParentCompoundShape();
@@ -894,9 +1147,14 @@ void CollisionShape::ReleaseShape()
         rigidBody_->UpdateMass();
     }
 
+    const bool wasCooking = IsCookingGeometry();
     shape_.reset();
     geometry_.Reset();
 
+    // A rigid body kept out of the simulation for this shape's cooking can resume
+    if (wasCooking && rigidBody_)
+        rigidBody_->UpdateCookingState();
+
     if (physicsWorld_)
         physicsWorld_->CleanupGeometryCache();
 }
@@ -986,6 +1244,11 @@ void CollisionShape::OnMarkedDirty(Node* node)
 
         cachedWorldScale_ = newWorldScale;
     }
+    else if (!shape_ && geometry_)
+    {
+        // Create the shape in the current scale once its geometry has been cooked
+        cachedWorldScale_ = newWorldScale;
+    }
 }
 
 btCompoundShape* CollisionShape::GetParentCompoundShape()
@@ -1122,15 +1385,27 @@ void CollisionShape::UpdateCachedGeometryShape(CollisionGeometryDataCache& cache
             geometry_ = cachedGeometry->second_;
         else
         {
-            geometry_ = CreateCollisionGeometryData(shapeType_, model_, lodLevel_);
-            assert(geometry_);
             // Check if model has dynamic buffers, do not cache in that case
             if (!HasDynamicBuffers(model_, lodLevel_))
+            {
+                // Triangle mesh BVHs and convex hulls may be loaded from disk or cooked in the background
+                if (shapeType_ == SHAPE_TRIANGLEMESH || shapeType_ == SHAPE_CONVEXHULL)
+                    geometry_ = CreateCookedCollisionGeometryData(shapeType_, model_, lodLevel_, physicsWorld_);
+                else
+                    geometry_ = CreateCollisionGeometryData(shapeType_, model_, lodLevel_);
                 cache[id] = geometry_;
+            }
+            else
+                geometry_ = CreateCollisionGeometryData(shapeType_, model_, lodLevel_);
+            assert(geometry_);
         }
 
-        shape_.reset(CreateCollisionGeometryDataShape(shapeType_, geometry_.Get(), cachedWorldScale_ * size_));
-        assert(shape_);
+        // The shape is created once the geometry has been cooked
+        if (geometry_->cooked_)
+        {
+            shape_.reset(CreateCollisionGeometryDataShape(shapeType_, geometry_.Get(), cachedWorldScale_ * size_));
+            assert(shape_);
+        }
         // Watch for live reloads of the collision model to reload the geometry if necessary
         SubscribeToEvent(model_, E_RELOADFINISHED, URHO3D_HANDLER(CollisionShape, HandleModelReloadFinished));
     }
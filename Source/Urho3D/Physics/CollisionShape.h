@@ -24,10 +24,12 @@ namespace Urho3D
 {
 
 class CustomGeometry;
+class Deserializer;
 class Geometry;
 class Model;
 class PhysicsWorld;
 class RigidBody;
+class Serializer;
 class Terrain;
 class TriangleMeshInterface;
 
@@ -49,6 +51,19 @@ enum ShapeType
 /// Base class for collision shape geometry data.
 struct CollisionGeometryData : public RefCounted
 {
+    /// Build the data if it was constructed uncooked. Called from a worker thread when cooking in the background.
+    virtual void Cook() {}
+    /// Load data cooked earlier. Return true if successful.
+    virtual bool LoadCooked(Deserializer& source) { return false; }
+    /// Save the cooked data.
+    virtual void SaveCooked(Serializer& dest) const {}
+
+    /// Cooked flag. False while the data is being cooked in the background.
+    bool cooked_{true};
+    /// Checksum of the model geometry the data is cooked from.
+    hash32 checksum_{};
+    /// File name to save the cooked data into, or empty if not saved.
+    String cookedFileName_;
 };
 
 /// Cache of collision geometry data.
@@ -58,14 +73,24 @@ using CollisionGeometryDataCache = HashMap<Pair<Model*, i32>, SharedPtr<Collisio
 /// Triangle mesh geometry data.
 struct TriangleMeshData : public CollisionGeometryData
 {
-    /// Construct from a model.
-    TriangleMeshData(Model* model, i32 lodLevel);
+    /// Construct from a model. If not cooked right away, Cook() or LoadCooked() must be called before use.
+    TriangleMeshData(Model* model, i32 lodLevel, bool cook = true);
     /// Construct from a custom geometry.
     explicit TriangleMeshData(CustomGeometry* custom);
 
+    /// Build the BVH and the internal edge info.
+    void Cook() override;
+    /// Load the BVH and the internal edge info cooked earlier. Return true if successful.
+    bool LoadCooked(Deserializer& source) override;
+    /// Save the BVH and the internal edge info.
+    void SaveCooked(Serializer& dest) const override;
+
     /// Bullet triangle mesh interface.
     std::unique_ptr<TriangleMeshInterface> meshInterface_;
 
+    /// Loaded BVH data, which Bullet uses in place.
+    SharedArrayPtr<byte> bvhData_;
+
     /// Bullet triangle mesh collision shape.
     std::unique_ptr<btBvhTriangleMeshShape> shape_;
 
@@ -88,14 +113,23 @@ struct GImpactMeshData : public CollisionGeometryData
 /// Convex hull geometry data.
 struct ConvexData : public CollisionGeometryData
 {
-    /// Construct from a model.
-    ConvexData(Model* model, i32 lodLevel);
+    /// Construct from a model. If not cooked right away, Cook() or LoadCooked() must be called before use.
+    ConvexData(Model* model, i32 lodLevel, bool cook = true);
     /// Construct from a custom geometry.
     explicit ConvexData(CustomGeometry* custom);
 
+    /// Build the convex hull from the model vertices.
+    void Cook() override;
+    /// Load the convex hull cooked earlier. Return true if successful.
+    bool LoadCooked(Deserializer& source) override;
+    /// Save the convex hull.
+    void SaveCooked(Serializer& dest) const override;
     /// Build the convex hull from vertices.
     void BuildHull(const Vector<Vector3>& vertices);
 
+    /// Model vertices to build the convex hull from when cooking.
+    Vector<Vector3> sourceVertices_;
+
     /// Vertex data.
     SharedArrayPtr<Vector3> vertexData_;
     /// Number of vertices.
@@ -207,6 +241,9 @@ public:
     /// Return the shared geometry data.
     CollisionGeometryData* GetGeometryData() const { return geometry_; }
 
+    /// Return whether the shape is enabled and waiting for its geometry to be cooked in the background.
+    bool IsCookingGeometry() const { return geometry_ && !geometry_->cooked_ && IsEnabledEffective(); }
+
     /// Return physics world.
     PhysicsWorld* GetPhysicsWorld() const { return physicsWorld_; }
 
@@ -244,6 +281,8 @@ public:
 
     /// Update the new collision shape to the RigidBody.
     void NotifyRigidBody(bool updateMass = true);
+    /// Create the collision shape after its geometry data has been cooked in the background. Called by PhysicsWorld.
+    void ApplyCookedGeometry();
     /// Set model attribute.
     void SetModelAttr(const ResourceRef& value);
     /// Return model attribute.
@@ -0,0 +1,77 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../IO/Serializer.h"
+#include "../Physics/CookedCollisionGeometry.h"
+
+#include <Bullet/LinearMath/btScalar.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Cooked data version. The serialized BVHs also depend on the pointer size and Bullet's scalar precision.
+static const u32 COOKED_GEOMETRY_FORMAT = (2u << 16u) | ((u32)sizeof(void*) << 8u) | (u32)sizeof(btScalar);
+
+CookedCollisionGeometry::CookedCollisionGeometry(Context* context) :
+    Resource(context)
+{
+}
+
+CookedCollisionGeometry::~CookedCollisionGeometry() = default;
+
+void CookedCollisionGeometry::RegisterObject(Context* context)
+{
+    context->RegisterFactory<CookedCollisionGeometry>();
+}
+
+bool CookedCollisionGeometry::BeginLoad(Deserializer& source)
+{
+    if (source.ReadFileID() != "UCOL")
+    {
+        URHO3D_LOGERROR(source.GetName() + " is not a valid cooked collision geometry file");
+        return false;
+    }
+
+    // Data cooked on another platform or by another version is simply cooked again
+    if (source.ReadU32() != COOKED_GEOMETRY_FORMAT)
+    {
+        URHO3D_LOGDEBUG(source.GetName() + " was cooked in an incompatible format");
+        return false;
+    }
+
+    checksum_ = source.ReadU32();
+    const u32 dataSize = source.ReadU32();
+    if (dataSize > source.GetSize() - source.GetPosition())
+    {
+        URHO3D_LOGERROR(source.GetName() + " is truncated");
+        return false;
+    }
+
+    data_.SetData(source, (i32)dataSize);
+    SetMemoryUse(sizeof(CookedCollisionGeometry) + dataSize);
+    return true;
+}
+
+bool CookedCollisionGeometry::Save(Serializer& dest) const
+{
+    if (!dest.WriteFileID("UCOL"))
+    {
+        URHO3D_LOGERROR("Can not save cooked collision geometry");
+        return false;
+    }
+
+    dest.WriteU32(COOKED_GEOMETRY_FORMAT);
+    dest.WriteU32(checksum_);
+    dest.WriteU32(data_.GetSize());
+    dest.Write(data_.GetData(), (i32)data_.GetSize());
+    return true;
+}
+
+}
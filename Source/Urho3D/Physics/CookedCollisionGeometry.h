@@ -0,0 +1,50 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "../IO/VectorBuffer.h"
+#include "../Resource/Resource.h"
+
+namespace Urho3D
+{
+
+/// Triangle mesh BVH or convex hull cooked from model geometry, stored in the cooked geometry directory of the physics world.
+class URHO3D_API CookedCollisionGeometry : public Resource
+{
+    URHO3D_OBJECT(CookedCollisionGeometry, Resource);
+
+public:
+    /// Construct.
+    explicit CookedCollisionGeometry(Context* context);
+    /// Destruct.
+    ~CookedCollisionGeometry() override;
+    /// Register object factory.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    bool BeginLoad(Deserializer& source) override;
+    /// Save resource. Return true if successful.
+    bool Save(Serializer& dest) const override;
+
+    /// Set checksum of the model geometry the data was cooked from.
+    void SetChecksum(hash32 checksum) { checksum_ = checksum; }
+    /// Return cooked data for writing.
+    VectorBuffer& GetData() { return data_; }
+
+    /// Return checksum of the model geometry the data was cooked from.
+    hash32 GetChecksum() const { return checksum_; }
+    /// Return cooked data.
+    const VectorBuffer& GetData() const { return data_; }
+
+private:
+    /// Checksum of the source model geometry.
+    hash32 checksum_{};
+    /// Cooked data.
+    VectorBuffer data_;
+};
+
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+#include "../Precompiled.h"
+
+#include "../Core/WorkQueue.h"
+#include "../Physics/PhysicsTaskScheduler.h"
+
+#include "../DebugNew.h"
+
+// Defined in btThreads.cpp but not declared in its header
+void btPushThreadsAreRunning();
+void btPopThreadsAreRunning();
+
+namespace Urho3D
+{
+
+PhysicsTaskScheduler::PhysicsTaskScheduler() :
+    btITaskScheduler("WorkQueue")
+{
+}
+
+void PhysicsTaskScheduler::SetWorkQueue(WorkQueue* queue)
+{
+    workQueue_ = queue;
+}
+
+WorkQueue* PhysicsTaskScheduler::GetWorkQueue() const
+{
+    return workQueue_;
+}
+
+int PhysicsTaskScheduler::getMaxNumThreads() const
+{
+    return BT_MAX_THREAD_COUNT;
+}
+
+int PhysicsTaskScheduler::getNumThreads() const
+{
+    // Bullet indexes per-thread data by its own thread index, which it assigns to every thread on first use for the
+    // lifetime of the process, so threads of a recreated work queue or threads running queries get indices beyond the
+    // work queue thread count
+    return BT_MAX_THREAD_COUNT;
+}
+
+void PhysicsTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+    // Run loops nested in a parallel loop on the calling thread
+    WorkQueue* queue = workQueue_;
+    if (!queue || btThreadsAreRunning())
+    {
+        body.forLoop(iBegin, iEnd);
+        return;
+    }
+
+    btPushThreadsAreRunning();
+    queue->ParallelFor(iBegin, iEnd, grainSize, [&body](i32 begin, i32 end, i32 threadIndex)
+    {
+        body.forLoop(begin, end);
+    });
+    btPopThreadsAreRunning();
+}
+
+btScalar PhysicsTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+{
+    WorkQueue* queue = workQueue_;
+    if (!queue || btThreadsAreRunning())
+        return body.sumLoop(iBegin, iEnd);
+
+    // A thread runs one range at a time, so the ranges can be summed per thread
+    threadSums_.Resize(queue->GetNumThreads() + 1);
+    for (btScalar& sum : threadSums_)
+        sum = 0;
+
+    btPushThreadsAreRunning();
+    queue->ParallelFor(iBegin, iEnd, grainSize, [this, &body](i32 begin, i32 end, i32 threadIndex)
+    {
+        threadSums_[threadIndex] += body.sumLoop(begin, end);
+    });
+    btPopThreadsAreRunning();
+
+    btScalar sum = 0;
+    for (btScalar threadSum : threadSums_)
+        sum += threadSum;
+    return sum;
+}
+
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+/// \file
+/// @nobindfile
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/Vector.h"
+
+#include <Bullet/LinearMath/btThreads.h>
+
+namespace Urho3D
+{
+
+class WorkQueue;
+
+/// Bullet task scheduler that runs parallel loops of the multithreaded dynamics world on the work queue.
+class URHO3D_API PhysicsTaskScheduler : public btITaskScheduler
+{
+public:
+    /// Construct.
+    PhysicsTaskScheduler();
+
+    /// Set the work queue to use.
+    void SetWorkQueue(WorkQueue* queue);
+    /// Return the work queue.
+    WorkQueue* GetWorkQueue() const;
+
+    /// Return maximum number of threads.
+    int getMaxNumThreads() const override;
+    /// Return number of thread indices Bullet may use for per-thread data. Covers every Bullet thread index rather than only the work queue threads.
+    int getNumThreads() const override;
+    /// Set number of threads. Ignored, the work queue owns its threads.
+    void setNumThreads(int numThreads) override { }
+    /// Run a parallel loop and wait for it to finish.
+    void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+    /// Run a parallel loop and wait for it to finish, returning the sum of all iterations.
+    btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+private:
+    /// Work queue.
+    WeakPtr<WorkQueue> workQueue_;
+    /// Sums of the parallel sum loop being executed per thread.
+    Vector<btScalar> threadSums_;
+};
+
+}
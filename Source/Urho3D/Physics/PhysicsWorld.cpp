@@ -3,31 +3,41 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Sort.h"
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Model.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../Math/Ray.h"
 #include "../Physics/CollisionShape.h"
 #include "../Physics/Constraint.h"
+#include "../Physics/CookedCollisionGeometry.h"
 #include "../Physics/PhysicsEvents.h"
+#include "../Physics/PhysicsTaskScheduler.h"
 #include "../Physics/PhysicsUtils.h"
 #include "../Physics/PhysicsWorld.h"
 #include "../Physics/RaycastVehicle.h"
 #include "../Physics/RigidBody.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
+#include "../Scene/WorldTransformBatch.h"
 
 #include <Bullet/BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <Bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
 #include <Bullet/BulletCollision/CollisionShapes/btBoxShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
 #include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
 
 extern ContactAddedCallback gContactAddedCallback;
 
@@ -40,6 +50,10 @@ const char* PHYSICS_CATEGORY = "Physics";
 extern const char* SUBSYSTEM_CATEGORY;
 
 static const int MAX_SOLVER_ITERATIONS = 256;
+/// Minimum number of batched queries to execute them in worker threads.
+static const i32 MIN_PARALLEL_QUERIES = 32;
+/// Minimum number of batched queries per work item.
+static const i32 MIN_QUERIES_PER_ITEM = 16;
 static const Vector3 DEFAULT_GRAVITY = Vector3(0.0f, -9.81f, 0.0f);
 
 PhysicsWorldConfig PhysicsWorld::config;
@@ -49,6 +63,147 @@ static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const Physics
     return lhs.distance_ < rhs.distance_;
 }
 
+/// Set a raycast result to no hit.
+static void ClearRaycastResult(PhysicsRaycastResult& result)
+{
+    result.body_ = nullptr;
+    result.position_ = Vector3::ZERO;
+    result.normal_ = Vector3::ZERO;
+    result.distance_ = M_INFINITY;
+    result.hitFraction_ = 0.0f;
+}
+
+/// Perform a raycast and return the closest hit. Does not modify the world.
+static void RaycastSingleImpl(btCollisionWorld* world, PhysicsRaycastResult& result, const Ray& ray, float maxDistance,
+    unsigned collisionMask)
+{
+    btCollisionWorld::ClosestRayResultCallback
+        rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ + maxDistance * ray.direction_));
+    rayCallback.m_collisionFilterGroup = (short)0xffff;
+    rayCallback.m_collisionFilterMask = (short)collisionMask;
+
+    world->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
+
+    if (rayCallback.hasHit())
+    {
+        result.position_ = ToVector3(rayCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
+        result.distance_ = (result.position_ - ray.origin_).Length();
+        result.hitFraction_ = rayCallback.m_closestHitFraction;
+        result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
+    }
+    else
+        ClearRaycastResult(result);
+}
+
+/// Perform a swept convex test and return the closest hit. Does not modify the world.
+static void ConvexCastImpl(btCollisionWorld* world, PhysicsRaycastResult& result, btConvexShape* shape, const Vector3& startPos,
+    const Quaternion& startRot, const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask)
+{
+    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos));
+    convexCallback.m_collisionFilterGroup = (short)0xffff;
+    convexCallback.m_collisionFilterMask = (short)collisionMask;
+
+    world->convexSweepTest(shape, btTransform(ToBtQuaternion(startRot), convexCallback.m_convexFromWorld),
+        btTransform(ToBtQuaternion(endRot), convexCallback.m_convexToWorld), convexCallback);
+
+    if (convexCallback.hasHit())
+    {
+        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
+        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
+        result.distance_ = convexCallback.m_closestHitFraction * (endPos - startPos).Length();
+        result.hitFraction_ = convexCallback.m_closestHitFraction;
+    }
+    else
+        ClearRaycastResult(result);
+}
+
+/// Perform a swept sphere test and return the closest hit. Does not modify the world.
+static void SphereCastImpl(btCollisionWorld* world, PhysicsRaycastResult& result, const Ray& ray, float radius, float maxDistance,
+    unsigned collisionMask)
+{
+    btSphereShape shape(radius);
+    ConvexCastImpl(world, result, &shape, ray.origin_, Quaternion::IDENTITY, ray.origin_ + maxDistance * ray.direction_,
+        Quaternion::IDENTITY, collisionMask);
+}
+
+/// Batch of physics queries and their results.
+struct QueryBatch
+{
+    /// Bullet world.
+    btCollisionWorld* world_;
+    /// Results.
+    PhysicsRaycastResult* results_;
+    /// Raycast queries, or null.
+    const PhysicsRaycastQuery* raycasts_;
+    /// Convex cast queries, or null.
+    const PhysicsConvexCastQuery* convexCasts_;
+};
+
+/// Execute a range of batched physics queries.
+static void ExecuteQueries(const QueryBatch& batch, i32 start, i32 end)
+{
+    for (i32 i = start; i < end; ++i)
+    {
+        PhysicsRaycastResult& result = batch.results_[i];
+        if (batch.raycasts_)
+        {
+            const PhysicsRaycastQuery& query = batch.raycasts_[i];
+            if (query.radius_ > 0.0f)
+                SphereCastImpl(batch.world_, result, query.ray_, query.radius_, query.maxDistance_, query.collisionMask_);
+            else
+                RaycastSingleImpl(batch.world_, result, query.ray_, query.maxDistance_, query.collisionMask_);
+        }
+        else
+        {
+            const PhysicsConvexCastQuery& query = batch.convexCasts_[i];
+            if (query.shape_ && query.shape_->isConvex())
+            {
+                ConvexCastImpl(batch.world_, result, static_cast<btConvexShape*>(query.shape_), query.startPos_, query.startRot_,
+                    query.endPos_, query.endRot_, query.collisionMask_);
+            }
+            else
+                ClearRaycastResult(result);
+        }
+    }
+}
+
+/// Execute a range of batched physics queries in a work item.
+static void ExecuteQueriesWork(const WorkItem* item, i32 threadIndex)
+{
+    const auto* batch = reinterpret_cast<const QueryBatch*>(item->aux_);
+    ExecuteQueries(*batch, (i32)reinterpret_cast<size_t>(item->start_), (i32)reinterpret_cast<size_t>(item->end_));
+}
+
+/// Execute batched physics queries, in worker threads if Bullet queries are thread-safe.
+static void ExecuteQueryBatch(WorkQueue* queue, const QueryBatch& batch, i32 numQueries)
+{
+    // Broadphase ray tests share a traversal stack unless Bullet is built thread-safe
+#if BT_THREADSAFE
+    if (queue && queue->GetNumThreads() && numQueries >= MIN_PARALLEL_QUERIES)
+    {
+        const i32 numWorkItems = Min(queue->GetNumThreads() + 1, numQueries / MIN_QUERIES_PER_ITEM); // Worker threads + main thread
+        const i32 queriesPerItem = (numQueries + numWorkItems - 1) / numWorkItems;
+        for (i32 start = 0; start < numQueries; start += queriesPerItem)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = WI_MAX_PRIORITY;
+            item->workFunction_ = ExecuteQueriesWork;
+            item->aux_ = const_cast<QueryBatch*>(&batch);
+            item->start_ = reinterpret_cast<void*>((size_t)start);
+            item->end_ = reinterpret_cast<void*>((size_t)Min(start + queriesPerItem, numQueries));
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(WI_MAX_PRIORITY);
+        return;
+    }
+#endif
+
+    ExecuteQueries(batch, 0, numQueries);
+}
+
 void InternalPreTickCallback(btDynamicsWorld* world, btScalar timeStep)
 {
     static_cast<PhysicsWorld*>(world->getWorldUserInfo())->PreStep(timeStep);
@@ -78,6 +233,93 @@ static bool CustomMaterialCombinerCallback(btManifoldPoint& cp, const btCollisio
     return true;
 }
 
+/// Access to the actions of a Bullet world, which has no public getter for them.
+struct DynamicsWorldActions : public btDiscreteDynamicsWorld
+{
+    static btAlignedObjectArray<btActionInterface*>& Get(btDiscreteDynamicsWorld* world)
+    {
+        return world->*(&DynamicsWorldActions::m_actions);
+    }
+};
+
+/// Return whether a constraint disables collisions between its bodies, which Bullet records as a constraint reference.
+static bool IsCollisionDisabled(btTypedConstraint* constraint)
+{
+    btRigidBody& body = constraint->getRigidBodyA();
+    for (int i = 0; i < body.getNumConstraintRefs(); ++i)
+    {
+        if (body.getConstraintRef(i) == constraint)
+            return true;
+    }
+    return false;
+}
+
+/// Return the rigid bodies of a manifold if they are touching and their collision is reported, or false for ghost objects, static pairs and pairs excluded by the collision event mode.
+static bool GetReportedBodies(const btPersistentManifold* manifold, RigidBody*& bodyA, RigidBody*& bodyB)
+{
+    // The manifold exists also when objects are close but not touching
+    if (!manifold->getNumContacts())
+        return false;
+
+    bodyA = static_cast<RigidBody*>(manifold->getBody0()->getUserPointer());
+    bodyB = static_cast<RigidBody*>(manifold->getBody1()->getUserPointer());
+    // If it's not a rigidbody, maybe a ghost object
+    if (!bodyA || !bodyB)
+        return false;
+
+    // Skip collision event signaling if both objects are static, or if collision event mode does not match
+    if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
+        !bodyA->IsActive() && !bodyB->IsActive())
+        return false;
+
+    return true;
+}
+
+/// Apply a batched world transform to the scene node of a rigid body.
+static void ApplyBatchedWorldTransform(const BatchedWorldTransform& transform)
+{
+    transform.rigidBody_->ApplyWorldTransform(transform.worldPosition_, transform.worldRotation_);
+    transform.rigidBody_->MarkNetworkUpdate();
+}
+
+/// Make the work queue scheduler the Bullet task scheduler for the multithreaded world.
+static void ActivateTaskScheduler(WorkQueue* queue)
+{
+    // Bullet keeps one global scheduler, and its worker thread indices must stay stable, so the scheduler is never destroyed
+    static PhysicsTaskScheduler scheduler;
+    scheduler.SetWorkQueue(queue);
+    if (btGetTaskScheduler() != &scheduler)
+        btSetTaskScheduler(&scheduler);
+}
+
+/// Cook collision geometry data in a worker thread.
+static void CookGeometryWork(const WorkItem* item, i32 threadIndex)
+{
+    static_cast<CollisionGeometryData*>(item->aux_)->Cook();
+}
+
+/// Save cooked collision geometry data into the cooked geometry cache.
+static void SaveCookedGeometry(Context* context, CollisionGeometryData* geometry)
+{
+    if (geometry->cookedFileName_.Empty())
+        return;
+
+    SharedPtr<CookedCollisionGeometry> cooked(new CookedCollisionGeometry(context));
+    cooked->SetChecksum(geometry->checksum_);
+    geometry->SaveCooked(cooked->GetData());
+
+    auto* fileSystem = context->GetSubsystem<FileSystem>();
+    const String path = GetPath(geometry->cookedFileName_);
+    if (fileSystem && !fileSystem->DirExists(path))
+        fileSystem->CreateDir(path);
+    if (!cooked->SaveFile(geometry->cookedFileName_))
+        URHO3D_LOGERROR("Could not save cooked collision geometry " + geometry->cookedFileName_);
+}
+
 void RemoveCachedGeometryImpl(CollisionGeometryDataCache& cache, Model* model)
 {
     for (auto i = cache.Begin(); i != cache.End();)
@@ -133,30 +375,40 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     debugMode_(btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawConstraints | btIDebugDraw::DBG_DrawConstraintLimits)
 {
     gContactAddedCallback = CustomMaterialCombinerCallback;
+#if BT_THREADSAFE
+    // Bullet numbers threads in the order they first use it and expects the main thread to be first
+    btGetCurrentThreadIndex();
+#endif
 
     if (PhysicsWorld::config.collisionConfig_)
         collisionConfiguration_ = PhysicsWorld::config.collisionConfig_;
     else
         collisionConfiguration_ = new btDefaultCollisionConfiguration();
 
-    collisionDispatcher_ = make_unique<btCollisionDispatcher>(collisionConfiguration_);
-    btGImpactCollisionAlgorithm::registerAlgorithm(static_cast<btCollisionDispatcher*>(collisionDispatcher_.get()));
-
     broadphase_ = make_unique<btDbvtBroadphase>();
-    solver_ = make_unique<btSequentialImpulseConstraintSolver>();
-    world_ = make_unique<btDiscreteDynamicsWorld>(collisionDispatcher_.get(), broadphase_.get(), solver_.get(), collisionConfiguration_);
+    CreateWorld();
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
     world_->getDispatchInfo().m_useContinuous = true;
     world_->getSolverInfo().m_splitImpulse = false; // Disable by default for performance
-    world_->setDebugDrawer(this);
-    world_->setInternalTickCallback(InternalPreTickCallback, static_cast<void*>(this), true);
-    world_->setInternalTickCallback(InternalTickCallback, static_cast<void*>(this), false);
-    world_->setSynchronizeAllMotionStates(true);
 }
 
 PhysicsWorld::~PhysicsWorld()
 {
+    // Worker threads must not be left cooking geometry that is about to be freed
+    if (!cookingGeometries_.Empty())
+    {
+        auto* queue = GetSubsystem<WorkQueue>();
+        for (const Pair<SharedPtr<WorkItem>, SharedPtr<CollisionGeometryData>>& cooking : cookingGeometries_)
+        {
+            if (!queue->RemoveWorkItem(cooking.first_))
+            {
+                while (!cooking.first_->completed_)
+                    Time::Sleep(0);
+            }
+        }
+    }
+
     if (scene_)
     {
         // Force all remaining constraints, rigid bodies and collision shapes to release themselves
@@ -171,6 +423,7 @@ PhysicsWorld::~PhysicsWorld()
     }
 
     world_.reset();
+    solverMt_.reset();
     solver_.reset();
     broadphase_.reset();
     collisionDispatcher_.reset();
@@ -193,6 +446,15 @@ void PhysicsWorld::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Interpolation", interpolation_, true, AM_FILE);
     URHO3D_ATTRIBUTE("Internal Edge Utility", internalEdge_, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Multithreaded", IsMultithreaded, SetMultithreaded, false, AM_FILE);
+    URHO3D_ATTRIBUTE("Parallel Transform Sync", parallelTransformSync_, false, AM_FILE);
+    URHO3D_ATTRIBUTE("Background Cooking", backgroundCooking_, false, AM_FILE);
+    URHO3D_ATTRIBUTE("Cooked Geometry Dir", cookedGeometryDir_, String::EMPTY, AM_FILE);
+    URHO3D_ATTRIBUTE("Collision Events", collisionEventsEnabled_, true, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Contact Stream", IsContactStreamEnabled, SetContactStreamEnabled, false, AM_FILE);
+    URHO3D_ATTRIBUTE("Contact Stream Mask", contactStreamMask_, M_MAX_UNSIGNED, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Snapshot History", GetSnapshotHistorySize, SetSnapshotHistorySize, 0, AM_FILE);
+    URHO3D_ATTRIBUTE("Deterministic Rollback", deterministicRollback_, false, AM_FILE);
 }
 
 bool PhysicsWorld::isVisible(const btVector3& aabbMin, const btVector3& aabbMax)
@@ -250,6 +512,10 @@ void PhysicsWorld::Update(float timeStep)
     else if (maxSubSteps_ > 0)
         maxSubSteps = Min(maxSubSteps, maxSubSteps_);
 
+    CreateWorld();
+    if (numWorldThreads_)
+        ActivateTaskScheduler(GetSubsystem<WorkQueue>());
+
     delayedWorldTransforms_.Clear();
     simulating_ = true;
 
@@ -261,6 +527,7 @@ void PhysicsWorld::Update(float timeStep)
         while (timeAcc_ >= internalTimeStep && maxSubSteps > 0)
         {
             world_->stepSimulation(internalTimeStep, 0, internalTimeStep);
+            CanonicalizeStep();
             timeAcc_ -= internalTimeStep;
             --maxSubSteps;
         }
@@ -268,6 +535,13 @@ void PhysicsWorld::Update(float timeStep)
 
     simulating_ = false;
 
+    ApplyWorldTransforms();
+}
+
+void PhysicsWorld::ApplyWorldTransforms()
+{
+    ApplyBatchedWorldTransforms();
+
     // Apply delayed (parented) world transforms now
     while (!delayedWorldTransforms_.Empty())
     {
@@ -290,6 +564,10 @@ void PhysicsWorld::Update(float timeStep)
 
 void PhysicsWorld::UpdateCollisions()
 {
+    CreateWorld();
+    if (numWorldThreads_)
+        ActivateTaskScheduler(GetSubsystem<WorkQueue>());
+
     world_->performDiscreteCollisionDetection();
 }
 
@@ -346,6 +624,354 @@ void PhysicsWorld::SetSplitImpulse(bool enable)
     MarkNetworkUpdate();
 }
 
+void PhysicsWorld::SetMultithreaded(bool enable)
+{
+    if (enable != multithreaded_)
+    {
+        multithreaded_ = enable;
+        // The world can not be recreated inside the simulation step, in that case Update() recreates it before the next step
+        if (!simulating_)
+            CreateWorld();
+
+        MarkNetworkUpdate();
+    }
+}
+
+void PhysicsWorld::SetSnapshotHistorySize(i32 size)
+{
+    size = Max(size, 0);
+    if (size == snapshotHistory_.Size())
+        return;
+
+    // The ring is indexed by step, so the saved snapshots are no longer in place
+    snapshotHistory_.Resize(size);
+    for (PhysicsWorldSnapshot& snapshot : snapshotHistory_)
+        snapshot.step_ = M_MAX_UNSIGNED;
+}
+
+void PhysicsWorld::SetDeterministicRollback(bool enable)
+{
+    deterministicRollback_ = enable;
+}
+
+void PhysicsWorld::SaveSnapshot(PhysicsWorldSnapshot& snapshot) const
+{
+    URHO3D_PROFILE(SavePhysicsSnapshot);
+
+    snapshot.step_ = simulationStep_;
+    snapshot.bodies_.Clear();
+    snapshot.manifolds_.Clear();
+    snapshot.contactPoints_.Clear();
+    snapshot.constraints_.Clear();
+
+    for (RigidBody* rigidBody : rigidBodies_)
+    {
+        const btRigidBody* body = rigidBody->GetBody();
+        if (!body || body->isStaticOrKinematicObject())
+            continue;
+
+        PhysicsBodySnapshot state;
+        state.body_ = rigidBody;
+        state.worldTransform_ = body->getWorldTransform();
+        state.interpolationWorldTransform_ = body->getInterpolationWorldTransform();
+        state.linearVelocity_ = body->getLinearVelocity();
+        state.angularVelocity_ = body->getAngularVelocity();
+        state.interpolationLinearVelocity_ = body->getInterpolationLinearVelocity();
+        state.interpolationAngularVelocity_ = body->getInterpolationAngularVelocity();
+        state.deactivationTime_ = body->getDeactivationTime();
+        state.activationState_ = body->getActivationState();
+        snapshot.bodies_.Push(state);
+    }
+
+    btDispatcher* dispatcher = world_->getDispatcher();
+    const i32 numManifolds = dispatcher->getNumManifolds();
+    for (i32 i = 0; i < numManifolds; ++i)
+    {
+        const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+        const i32 numPoints = manifold->getNumContacts();
+        if (!numPoints)
+            continue;
+
+        snapshot.manifolds_.Push(PhysicsManifoldSnapshot{manifold->getBody0(), manifold->getBody1(), snapshot.contactPoints_.Size(),
+            numPoints});
+        for (i32 j = 0; j < numPoints; ++j)
+            snapshot.contactPoints_.Push(manifold->getContactPoint(j));
+    }
+
+    for (Constraint* constraint : constraints_)
+    {
+        if (const btTypedConstraint* btConstraint = constraint->GetConstraint())
+            snapshot.constraints_.Push(PhysicsConstraintSnapshot{WeakPtr<Constraint>(constraint), btConstraint->getAppliedImpulse()});
+    }
+
+    // The solver pool of the multithreaded world has a seed per solver, which is not saved
+    snapshot.solverSeed_ = numWorldThreads_ ? 0 : static_cast<btSequentialImpulseConstraintSolver*>(solver_.get())->getRandSeed();
+}
+
+void PhysicsWorld::RestoreSnapshot(const PhysicsWorldSnapshot& snapshot)
+{
+    if (simulating_)
+    {
+        URHO3D_LOGERROR("Can not restore a physics snapshot during the simulation step");
+        return;
+    }
+
+    URHO3D_PROFILE(RestorePhysicsSnapshot);
+
+    CreateWorld();
+    if (numWorldThreads_)
+        ActivateTaskScheduler(GetSubsystem<WorkQueue>());
+
+    for (const PhysicsBodySnapshot& state : snapshot.bodies_)
+    {
+        RigidBody* rigidBody = state.body_;
+        btRigidBody* body = rigidBody ? rigidBody->GetBody() : nullptr;
+        if (!body || body->isStaticOrKinematicObject())
+            continue;
+
+        body->setWorldTransform(state.worldTransform_);
+        body->setInterpolationWorldTransform(state.interpolationWorldTransform_);
+        body->updateInertiaTensor();
+        body->setLinearVelocity(state.linearVelocity_);
+        body->setAngularVelocity(state.angularVelocity_);
+        body->setInterpolationLinearVelocity(state.interpolationLinearVelocity_);
+        body->setInterpolationAngularVelocity(state.interpolationAngularVelocity_);
+        body->clearForces();
+        body->forceActivationState(state.activationState_);
+        body->setDeactivationTime(state.deactivationTime_);
+
+        rigidBody->QueueWorldTransform(state.worldTransform_);
+    }
+
+    RestoreContacts(snapshot);
+
+    simulationStep_ = snapshot.step_;
+    ApplyWorldTransforms();
+}
+
+bool PhysicsWorld::Rollback(u32 step)
+{
+    const PhysicsWorldSnapshot* snapshot = GetHistorySnapshot(step);
+    if (!snapshot)
+        return false;
+
+    RestoreSnapshot(*snapshot);
+    return true;
+}
+
+void PhysicsWorld::Resimulate(i32 numSteps)
+{
+    URHO3D_PROFILE(ResimulatePhysics);
+
+    const float internalTimeStep = 1.0f / fps_;
+
+    CreateWorld();
+    if (numWorldThreads_)
+        ActivateTaskScheduler(GetSubsystem<WorkQueue>());
+
+    delayedWorldTransforms_.Clear();
+    simulating_ = true;
+
+    for (i32 i = 0; i < numSteps; ++i)
+    {
+        world_->stepSimulation(internalTimeStep, 0, internalTimeStep);
+        CanonicalizeStep();
+    }
+
+    simulating_ = false;
+
+    ApplyWorldTransforms();
+}
+
+void PhysicsWorld::RestoreContacts(const PhysicsWorldSnapshot& snapshot)
+{
+    RebuildBroadphase();
+
+    // Find the contacts again and replace their points with the saved ones, which carry the warm starting impulses.
+    // Pairs are matched in the saved order, as compound shapes have a manifold per child shape
+    const i32 numSaved = snapshot.manifolds_.Size();
+    restoreManifoldOrder_.Resize(numSaved);
+    for (i32 i = 0; i < numSaved; ++i)
+        restoreManifoldOrder_[i] = i;
+    const auto compareManifolds = [&snapshot](i32 lhs, i32 rhs)
+    {
+        const PhysicsManifoldSnapshot& lhsManifold = snapshot.manifolds_[lhs];
+        const PhysicsManifoldSnapshot& rhsManifold = snapshot.manifolds_[rhs];
+        if (lhsManifold.body0_ != rhsManifold.body0_)
+            return lhsManifold.body0_ < rhsManifold.body0_;
+        if (lhsManifold.body1_ != rhsManifold.body1_)
+            return lhsManifold.body1_ < rhsManifold.body1_;
+        return lhs < rhs;
+    };
+    Sort(restoreManifoldOrder_.Begin(), restoreManifoldOrder_.End(), compareManifolds);
+
+    world_->performDiscreteCollisionDetection();
+
+    btDispatcher* dispatcher = world_->getDispatcher();
+    const i32 numManifolds = dispatcher->getNumManifolds();
+    for (i32 i = 0; i < numManifolds; ++i)
+    {
+        btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+        manifold->clearManifold();
+
+        // Binary search for the first saved manifold of the pair, then skip the ones already matched, which are marked
+        // by complementing the index
+        i32 first = 0;
+        i32 count = numSaved;
+        while (count > 0)
+        {
+            const i32 step = count / 2;
+            const i32 index = restoreManifoldOrder_[first + step];
+            const PhysicsManifoldSnapshot& saved = snapshot.manifolds_[index < 0 ? ~index : index];
+            if (saved.body0_ < manifold->getBody0() || (saved.body0_ == manifold->getBody0() && saved.body1_ < manifold->getBody1()))
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+
+        for (i32 j = first; j < numSaved; ++j)
+        {
+            const i32 index = restoreManifoldOrder_[j];
+            const PhysicsManifoldSnapshot& saved = snapshot.manifolds_[index < 0 ? ~index : index];
+            if (saved.body0_ != manifold->getBody0() || saved.body1_ != manifold->getBody1())
+                break;
+            if (index < 0)
+                continue;
+
+            manifold->setNumContacts(saved.numPoints_);
+            for (i32 k = 0; k < saved.numPoints_; ++k)
+                manifold->getContactPoint(k) = snapshot.contactPoints_[saved.firstPoint_ + k];
+            restoreManifoldOrder_[j] = ~index;
+            break;
+        }
+    }
+
+    for (const PhysicsConstraintSnapshot& state : snapshot.constraints_)
+    {
+        Constraint* constraint = state.constraint_;
+        if (btTypedConstraint* btConstraint = constraint ? constraint->GetConstraint() : nullptr)
+            btConstraint->internalSetAppliedImpulse(state.appliedImpulse_);
+    }
+
+    if (!numWorldThreads_)
+        static_cast<btSequentialImpulseConstraintSolver*>(solver_.get())->setRandSeed(snapshot.solverSeed_);
+}
+
+void PhysicsWorld::CanonicalizeStep()
+{
+    if (!deterministicRollback_)
+        return;
+
+    // Continue from the same broadphase and contact state as when the snapshot is restored, so that the steps
+    // simulated from here on are bit-identical to resimulating them. This is done between the steps rather than in
+    // the tick callback, so that Bullet has finished the step
+    if (const PhysicsWorldSnapshot* snapshot = GetHistorySnapshot(simulationStep_))
+        RestoreContacts(*snapshot);
+}
+
+const PhysicsWorldSnapshot* PhysicsWorld::GetHistorySnapshot(u32 step) const
+{
+    if (snapshotHistory_.Empty() || step > simulationStep_)
+        return nullptr;
+
+    const PhysicsWorldSnapshot& snapshot = snapshotHistory_[step % snapshotHistory_.Size()];
+    return snapshot.step_ == step ? &snapshot : nullptr;
+}
+
+void PhysicsWorld::RebuildBroadphase()
+{
+    btCollisionObjectArray& objects = world_->getCollisionObjectArray();
+    btDispatcher* dispatcher = world_->getDispatcher();
+    broadphaseFilters_.Resize(objects.size());
+
+    // Destroying the proxies also destroys their pairs, collision algorithms and manifolds
+    for (i32 i = 0; i < objects.size(); ++i)
+    {
+        btBroadphaseProxy* proxy = objects[i]->getBroadphaseHandle();
+        if (!proxy)
+            continue;
+
+        broadphaseFilters_[i] = IntVector2(proxy->m_collisionFilterGroup, proxy->m_collisionFilterMask);
+        broadphase_->destroyProxy(proxy, dispatcher);
+        objects[i]->setBroadphaseHandle(nullptr);
+    }
+
+    // With no proxies left, the dynamic tree and its incremental update state are reset
+    broadphase_->resetPool(dispatcher);
+
+    for (i32 i = 0; i < objects.size(); ++i)
+    {
+        btCollisionObject* object = objects[i];
+        btVector3 aabbMin, aabbMax;
+        object->getCollisionShape()->getAabb(object->getWorldTransform(), aabbMin, aabbMax);
+        object->setBroadphaseHandle(broadphase_->createProxy(aabbMin, aabbMax, object->getCollisionShape()->getShapeType(),
+            object, broadphaseFilters_[i].x_, broadphaseFilters_[i].y_, dispatcher));
+    }
+}
+
+void PhysicsWorld::SetParallelTransformSync(bool enable)
+{
+    parallelTransformSync_ = enable;
+}
+
+void PhysicsWorld::SetBackgroundCooking(bool enable)
+{
+    backgroundCooking_ = enable;
+}
+
+void PhysicsWorld::SetCookedGeometryDir(const String& dir)
+{
+    cookedGeometryDir_ = dir;
+}
+
+void PhysicsWorld::CompleteCooking()
+{
+    if (cookingGeometries_.Empty())
+        return;
+
+    URHO3D_PROFILE(CompleteCooking);
+
+    auto* queue = GetSubsystem<WorkQueue>();
+    while (!cookingGeometries_.Empty())
+    {
+        const i32 index = cookingGeometries_.Size() - 1;
+        const Pair<SharedPtr<WorkItem>, SharedPtr<CollisionGeometryData>>& cooking = cookingGeometries_[index];
+        // Cook here if no worker thread has started yet, otherwise wait for the worker thread
+        if (queue->RemoveWorkItem(cooking.first_))
+            cooking.second_->Cook();
+        else
+        {
+            while (!cooking.first_->completed_)
+                Time::Sleep(0);
+        }
+        FinishCooking(index);
+    }
+}
+
+void PhysicsWorld::SetCollisionEventsEnabled(bool enable)
+{
+    collisionEventsEnabled_ = enable;
+}
+
+void PhysicsWorld::SetContactStreamEnabled(bool enable)
+{
+    contactStreamEnabled_ = enable;
+    if (!enable)
+    {
+        streamContacts_.Clear();
+        streamContactPoints_.Clear();
+        streamPairs_.Clear();
+    }
+}
+
+void PhysicsWorld::SetContactStreamMask(unsigned mask)
+{
+    contactStreamMask_ = mask;
+}
+
 void PhysicsWorld::SetMaxNetworkAngularVelocity(float velocity)
 {
     maxNetworkAngularVelocity_ = Clamp(velocity, 1.0f, 32767.0f);
@@ -388,29 +1014,7 @@ void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, f
     if (maxDistance >= M_INFINITY)
         URHO3D_LOGWARNING("Infinite maxDistance in physics raycast is not supported");
 
-    btCollisionWorld::ClosestRayResultCallback
-        rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ + maxDistance * ray.direction_));
-    rayCallback.m_collisionFilterGroup = (short)0xffff;
-    rayCallback.m_collisionFilterMask = (short)collisionMask;
-
-    world_->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
-
-    if (rayCallback.hasHit())
-    {
-        result.position_ = ToVector3(rayCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
-        result.distance_ = (result.position_ - ray.origin_).Length();
-        result.hitFraction_ = rayCallback.m_closestHitFraction;
-        result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
-    }
-    else
-    {
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
-        result.body_ = nullptr;
-    }
+    RaycastSingleImpl(world_.get(), result, ray, maxDistance, collisionMask);
 }
 
 void PhysicsWorld::RaycastSingleSegmented(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, float segmentDistance, unsigned collisionMask, float overlapDistance)
@@ -472,33 +1076,7 @@ void PhysicsWorld::SphereCast(PhysicsRaycastResult& result, const Ray& ray, floa
     if (maxDistance >= M_INFINITY)
         URHO3D_LOGWARNING("Infinite maxDistance in physics sphere cast is not supported");
 
-    btSphereShape shape(radius);
-    Vector3 endPos = ray.origin_ + maxDistance * ray.direction_;
-
-    btCollisionWorld::ClosestConvexResultCallback
-        convexCallback(ToBtVector3(ray.origin_), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = (short)collisionMask;
-
-    world_->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), convexCallback.m_convexFromWorld),
-        btTransform(btQuaternion::getIdentity(), convexCallback.m_convexToWorld), convexCallback);
-
-    if (convexCallback.hasHit())
-    {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = convexCallback.m_closestHitFraction * (endPos - ray.origin_).Length();
-        result.hitFraction_ = convexCallback.m_closestHitFraction;
-    }
-    else
-    {
-        result.body_ = nullptr;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
-    }
+    SphereCastImpl(world_.get(), result, ray, radius, maxDistance, collisionMask);
 }
 
 void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos,
@@ -569,30 +1147,31 @@ void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, btCollisionShape* sh
 
     URHO3D_PROFILE(PhysicsConvexCast);
 
-    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = (short)collisionMask;
+    ConvexCastImpl(world_.get(), result, static_cast<btConvexShape*>(shape), startPos, startRot, endPos, endRot, collisionMask);
+}
 
-    world_->convexSweepTest(static_cast<btConvexShape*>(shape), btTransform(ToBtQuaternion(startRot),
-            convexCallback.m_convexFromWorld), btTransform(ToBtQuaternion(endRot), convexCallback.m_convexToWorld),
-        convexCallback);
+void PhysicsWorld::RaycastSingleBatch(Vector<PhysicsRaycastResult>& results, const Vector<PhysicsRaycastQuery>& queries)
+{
+    URHO3D_PROFILE(PhysicsRaycastSingleBatch);
 
-    if (convexCallback.hasHit())
-    {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = convexCallback.m_closestHitFraction * (endPos - startPos).Length();
-        result.hitFraction_ = convexCallback.m_closestHitFraction;
-    }
-    else
-    {
-        result.body_ = nullptr;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
-    }
+    results.Resize(queries.Size());
+    if (queries.Empty())
+        return;
+
+    QueryBatch batch{world_.get(), &results[0], &queries[0], nullptr};
+    ExecuteQueryBatch(GetSubsystem<WorkQueue>(), batch, queries.Size());
+}
+
+void PhysicsWorld::ConvexCastBatch(Vector<PhysicsRaycastResult>& results, const Vector<PhysicsConvexCastQuery>& queries)
+{
+    URHO3D_PROFILE(PhysicsConvexCastBatch);
+
+    results.Resize(queries.Size());
+    if (queries.Empty())
+        return;
+
+    QueryBatch batch{world_.get(), &results[0], nullptr, &queries[0]};
+    ExecuteQueryBatch(GetSubsystem<WorkQueue>(), batch, queries.Size());
 }
 
 void PhysicsWorld::RemoveCachedGeometry(Model* model)
@@ -662,12 +1241,40 @@ void PhysicsWorld::GetRigidBodies(Vector<RigidBody*>& result, const RigidBody* b
     }
 }
 
+void PhysicsWorld::GetContacts(Vector<PhysicsContact>& result, unsigned collisionMask) const
+{
+    result.Clear();
+
+    for (const PhysicsContact& contact : streamContacts_)
+    {
+        if ((contact.bodyA_->GetCollisionLayer() | contact.bodyB_->GetCollisionLayer()) & collisionMask)
+            result.Push(contact);
+    }
+}
+
 void PhysicsWorld::GetCollidingBodies(Vector<RigidBody*>& result, const RigidBody* body)
 {
     URHO3D_PROFILE(GetCollidingBodies);
 
     result.Clear();
 
+    // The collision pairs are only stored for the events, otherwise check the manifolds
+    if (!collisionEventsEnabled_)
+    {
+        for (int i = 0; i < collisionDispatcher_->getNumManifolds(); ++i)
+        {
+            RigidBody* bodyA;
+            RigidBody* bodyB;
+            if (!GetReportedBodies(collisionDispatcher_->getManifoldByIndexInternal(i), bodyA, bodyB))
+                continue;
+            if (bodyA == body && !result.Contains(bodyB))
+                result.Push(bodyB);
+            else if (bodyB == body && !result.Contains(bodyA))
+                result.Push(bodyA);
+        }
+        return;
+    }
+
     for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody>>, ManifoldPair>::Iterator i = currentCollisions_.Begin();
          i != currentCollisions_.End(); ++i)
     {
@@ -709,6 +1316,17 @@ void PhysicsWorld::RemoveRigidBody(RigidBody* body)
     rigidBodies_.Remove(body);
     // Remove possible dangling pointer from the delayedWorldTransforms structure
     delayedWorldTransforms_.Erase(body);
+    for (i32 i = batchedWorldTransforms_.Size() - 1; i >= 0; --i)
+    {
+        if (batchedWorldTransforms_[i].rigidBody_ == body)
+            batchedWorldTransforms_.Erase(i);
+    }
+    // Forget the contact stream pairs of the body, so that a new body at the same address does not continue them
+    for (i32 i = streamPairs_.Size() - 1; i >= 0; --i)
+    {
+        if (streamPairs_[i].first_ == body || streamPairs_[i].second_ == body)
+            streamPairs_.Erase(i);
+    }
 }
 
 void PhysicsWorld::AddCollisionShape(CollisionShape* shape)
@@ -736,6 +1354,11 @@ void PhysicsWorld::AddDelayedWorldTransform(const DelayedWorldTransform& transfo
     delayedWorldTransforms_[transform.rigidBody_] = transform;
 }
 
+void PhysicsWorld::AddBatchedWorldTransform(const BatchedWorldTransform& transform)
+{
+    batchedWorldTransforms_.Push(transform);
+}
+
 void PhysicsWorld::DrawDebugGeometry(bool depthTest)
 {
     auto* debug = GetComponent<DebugRenderer>();
@@ -760,6 +1383,31 @@ void PhysicsWorld::CleanupGeometryCache()
     CleanupGeometryCacheImpl(gimpactTrimeshCache_);
 }
 
+void PhysicsWorld::CookGeometry(CollisionGeometryData* geometry)
+{
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (backgroundCooking_ && queue && queue->GetNumThreads())
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        // Lowest priority, so that the per-frame work is not delayed. The completion event is sent at the start of a frame
+        item->priority_ = 0;
+        item->workFunction_ = CookGeometryWork;
+        item->aux_ = geometry;
+        item->sendEvent_ = true;
+
+        geometry->cooked_ = false;
+        cookingGeometries_.Push(MakePair(item, SharedPtr<CollisionGeometryData>(geometry)));
+        SubscribeToEvent(queue, E_WORKITEMCOMPLETED, URHO3D_HANDLER(PhysicsWorld, HandleWorkItemCompleted));
+        queue->AddWorkItem(item);
+    }
+    else
+    {
+        URHO3D_PROFILE(CookCollisionGeometry);
+        geometry->Cook();
+        SaveCookedGeometry(context_, geometry);
+    }
+}
+
 void PhysicsWorld::OnSceneSet(Scene* scene)
 {
     // Subscribe to the scene subsystem update, which will trigger the physics simulation step
@@ -781,8 +1429,45 @@ void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap&
     Update(eventData[P_TIMESTEP].GetFloat());
 }
 
+void PhysicsWorld::HandleWorkItemCompleted(StringHash eventType, VariantMap& eventData)
+{
+    using namespace WorkItemCompleted;
+
+    auto* item = static_cast<WorkItem*>(eventData[P_ITEM].GetPtr());
+    for (i32 i = 0; i < cookingGeometries_.Size(); ++i)
+    {
+        if (cookingGeometries_[i].first_ == item)
+        {
+            FinishCooking(i);
+            break;
+        }
+    }
+}
+
+void PhysicsWorld::FinishCooking(i32 index)
+{
+    SharedPtr<CollisionGeometryData> geometry = cookingGeometries_[index].second_;
+    cookingGeometries_.Erase(index);
+    if (cookingGeometries_.Empty())
+        UnsubscribeFromEvent(E_WORKITEMCOMPLETED);
+
+    geometry->cooked_ = true;
+    SaveCookedGeometry(context_, geometry);
+
+    // Shapes that changed their geometry in the meanwhile no longer wait for it
+    for (CollisionShape* shape : collisionShapes_)
+    {
+        if (shape->GetGeometryData() == geometry)
+            shape->ApplyCookedGeometry();
+    }
+}
+
 void PhysicsWorld::PreStep(float timeStep)
 {
+    // Without interpolation each substep synchronizes the motion states, so apply the transforms of the previous one
+    // before the step logic runs
+    ApplyBatchedWorldTransforms();
+
     // Send pre-step event
     using namespace PhysicsPreStep;
 
@@ -816,12 +1501,29 @@ void PhysicsWorld::PostStep(float timeStep)
     eventData[P_WORLD] = this;
     eventData[P_TIMESTEP] = timeStep;
     SendEvent(E_PHYSICSPOSTSTEP, eventData);
+
+    ++simulationStep_;
+    if (!snapshotHistory_.Empty())
+        SaveSnapshot(snapshotHistory_[simulationStep_ % snapshotHistory_.Size()]);
 }
 
 void PhysicsWorld::SendCollisionEvents()
 {
     URHO3D_PROFILE(SendCollisionEvents);
 
+    if (contactStreamEnabled_)
+        BuildContactStream();
+
+    // Without the events there is no need to track the collision pairs
+    if (!collisionEventsEnabled_)
+    {
+        currentCollisions_.Clear();
+        previousCollisions_.Clear();
+        return;
+    }
+
+    // The pairs of the last step become the previous pairs, which are used to check if a collision is "new"
+    previousCollisions_.Swap(currentCollisions_);
     currentCollisions_.Clear();
     physicsCollisionData_.Clear();
     nodeCollisionData_.Clear();
@@ -835,26 +1537,9 @@ void PhysicsWorld::SendCollisionEvents()
         for (int i = 0; i < numManifolds; ++i)
         {
             btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
-            // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
-            if (!contactManifold->getNumContacts())
-                continue;
-
-            const btCollisionObject* objectA = contactManifold->getBody0();
-            const btCollisionObject* objectB = contactManifold->getBody1();
-
-            auto* bodyA = static_cast<RigidBody*>(objectA->getUserPointer());
-            auto* bodyB = static_cast<RigidBody*>(objectB->getUserPointer());
-            // If it's not a rigidbody, maybe a ghost object
-            if (!bodyA || !bodyB)
-                continue;
-
-            // Skip collision event signaling if both objects are static, or if collision event mode does not match
-            if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                !bodyA->IsActive() && !bodyB->IsActive())
+            RigidBody* bodyA;
+            RigidBody* bodyB;
+            if (!GetReportedBodies(contactManifold, bodyA, bodyB))
                 continue;
 
             WeakPtr<RigidBody> bodyWeakA(bodyA);
@@ -874,7 +1559,10 @@ void PhysicsWorld::SendCollisionEvents()
                 currentCollisions_[bodyPair].flippedManifold_ = contactManifold;
             }
         }
+    }
 
+    if (!currentCollisions_.Empty())
+    {
         for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody>>, ManifoldPair>::Iterator i = currentCollisions_.Begin();
              i != currentCollisions_.End(); ++i)
         {
@@ -1003,6 +1691,7 @@ void PhysicsWorld::SendCollisionEvents()
     }
 
     // Send collision end events as applicable
+    if (!previousCollisions_.Empty())
     {
         physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
 
@@ -1060,13 +1749,247 @@ void PhysicsWorld::SendCollisionEvents()
             }
         }
     }
+}
+
+void PhysicsWorld::BuildContactStream()
+{
+    URHO3D_PROFILE(BuildContactStream);
+
+    streamContacts_.Clear();
+    streamContactPoints_.Clear();
+    streamManifolds_.Clear();
+    previousStreamPairs_.Swap(streamPairs_);
+    streamPairs_.Clear();
+
+    // Collect the manifolds of the recorded pairs. A pair may have several manifolds, for example with compound shapes
+    const int numManifolds = collisionDispatcher_->getNumManifolds();
+    for (int i = 0; i < numManifolds; ++i)
+    {
+        btPersistentManifold* manifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        RigidBody* bodyA;
+        RigidBody* bodyB;
+        if (!GetReportedBodies(manifold, bodyA, bodyB) ||
+            !((bodyA->GetCollisionLayer() | bodyB->GetCollisionLayer()) & contactStreamMask_))
+            continue;
+
+        if (bodyA < bodyB)
+            streamManifolds_.Push(StreamManifold{MakePair(bodyA, bodyB), manifold, false, i});
+        else
+            streamManifolds_.Push(StreamManifold{MakePair(bodyB, bodyA), manifold, true, i});
+    }
+
+    Sort(streamManifolds_.Begin(), streamManifolds_.End(), [](const StreamManifold& lhs, const StreamManifold& rhs)
+    {
+        if (lhs.bodies_ != rhs.bodies_)
+            return lhs.bodies_ < rhs.bodies_;
+        return lhs.index_ < rhs.index_;
+    });
+
+    // Walk the sorted pairs of this and the previous step together to find the starting, staying and ending contacts
+    i32 previous = 0;
+    for (i32 i = 0; i < streamManifolds_.Size();)
+    {
+        const Pair<RigidBody*, RigidBody*>& bodies = streamManifolds_[i].bodies_;
+        for (; previous < previousStreamPairs_.Size() && previousStreamPairs_[previous] < bodies; ++previous)
+            AddStreamContactEnd(previousStreamPairs_[previous]);
+
+        PhysicsContact contact;
+        contact.bodyA_ = bodies.first_;
+        contact.bodyB_ = bodies.second_;
+        contact.firstPoint_ = streamContactPoints_.Size();
+        contact.state_ = CONTACT_START;
+        contact.trigger_ = bodies.first_->IsTrigger() || bodies.second_->IsTrigger();
+        if (previous < previousStreamPairs_.Size() && previousStreamPairs_[previous] == bodies)
+        {
+            contact.state_ = CONTACT_STAY;
+            ++previous;
+        }
+
+        // As in the collision events, the normals of the flipped manifolds are flipped to point towards body A
+        for (; i < streamManifolds_.Size() && streamManifolds_[i].bodies_ == bodies; ++i)
+            AddStreamContactPoints(streamManifolds_[i].manifold_, streamManifolds_[i].flipped_);
 
-    previousCollisions_ = currentCollisions_;
+        contact.numPoints_ = streamContactPoints_.Size() - contact.firstPoint_;
+        streamContacts_.Push(contact);
+        streamPairs_.Push(bodies);
+    }
+    for (; previous < previousStreamPairs_.Size(); ++previous)
+        AddStreamContactEnd(previousStreamPairs_[previous]);
+}
+
+void PhysicsWorld::AddStreamContactEnd(const Pair<RigidBody*, RigidBody*>& bodies)
+{
+    // The pair may have ended because it is no longer recorded
+    if (!((bodies.first_->GetCollisionLayer() | bodies.second_->GetCollisionLayer()) & contactStreamMask_))
+        return;
+
+    PhysicsContact contact;
+    contact.bodyA_ = bodies.first_;
+    contact.bodyB_ = bodies.second_;
+    contact.firstPoint_ = streamContactPoints_.Size();
+    contact.numPoints_ = 0;
+    contact.state_ = CONTACT_END;
+    contact.trigger_ = bodies.first_->IsTrigger() || bodies.second_->IsTrigger();
+    streamContacts_.Push(contact);
+}
+
+void PhysicsWorld::AddStreamContactPoints(btPersistentManifold* manifold, bool flipNormals)
+{
+    if (!manifold)
+        return;
+
+    for (int i = 0; i < manifold->getNumContacts(); ++i)
+    {
+        const btManifoldPoint& point = manifold->getContactPoint(i);
+        PhysicsContactPoint contactPoint;
+        contactPoint.position_ = ToVector3(point.m_positionWorldOnB);
+        contactPoint.normal_ = flipNormals ? -ToVector3(point.m_normalWorldOnB) : ToVector3(point.m_normalWorldOnB);
+        contactPoint.distance_ = point.m_distance1;
+        contactPoint.impulse_ = point.m_appliedImpulse;
+        streamContactPoints_.Push(contactPoint);
+    }
+}
+
+void PhysicsWorld::ApplyBatchedWorldTransforms()
+{
+    if (batchedWorldTransforms_.Empty())
+        return;
+
+    URHO3D_PROFILE(ApplyPhysicsTransforms);
+
+    // The node dirtying caused by the new transforms must not be applied back to the bodies
+    applyingTransforms_ = true;
+    ApplyWorldTransformBatch(scene_, batchedWorldTransforms_, parallelTransformSync_, ApplyBatchedWorldTransform);
+    applyingTransforms_ = false;
+}
+
+void PhysicsWorld::CreateWorld()
+{
+    i32 numThreads = 0;
+    auto* queue = GetSubsystem<WorkQueue>();
+#if BT_THREADSAFE
+    if (multithreaded_ && queue && queue->GetNumThreads())
+        numThreads = Min(queue->GetNumThreads() + 1, (i32)BT_MAX_THREAD_COUNT);
+#endif
+
+    if (world_ && numThreads == numWorldThreads_)
+        return;
+
+    unique_ptr<btDiscreteDynamicsWorld> oldWorld = move(world_);
+    unique_ptr<btDispatcher> oldDispatcher = move(collisionDispatcher_);
+    unique_ptr<btConstraintSolver> oldSolver = move(solver_);
+    unique_ptr<btConstraintSolver> oldSolverMt = move(solverMt_);
+
+    if (numThreads)
+    {
+        // The multithreaded dispatcher sizes its per-thread data from the active scheduler
+        ActivateTaskScheduler(queue);
+        collisionDispatcher_ = make_unique<btCollisionDispatcherMt>(collisionConfiguration_);
+        auto* solverPool = new btConstraintSolverPoolMt(numThreads);
+        solver_.reset(solverPool);
+        solverMt_ = make_unique<btSequentialImpulseConstraintSolverMt>();
+        world_ = make_unique<btDiscreteDynamicsWorldMt>(collisionDispatcher_.get(), broadphase_.get(), solverPool, solverMt_.get(),
+            collisionConfiguration_);
+    }
+    else
+    {
+        collisionDispatcher_ = make_unique<btCollisionDispatcher>(collisionConfiguration_);
+        solver_ = make_unique<btSequentialImpulseConstraintSolver>();
+        world_ = make_unique<btDiscreteDynamicsWorld>(collisionDispatcher_.get(), broadphase_.get(), solver_.get(),
+            collisionConfiguration_);
+    }
+
+    numWorldThreads_ = numThreads;
+    btGImpactCollisionAlgorithm::registerAlgorithm(static_cast<btCollisionDispatcher*>(collisionDispatcher_.get()));
+    world_->setDebugDrawer(this);
+    world_->setInternalTickCallback(InternalPreTickCallback, static_cast<void*>(this), true);
+    world_->setInternalTickCallback(InternalTickCallback, static_cast<void*>(this), false);
+    world_->setSynchronizeAllMotionStates(true);
+
+    if (!oldWorld)
+        return;
+
+    URHO3D_PROFILE(RecreatePhysicsWorld);
+
+    world_->setGravity(oldWorld->getGravity());
+    world_->getSolverInfo() = oldWorld->getSolverInfo();
+    world_->getDispatchInfo() = oldWorld->getDispatchInfo();
+
+    // Remove everything from the old world in its original order, then add to the new world in the same order
+    Vector<Pair<btTypedConstraint*, bool>> constraints;
+    for (int i = 0; i < oldWorld->getNumConstraints(); ++i)
+    {
+        btTypedConstraint* constraint = oldWorld->getConstraint(i);
+        constraints.Push(MakePair(constraint, IsCollisionDisabled(constraint)));
+    }
+    for (const Pair<btTypedConstraint*, bool>& constraint : constraints)
+        oldWorld->removeConstraint(constraint.first_);
+
+    Vector<btActionInterface*> actions;
+    const btAlignedObjectArray<btActionInterface*>& oldActions = DynamicsWorldActions::Get(oldWorld.get());
+    for (int i = 0; i < oldActions.size(); ++i)
+        actions.Push(oldActions[i]);
+    for (btActionInterface* action : actions)
+        oldWorld->removeAction(action);
+
+    struct CollisionObjectEntry
+    {
+        btCollisionObject* object_;
+        int group_;
+        int mask_;
+        Vector3 gravity_;
+    };
+
+    Vector<CollisionObjectEntry> objects;
+    const btCollisionObjectArray& oldObjects = oldWorld->getCollisionObjectArray();
+    for (int i = 0; i < oldObjects.size(); ++i)
+    {
+        btCollisionObject* object = oldObjects[i];
+        btBroadphaseProxy* proxy = object->getBroadphaseHandle();
+        btRigidBody* body = btRigidBody::upcast(object);
+        objects.Push(CollisionObjectEntry{object, proxy ? proxy->m_collisionFilterGroup : 0, proxy ? proxy->m_collisionFilterMask : 0,
+            body ? ToVector3(body->getGravity()) : Vector3::ZERO});
+    }
+    for (const CollisionObjectEntry& entry : objects)
+    {
+        if (btRigidBody* body = btRigidBody::upcast(entry.object_))
+            oldWorld->removeRigidBody(body);
+        else
+            oldWorld->removeCollisionObject(entry.object_);
+    }
+
+    for (const CollisionObjectEntry& entry : objects)
+    {
+        if (btRigidBody* body = btRigidBody::upcast(entry.object_))
+        {
+            world_->addRigidBody(body, entry.group_, entry.mask_);
+            // Keep per-body gravity overrides, which adding to the world resets
+            body->setGravity(ToBtVector3(entry.gravity_));
+        }
+        else
+            world_->addCollisionObject(entry.object_, entry.group_, entry.mask_);
+    }
+    for (const Pair<btTypedConstraint*, bool>& constraint : constraints)
+        world_->addConstraint(constraint.first_, constraint.second_);
+    for (btActionInterface* action : actions)
+        world_->addAction(action);
+
+    // The old world must be destroyed before the dispatcher and solvers it uses
+    oldWorld.reset();
+    oldSolverMt.reset();
+    oldSolver.reset();
+    oldDispatcher.reset();
+
+    // Keep the collision pairs for continuous collision events, but forget the manifolds of the old dispatcher
+    for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody>>, ManifoldPair>::Iterator i = currentCollisions_.Begin();
+         i != currentCollisions_.End(); ++i)
+        i->second_ = ManifoldPair();
 }
 
 void RegisterPhysicsLibrary(Context* context)
 {
     CollisionShape::RegisterObject(context);
+    CookedCollisionGeometry::RegisterObject(context);
     RigidBody::RegisterObject(context);
     Constraint::RegisterObject(context);
     PhysicsWorld::RegisterObject(context);
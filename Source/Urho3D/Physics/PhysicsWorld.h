@@ -6,15 +6,19 @@
 #include "../Container/HashSet.h"
 #include "../IO/VectorBuffer.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Ray.h"
 #include "../Math/Sphere.h"
 #include "../Math/Vector3.h"
 #include "../Scene/Component.h"
 
+#include <Bullet/BulletCollision/NarrowPhaseCollision/btManifoldPoint.h>
 #include <Bullet/LinearMath/btIDebugDraw.h>
+#include <Bullet/LinearMath/btTransform.h>
 
 #include <memory>
 
 class btCollisionConfiguration;
+class btCollisionObject;
 class btCollisionShape;
 class btBroadphaseInterface;
 class btConstraintSolver;
@@ -31,13 +35,13 @@ class Deserializer;
 class Constraint;
 class Model;
 class Node;
-class Ray;
 class RigidBody;
 class Scene;
 class Serializer;
 class XMLElement;
 
 struct CollisionGeometryData;
+struct WorkItem;
 
 /// Physics raycast hit.
 struct URHO3D_API PhysicsRaycastResult
@@ -60,6 +64,36 @@ struct URHO3D_API PhysicsRaycastResult
     RigidBody* body_{};
 };
 
+/// Raycast or swept sphere test in a batched physics query.
+struct URHO3D_API PhysicsRaycastQuery
+{
+    /// Ray.
+    Ray ray_;
+    /// Maximum distance along the ray.
+    float maxDistance_{};
+    /// Radius of the swept sphere, or 0 for a raycast.
+    float radius_{};
+    /// Collision mask.
+    unsigned collisionMask_{M_MAX_UNSIGNED};
+};
+
+/// Swept convex test in a batched physics query.
+struct URHO3D_API PhysicsConvexCastQuery
+{
+    /// Bullet collision shape, which must be convex.
+    btCollisionShape* shape_{};
+    /// Start position.
+    Vector3 startPos_;
+    /// Start rotation.
+    Quaternion startRot_;
+    /// End position.
+    Vector3 endPos_;
+    /// End rotation.
+    Quaternion endRot_;
+    /// Collision mask.
+    unsigned collisionMask_{M_MAX_UNSIGNED};
+};
+
 /// Delayed world transform assignment for parented rigidbodies.
 struct DelayedWorldTransform
 {
@@ -73,6 +107,122 @@ struct DelayedWorldTransform
     Quaternion worldRotation_;
 };
 
+/// State of a body pair in the contact stream.
+enum ContactState : u8
+{
+    /// The bodies started touching on this step.
+    CONTACT_START = 0,
+    /// The bodies were already touching on the previous step.
+    CONTACT_STAY,
+    /// The bodies stopped touching on this step. There are no contact points.
+    CONTACT_END
+};
+
+/// Contact point in the contact stream.
+struct PhysicsContactPoint
+{
+    /// Worldspace position on body B.
+    Vector3 position_;
+    /// Worldspace normal on body B, pointing towards body A.
+    Vector3 normal_;
+    /// Distance, negative when penetrating.
+    float distance_;
+    /// Impulse applied by the constraint solver.
+    float impulse_;
+};
+
+/// Body pair record in the contact stream.
+struct PhysicsContact
+{
+    /// First rigid body.
+    RigidBody* bodyA_;
+    /// Second rigid body.
+    RigidBody* bodyB_;
+    /// Index of the first contact point in the contact point array.
+    i32 firstPoint_;
+    /// Number of contact points.
+    i32 numPoints_;
+    /// Contact state.
+    ContactState state_;
+    /// Whether either of the bodies is a trigger.
+    bool trigger_;
+};
+
+/// Rigid body world transform from the simulation, applied to the scene node after the step together with the other bodies.
+struct BatchedWorldTransform
+{
+    /// Rigid body.
+    RigidBody* rigidBody_;
+    /// New world position.
+    Vector3 worldPosition_;
+    /// New world rotation.
+    Quaternion worldRotation_;
+    /// Whether the transform may be applied from a worker thread. True when the node is a direct child of the scene and no SmoothedTransform is used.
+    bool threadSafe_;
+};
+
+/// Simulation state of a dynamic rigid body in a physics world snapshot. Stored in Bullet's own types to restore it bit for bit.
+struct PhysicsBodySnapshot
+{
+    /// Rigid body.
+    WeakPtr<RigidBody> body_;
+    /// Center of mass transform.
+    btTransform worldTransform_;
+    /// Center of mass transform used for motion state interpolation.
+    btTransform interpolationWorldTransform_;
+    /// Linear velocity.
+    btVector3 linearVelocity_;
+    /// Angular velocity.
+    btVector3 angularVelocity_;
+    /// Linear velocity used for motion state interpolation.
+    btVector3 interpolationLinearVelocity_;
+    /// Angular velocity used for motion state interpolation.
+    btVector3 interpolationAngularVelocity_;
+    /// Time spent below the sleep thresholds.
+    float deactivationTime_;
+    /// Bullet activation state.
+    int activationState_;
+};
+
+/// Contact manifold in a physics world snapshot. The collision object pointers are only used to find the contact again.
+struct PhysicsManifoldSnapshot
+{
+    /// First collision object.
+    const btCollisionObject* body0_;
+    /// Second collision object.
+    const btCollisionObject* body1_;
+    /// Index of the first contact point in the snapshot's contact point array.
+    i32 firstPoint_;
+    /// Number of contact points.
+    i32 numPoints_;
+};
+
+/// Constraint state in a physics world snapshot.
+struct PhysicsConstraintSnapshot
+{
+    /// Constraint.
+    WeakPtr<Constraint> constraint_;
+    /// Impulse applied on the last step.
+    float appliedImpulse_;
+};
+
+/// Physics world state after a simulation step, for rolling back and resimulating. The vectors keep their memory when the snapshot is saved again.
+struct PhysicsWorldSnapshot
+{
+    /// Number of simulation steps taken when the snapshot was saved.
+    u32 step_{M_MAX_UNSIGNED};
+    /// Dynamic rigid bodies.
+    Vector<PhysicsBodySnapshot> bodies_;
+    /// Contact manifolds with contact points, which warm start the constraint solver.
+    Vector<PhysicsManifoldSnapshot> manifolds_;
+    /// Contact points of the manifolds.
+    Vector<btManifoldPoint> contactPoints_;
+    /// Constraints.
+    Vector<PhysicsConstraintSnapshot> constraints_;
+    /// Random seed of the sequential constraint solver.
+    unsigned long solverSeed_{};
+};
+
 /// Manifold pointers stored during collision processing.
 struct ManifoldPair
 {
@@ -175,6 +325,43 @@ public:
     void SetSplitImpulse(bool enable);
     /// Set maximum angular velocity for network replication.
     void SetMaxNetworkAngularVelocity(float velocity);
+    /// Set whether to send the physics and node collision events. Enabled by default.
+    /// @property
+    void SetCollisionEventsEnabled(bool enable);
+    /// Set whether to record the contacts of each simulation step into the contact stream. Disabled by default.
+    /// @property
+    void SetContactStreamEnabled(bool enable);
+    /// Set collision layer mask of the contact stream. Body pairs are recorded when either body's collision layer matches.
+    /// @property
+    void SetContactStreamMask(unsigned mask);
+    /// Set whether to apply the simulated transforms of top-level rigid bodies to their scene nodes in worker threads. The node dirty notifications are then handled like in the threaded drawable update, so custom components listening to those nodes must be thread-safe. Disabled by default.
+    /// @property
+    void SetParallelTransformSync(bool enable);
+    /// Set whether to run collision detection and constraint solving on the work queue threads. Requires a thread-safe Bullet build and work queue threads, otherwise the sequential world is used. Disabled by default.
+    /// @property
+    void SetMultithreaded(bool enable);
+    /// Set whether to cook triangle mesh BVHs and convex hulls of models in work queue threads. The collision shapes are created once their geometry has been cooked, and until then their dynamic rigid bodies are kept out of the simulation. Requires work queue threads, otherwise the geometry is cooked right away. Disabled by default.
+    /// @property
+    void SetBackgroundCooking(bool enable);
+    /// Set directory to load cooked triangle mesh BVHs and convex hulls of models from, and to save them into after cooking. The files are named by a checksum of the model geometry. A relative directory is looked up from the resource directories and packages, and saved into the first resource directory. Empty (default) disables the cooked geometry cache.
+    /// @property
+    void SetCookedGeometryDir(const String& dir);
+    /// Wait for the geometry being cooked in the background and create the collision shapes waiting for it.
+    void CompleteCooking();
+    /// Set number of simulation steps to keep snapshots of for rolling back. 0 (default) disables the history.
+    /// @property
+    void SetSnapshotHistorySize(i32 size);
+    /// Set whether to put the world after each simulation step into the same broadphase and contact state as when its history snapshot is restored, so that resimulating after a rollback matches the original steps bit for bit. This costs a broadphase rebuild and an extra collision detection pass per step. Requires the snapshot history and interpolation disabled, so that each step is taken separately. Default false.
+    /// @property
+    void SetDeterministicRollback(bool enable);
+    /// Save the state of the dynamic rigid bodies, their contacts and the constraints into a snapshot. Resimulation is only deterministic in the sequential world, as the constraint solver state of the multithreaded world is not saved.
+    void SaveSnapshot(PhysicsWorldSnapshot& snapshot) const;
+    /// Restore the state saved into a snapshot and apply it to the scene nodes. Bodies and constraints removed since are skipped, and bodies added since keep their state. The broadphase is rebuilt and the contacts are found again, so that resimulating from the same snapshot is bit-identical no matter what was simulated in between. Rewinds the simulation step count.
+    void RestoreSnapshot(const PhysicsWorldSnapshot& snapshot);
+    /// Restore the history snapshot saved after the given simulation step. Return true if it was still in the history.
+    bool Rollback(u32 step);
+    /// Simulate a number of fixed steps right away without interpolation, sending the step events. Used to resimulate to the present after a rollback.
+    void Resimulate(i32 numSteps);
     /// Perform a physics world raycast and return all hits.
     void Raycast
         (Vector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
@@ -192,6 +379,10 @@ public:
     /// Perform a physics world swept convex test using a user-supplied Bullet collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, btCollisionShape* shape, const Vector3& startPos, const Quaternion& startRot,
         const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform a batch of raycasts and swept sphere tests and return the closest hit of each into the result array, which is resized to the number of queries. The queries are executed in worker threads when Bullet is thread-safe. Must not be called during the simulation step.
+    void RaycastSingleBatch(Vector<PhysicsRaycastResult>& results, const Vector<PhysicsRaycastQuery>& queries);
+    /// Perform a batch of swept convex tests and return the first hit of each into the result array, which is resized to the number of queries. The queries are executed in worker threads when Bullet is thread-safe. Must not be called during the simulation step.
+    void ConvexCastBatch(Vector<PhysicsRaycastResult>& results, const Vector<PhysicsConvexCastQuery>& queries);
     /// Invalidate cached collision geometry for a model.
     void RemoveCachedGeometry(Model* model);
     /// Return rigid bodies by a sphere query.
@@ -200,7 +391,9 @@ public:
     void GetRigidBodies(Vector<RigidBody*>& result, const BoundingBox& box, unsigned collisionMask = M_MAX_UNSIGNED);
     /// Return rigid bodies by contact test with the specified body. It needs to be active to return all contacts reliably.
     void GetRigidBodies(Vector<RigidBody*>& result, const RigidBody* body);
-    /// Return rigid bodies that have been in collision with the specified body on the last simulation step. Only returns collisions that were sent as events (depends on collision event mode) and excludes e.g. static-static collisions.
+    /// Return contact stream records of the last simulation step where either body's collision layer matches the mask.
+    void GetContacts(Vector<PhysicsContact>& result, unsigned collisionMask) const;
+    /// Return rigid bodies that have been in collision with the specified body on the last simulation step. Only returns collisions that are sent as events (depends on collision event mode) and excludes e.g. static-static collisions.
     void GetCollidingBodies(Vector<RigidBody*>& result, const RigidBody* body);
 
     /// Return gravity.
@@ -238,6 +431,60 @@ public:
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
+    /// Return whether simulated transforms are applied to scene nodes in worker threads.
+    /// @property
+    bool GetParallelTransformSync() const { return parallelTransformSync_; }
+
+    /// Return whether collision events are sent.
+    /// @property
+    bool IsCollisionEventsEnabled() const { return collisionEventsEnabled_; }
+
+    /// Return whether the contact stream is recorded.
+    /// @property
+    bool IsContactStreamEnabled() const { return contactStreamEnabled_; }
+
+    /// Return collision layer mask of the contact stream.
+    /// @property
+    unsigned GetContactStreamMask() const { return contactStreamMask_; }
+
+    /// Return contact stream records of the last simulation step, sorted neither by body nor by state. The body pointers are valid until the bodies are removed, for example by collision event handlers.
+    const Vector<PhysicsContact>& GetContacts() const { return streamContacts_; }
+
+    /// Return contact points of the contact stream records.
+    const Vector<PhysicsContactPoint>& GetContactPoints() const { return streamContactPoints_; }
+
+    /// Return whether multithreaded simulation is requested.
+    /// @property
+    bool IsMultithreaded() const { return multithreaded_; }
+
+    /// Return number of threads the Bullet world was created for, or 0 if it is the sequential world.
+    i32 GetNumWorldThreads() const { return numWorldThreads_; }
+
+    /// Return whether triangle mesh BVHs and convex hulls are cooked in work queue threads.
+    /// @property
+    bool GetBackgroundCooking() const { return backgroundCooking_; }
+
+    /// Return directory of the cooked geometry cache.
+    /// @property
+    const String& GetCookedGeometryDir() const { return cookedGeometryDir_; }
+
+    /// Return whether geometry is being cooked in the background.
+    bool IsCookingGeometry() const { return !cookingGeometries_.Empty(); }
+
+    /// Return number of simulation steps to keep snapshots of.
+    /// @property
+    i32 GetSnapshotHistorySize() const { return snapshotHistory_.Size(); }
+
+    /// Return whether the world is put into the restored snapshot state after each simulation step.
+    /// @property
+    bool GetDeterministicRollback() const { return deterministicRollback_; }
+
+    /// Return number of simulation steps taken.
+    u32 GetSimulationStep() const { return simulationStep_; }
+
+    /// Return the history snapshot saved after the given simulation step, or null if it is no longer in the history.
+    const PhysicsWorldSnapshot* GetHistorySnapshot(u32 step) const;
+
     /// Add a rigid body to keep track of. Called by RigidBody.
     void AddRigidBody(RigidBody* body);
     /// Remove a rigid body. Called by RigidBody.
@@ -252,6 +499,8 @@ public:
     void RemoveConstraint(Constraint* constraint);
     /// Add a delayed world transform assignment. Called by RigidBody.
     void AddDelayedWorldTransform(const DelayedWorldTransform& transform);
+    /// Add a world transform to be applied after the simulation step. Called by RigidBody.
+    void AddBatchedWorldTransform(const BatchedWorldTransform& transform);
     /// Add debug geometry to the debug renderer.
     void DrawDebugGeometry(bool depthTest);
     /// Set debug renderer to use. Called both by PhysicsWorld itself and physics components.
@@ -264,6 +513,8 @@ public:
 
     /// Clean up the geometry cache.
     void CleanupGeometryCache();
+    /// Cook collision geometry data and save it into the cooked geometry cache, in the background if enabled. Called by CollisionShape.
+    void CookGeometry(CollisionGeometryData* geometry);
 
     /// Return trimesh collision geometry cache.
     CollisionGeometryDataCache& GetTriMeshCache() { return triMeshCache_; }
@@ -299,6 +550,28 @@ private:
     void PostStep(float timeStep);
     /// Send accumulated collision events.
     void SendCollisionEvents();
+    /// Record the contact stream of the simulation step from the collision manifolds.
+    void BuildContactStream();
+    /// Append an ending contact of a body pair to the contact stream.
+    void AddStreamContactEnd(const Pair<RigidBody*, RigidBody*>& bodies);
+    /// Append the contact points of a manifold to the contact stream.
+    void AddStreamContactPoints(btPersistentManifold* manifold, bool flipNormals);
+    /// Apply the batched world transforms of the last simulation step to the scene nodes.
+    void ApplyBatchedWorldTransforms();
+    /// Apply the batched and delayed world transforms to the scene nodes after simulating.
+    void ApplyWorldTransforms();
+    /// Recreate the broadphase proxies of all collision objects in the world order, so that the broadphase state only depends on the current transforms.
+    void RebuildBroadphase();
+    /// Rebuild the broadphase and restore the contact points, constraint impulses and solver seed of a snapshot.
+    void RestoreContacts(const PhysicsWorldSnapshot& snapshot);
+    /// Restore the contacts of the history snapshot of the current step after a simulation step, if deterministic rollback is enabled.
+    void CanonicalizeStep();
+    /// Handle a work queue item completing, finish cooking geometry here.
+    void HandleWorkItemCompleted(StringHash eventType, VariantMap& eventData);
+    /// Save the geometry cooked in the background and create the collision shapes waiting for it.
+    void FinishCooking(i32 index);
+    /// Create the Bullet world, or recreate it when the multithreaded mode or the number of work queue threads has changed. Moves existing collision objects, constraints and actions to the new world.
+    void CreateWorld();
 
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_{};
@@ -309,9 +582,12 @@ private:
     /// Bullet collision broadphase.
     std::unique_ptr<btBroadphaseInterface> broadphase_;
 
-    /// Bullet constraint solver.
+    /// Bullet constraint solver, or the solver pool of the multithreaded world.
     std::unique_ptr<btConstraintSolver> solver_;
 
+    /// Bullet multithreaded solver for large islands.
+    std::unique_ptr<btConstraintSolver> solverMt_;
+
     /// Bullet physics world.
     std::unique_ptr<btDiscreteDynamicsWorld> world_;
 
@@ -323,24 +599,63 @@ private:
     Vector<CollisionShape*> collisionShapes_;
     /// Constraints in the world.
     Vector<Constraint*> constraints_;
-    /// Collision pairs on this frame.
+    /// Collision pairs on this frame. Only stored when collision events are enabled.
     HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody>>, ManifoldPair> currentCollisions_;
     /// Collision pairs on the previous frame. Used to check if a collision is "new". Manifolds are not guaranteed to exist anymore.
     HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody>>, ManifoldPair> previousCollisions_;
     /// Delayed (parented) world transform assignments.
     HashMap<RigidBody*, DelayedWorldTransform> delayedWorldTransforms_;
+    /// World transforms of unparented rigid bodies from the last simulation step.
+    Vector<BatchedWorldTransform> batchedWorldTransforms_;
     /// Cache for trimesh geometry data by model and LOD level.
     CollisionGeometryDataCache triMeshCache_;
     /// Cache for convex geometry data by model and LOD level.
     CollisionGeometryDataCache convexCache_;
     /// Cache for GImpact trimesh geometry data by model and LOD level.
     CollisionGeometryDataCache gimpactTrimeshCache_;
+    /// Work items cooking geometry in the background and the geometry they cook.
+    Vector<Pair<SharedPtr<WorkItem>, SharedPtr<CollisionGeometryData>>> cookingGeometries_;
+    /// Cooked geometry cache directory.
+    String cookedGeometryDir_;
     /// Preallocated event data map for physics collision events.
     VariantMap physicsCollisionData_;
     /// Preallocated event data map for node collision events.
     VariantMap nodeCollisionData_;
     /// Preallocated buffer for physics collision contact data.
     VectorBuffer contacts_;
+    /// Manifold of a body pair collected for the contact stream.
+    struct StreamManifold
+    {
+        /// Body pair, sorted by address.
+        Pair<RigidBody*, RigidBody*> bodies_;
+        /// Manifold.
+        btPersistentManifold* manifold_;
+        /// Whether the manifold has the bodies in the opposite order.
+        bool flipped_;
+        /// Index of the manifold in the dispatcher, to keep the manifold order of a pair.
+        i32 index_;
+    };
+
+    /// Manifolds of the contact stream sorted by body pair.
+    Vector<StreamManifold> streamManifolds_;
+    /// Body pairs of the contact stream on this step, sorted. Pairs of removed bodies are erased.
+    Vector<Pair<RigidBody*, RigidBody*>> streamPairs_;
+    /// Body pairs of the contact stream on the previous step, sorted. Used to find the starting, staying and ending contacts.
+    Vector<Pair<RigidBody*, RigidBody*>> previousStreamPairs_;
+    /// Contact stream records of the last simulation step.
+    Vector<PhysicsContact> streamContacts_;
+    /// Contact stream points of the last simulation step.
+    Vector<PhysicsContactPoint> streamContactPoints_;
+    /// Collision layer mask of the contact stream.
+    unsigned contactStreamMask_{M_MAX_UNSIGNED};
+    /// Ring buffer of snapshots saved after the simulation steps.
+    Vector<PhysicsWorldSnapshot> snapshotHistory_;
+    /// Number of simulation steps taken.
+    u32 simulationStep_{};
+    /// Saved manifold indices sorted by body pair when restoring a snapshot.
+    Vector<i32> restoreManifoldOrder_;
+    /// Collision filter group and mask of the collision objects when rebuilding the broadphase.
+    Vector<IntVector2> broadphaseFilters_;
     /// Simulation substeps per second.
     i32 fps_{DEFAULT_FPS};
     /// Maximum number of simulation substeps per frame. 0 (default) unlimited, or negative values for adaptive timestep.
@@ -353,6 +668,20 @@ private:
     bool updateEnabled_{true};
     /// Interpolation flag.
     bool interpolation_{true};
+    /// Multithreaded simulation flag.
+    bool multithreaded_{};
+    /// Parallel transform sync flag.
+    bool parallelTransformSync_{};
+    /// Background geometry cooking flag.
+    bool backgroundCooking_{};
+    /// Deterministic rollback flag.
+    bool deterministicRollback_{};
+    /// Collision events flag.
+    bool collisionEventsEnabled_{true};
+    /// Contact stream flag.
+    bool contactStreamEnabled_{};
+    /// Number of threads of the current Bullet world, 0 for the sequential world.
+    i32 numWorldThreads_{};
     /// Use internal edge utility flag.
     bool internalEdge_{true};
     /// Applying transforms flag.
@@ -22,6 +22,26 @@ const IntVector3 RaycastVehicle::UP_RIGHT_FORWARD(1, 0, 2);
 const IntVector3 RaycastVehicle::FORWARD_RIGHT_UP(2, 0, 1);
 const IntVector3 RaycastVehicle::FORWARD_UP_RIGHT(2, 1, 0);
 
+/// Vehicle raycaster that casts into the current Bullet world of a physics world, which is recreated when switching the multithreaded mode.
+struct PhysicsWorldVehicleRaycaster : public btVehicleRaycaster
+{
+    explicit PhysicsWorldVehicleRaycaster(PhysicsWorld* physicsWorld) :
+        physicsWorld_(physicsWorld)
+    {
+    }
+
+    void* castRay(const btVector3& from, const btVector3& to, btVehicleRaycasterResult& result) override
+    {
+        if (!physicsWorld_ || !physicsWorld_->GetWorld())
+            return nullptr;
+
+        btDefaultVehicleRaycaster raycaster(physicsWorld_->GetWorld());
+        return raycaster.castRay(from, to, result);
+    }
+
+    WeakPtr<PhysicsWorld> physicsWorld_;
+};
+
 struct RaycastVehicleData
 {
     RaycastVehicleData()
@@ -71,7 +91,7 @@ struct RaycastVehicleData
             delete vehicle_;
         }
 
-        vehicleRayCaster_ = new btDefaultVehicleRaycaster(pbtDynWorld);
+        vehicleRayCaster_ = new PhysicsWorldVehicleRaycaster(pPhysWorld);
         btRigidBody* bthullBody = body->GetBody();
         vehicle_ = new btRaycastVehicle(tuning_, bthullBody, vehicleRayCaster_);
         if (enabled)
@@ -44,6 +44,32 @@ static const char* collisionEventModeNames[] =
 
 extern const char* PHYSICS_CATEGORY;
 
+/// Indices of the rigid body network attributes recorded by the setters in network change journal mode. Looked up by
+/// name on registration, NINDEX if not found.
+static i32 networkAttrMass = NINDEX;
+static i32 networkAttrFriction = NINDEX;
+static i32 networkAttrAnisotropicFriction = NINDEX;
+static i32 networkAttrRollingFriction = NINDEX;
+static i32 networkAttrRestitution = NINDEX;
+static i32 networkAttrLinearVelocity = NINDEX;
+static i32 networkAttrLinearFactor = NINDEX;
+static i32 networkAttrAngularFactor = NINDEX;
+static i32 networkAttrLinearDamping = NINDEX;
+static i32 networkAttrAngularDamping = NINDEX;
+static i32 networkAttrLinearRestThreshold = NINDEX;
+static i32 networkAttrAngularRestThreshold = NINDEX;
+static i32 networkAttrCollisionLayer = NINDEX;
+static i32 networkAttrCollisionMask = NINDEX;
+static i32 networkAttrContactThreshold = NINDEX;
+static i32 networkAttrCcdRadius = NINDEX;
+static i32 networkAttrCcdMotionThreshold = NINDEX;
+static i32 networkAttrAngularVelocity = NINDEX;
+static i32 networkAttrCollisionEventMode = NINDEX;
+static i32 networkAttrUseGravity = NINDEX;
+static i32 networkAttrKinematic = NINDEX;
+static i32 networkAttrTrigger = NINDEX;
+static i32 networkAttrGravityOverride = NINDEX;
+
 RigidBody::RigidBody(Context* context) :
     Component(context),
     gravityOverride_(Vector3::ZERO),
@@ -109,6 +135,31 @@ void RigidBody::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE_EX("Is Kinematic", kinematic_, MarkBodyDirty, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Is Trigger", trigger_, MarkBodyDirty, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Gravity Override", GetGravityOverride, SetGravityOverride, Vector3::ZERO, AM_DEFAULT);
+
+    const StringHash type = GetTypeStatic();
+    networkAttrMass = GetNetworkAttributeIndex(context, type, "Mass");
+    networkAttrFriction = GetNetworkAttributeIndex(context, type, "Friction");
+    networkAttrAnisotropicFriction = GetNetworkAttributeIndex(context, type, "Anisotropic Friction");
+    networkAttrRollingFriction = GetNetworkAttributeIndex(context, type, "Rolling Friction");
+    networkAttrRestitution = GetNetworkAttributeIndex(context, type, "Restitution");
+    networkAttrLinearVelocity = GetNetworkAttributeIndex(context, type, "Linear Velocity");
+    networkAttrLinearFactor = GetNetworkAttributeIndex(context, type, "Linear Factor");
+    networkAttrAngularFactor = GetNetworkAttributeIndex(context, type, "Angular Factor");
+    networkAttrLinearDamping = GetNetworkAttributeIndex(context, type, "Linear Damping");
+    networkAttrAngularDamping = GetNetworkAttributeIndex(context, type, "Angular Damping");
+    networkAttrLinearRestThreshold = GetNetworkAttributeIndex(context, type, "Linear Rest Threshold");
+    networkAttrAngularRestThreshold = GetNetworkAttributeIndex(context, type, "Angular Rest Threshold");
+    networkAttrCollisionLayer = GetNetworkAttributeIndex(context, type, "Collision Layer");
+    networkAttrCollisionMask = GetNetworkAttributeIndex(context, type, "Collision Mask");
+    networkAttrContactThreshold = GetNetworkAttributeIndex(context, type, "Contact Threshold");
+    networkAttrCcdRadius = GetNetworkAttributeIndex(context, type, "CCD Radius");
+    networkAttrCcdMotionThreshold = GetNetworkAttributeIndex(context, type, "CCD Motion Threshold");
+    networkAttrAngularVelocity = GetNetworkAttributeIndex(context, type, "Network Angular Velocity");
+    networkAttrCollisionEventMode = GetNetworkAttributeIndex(context, type, "Collision Event Mode");
+    networkAttrUseGravity = GetNetworkAttributeIndex(context, type, "Use Gravity");
+    networkAttrKinematic = GetNetworkAttributeIndex(context, type, "Is Kinematic");
+    networkAttrTrigger = GetNetworkAttributeIndex(context, type, "Is Trigger");
+    networkAttrGravityOverride = GetNetworkAttributeIndex(context, type, "Gravity Override");
 }
 
 void RigidBody::ApplyAttributes()
@@ -147,6 +198,11 @@ void RigidBody::setWorldTransform(const btTransform& worldTrans)
     if (!body_->isActive()) // Fix #2491
         return;
 
+    QueueWorldTransform(worldTrans);
+}
+
+void RigidBody::QueueWorldTransform(const btTransform& worldTrans)
+{
     Quaternion newWorldRotation = ToQuaternion(worldTrans.getRotation());
     Vector3 newWorldPosition = ToVector3(worldTrans.getOrigin()) - newWorldRotation * centerOfMass_;
     RigidBody* parentRigidBody = nullptr;
@@ -162,7 +218,16 @@ void RigidBody::setWorldTransform(const btTransform& worldTrans)
             parentRigidBody = parent->GetComponent<RigidBody>();
 
         if (!parentRigidBody)
-            ApplyWorldTransform(newWorldPosition, newWorldRotation);
+        {
+            // Apply after the step in one pass with the other bodies, so that the node updates are not interleaved with
+            // the motion state synchronization
+            BatchedWorldTransform batched;
+            batched.rigidBody_ = this;
+            batched.worldPosition_ = newWorldPosition;
+            batched.worldRotation_ = newWorldRotation;
+            batched.threadSafe_ = parent == GetScene() && !smoothedTransform_;
+            physicsWorld_->AddBatchedWorldTransform(batched);
+        }
         else
         {
             DelayedWorldTransform delayed;
@@ -171,9 +236,9 @@ void RigidBody::setWorldTransform(const btTransform& worldTrans)
             delayed.worldPosition_ = newWorldPosition;
             delayed.worldRotation_ = newWorldRotation;
             physicsWorld_->AddDelayedWorldTransform(delayed);
-        }
 
-        MarkNetworkUpdate();
+            MarkNetworkUpdate();
+        }
     }
 
     hasSimulated_ = true;
@@ -202,7 +267,7 @@ void RigidBody::SetMass(float mass)
     {
         mass_ = mass;
         AddBodyToWorld();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrMass);
     }
 }
 
@@ -285,7 +350,7 @@ void RigidBody::SetLinearVelocity(const Vector3& velocity)
         body_->setLinearVelocity(ToBtVector3(velocity));
         if (velocity != Vector3::ZERO)
             Activate();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrLinearVelocity);
     }
 }
 
@@ -294,7 +359,7 @@ void RigidBody::SetLinearFactor(const Vector3& factor)
     if (body_)
     {
         body_->setLinearFactor(ToBtVector3(factor));
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrLinearFactor);
     }
 }
 
@@ -303,7 +368,7 @@ void RigidBody::SetLinearRestThreshold(float threshold)
     if (body_)
     {
         body_->setSleepingThresholds(threshold, body_->getAngularSleepingThreshold());
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrLinearRestThreshold);
     }
 }
 
@@ -312,7 +377,7 @@ void RigidBody::SetLinearDamping(float damping)
     if (body_)
     {
         body_->setDamping(damping, body_->getAngularDamping());
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrLinearDamping);
     }
 }
 
@@ -323,7 +388,7 @@ void RigidBody::SetAngularVelocity(const Vector3& velocity)
         body_->setAngularVelocity(ToBtVector3(velocity));
         if (velocity != Vector3::ZERO)
             Activate();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrAngularVelocity);
     }
 }
 
@@ -332,7 +397,7 @@ void RigidBody::SetAngularFactor(const Vector3& factor)
     if (body_)
     {
         body_->setAngularFactor(ToBtVector3(factor));
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrAngularFactor);
     }
 }
 
@@ -341,7 +406,7 @@ void RigidBody::SetAngularRestThreshold(float threshold)
     if (body_)
     {
         body_->setSleepingThresholds(body_->getLinearSleepingThreshold(), threshold);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrAngularRestThreshold);
     }
 }
 
@@ -350,7 +415,7 @@ void RigidBody::SetAngularDamping(float damping)
     if (body_)
     {
         body_->setDamping(body_->getLinearDamping(), damping);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrAngularDamping);
     }
 }
 
@@ -359,7 +424,7 @@ void RigidBody::SetFriction(float friction)
     if (body_)
     {
         body_->setFriction(friction);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrFriction);
     }
 }
 
@@ -368,7 +433,7 @@ void RigidBody::SetAnisotropicFriction(const Vector3& friction)
     if (body_)
     {
         body_->setAnisotropicFriction(ToBtVector3(friction));
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrAnisotropicFriction);
     }
 }
 
@@ -377,7 +442,7 @@ void RigidBody::SetRollingFriction(float friction)
     if (body_)
     {
         body_->setRollingFriction(friction);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrRollingFriction);
     }
 }
 
@@ -386,7 +451,7 @@ void RigidBody::SetRestitution(float restitution)
     if (body_)
     {
         body_->setRestitution(restitution);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrRestitution);
     }
 }
 
@@ -395,7 +460,7 @@ void RigidBody::SetContactProcessingThreshold(float threshold)
     if (body_)
     {
         body_->setContactProcessingThreshold(threshold);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrContactThreshold);
     }
 }
 
@@ -405,7 +470,7 @@ void RigidBody::SetCcdRadius(float radius)
     if (body_)
     {
         body_->setCcdSweptSphereRadius(radius);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrCcdRadius);
     }
 }
 
@@ -415,7 +480,7 @@ void RigidBody::SetCcdMotionThreshold(float threshold)
     if (body_)
     {
         body_->setCcdMotionThreshold(threshold);
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrCcdMotionThreshold);
     }
 }
 
@@ -425,7 +490,7 @@ void RigidBody::SetUseGravity(bool enable)
     {
         useGravity_ = enable;
         UpdateGravity();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrUseGravity);
     }
 }
 
@@ -435,7 +500,7 @@ void RigidBody::SetGravityOverride(const Vector3& gravity)
     {
         gravityOverride_ = gravity;
         UpdateGravity();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrGravityOverride);
     }
 }
 
@@ -445,7 +510,7 @@ void RigidBody::SetKinematic(bool enable)
     {
         kinematic_ = enable;
         AddBodyToWorld();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrKinematic);
     }
 }
 
@@ -455,7 +520,7 @@ void RigidBody::SetTrigger(bool enable)
     {
         trigger_ = enable;
         AddBodyToWorld();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrTrigger);
     }
 }
 
@@ -465,7 +530,7 @@ void RigidBody::SetCollisionLayer(unsigned layer)
     {
         collisionLayer_ = layer;
         AddBodyToWorld();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrCollisionLayer);
     }
 }
 
@@ -475,7 +540,7 @@ void RigidBody::SetCollisionMask(unsigned mask)
     {
         collisionMask_ = mask;
         AddBodyToWorld();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrCollisionMask);
     }
 }
 
@@ -486,14 +551,15 @@ void RigidBody::SetCollisionLayerAndMask(unsigned layer, unsigned mask)
         collisionLayer_ = layer;
         collisionMask_ = mask;
         AddBodyToWorld();
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrCollisionLayer);
+        MarkNetworkUpdate(GetTypeStatic(), networkAttrCollisionMask);
     }
 }
 
 void RigidBody::SetCollisionEventMode(CollisionEventMode mode)
 {
     collisionEventMode_ = mode;
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(GetTypeStatic(), networkAttrCollisionEventMode);
 }
 
 void RigidBody::ApplyForce(const Vector3& force)
@@ -678,6 +744,37 @@ float RigidBody::GetCcdMotionThreshold() const
     return body_ ? body_->getCcdMotionThreshold() : 0.0f;
 }
 
+void RigidBody::UpdateCookingState()
+{
+    if (!body_ || !inWorld_)
+        return;
+
+    bool cooking = false;
+    if (mass_ > 0.0f && !kinematic_)
+    {
+        Vector<CollisionShape*> shapes;
+        node_->GetComponents<CollisionShape>(shapes);
+        for (Vector<CollisionShape*>::ConstIterator i = shapes.Begin(); i != shapes.End(); ++i)
+        {
+            if ((*i)->IsCookingGeometry())
+            {
+                cooking = true;
+                break;
+            }
+        }
+    }
+
+    // Disabled simulation is not lifted by activation from collisions or constraints, so the body neither falls nor is
+    // pushed without its shape
+    if (cooking)
+        body_->forceActivationState(DISABLE_SIMULATION);
+    else if (body_->getActivationState() == DISABLE_SIMULATION)
+    {
+        body_->forceActivationState(ISLAND_SLEEPING);
+        Activate();
+    }
+}
+
 bool RigidBody::IsActive() const
 {
     return body_ ? body_->isActive() : false;
@@ -698,7 +795,10 @@ void RigidBody::ApplyWorldTransform(const Vector3& newWorldPosition, const Quate
     if (!node_ || !physicsWorld_)
         return;
 
-    physicsWorld_->SetApplyingTransforms(true);
+    // Batched transforms are applied with the flag already set, possibly from several threads
+    const bool wasApplying = physicsWorld_->IsApplyingTransforms();
+    if (!wasApplying)
+        physicsWorld_->SetApplyingTransforms(true);
 
     // Apply transform to the SmoothedTransform component instead of node transform if available
     if (smoothedTransform_)
@@ -716,7 +816,8 @@ void RigidBody::ApplyWorldTransform(const Vector3& newWorldPosition, const Quate
         lastRotation_ = node_->GetWorldRotation();
     }
 
-    physicsWorld_->SetApplyingTransforms(false);
+    if (!wasApplying)
+        physicsWorld_->SetApplyingTransforms(false);
 }
 
 void RigidBody::UpdateMass()
@@ -1006,6 +1107,8 @@ void RigidBody::AddBodyToWorld()
         SetLinearVelocity(Vector3::ZERO);
         SetAngularVelocity(Vector3::ZERO);
     }
+
+    UpdateCookingState();
 }
 
 void RigidBody::RemoveBodyFromWorld()
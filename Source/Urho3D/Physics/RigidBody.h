@@ -266,12 +266,16 @@ public:
     /// Return colliding rigid bodies from the last simulation step. Only returns collisions that were sent as events (depends on collision event mode) and excludes e.g. static-static collisions.
     void GetCollidingBodies(Vector<RigidBody*>& result) const;
 
+    /// Queue a center of mass transform from the simulation to be applied to the scene node with the other bodies. Called internally.
+    void QueueWorldTransform(const btTransform& worldTrans);
     /// Apply new world transform after a simulation step. Called internally.
     void ApplyWorldTransform(const Vector3& newWorldPosition, const Quaternion& newWorldRotation);
     /// Update mass and inertia to the Bullet rigid body. Readd body to world if necessary: if was in world and the Bullet collision shape to use changed.
     void UpdateMass();
     /// Update gravity parameters to the Bullet rigid body.
     void UpdateGravity();
+    /// Keep a dynamic rigid body out of the simulation while the geometry of any of its collision shapes is being cooked, and resume it once cooked. Called internally.
+    void UpdateCookingState();
     /// Set network angular velocity attribute.
     void SetNetAngularVelocityAttr(const Vector<byte>& value);
     /// Return network angular velocity attribute.
@@ -5,6 +5,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Renderer.h"
@@ -16,6 +17,7 @@
 #include "../Physics2D/RigidBody2D.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
+#include "../Scene/WorldTransformBatch.h"
 
 #include "../DebugNew.h"
 
@@ -74,6 +76,8 @@ void PhysicsWorld2D::RegisterObject(Context* context)
         AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Position Iterations", GetPositionIterations, SetPositionIterations, DEFAULT_POSITION_ITERATIONS,
         AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Multithreaded", IsMultithreaded, SetMultithreaded, false, AM_FILE);
+    URHO3D_ATTRIBUTE("Parallel Transform Sync", parallelTransformSync_, false, AM_FILE);
 }
 
 void PhysicsWorld2D::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -261,6 +265,14 @@ void PhysicsWorld2D::DrawTransform(const b2Transform& xf)
     debugRenderer_->AddLine(Vector3(p1.x, p1.y, 0.0f), Vector3(p2.x, p2.y, 0.0f), Color::GREEN, debugDepthTest_);
 }
 
+void PhysicsWorld2D::ParallelFor(int32 itemCount, int32 minRange, b2TaskCallback* task, void* context)
+{
+    GetSubsystem<WorkQueue>()->ParallelFor(0, itemCount, minRange, [task, context](i32 begin, i32 end, i32 threadIndex)
+    {
+        task(begin, end, context);
+    });
+}
+
 void PhysicsWorld2D::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdatePhysics2D);
@@ -272,11 +284,15 @@ void PhysicsWorld2D::Update(float timeStep)
     eventData[P_TIMESTEP] = timeStep;
     SendEvent(E_PHYSICSPRESTEP, eventData);
 
+    // Without worker threads the contacts are computed faster in one pass
+    auto* queue = GetSubsystem<WorkQueue>();
+    world_->SetTaskExecutor(multithreaded_ && queue && queue->GetNumThreads() ? this : nullptr);
+
     physicsStepping_ = true;
     world_->Step(timeStep, velocityIterations_, positionIterations_);
     physicsStepping_ = false;
 
-    // Apply world transforms. Unparented transforms first
+    // Gather world transforms. Unparented transforms are batched and applied first
     for (i32 i = 0; i < rigidBodies_.Size();)
     {
         if (rigidBodies_[i])
@@ -291,6 +307,8 @@ void PhysicsWorld2D::Update(float timeStep)
         }
     }
 
+    ApplyBatchedWorldTransforms();
+
     // Apply delayed (parented) world transforms now, if any
     while (!delayedWorldTransforms_.Empty())
     {
@@ -412,6 +430,16 @@ void PhysicsWorld2D::SetPositionIterations(int positionIterations)
     positionIterations_ = positionIterations;
 }
 
+void PhysicsWorld2D::SetMultithreaded(bool enable)
+{
+    multithreaded_ = enable;
+}
+
+void PhysicsWorld2D::SetParallelTransformSync(bool enable)
+{
+    parallelTransformSync_ = enable;
+}
+
 void PhysicsWorld2D::AddRigidBody(RigidBody2D* rigidBody)
 {
     if (!rigidBody)
@@ -431,6 +459,11 @@ void PhysicsWorld2D::RemoveRigidBody(RigidBody2D* rigidBody)
 
     WeakPtr<RigidBody2D> rigidBodyPtr(rigidBody);
     rigidBodies_.Remove(rigidBodyPtr);
+    for (i32 i = batchedWorldTransforms_.Size() - 1; i >= 0; --i)
+    {
+        if (batchedWorldTransforms_[i].rigidBody_ == rigidBody)
+            batchedWorldTransforms_.Erase(i);
+    }
 }
 
 void PhysicsWorld2D::AddDelayedWorldTransform(const DelayedWorldTransform2D& transform)
@@ -438,6 +471,11 @@ void PhysicsWorld2D::AddDelayedWorldTransform(const DelayedWorldTransform2D& tra
     delayedWorldTransforms_[transform.rigidBody_] = transform;
 }
 
+void PhysicsWorld2D::AddBatchedWorldTransform(const BatchedWorldTransform2D& transform)
+{
+    batchedWorldTransforms_.Push(transform);
+}
+
 // Ray cast call back class.
 class RayCastCallback : public b2RayCastCallback
 {
@@ -805,6 +843,22 @@ void PhysicsWorld2D::SendEndContactEvents()
     endContactInfos_.Clear();
 }
 
+void PhysicsWorld2D::ApplyBatchedWorldTransforms()
+{
+    if (batchedWorldTransforms_.Empty())
+        return;
+
+    URHO3D_PROFILE(ApplyPhysics2DTransforms);
+
+    // The node dirtying caused by the new transforms must not be applied back to the bodies
+    applyingTransforms_ = true;
+    ApplyWorldTransformBatch(scene_, batchedWorldTransforms_, parallelTransformSync_, [](const BatchedWorldTransform2D& transform)
+    {
+        transform.rigidBody_->ApplyWorldTransform(transform.worldPosition_, transform.worldRotation_);
+    });
+    applyingTransforms_ = false;
+}
+
 PhysicsWorld2D::ContactInfo::ContactInfo() = default;
 
 PhysicsWorld2D::ContactInfo::ContactInfo(b2Contact* contact)
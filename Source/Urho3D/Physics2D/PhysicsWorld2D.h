@@ -49,8 +49,21 @@ struct DelayedWorldTransform2D
     Quaternion worldRotation_;
 };
 
+/// 2D rigid body world transform from the simulation, applied to the scene node after the step together with the other bodies.
+struct BatchedWorldTransform2D
+{
+    /// Rigid body.
+    RigidBody2D* rigidBody_;
+    /// New world position.
+    Vector3 worldPosition_;
+    /// New world rotation.
+    Quaternion worldRotation_;
+    /// Whether the transform may be applied from a worker thread. True when the node is a direct child of the scene.
+    bool threadSafe_;
+};
+
 /// 2D physics simulation world component. Should be added only to the root scene node.
-class URHO3D_API PhysicsWorld2D : public Component, public b2ContactListener, public b2Draw
+class URHO3D_API PhysicsWorld2D : public Component, public b2ContactListener, public b2Draw, public b2TaskExecutor
 {
     URHO3D_OBJECT(PhysicsWorld2D, Component);
 
@@ -90,6 +103,10 @@ public:
     /// Draw a point.
     void DrawPoint(const b2Vec2& p, float size, const b2Color& color) override;
 
+    // Implement b2TaskExecutor
+    /// Run a parallel loop of the world step on the work queue and wait for it to finish.
+    void ParallelFor(int32 itemCount, int32 minRange, b2TaskCallback* task, void* context) override;
+
     /// Step the simulation forward.
     void Update(float timeStep);
     /// Add debug geometry to the debug renderer.
@@ -136,12 +153,20 @@ public:
     /// Set position iterations.
     /// @property
     void SetPositionIterations(int positionIterations);
+    /// Set whether to compute the contacts on the work queue threads during the step. The contact events are still sent from the main thread, in the same order. Disabled by default.
+    /// @property
+    void SetMultithreaded(bool enable);
+    /// Set whether to apply the simulated transforms of top-level rigid bodies to their scene nodes in worker threads. The node dirty notifications are then handled like in the threaded drawable update, so custom components listening to those nodes must be thread-safe. Disabled by default.
+    /// @property
+    void SetParallelTransformSync(bool enable);
     /// Add rigid body.
     void AddRigidBody(RigidBody2D* rigidBody);
     /// Remove rigid body.
     void RemoveRigidBody(RigidBody2D* rigidBody);
     /// Add a delayed world transform assignment. Called by RigidBody2D.
     void AddDelayedWorldTransform(const DelayedWorldTransform2D& transform);
+    /// Add a world transform to be applied after the simulation step. Called by RigidBody2D.
+    void AddBatchedWorldTransform(const BatchedWorldTransform2D& transform);
 
     /// Perform a physics world raycast and return all hits.
     void Raycast(Vector<PhysicsRaycastResult2D>& results, const Vector2& startPoint, const Vector2& endPoint,
@@ -208,6 +233,14 @@ public:
     /// @property
     int GetPositionIterations() const { return positionIterations_; }
 
+    /// Return whether the contacts are computed on the work queue threads.
+    /// @property
+    bool IsMultithreaded() const { return multithreaded_; }
+
+    /// Return whether simulated transforms are applied to scene nodes in worker threads.
+    /// @property
+    bool GetParallelTransformSync() const { return parallelTransformSync_; }
+
     /// Return the Box2D physics world.
     b2World* GetWorld() { return world_.get(); }
 
@@ -227,6 +260,8 @@ protected:
     void SendBeginContactEvents();
     /// Send end contact events.
     void SendEndContactEvents();
+    /// Apply the batched world transforms of the last simulation step to the scene nodes.
+    void ApplyBatchedWorldTransforms();
 
     /// Box2D physics world.
     std::unique_ptr<b2World> world_;
@@ -251,10 +286,16 @@ protected:
     bool physicsStepping_{};
     /// Applying transforms.
     bool applyingTransforms_{};
+    /// Multithreaded contact computation flag.
+    bool multithreaded_{};
+    /// Parallel transform sync flag.
+    bool parallelTransformSync_{};
     /// Rigid bodies.
     Vector<WeakPtr<RigidBody2D>> rigidBodies_;
     /// Delayed (parented) world transform assignments.
     HashMap<RigidBody2D*, DelayedWorldTransform2D> delayedWorldTransforms_;
+    /// World transforms of unparented rigid bodies from the last simulation step.
+    Vector<BatchedWorldTransform2D> batchedWorldTransforms_;
 
     /// Contact info.
     struct ContactInfo
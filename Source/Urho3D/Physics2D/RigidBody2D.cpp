@@ -432,18 +432,30 @@ void RigidBody2D::ApplyWorldTransform()
         physicsWorld_->AddDelayedWorldTransform(delayed);
     }
     else
-        ApplyWorldTransform(newWorldPosition, newWorldRotation);
+    {
+        // Apply after all bodies have been gathered, so that the node updates can be done in one pass
+        BatchedWorldTransform2D batched;
+        batched.rigidBody_ = this;
+        batched.worldPosition_ = newWorldPosition;
+        batched.worldRotation_ = newWorldRotation;
+        batched.threadSafe_ = parent == GetScene();
+        physicsWorld_->AddBatchedWorldTransform(batched);
+    }
 }
 
 void RigidBody2D::ApplyWorldTransform(const Vector3& newWorldPosition, const Quaternion& newWorldRotation)
 {
     if (newWorldPosition != node_->GetWorldPosition() || newWorldRotation != node_->GetWorldRotation())
     {
-        // Do not feed changed position back to simulation now
-        physicsWorld_->SetApplyingTransforms(true);
+        // Do not feed changed position back to simulation now. Batched transforms are applied with the flag already
+        // set, possibly from several threads
+        const bool wasApplying = physicsWorld_->IsApplyingTransforms();
+        if (!wasApplying)
+            physicsWorld_->SetApplyingTransforms(true);
         node_->SetWorldPosition(newWorldPosition);
         node_->SetWorldRotation(newWorldRotation);
-        physicsWorld_->SetApplyingTransforms(false);
+        if (!wasApplying)
+            physicsWorld_->SetApplyingTransforms(false);
     }
 }
 
@@ -100,7 +100,7 @@ public:
     /// Release body.
     void ReleaseBody();
 
-    /// Apply world transform from the Box2D body. Called by PhysicsWorld2D.
+    /// Gather world transform from the Box2D body to be applied to the node after the step. Called by PhysicsWorld2D.
     void ApplyWorldTransform();
     /// Apply specified world position & rotation. Called by PhysicsWorld2D.
     void ApplyWorldTransform(const Vector3& newWorldPosition, const Quaternion& newWorldRotation);
@@ -8,6 +8,7 @@
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
 #include "../Resource/BackgroundLoader.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
@@ -17,94 +18,256 @@
 namespace Urho3D
 {
 
+/// Thread of the background loader. Either reads resource files into memory ahead of BeginLoad(), so that slow reads
+/// do not stall the loading, or calls BeginLoad() on resources whose files have been read.
+class BackgroundLoaderThread : public Thread, public RefCounted
+{
+public:
+    /// Construct with the work function to call repeatedly.
+    BackgroundLoaderThread(BackgroundLoader* owner, bool (BackgroundLoader::*work)(), const char* name) :
+        owner_(owner),
+        work_(work),
+        name_(name)
+    {
+    }
+
+    /// Process work until stopped.
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD(name_);
+
+        while (shouldRun_)
+        {
+            if (!(owner_->*work_)())
+                Time::Sleep(5);
+        }
+    }
+
+private:
+    /// Background loader.
+    BackgroundLoader* owner_;
+    /// Work function.
+    bool (BackgroundLoader::*work_)();
+    /// Thread name for profiling.
+    const char* name_;
+};
+
 BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
-    owner_(owner)
+    owner_(owner),
+    numIOThreads_(DEFAULT_BACKGROUND_IO_THREADS),
+    numLoadThreads_(DEFAULT_BACKGROUND_LOAD_THREADS),
+    prefetchBudget_(DEFAULT_BACKGROUND_PREFETCH_BUDGET),
+    prefetchedBytes_(0)
 {
 }
 
 BackgroundLoader::~BackgroundLoader()
 {
+    // Stop all threads before clearing the queue, as they may be accessing the items
+    for (const SharedPtr<BackgroundLoaderThread>& thread : ioThreads_)
+        thread->Stop();
+    for (const SharedPtr<BackgroundLoaderThread>& thread : loadThreads_)
+        thread->Stop();
+
     MutexLock lock(backgroundLoadMutex_);
 
     backgroundLoadQueue_.Clear();
 }
 
-void BackgroundLoader::ThreadFunction()
+bool BackgroundLoader::LoadNextResource()
 {
-    URHO3D_PROFILE_THREAD("BackgroundLoader Thread");
+    backgroundLoadMutex_.Acquire();
 
-    while (shouldRun_)
+    // Search for the highest priority queued resource whose file has been read. BeginLoad() of different resources is
+    // independent; the dependency graph only gates EndLoad() in the main thread, and dependencies are prioritized above
+    // their callers so that the callers are not left waiting
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.End();
+    for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Begin();
+         j != backgroundLoadQueue_.End(); ++j)
     {
-        backgroundLoadMutex_.Acquire();
+        const BackgroundLoadItem& candidate = j->second_;
+        if (candidate.resource_->GetAsyncLoadState() != ASYNC_QUEUED)
+            continue;
+        if (candidate.ioState_ != BACKGROUND_IO_READY && candidate.ioState_ != BACKGROUND_IO_FAILED)
+            continue;
+        if (i == backgroundLoadQueue_.End() || candidate.priority_ > i->second_.priority_)
+            i = j;
+    }
 
-        // Search for a queued resource that has not been loaded yet
-        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-        while (i != backgroundLoadQueue_.End())
-        {
-            if (i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
-                break;
-            else
-                ++i;
-        }
+    if (i == backgroundLoadQueue_.End())
+    {
+        // No resources to load found
+        backgroundLoadMutex_.Release();
+        return false;
+    }
 
-        if (i == backgroundLoadQueue_.End())
+    BackgroundLoadItem& item = i->second_;
+    Resource* resource = item.resource_;
+    // We can be sure that the item is not removed from the queue as long as it is in the
+    // "queued" or "loading" state. Setting the state while still holding the mutex ensures no other load
+    // thread picks the same item
+    resource->SetAsyncLoadState(ASYNC_LOADING);
+    item.waitTime_ = item.queueTimer_.GetUSec(false);
+    backgroundLoadMutex_.Release();
+
+    bool success = false;
+    HiresTimer loadTimer;
+    if (item.ioState_ == BACKGROUND_IO_READY)
+    {
+        MemoryBuffer source(item.data_);
+        source.SetName(item.fileName_);
+        success = resource->BeginLoad(source);
+    }
+    long long beginLoadTime = loadTimer.GetUSec(false);
+
+    // Process dependencies now
+    // Need to lock the queue again when manipulating other entries
+    Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
+    MutexLock lock(backgroundLoadMutex_);
+    item.beginLoadTime_ = beginLoadTime;
+    ReleaseData(item);
+    if (item.dependents_.Size())
+    {
+        for (HashSet<Pair<StringHash, StringHash>>::Iterator j = item.dependents_.Begin(); j != item.dependents_.End(); ++j)
         {
-            // No resources to load found
-            backgroundLoadMutex_.Release();
-            Time::Sleep(5);
+            HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator k = backgroundLoadQueue_.Find(*j);
+            if (k != backgroundLoadQueue_.End())
+                k->second_.dependencies_.Erase(key);
         }
-        else
-        {
-            BackgroundLoadItem& item = i->second_;
-            Resource* resource = item.resource_;
-            // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
-            backgroundLoadMutex_.Release();
-
-            bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
-            if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
-                success = resource->BeginLoad(*file);
-            }
 
-            // Process dependencies now
-            // Need to lock the queue again when manipulating other entries
-            Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
-            backgroundLoadMutex_.Acquire();
-            if (item.dependents_.Size())
-            {
-                for (HashSet<Pair<StringHash, StringHash>>::Iterator i = item.dependents_.Begin();
-                     i != item.dependents_.End(); ++i)
-                {
-                    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
-                    if (j != backgroundLoadQueue_.End())
-                        j->second_.dependencies_.Erase(key);
-                }
+        item.dependents_.Clear();
+    }
 
-                item.dependents_.Clear();
-            }
+    resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+    return true;
+}
 
-            resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
-            backgroundLoadMutex_.Release();
-        }
+bool BackgroundLoader::ReadNextFile()
+{
+    backgroundLoadMutex_.Acquire();
+
+    // Do not read further ahead when enough data is already waiting. Always allow one file so that files larger than
+    // the budget can be loaded
+    if (prefetchedBytes_ && prefetchedBytes_ >= prefetchBudget_)
+    {
+        backgroundLoadMutex_.Release();
+        return false;
+    }
+
+    BackgroundLoadItem* item = nullptr;
+    for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
+         i != backgroundLoadQueue_.End(); ++i)
+    {
+        BackgroundLoadItem& candidate = i->second_;
+        if (candidate.ioState_ != BACKGROUND_IO_PENDING || candidate.resource_->GetAsyncLoadState() != ASYNC_QUEUED)
+            continue;
+        if (!item || candidate.priority_ > item->priority_)
+            item = &candidate;
+    }
+
+    if (!item)
+    {
+        backgroundLoadMutex_.Release();
+        return false;
+    }
+
+    // The item stays in the queue while its resource is in the "queued" state, so it is safe to read without the mutex
+    item->ioState_ = BACKGROUND_IO_READING;
+    String name = item->resource_->GetName();
+    bool sendEventOnFailure = item->sendEventOnFailure_;
+    backgroundLoadMutex_.Release();
+
+    Vector<byte> data;
+    String fileName;
+    bool success = false;
+    HiresTimer readTimer;
+    SharedPtr<File> file = owner_->GetFile(name, sendEventOnFailure);
+    if (file)
+    {
+        fileName = file->GetName();
+        data.Resize((i32)file->GetSize());
+        success = file->Read(data.Buffer(), data.Size()) == data.Size();
+        if (!success)
+            URHO3D_LOGERROR("Could not read resource file " + fileName);
+    }
+
+    long long readTime = readTimer.GetUSec(false);
+
+    MutexLock lock(backgroundLoadMutex_);
+    item->readTime_ = readTime;
+    if (success)
+    {
+        item->data_.Swap(data);
+        item->fileName_ = fileName;
+        prefetchedBytes_ += item->data_.Size();
     }
+    item->ioState_ = success ? BACKGROUND_IO_READY : BACKGROUND_IO_FAILED;
+    return true;
 }
 
-bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+/// Return priority for a resource requested by a loading caller of the given priority.
+static i32 GetDependencyPriority(i32 callerPriority)
+{
+    // Saturate, as a caller the main thread waits for is already at the maximum
+    return callerPriority < M_MAX_INT ? callerPriority + 1 : M_MAX_INT;
+}
+
+void BackgroundLoader::RaisePriority(BackgroundLoadItem& item, i32 priority)
+{
+    if (item.priority_ >= priority)
+        return;
+
+    item.priority_ = priority;
+
+    // Dependencies are only recorded for newly queued resources, so the graph has no cycles
+    const i32 dependencyPriority = GetDependencyPriority(priority);
+    for (HashSet<Pair<StringHash, StringHash>>::Iterator i = item.dependencies_.Begin(); i != item.dependencies_.End(); ++i)
+    {
+        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
+        if (j != backgroundLoadQueue_.End())
+            RaisePriority(j->second_, dependencyPriority);
+    }
+}
+
+void BackgroundLoader::ReleaseData(BackgroundLoadItem& item)
+{
+    prefetchedBytes_ -= item.data_.Size();
+    // Swap with an empty vector to actually free the memory
+    Vector<byte>().Swap(item.data_);
+}
+
+bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, i32 priority)
 {
     StringHash nameHash(name);
     Pair<StringHash, StringHash> key = MakePair(type, nameHash);
 
     MutexLock lock(backgroundLoadMutex_);
 
-    // Check if already exists in the queue
-    if (backgroundLoadQueue_.Find(key) != backgroundLoadQueue_.End())
+    // Resources requested by a loading resource block its completion, so read and load them before the caller
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator callerIt = backgroundLoadQueue_.End();
+    if (caller)
+    {
+        callerIt = backgroundLoadQueue_.Find(MakePair(caller->GetType(), caller->GetNameHash()));
+        if (callerIt != backgroundLoadQueue_.End())
+            priority = Max(priority, GetDependencyPriority(callerIt->second_.priority_));
+    }
+
+    // Check if already exists in the queue. If so, only raise its priority and that of its dependencies if necessary
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator existing = backgroundLoadQueue_.Find(key);
+    if (existing != backgroundLoadQueue_.End())
+    {
+        RaisePriority(existing->second_, priority);
         return false;
+    }
 
     BackgroundLoadItem& item = backgroundLoadQueue_[key];
     item.sendEventOnFailure_ = sendEventOnFailure;
+    item.priority_ = priority;
+    item.ioState_ = BACKGROUND_IO_PENDING;
+    item.waitTime_ = 0;
+    item.readTime_ = 0;
+    item.beginLoadTime_ = 0;
+    item.queueTimer_.Reset();
 
     // Make sure the pointer is non-null and is a Resource subclass
     item.resource_ = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
@@ -133,12 +296,10 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
     // If this is a resource calling for the background load of more resources, mark the dependency as necessary
     if (caller)
     {
-        Pair<StringHash, StringHash> callerKey = MakePair(caller->GetType(), caller->GetNameHash());
-        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(callerKey);
-        if (j != backgroundLoadQueue_.End())
+        if (callerIt != backgroundLoadQueue_.End())
         {
-            BackgroundLoadItem& callerItem = j->second_;
-            item.dependents_.Insert(callerKey);
+            BackgroundLoadItem& callerItem = callerIt->second_;
+            item.dependents_.Insert(callerIt->first_);
             callerItem.dependencies_.Insert(key);
         }
         else
@@ -146,13 +307,56 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
                        " requested for a background loaded resource but was not in the background load queue");
     }
 
-    // Start the background loader thread now
-    if (!IsStarted())
-        Run();
+    // Start the background loader threads now
+    StartThreads();
 
     return true;
 }
 
+void BackgroundLoader::SetNumIOThreads(i32 numThreads)
+{
+    MutexLock lock(backgroundLoadMutex_);
+    numIOThreads_ = Max(numThreads, 1);
+}
+
+void BackgroundLoader::SetNumLoadThreads(i32 numThreads)
+{
+    MutexLock lock(backgroundLoadMutex_);
+    numLoadThreads_ = Max(numThreads, 1);
+}
+
+void BackgroundLoader::SetPrefetchBudget(unsigned long long bytes)
+{
+    MutexLock lock(backgroundLoadMutex_);
+    prefetchBudget_ = bytes;
+}
+
+unsigned long long BackgroundLoader::GetPrefetchedBytes() const
+{
+    MutexLock lock(backgroundLoadMutex_);
+    return prefetchedBytes_;
+}
+
+void BackgroundLoader::StartThreads()
+{
+    // Threads are only added, not removed, as the running ones may be in the middle of their work
+    while (ioThreads_.Size() < numIOThreads_)
+    {
+        SharedPtr<BackgroundLoaderThread> thread(new BackgroundLoaderThread(this, &BackgroundLoader::ReadNextFile,
+            "BackgroundLoader I/O Thread"));
+        thread->Run();
+        ioThreads_.Push(thread);
+    }
+
+    while (loadThreads_.Size() < numLoadThreads_)
+    {
+        SharedPtr<BackgroundLoaderThread> thread(new BackgroundLoaderThread(this, &BackgroundLoader::LoadNextResource,
+            "BackgroundLoader Thread"));
+        thread->Run();
+        loadThreads_.Push(thread);
+    }
+}
+
 void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 {
     backgroundLoadMutex_.Acquire();
@@ -162,6 +366,8 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
     if (i != backgroundLoadQueue_.End())
     {
+        // The main thread is blocked on this resource, so move it and its dependencies ahead of everything else
+        RaisePriority(i->second_, M_MAX_INT);
         backgroundLoadMutex_.Release();
 
         {
@@ -200,7 +406,7 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 
 void BackgroundLoader::FinishResources(int maxMs)
 {
-    if (IsStarted())
+    if (!loadThreads_.Empty())
     {
         HiresTimer timer;
 
@@ -239,9 +445,17 @@ unsigned BackgroundLoader::GetNumQueuedResources() const
     return backgroundLoadQueue_.Size();
 }
 
+i32 BackgroundLoader::GetResourcePriority(StringHash type, StringHash nameHash) const
+{
+    MutexLock lock(backgroundLoadMutex_);
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::ConstIterator i = backgroundLoadQueue_.Find(MakePair(type, nameHash));
+    return i != backgroundLoadQueue_.End() ? i->second_.priority_ : M_MIN_INT;
+}
+
 void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 {
     Resource* resource = item.resource_;
+    long long endLoadTime = 0;
 
     bool success = resource->GetAsyncLoadState() == ASYNC_SUCCESS;
     // If BeginLoad() phase was successful, call EndLoad() and get the final success/failure result
@@ -261,7 +475,9 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 #endif
 
         URHO3D_LOGDEBUG("Finishing background loaded resource " + resource->GetName());
+        HiresTimer endLoadTimer;
         success = resource->EndLoad();
+        endLoadTime = endLoadTimer.GetUSec(false);
 
 #ifdef URHO3D_PROFILING
         if (profiler)
@@ -270,6 +486,10 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
     }
     resource->SetAsyncLoadState(ASYNC_DONE);
 
+    URHO3D_LOGDEBUGF("Background loaded resource %s: wait %.3f ms, read %.3f ms, BeginLoad %.3f ms, EndLoad %.3f ms",
+        resource->GetName().CString(), item.waitTime_ / 1000.0f, item.readTime_ / 1000.0f, item.beginLoadTime_ / 1000.0f,
+        endLoadTime / 1000.0f);
+
     if (!success && item.sendEventOnFailure_)
     {
         using namespace LoadFailed;
@@ -291,6 +511,11 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
         eventData[P_RESOURCENAME] = resource->GetName();
         eventData[P_SUCCESS] = success;
         eventData[P_RESOURCE] = resource;
+        eventData[P_WAITTIME] = item.waitTime_ / 1000.0f;
+        eventData[P_READTIME] = item.readTime_ / 1000.0f;
+        eventData[P_BEGINLOADTIME] = item.beginLoadTime_ / 1000.0f;
+        eventData[P_ENDLOADTIME] = endLoadTime / 1000.0f;
+        eventData[P_TOTALTIME] = item.queueTimer_.GetUSec(false) / 1000.0f;
         owner_->SendEvent(E_RESOURCEBACKGROUNDLOADED, eventData);
     }
 }
@@ -8,15 +8,38 @@
 #include "../Core/Mutex.h"
 #include "../Container/Ptr.h"
 #include "../Container/RefCounted.h"
+#include "../Container/Str.h"
 #include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../Math/StringHash.h"
 
 namespace Urho3D
 {
 
+class BackgroundLoaderThread;
 class Resource;
 class ResourceCache;
 
+/// Default number of threads reading resource files ahead of loading.
+inline constexpr i32 DEFAULT_BACKGROUND_IO_THREADS = 2;
+/// Default number of threads calling BeginLoad() on background loaded resources.
+inline constexpr i32 DEFAULT_BACKGROUND_LOAD_THREADS = 1;
+/// Default maximum amount of read-ahead file data waiting to be loaded.
+inline constexpr unsigned long long DEFAULT_BACKGROUND_PREFETCH_BUDGET = 64 * 1024 * 1024;
+
+/// File read state of a background loaded resource.
+enum BackgroundIOState
+{
+    /// File not read yet.
+    BACKGROUND_IO_PENDING = 0,
+    /// File is being read by an I/O thread.
+    BACKGROUND_IO_READING,
+    /// File data is in memory and ready for BeginLoad().
+    BACKGROUND_IO_READY,
+    /// File could not be opened or read.
+    BACKGROUND_IO_FAILED
+};
+
 /// Queue item for background loading of a resource.
 struct BackgroundLoadItem
 {
@@ -26,14 +49,32 @@ struct BackgroundLoadItem
     HashSet<Pair<StringHash, StringHash>> dependencies_;
     /// Resources that depend on this resource's loading.
     HashSet<Pair<StringHash, StringHash>> dependents_;
+    /// Read-ahead file data.
+    Vector<byte> data_;
+    /// Name of the file the data was read from.
+    String fileName_;
+    /// Priority. Higher value = read and loaded first.
+    i32 priority_;
+    /// File read state.
+    BackgroundIOState ioState_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
+    /// Timer started when the item was queued.
+    HiresTimer queueTimer_;
+    /// Time spent waiting in the queue before BeginLoad() in microseconds.
+    long long waitTime_;
+    /// Time spent reading the file in microseconds.
+    long long readTime_;
+    /// Time spent in BeginLoad() in microseconds.
+    long long beginLoadTime_;
 };
 
 /// Background loader of resources. Owned by the ResourceCache.
 /// @nobind
-class BackgroundLoader : public RefCounted, public Thread
+class BackgroundLoader : public RefCounted
 {
+    friend class BackgroundLoaderThread;
+
 public:
     /// Construct.
     explicit BackgroundLoader(ResourceCache* owner);
@@ -41,20 +82,44 @@ public:
     /// Destruct. Forcibly clear the load queue.
     ~BackgroundLoader() override;
 
-    /// Resource background loading loop.
-    void ThreadFunction() override;
-
-    /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type).
-    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller);
+    /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Dependencies of a caller are raised above the caller's priority. Return true if queued (not a duplicate and resource was a known type).
+    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, i32 priority = 0);
     /// Wait and finish possible loading of a resource when being requested from the cache.
     void WaitForResource(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
 
+    /// Set number of threads reading files ahead of loading. Takes effect on the next background load request.
+    void SetNumIOThreads(i32 numThreads);
+    /// Set number of threads calling BeginLoad() concurrently. Takes effect on the next background load request.
+    void SetNumLoadThreads(i32 numThreads);
+    /// Set maximum amount of read-ahead file data waiting to be loaded.
+    void SetPrefetchBudget(unsigned long long bytes);
+
     /// Return amount of resources in the load queue.
     unsigned GetNumQueuedResources() const;
+    /// Return priority of a resource in the load queue, or M_MIN_INT if not queued.
+    i32 GetResourcePriority(StringHash type, StringHash nameHash) const;
+    /// Return number of threads reading files ahead of loading.
+    i32 GetNumIOThreads() const { return numIOThreads_; }
+    /// Return number of threads calling BeginLoad() concurrently.
+    i32 GetNumLoadThreads() const { return numLoadThreads_; }
+    /// Return maximum amount of read-ahead file data waiting to be loaded.
+    unsigned long long GetPrefetchBudget() const { return prefetchBudget_; }
+    /// Return amount of read-ahead file data currently waiting to be loaded.
+    unsigned long long GetPrefetchedBytes() const;
 
 private:
+    /// Start the loader and I/O threads if not running yet.
+    void StartThreads();
+    /// Read the highest priority pending file into memory. Called by the I/O threads. Return false if there was nothing to read.
+    bool ReadNextFile();
+    /// Call BeginLoad() on the highest priority resource whose file has been read. Called by the load threads. Return false if there was nothing to load.
+    bool LoadNextResource();
+    /// Raise priority of an item and the queued resources it depends on. The mutex must be held.
+    void RaisePriority(BackgroundLoadItem& item, i32 priority);
+    /// Release the read-ahead data of an item. The mutex must be held.
+    void ReleaseData(BackgroundLoadItem& item);
     /// Finish one background loaded resource.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
 
@@ -64,6 +129,18 @@ private:
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// File read-ahead threads.
+    Vector<SharedPtr<BackgroundLoaderThread>> ioThreads_;
+    /// BeginLoad() threads.
+    Vector<SharedPtr<BackgroundLoaderThread>> loadThreads_;
+    /// Number of file read-ahead threads to use.
+    i32 numIOThreads_;
+    /// Number of BeginLoad() threads to use.
+    i32 numLoadThreads_;
+    /// Maximum read-ahead data in bytes.
+    unsigned long long prefetchBudget_;
+    /// Current read-ahead data in bytes.
+    unsigned long long prefetchedBytes_;
 };
 
 }
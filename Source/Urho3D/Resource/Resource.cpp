@@ -7,6 +7,7 @@
 #include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../Resource/Resource.h"
+#include "../Resource/ResourceCache.h"
 #include "../Resource/XMLElement.h"
 
 namespace Urho3D
@@ -15,6 +16,8 @@ namespace Urho3D
 Resource::Resource(Context* context) :
     Object(context),
     memoryUse_(0),
+    lastUseFrame_(0),
+    pinned_(false),
     asyncLoadState_(ASYNC_DONE)
 {
 }
@@ -91,7 +94,13 @@ void Resource::SetName(const String& name)
 void Resource::SetMemoryUse(i32 size)
 {
     assert(size >= 0);
+    if (size == memoryUse_)
+        return;
+
+    const i32 oldSize = memoryUse_;
     memoryUse_ = size;
+    if (auto* cache = GetSubsystem<ResourceCache>())
+        cache->UpdateMemoryUse(this, oldSize);
 }
 
 void Resource::ResetUseTimer()
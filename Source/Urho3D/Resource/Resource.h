@@ -64,6 +64,11 @@ public:
     void SetMemoryUse(i32 size);
     /// Reset last used timer.
     void ResetUseTimer();
+    /// Set the resource cache frame number on which the resource was last used. Called by ResourceCache.
+    void SetLastUseFrame(unsigned frameNumber) { lastUseFrame_ = frameNumber; }
+    /// Set whether the resource is pinned. Pinned resources are never evicted to satisfy a memory budget.
+    /// @property
+    void SetPinned(bool enable) { pinned_ = enable; }
     /// Set the asynchronous loading state. Called by ResourceCache. Resources in the middle of asynchronous loading are not normally returned to user.
     void SetAsyncLoadState(AsyncLoadState newState);
 
@@ -82,6 +87,13 @@ public:
     /// @property
     unsigned GetUseTimer();
 
+    /// Return the resource cache frame number on which the resource was last used.
+    unsigned GetLastUseFrame() const { return lastUseFrame_; }
+
+    /// Return whether the resource is pinned.
+    /// @property
+    bool IsPinned() const { return pinned_; }
+
     /// Return the asynchronous loading state.
     AsyncLoadState GetAsyncLoadState() const { return asyncLoadState_; }
 
@@ -94,6 +106,10 @@ private:
     Timer useTimer_;
     /// Memory use in bytes.
     i32 memoryUse_;
+    /// Frame number of last use.
+    unsigned lastUseFrame_;
+    /// Pinned flag.
+    bool pinned_;
     /// Asynchronous loading state.
     AsyncLoadState asyncLoadState_;
 };
@@ -54,7 +54,13 @@ ResourceCache::ResourceCache(Context* context) :
     returnFailedResources_(false),
     searchPackagesFirst_(true),
     isRouting_(false),
-    finishBackgroundResourcesMs_(5)
+    finishBackgroundResourcesMs_(5),
+    totalMemoryBudget_(0),
+    totalMemoryUse_(0),
+    evictedMemory_(0),
+    numEvictedResources_(0),
+    frameNumber_(1),
+    totalOverBudget_(false)
 {
     // Register Resource library object factories
     RegisterResourceLibrary(context_);
@@ -66,6 +72,8 @@ ResourceCache::ResourceCache(Context* context) :
 
     // Subscribe BeginFrame for handling directory watchers and background loaded resource finalization
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(ResourceCache, HandleBeginFrame));
+    // Subscribe EndFrame for enforcing the memory budgets once the frame has released the resources it no longer uses
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(ResourceCache, HandleEndFrame));
 }
 
 ResourceCache::~ResourceCache()
@@ -161,7 +169,8 @@ bool ResourceCache::AddManualResource(Resource* resource)
     }
 
     resource->ResetUseTimer();
-    resourceGroups_[resource->GetType()].resources_[resource->GetNameHash()] = resource;
+    resource->SetLastUseFrame(frameNumber_);
+    StoreResource(resourceGroups_[resource->GetType()], resource);
     UpdateResourceGroup(resource->GetType());
     return true;
 }
@@ -239,7 +248,8 @@ void ResourceCache::ReleaseResource(StringHash type, const String& name, bool fo
     // If other references exist, do not release, unless forced
     if ((existingRes.Refs() == 1 && existingRes.WeakRefs() == 0) || force)
     {
-        resourceGroups_[type].resources_.Erase(nameHash);
+        ResourceGroup& group = resourceGroups_[type];
+        EraseResource(group, group.resources_.Find(nameHash));
         UpdateResourceGroup(type);
     }
 }
@@ -258,7 +268,7 @@ void ResourceCache::ReleaseResources(StringHash type, bool force)
             // If other references exist, do not release, unless forced
             if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
             {
-                i->second_.resources_.Erase(current);
+                EraseResource(i->second_, current);
                 released = true;
             }
         }
@@ -284,7 +294,7 @@ void ResourceCache::ReleaseResources(StringHash type, const String& partialName,
                 // If other references exist, do not release, unless forced
                 if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
                 {
-                    i->second_.resources_.Erase(current);
+                    EraseResource(i->second_, current);
                     released = true;
                 }
             }
@@ -315,7 +325,7 @@ void ResourceCache::ReleaseResources(const String& partialName, bool force)
                     // If other references exist, do not release, unless forced
                     if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
                     {
-                        i->second_.resources_.Erase(current);
+                        EraseResource(i->second_, current);
                         released = true;
                     }
                 }
@@ -344,7 +354,7 @@ void ResourceCache::ReleaseAllResources(bool force)
                 // If other references exist, do not release, unless forced
                 if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
                 {
-                    i->second_.resources_.Erase(current);
+                    EraseResource(i->second_, current);
                     released = true;
                 }
             }
@@ -370,6 +380,7 @@ bool ResourceCache::ReloadResource(Resource* resource)
     if (success)
     {
         resource->ResetUseTimer();
+        resource->SetLastUseFrame(frameNumber_);
         UpdateResourceGroup(resource->GetType());
         resource->SendEvent(E_RELOADFINISHED);
         return true;
@@ -422,6 +433,13 @@ void ResourceCache::ReloadResourceWithDependencies(const String& fileName)
 void ResourceCache::SetMemoryBudget(StringHash type, unsigned long long budget)
 {
     resourceGroups_[type].memoryBudget_ = budget;
+    UpdateResourceGroup(type);
+}
+
+void ResourceCache::SetTotalMemoryBudget(unsigned long long budget)
+{
+    totalMemoryBudget_ = budget;
+    UpdateTotalMemoryBudget();
 }
 
 void ResourceCache::SetAutoReloadResources(bool enable)
@@ -547,6 +565,8 @@ Resource* ResourceCache::GetExistingResource(StringHash type, const String& name
     StringHash nameHash(sanitatedName);
 
     const SharedPtr<Resource>& existing = FindResource(type, nameHash);
+    if (existing)
+        existing->SetLastUseFrame(frameNumber_);
     return existing;
 }
 
@@ -573,7 +593,10 @@ Resource* ResourceCache::GetResource(StringHash type, const String& name, bool s
 
     const SharedPtr<Resource>& existing = FindResource(type, nameHash);
     if (existing)
+    {
+        existing->SetLastUseFrame(frameNumber_);
         return existing;
+    }
 
     SharedPtr<Resource> resource;
     // Make sure the pointer is non-null and is a Resource subclass
@@ -620,13 +643,15 @@ Resource* ResourceCache::GetResource(StringHash type, const String& name, bool s
 
     // Store to cache
     resource->ResetUseTimer();
-    resourceGroups_[type].resources_[nameHash] = resource;
+    resource->SetLastUseFrame(frameNumber_);
+    StoreResource(resourceGroups_[type], resource);
     UpdateResourceGroup(type);
 
     return resource;
 }
 
-bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller,
+    i32 priority)
 {
 #ifdef URHO3D_THREADING
     // If empty name, fail immediately
@@ -639,7 +664,7 @@ bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name,
     if (FindResource(type, nameHash) != noResource)
         return false;
 
-    return backgroundLoader_->QueueResource(type, sanitatedName, sendEventOnFailure, caller);
+    return backgroundLoader_->QueueResource(type, sanitatedName, sendEventOnFailure, caller, priority);
 #else
     // When threading not supported, fall back to synchronous loading
     return GetResource(type, name, sendEventOnFailure);
@@ -699,6 +724,54 @@ SharedPtr<Resource> ResourceCache::GetTempResource(StringHash type, const String
     return resource;
 }
 
+void ResourceCache::SetNumBackgroundIOThreads(i32 numThreads)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumIOThreads(numThreads);
+#endif
+}
+
+void ResourceCache::SetNumBackgroundLoadThreads(i32 numThreads)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumLoadThreads(numThreads);
+#endif
+}
+
+void ResourceCache::SetBackgroundPrefetchBudget(unsigned long long bytes)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetPrefetchBudget(bytes);
+#endif
+}
+
+i32 ResourceCache::GetNumBackgroundIOThreads() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumIOThreads();
+#else
+    return 0;
+#endif
+}
+
+i32 ResourceCache::GetNumBackgroundLoadThreads() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumLoadThreads();
+#else
+    return 0;
+#endif
+}
+
+unsigned long long ResourceCache::GetBackgroundPrefetchBudget() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetPrefetchBudget();
+#else
+    return 0;
+#endif
+}
+
 unsigned ResourceCache::GetNumBackgroundLoadResources() const
 {
 #ifdef URHO3D_THREADING
@@ -708,6 +781,15 @@ unsigned ResourceCache::GetNumBackgroundLoadResources() const
 #endif
 }
 
+i32 ResourceCache::GetBackgroundLoadPriority(StringHash type, const String& name) const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetResourcePriority(type, StringHash(SanitateResourceName(name)));
+#else
+    return M_MIN_INT;
+#endif
+}
+
 void ResourceCache::GetResources(Vector<Resource*>& result, StringHash type) const
 {
     result.Clear();
@@ -771,10 +853,32 @@ unsigned long long ResourceCache::GetMemoryUse(StringHash type) const
 
 unsigned long long ResourceCache::GetTotalMemoryUse() const
 {
-    unsigned long long total = 0;
+    return totalMemoryUse_;
+}
+
+void ResourceCache::UpdateMemoryUse(Resource* resource, i32 oldMemoryUse)
+{
+    // Only resources stored in the cache are counted. Resources being loaded in the background are not stored yet
+    if (!resource || !Thread::IsMainThread() || FindResource(resource->GetType(), resource->GetNameHash()) != resource)
+        return;
+
+    ResourceGroup& group = resourceGroups_[resource->GetType()];
+    group.memoryUse_ = group.memoryUse_ - oldMemoryUse + resource->GetMemoryUse();
+    totalMemoryUse_ = totalMemoryUse_ - oldMemoryUse + resource->GetMemoryUse();
+}
+
+bool ResourceCache::IsOverMemoryBudget() const
+{
+    if (totalOverBudget_)
+        return true;
+
     for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
-        total += i->second_.memoryUse_;
-    return total;
+    {
+        if (i->second_.overBudget_)
+            return true;
+    }
+
+    return false;
 }
 
 String ResourceCache::GetResourceFileName(const String& name) const
@@ -1014,7 +1118,7 @@ void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
                 // If other references exist, do not release, unless forced
                 if ((k->second_.Refs() == 1 && k->second_.WeakRefs() == 0) || force)
                 {
-                    j->second_.resources_.Erase(k);
+                    EraseResource(j->second_, k);
                     affectedGroups.Insert(j->first_);
                 }
                 break;
@@ -1032,42 +1136,149 @@ void ResourceCache::UpdateResourceGroup(StringHash type)
     if (i == resourceGroups_.End())
         return;
 
-    for (;;)
+    ResourceGroup& group = i->second_;
+
+    // If memory budget defined and is exceeded, evict the least recently used resources
+    // (resources in use or pinned can not be evicted)
+    bool exceeded = false;
+    while (group.memoryBudget_ && group.memoryUse_ > group.memoryBudget_)
+    {
+        if (!EvictResource(&group))
+        {
+            exceeded = true;
+            break;
+        }
+    }
+
+    SetOverBudget(group.overBudget_, exceeded, type, group.memoryUse_, group.memoryBudget_);
+
+    UpdateTotalMemoryBudget();
+}
+
+void ResourceCache::UpdateTotalMemoryBudget()
+{
+    if (!totalMemoryBudget_)
+    {
+        totalOverBudget_ = false;
+        return;
+    }
+
+    bool exceeded = false;
+    while (totalMemoryUse_ > totalMemoryBudget_)
     {
-        unsigned totalSize = 0;
-        unsigned oldestTimer = 0;
-        HashMap<StringHash, SharedPtr<Resource>>::Iterator oldestResource = i->second_.resources_.End();
+        if (!EvictResource(nullptr))
+        {
+            exceeded = true;
+            break;
+        }
+    }
+
+    SetOverBudget(totalOverBudget_, exceeded, StringHash(), totalMemoryUse_, totalMemoryBudget_);
+}
+
+bool ResourceCache::EvictResource(ResourceGroup* group)
+{
+    ResourceGroup* oldestGroup = nullptr;
+    HashMap<StringHash, SharedPtr<Resource>>::Iterator oldestResource;
+    unsigned oldestFrame = M_MAX_UNSIGNED;
+    unsigned oldestTimer = 0;
+
+    for (HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    {
+        if (group && &i->second_ != group)
+            continue;
 
         for (HashMap<StringHash, SharedPtr<Resource>>::Iterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End(); ++j)
         {
-            totalSize += j->second_->GetMemoryUse();
-            unsigned useTimer = j->second_->GetUseTimer();
-            if (useTimer > oldestTimer)
+            Resource* resource = j->second_;
+            // Resources referred to elsewhere than in the cache count as used on the current frame
+            if (resource->Refs() > 1)
             {
-                oldestTimer = useTimer;
+                resource->SetLastUseFrame(frameNumber_);
+                continue;
+            }
+            if (resource->IsPinned())
+                continue;
+
+            // Prefer the oldest frame of use, then the longest time since last use
+            unsigned lastUseFrame = resource->GetLastUseFrame();
+            unsigned useTimer = resource->GetUseTimer();
+            if (lastUseFrame < oldestFrame || (lastUseFrame == oldestFrame && useTimer >= oldestTimer))
+            {
+                oldestGroup = &i->second_;
                 oldestResource = j;
+                oldestFrame = lastUseFrame;
+                oldestTimer = useTimer;
             }
         }
+    }
 
-        i->second_.memoryUse_ = totalSize;
+    if (!oldestGroup)
+        return false;
 
-        // If memory budget defined and is exceeded, remove the oldest resource and loop again
-        // (resources in use always return a zero timer and can not be removed)
-        if (i->second_.memoryBudget_ && i->second_.memoryUse_ > i->second_.memoryBudget_ &&
-            oldestResource != i->second_.resources_.End())
-        {
-            URHO3D_LOGDEBUG("Resource group " + oldestResource->second_->GetTypeName() + " over memory budget, releasing resource " +
-                     oldestResource->second_->GetName());
-            i->second_.resources_.Erase(oldestResource);
-        }
-        else
-            break;
+    SharedPtr<Resource> resource = oldestResource->second_;
+    i32 memoryUse = resource->GetMemoryUse();
+    URHO3D_LOGDEBUG("Resource " + resource->GetName() + " of type " + resource->GetTypeName() + " over memory budget, releasing");
+    EraseResource(*oldestGroup, oldestResource);
+    ++numEvictedResources_;
+    evictedMemory_ += memoryUse;
+
+    using namespace ResourceEvicted;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_RESOURCENAME] = resource->GetName();
+    eventData[P_RESOURCETYPE] = resource->GetType();
+    eventData[P_MEMORYUSE] = memoryUse;
+    SendEvent(E_RESOURCEEVICTED, eventData);
+
+    return true;
+}
+
+void ResourceCache::StoreResource(ResourceGroup& group, Resource* resource)
+{
+    SharedPtr<Resource>& stored = group.resources_[resource->GetNameHash()];
+    if (stored)
+    {
+        group.memoryUse_ -= stored->GetMemoryUse();
+        totalMemoryUse_ -= stored->GetMemoryUse();
+    }
+
+    stored = resource;
+    group.memoryUse_ += resource->GetMemoryUse();
+    totalMemoryUse_ += resource->GetMemoryUse();
+}
+
+void ResourceCache::EraseResource(ResourceGroup& group, HashMap<StringHash, SharedPtr<Resource>>::Iterator i)
+{
+    group.memoryUse_ -= i->second_->GetMemoryUse();
+    totalMemoryUse_ -= i->second_->GetMemoryUse();
+    group.resources_.Erase(i);
+}
+
+void ResourceCache::SetOverBudget(bool& overBudget, bool exceeded, StringHash type, unsigned long long memoryUse,
+    unsigned long long budget)
+{
+    if (exceeded && !overBudget)
+    {
+        URHO3D_LOGWARNING("Resource memory budget exceeded, all remaining resources are in use or pinned");
+
+        using namespace ResourceBudgetExceeded;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_RESOURCETYPE] = type;
+        eventData[P_MEMORYUSE] = memoryUse;
+        eventData[P_MEMORYBUDGET] = budget;
+        SendEvent(E_RESOURCEBUDGETEXCEEDED, eventData);
     }
+
+    overBudget = exceeded;
 }
 
 void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
+    ++frameNumber_;
+
     for (unsigned i = 0; i < fileWatchers_.Size(); ++i)
     {
         String fileName;
@@ -1094,6 +1305,23 @@ void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData
 #endif
 }
 
+void ResourceCache::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    URHO3D_PROFILE(EnforceMemoryBudgets);
+
+    // The memory use is tracked as resources are added, released and change their memory use, but eviction after a
+    // change of memory use is deferred to here, as the resource may be in the middle of loading. Resources held
+    // elsewhere may also have been released since, so retry the budgets that are still exceeded
+    for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    {
+        if (i->second_.memoryBudget_ && i->second_.memoryUse_ > i->second_.memoryBudget_)
+            UpdateResourceGroup(i->first_);
+    }
+
+    if (totalMemoryBudget_ && totalMemoryUse_ > totalMemoryBudget_)
+        UpdateTotalMemoryBudget();
+}
+
 File* ResourceCache::SearchResourceDirs(const String& name)
 {
     FileSystem* fileSystem = GetSubsystem<FileSystem>();
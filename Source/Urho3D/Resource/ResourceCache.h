@@ -26,7 +26,8 @@ struct ResourceGroup
     /// Construct with defaults.
     ResourceGroup() :
         memoryBudget_(0),
-        memoryUse_(0)
+        memoryUse_(0),
+        overBudget_(false)
     {
     }
 
@@ -34,6 +35,8 @@ struct ResourceGroup
     unsigned long long memoryBudget_;
     /// Current memory use.
     unsigned long long memoryUse_;
+    /// Memory budget exceeded with no resources left to evict.
+    bool overBudget_;
     /// Resources.
     HashMap<StringHash, SharedPtr<Resource>> resources_;
 };
@@ -99,9 +102,14 @@ public:
     bool ReloadResource(Resource* resource);
     /// Reload a resource based on filename. Causes also reload of dependent resources if necessary.
     void ReloadResourceWithDependencies(const String& fileName);
+    /// Update the tracked memory use after the memory use of a resource has changed. Budgets exceeded by the change are enforced at the end of the frame. Called by Resource::SetMemoryUse().
+    void UpdateMemoryUse(Resource* resource, i32 oldMemoryUse);
     /// Set memory budget for a specific resource type, default 0 is unlimited.
     /// @property
     void SetMemoryBudget(StringHash type, unsigned long long budget);
+    /// Set memory budget for all resource types combined, default 0 is unlimited. When exceeded, the least recently used resources of any type are evicted.
+    /// @property
+    void SetTotalMemoryBudget(unsigned long long budget);
     /// Enable or disable automatic reloading of resources as files are modified. Default false.
     /// @property
     void SetAutoReloadResources(bool enable);
@@ -117,6 +125,16 @@ public:
     /// @property
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
 
+    /// Set number of threads reading resource files into memory ahead of background loading. Default 2.
+    /// @property
+    void SetNumBackgroundIOThreads(i32 numThreads);
+    /// Set number of threads calling BeginLoad() concurrently on background loaded resources. Default 1.
+    /// @property
+    void SetNumBackgroundLoadThreads(i32 numThreads);
+    /// Set maximum amount of file data in bytes read ahead of background loading. Default 64 MB.
+    /// @property
+    void SetBackgroundPrefetchBudget(unsigned long long bytes);
+
     /// Add a resource router object. By default there is none, so the routing process is skipped.
     void AddResourceRouter(ResourceRouter* router, bool addAsFirst = false);
     /// Remove a resource router object.
@@ -128,11 +146,13 @@ public:
     Resource* GetResource(StringHash type, const String& name, bool sendEventOnFailure = true);
     /// Load a resource without storing it in the resource cache. Return null if not found or if fails. Can be called from outside the main thread if the resource itself is safe to load completely (it does not possess for example GPU data).
     SharedPtr<Resource> GetTempResource(StringHash type, const String& name, bool sendEventOnFailure = true);
-    /// Background load a resource. An event will be sent when complete. Return true if successfully stored to the load queue, false if eg. already exists. Can be called from outside the main thread.
-    bool BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr);
+    /// Background load a resource. An event will be sent when complete. Resources with higher priority are read and loaded first; resources requested by a loading caller are prioritized above it. Return true if successfully stored to the load queue, false if eg. already exists. Can be called from outside the main thread.
+    bool BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, i32 priority = 0);
     /// Return number of pending background-loaded resources.
     /// @property
     unsigned GetNumBackgroundLoadResources() const;
+    /// Return background load priority of a queued resource, or M_MIN_INT if it is not in the background load queue.
+    i32 GetBackgroundLoadPriority(StringHash type, const String& name) const;
     /// Return all loaded resources of a specific type.
     void GetResources(Vector<Resource*>& result, StringHash type) const;
     /// Return an already loaded resource of specific type & name, or null if not found. Will not load if does not exist.
@@ -158,7 +178,7 @@ public:
     /// Template version of releasing a resource by name.
     template <class T> void ReleaseResource(const String& name, bool force = false);
     /// Template version of queueing a resource background load.
-    template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr);
+    template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, i32 priority = 0);
     /// Template version of returning loaded resources of a specific type.
     template <class T> void GetResources(Vector<T*>& result) const;
     /// Return whether a file exists in the resource directories or package files. Does not check manually added in-memory resources.
@@ -172,6 +192,22 @@ public:
     /// Return total memory use for all resources.
     /// @property
     unsigned long long GetTotalMemoryUse() const;
+
+    /// Return memory budget for all resource types combined.
+    /// @property
+    unsigned long long GetTotalMemoryBudget() const { return totalMemoryBudget_; }
+
+    /// Return number of resources evicted to satisfy memory budgets.
+    /// @property
+    unsigned GetNumEvictedResources() const { return numEvictedResources_; }
+
+    /// Return total memory in bytes freed by evicting resources.
+    /// @property
+    unsigned long long GetEvictedMemory() const { return evictedMemory_; }
+
+    /// Return whether a memory budget is exceeded and can not be satisfied, because the remaining resources are in use or pinned.
+    /// @property
+    bool IsOverMemoryBudget() const;
     /// Return full absolute file name of resource if possible, or empty if not found.
     String GetResourceFileName(const String& name) const;
 
@@ -191,6 +227,16 @@ public:
     /// @property
     int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
 
+    /// Return number of threads reading resource files ahead of background loading.
+    /// @property
+    i32 GetNumBackgroundIOThreads() const;
+    /// Return number of threads calling BeginLoad() concurrently on background loaded resources.
+    /// @property
+    i32 GetNumBackgroundLoadThreads() const;
+    /// Return maximum amount of file data read ahead of background loading.
+    /// @property
+    unsigned long long GetBackgroundPrefetchBudget() const;
+
     /// Return a resource router by index.
     ResourceRouter* GetResourceRouter(unsigned index) const;
 
@@ -215,10 +261,22 @@ private:
     const SharedPtr<Resource>& FindResource(StringHash nameHash);
     /// Release resources loaded from a package file.
     void ReleasePackageResources(PackageFile* package, bool force = false);
-    /// Update a resource group. Recalculate memory use and release resources if over memory budget.
+    /// Update a resource group. Release resources if over memory budget.
     void UpdateResourceGroup(StringHash type);
+    /// Store a resource to a group, replacing a resource with the same name, and count its memory use.
+    void StoreResource(ResourceGroup& group, Resource* resource);
+    /// Erase a resource from a group and stop counting its memory use.
+    void EraseResource(ResourceGroup& group, HashMap<StringHash, SharedPtr<Resource>>::Iterator i);
+    /// Evict least recently used resources of any type until the total memory budget is satisfied.
+    void UpdateTotalMemoryBudget();
+    /// Evict the least recently used resource that is not in use or pinned, either from one group or from all groups. Return true if a resource was evicted.
+    bool EvictResource(ResourceGroup* group);
+    /// Update the budget exceeded state of a resource group or the total budget and send event when it becomes exceeded.
+    void SetOverBudget(bool& overBudget, bool exceeded, StringHash type, unsigned long long memoryUse, unsigned long long budget);
     /// Handle begin frame event. Automatic resource reloads and the finalization of background loaded resources are processed here.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle end frame event. Exceeded memory budgets are enforced here.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
     /// Search FileSystem for file.
     File* SearchResourceDirs(const String& name);
     /// Search resource packages for file.
@@ -250,6 +308,18 @@ private:
     mutable bool isRouting_;
     /// How many milliseconds maximum per frame to spend on finishing background loaded resources.
     int finishBackgroundResourcesMs_;
+    /// Memory budget for all resource types combined.
+    unsigned long long totalMemoryBudget_;
+    /// Memory use of all resource types combined.
+    unsigned long long totalMemoryUse_;
+    /// Memory freed by evicting resources.
+    unsigned long long evictedMemory_;
+    /// Number of evicted resources.
+    unsigned numEvictedResources_;
+    /// Frame number used for least recently used tracking.
+    unsigned frameNumber_;
+    /// Total memory budget exceeded with no resources left to evict.
+    bool totalOverBudget_;
 };
 
 template <class T> T* ResourceCache::GetExistingResource(const String& name)
@@ -276,10 +346,10 @@ template <class T> SharedPtr<T> ResourceCache::GetTempResource(const String& nam
     return StaticCast<T>(GetTempResource(type, name, sendEventOnFailure));
 }
 
-template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure, Resource* caller)
+template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure, Resource* caller, i32 priority)
 {
     StringHash type = T::GetTypeStatic();
-    return BackgroundLoadResource(type, name, sendEventOnFailure, caller);
+    return BackgroundLoadResource(type, name, sendEventOnFailure, caller, priority);
 }
 
 template <class T> void ResourceCache::GetResources(Vector<T*>& result) const
@@ -54,6 +54,27 @@ URHO3D_EVENT(E_RESOURCEBACKGROUNDLOADED, ResourceBackgroundLoaded)
     URHO3D_PARAM(P_RESOURCENAME, ResourceName);            // String
     URHO3D_PARAM(P_SUCCESS, Success);                      // bool
     URHO3D_PARAM(P_RESOURCE, Resource);                    // Resource pointer
+    URHO3D_PARAM(P_WAITTIME, WaitTime);                    // float, milliseconds queued before BeginLoad()
+    URHO3D_PARAM(P_READTIME, ReadTime);                    // float, milliseconds reading the file
+    URHO3D_PARAM(P_BEGINLOADTIME, BeginLoadTime);          // float, milliseconds in BeginLoad()
+    URHO3D_PARAM(P_ENDLOADTIME, EndLoadTime);              // float, milliseconds in EndLoad()
+    URHO3D_PARAM(P_TOTALTIME, TotalTime);                  // float, milliseconds from queuing to finish
+}
+
+/// Resource was evicted from the resource cache to satisfy a memory budget.
+URHO3D_EVENT(E_RESOURCEEVICTED, ResourceEvicted)
+{
+    URHO3D_PARAM(P_RESOURCENAME, ResourceName);            // String
+    URHO3D_PARAM(P_RESOURCETYPE, ResourceType);            // StringHash
+    URHO3D_PARAM(P_MEMORYUSE, MemoryUse);                  // int
+}
+
+/// Resource memory budget is exceeded and no more resources can be evicted, because they are in use or pinned. Sent once until memory use drops back under the budget.
+URHO3D_EVENT(E_RESOURCEBUDGETEXCEEDED, ResourceBudgetExceeded)
+{
+    URHO3D_PARAM(P_RESOURCETYPE, ResourceType);            // StringHash, zero for the total memory budget
+    URHO3D_PARAM(P_MEMORYUSE, MemoryUse);                  // unsigned long long
+    URHO3D_PARAM(P_MEMORYBUDGET, MemoryBudget);            // unsigned long long
 }
 
 /// Language changed.
@@ -4,6 +4,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../IO/Log.h"
 #include "../Resource/JSONValue.h"
 #include "../Scene/Component.h"
 #include "../Scene/ReplicationState.h"
@@ -75,6 +76,10 @@ bool Component::SaveJSON(JSONValue& dest) const
 
 void Component::MarkNetworkUpdate()
 {
+    // Changes without an attribute index require comparing all attributes, also in change journal mode
+    if (networkState_)
+        networkState_->compareAll_ = true;
+
     if (!networkUpdate_ && IsReplicated())
     {
         Scene* scene = GetScene();
@@ -86,10 +91,43 @@ void Component::MarkNetworkUpdate()
     }
 }
 
+void Component::MarkNetworkUpdate(StringHash type, i32 attributeIndex)
+{
+    Scene* scene = GetScene();
+    if (!networkState_ || !scene || !scene->GetNetworkChangeJournal() || GetType() != type || attributeIndex == NINDEX)
+    {
+        MarkNetworkUpdate();
+        return;
+    }
+
+    networkState_->changedAttributes_.Set(attributeIndex);
+    if (!networkUpdate_ && IsReplicated())
+    {
+        scene->MarkNetworkUpdate(this);
+        networkUpdate_ = true;
+    }
+}
+
 void Component::GetDependencyNodes(Vector<Node*>& dest)
 {
 }
 
+i32 Component::GetNetworkAttributeIndex(Context* context, StringHash type, const char* name)
+{
+    const Vector<AttributeInfo>* attributes = context->GetNetworkAttributes(type);
+    if (attributes)
+    {
+        for (i32 i = 0; i < attributes->Size(); ++i)
+        {
+            if ((*attributes)[i].name_ == name)
+                return i;
+        }
+    }
+
+    URHO3D_LOGERRORF("Network attribute %s not found, its changes are detected by comparison", name);
+    return NINDEX;
+}
+
 void Component::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
 {
 }
@@ -136,12 +174,40 @@ Scene* Component::GetScene() const
 
 void Component::AddReplicationState(ComponentReplicationState* state)
 {
+    // Replication states may be added by parallel per-connection server updates
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        MutexLock lock(scene->GetSceneMutex());
+        if (!networkState_)
+            AllocateNetworkState();
+
+        networkState_->replicationStates_.Push(state);
+        return;
+    }
+
     if (!networkState_)
         AllocateNetworkState();
 
     networkState_->replicationStates_.Push(state);
 }
 
+void Component::RemoveReplicationState(ComponentReplicationState* state)
+{
+    if (!networkState_)
+        return;
+
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        MutexLock lock(scene->GetSceneMutex());
+        networkState_->replicationStates_.Remove(state);
+        return;
+    }
+
+    networkState_->replicationStates_.Remove(state);
+}
+
 void Component::PrepareNetworkUpdate()
 {
     if (!networkState_)
@@ -153,9 +219,17 @@ void Component::PrepareNetworkUpdate()
 
     unsigned numAttributes = attributes->Size();
 
+    bool changed = false;
+    // In change journal mode compare only the attributes recorded by the setters, unless marked without an index
+    Scene* scene = GetScene();
+    bool compareAll = networkState_->compareAll_ || !scene || !scene->GetNetworkChangeJournal();
+
     // Check for attribute changes
     for (unsigned i = 0; i < numAttributes; ++i)
     {
+        if (!compareAll && !networkState_->changedAttributes_.IsSet(i))
+            continue;
+
         const AttributeInfo& attr = attributes->At(i);
 
         if (animationEnabled_ && IsAnimatedNetworkAttribute(attr))
@@ -166,6 +240,7 @@ void Component::PrepareNetworkUpdate()
         if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            changed = true;
 
             // Mark the attribute dirty in all replication states that are tracking this component
             for (Vector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin();
@@ -185,6 +260,13 @@ void Component::PrepareNetworkUpdate()
         }
     }
 
+    networkState_->changedAttributes_.ClearAll();
+    networkState_->compareAll_ = false;
+
+    // The serialized updates shared by the connections are no longer valid
+    if (changed)
+        networkState_->ClearSerializedUpdates();
+
     networkUpdate_ = false;
 }
 
@@ -52,6 +52,8 @@ public:
     bool SaveJSON(JSONValue& dest) const override;
     /// Mark for attribute check on the next network update.
     void MarkNetworkUpdate() override;
+    /// Mark a network attribute changed by its index in the network attributes of a component type. In network change journal mode only the marked attributes are checked on the next network update. Subclasses of the type may order their attributes differently, so for them all attributes are checked.
+    void MarkNetworkUpdate(StringHash type, i32 attributeIndex);
     /// Return the depended on nodes to order network updates.
     virtual void GetDependencyNodes(Vector<Node*>& dest);
     /// Visualize the component as debug geometry.
@@ -95,6 +97,8 @@ public:
 
     /// Add a replication state that is tracking this component.
     void AddReplicationState(ComponentReplicationState* state);
+    /// Remove a replication state that is no longer tracking this component.
+    void RemoveReplicationState(ComponentReplicationState* state);
     /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
     void PrepareNetworkUpdate();
     /// Clean up all references to a network connection that is about to be removed.
@@ -123,6 +127,8 @@ protected:
     void HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData);
     /// Return a component from the scene root that sends out fixed update events (either PhysicsWorld or PhysicsWorld2D). Return null if neither exists.
     Component* GetFixedUpdateSource();
+    /// Return index of a network attribute of a component type by name, or NINDEX if not found. Called by subclasses when registering, to find the attribute indices their setters mark changed.
+    static i32 GetNetworkAttributeIndex(Context* context, StringHash type, const char* name);
     /// Perform autoremove. Called by subclasses. Caller should keep a weak pointer to itself to check whether was actually removed, and return immediately without further member operations in that case.
     void DoAutoRemove(AutoRemoveMode mode);
 
@@ -24,6 +24,31 @@ using namespace std;
 namespace Urho3D
 {
 
+/// Indices of the node network attributes for recording changes in network change journal mode. Looked up by name on
+/// registration, NINDEX if not found.
+static i32 networkAttrEnabled = NINDEX;
+static i32 networkAttrName = NINDEX;
+static i32 networkAttrTags = NINDEX;
+static i32 networkAttrScale = NINDEX;
+static i32 networkAttrPosition = NINDEX;
+static i32 networkAttrRotation = NINDEX;
+
+/// Return index of a network attribute by name, or NINDEX if not found.
+static i32 GetNetworkAttributeIndex(const Vector<AttributeInfo>* attributes, const char* name)
+{
+    if (attributes)
+    {
+        for (i32 i = 0; i < attributes->Size(); ++i)
+        {
+            if ((*attributes)[i].name_ == name)
+                return i;
+        }
+    }
+
+    URHO3D_LOGERRORF("Node network attribute %s not found, its changes are detected by comparison", name);
+    return NINDEX;
+}
+
 Node::Node(Context* context) :
     Animatable(context),
     worldTransform_(Matrix3x4::IDENTITY),
@@ -70,6 +95,14 @@ void Node::RegisterObject(Context* context)
         AM_NET | AM_LATESTDATA | AM_NOEDIT);
     URHO3D_ACCESSOR_ATTRIBUTE("Network Parent Node", GetNetParentAttr, SetNetParentAttr, Variant::emptyBuffer,
         AM_NET | AM_NOEDIT);
+
+    const Vector<AttributeInfo>* networkAttributes = context->GetNetworkAttributes(GetTypeStatic());
+    networkAttrEnabled = GetNetworkAttributeIndex(networkAttributes, "Is Enabled");
+    networkAttrName = GetNetworkAttributeIndex(networkAttributes, "Name");
+    networkAttrTags = GetNetworkAttributeIndex(networkAttributes, "Tags");
+    networkAttrScale = GetNetworkAttributeIndex(networkAttributes, "Scale");
+    networkAttrPosition = GetNetworkAttributeIndex(networkAttributes, "Network Position");
+    networkAttrRotation = GetNetworkAttributeIndex(networkAttributes, "Network Rotation");
 }
 
 bool Node::Load(Deserializer& source)
@@ -256,6 +289,10 @@ void Node::ApplyAttributes()
 
 void Node::MarkNetworkUpdate()
 {
+    // Changes without an attribute index require comparing all attributes, also in change journal mode
+    if (networkState_)
+        networkState_->compareAll_ = true;
+
     if (!networkUpdate_ && scene_ && IsReplicated())
     {
         scene_->MarkNetworkUpdate(this);
@@ -263,14 +300,60 @@ void Node::MarkNetworkUpdate()
     }
 }
 
+void Node::MarkNetworkUpdate(i32 attributeIndex)
+{
+    // The scene has attributes of its own, so the node attribute indices do not apply to it. Before the first network
+    // update there is no state to record the change to, and all attributes are compared anyway
+    if (!networkState_ || !scene_ || scene_ == this || !scene_->GetNetworkChangeJournal() || attributeIndex == NINDEX)
+    {
+        MarkNetworkUpdate();
+        return;
+    }
+
+    networkState_->changedAttributes_.Set(attributeIndex);
+    if (!networkUpdate_ && IsReplicated())
+    {
+        scene_->MarkNetworkUpdate(this);
+        networkUpdate_ = true;
+    }
+}
+
 void Node::AddReplicationState(NodeReplicationState* state)
 {
+    // Replication states may be added by parallel per-connection server updates
+    Scene* scene = scene_;
+    if (scene && scene->IsThreadedUpdate())
+    {
+        MutexLock lock(scene->GetSceneMutex());
+        if (!networkState_)
+            AllocateNetworkState();
+
+        networkState_->replicationStates_.Push(state);
+        return;
+    }
+
     if (!networkState_)
         AllocateNetworkState();
 
     networkState_->replicationStates_.Push(state);
 }
 
+void Node::RemoveReplicationState(NodeReplicationState* state)
+{
+    if (!networkState_)
+        return;
+
+    Scene* scene = scene_;
+    if (scene && scene->IsThreadedUpdate())
+    {
+        MutexLock lock(scene->GetSceneMutex());
+        networkState_->replicationStates_.Remove(state);
+        return;
+    }
+
+    networkState_->replicationStates_.Remove(state);
+}
+
 bool Node::SaveXML(Serializer& dest, const String& indentation) const
 {
     SharedPtr<XMLFile> xml(new XMLFile(context_));
@@ -299,7 +382,7 @@ void Node::SetName(const String& name)
         impl_->name_ = name;
         impl_->nameHash_ = name;
 
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(networkAttrName);
 
         // Send change event
         if (scene_)
@@ -345,7 +428,7 @@ void Node::AddTag(const String& tag)
         scene_->SendEvent(E_NODETAGADDED, eventData);
     }
     // Sync
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrTags);
 }
 
 void Node::AddTags(const String& tags, char separator)
@@ -383,7 +466,7 @@ bool Node::RemoveTag(const String& tag)
     }
 
     // Sync
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrTags);
     return true;
 }
 
@@ -409,7 +492,7 @@ void Node::RemoveAllTags()
     impl_->tags_.Clear();
 
     // Sync
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrTags);
 }
 
 void Node::SetPosition(const Vector3& position)
@@ -417,7 +500,7 @@ void Node::SetPosition(const Vector3& position)
     position_ = position;
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrPosition);
 }
 
 void Node::SetRotation(const Quaternion& rotation)
@@ -425,7 +508,7 @@ void Node::SetRotation(const Quaternion& rotation)
     rotation_ = rotation;
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrRotation);
 }
 
 void Node::SetDirection(const Vector3& direction)
@@ -451,7 +534,7 @@ void Node::SetScale(const Vector3& scale)
         scale_.z_ = M_EPSILON;
 
     MarkDirty();
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrScale);
 }
 
 void Node::SetTransform(const Vector3& position, const Quaternion& rotation)
@@ -460,7 +543,8 @@ void Node::SetTransform(const Vector3& position, const Quaternion& rotation)
     rotation_ = rotation;
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrPosition);
+    MarkNetworkUpdate(networkAttrRotation);
 }
 
 void Node::SetTransform(const Vector3& position, const Quaternion& rotation, float scale)
@@ -475,7 +559,9 @@ void Node::SetTransform(const Vector3& position, const Quaternion& rotation, con
     scale_ = scale;
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrPosition);
+    MarkNetworkUpdate(networkAttrRotation);
+    MarkNetworkUpdate(networkAttrScale);
 }
 
 void Node::SetTransform(const Matrix3x4& matrix)
@@ -554,7 +640,7 @@ void Node::Translate(const Vector3& delta, TransformSpace space)
 
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrPosition);
 }
 
 void Node::Rotate(const Quaternion& delta, TransformSpace space)
@@ -582,7 +668,7 @@ void Node::Rotate(const Quaternion& delta, TransformSpace space)
 
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrRotation);
 }
 
 void Node::RotateAround(const Vector3& point, const Quaternion& delta, TransformSpace space)
@@ -622,7 +708,8 @@ void Node::RotateAround(const Vector3& point, const Quaternion& delta, Transform
 
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrPosition);
+    MarkNetworkUpdate(networkAttrRotation);
 }
 
 void Node::Yaw(float angle, TransformSpace space)
@@ -682,7 +769,7 @@ void Node::Scale(const Vector3& scale)
     scale_ *= scale;
     MarkDirty();
 
-    MarkNetworkUpdate();
+    MarkNetworkUpdate(networkAttrScale);
 }
 
 void Node::SetEnabled(bool enable)
@@ -1697,9 +1784,17 @@ void Node::PrepareNetworkUpdate()
     const Vector<AttributeInfo>* attributes = networkState_->attributes_;
     i32 numAttributes = attributes->Size();
 
+    bool changed = false;
+    // In change journal mode compare only the attributes recorded by the setters, unless marked without an index.
+    // The scene does not record its attributes
+    bool compareAll = networkState_->compareAll_ || !scene_ || scene_ == this || !scene_->GetNetworkChangeJournal();
+
     // Check for attribute changes
     for (i32 i = 0; i < numAttributes; ++i)
     {
+        if (!compareAll && !networkState_->changedAttributes_.IsSet(i))
+            continue;
+
         const AttributeInfo& attr = attributes->At(i);
 
         if (animationEnabled_ && IsAnimatedNetworkAttribute(attr))
@@ -1710,6 +1805,7 @@ void Node::PrepareNetworkUpdate()
         if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            changed = true;
 
             // Mark the attribute dirty in all replication states that are tracking this node
             for (Vector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin();
@@ -1728,6 +1824,13 @@ void Node::PrepareNetworkUpdate()
         }
     }
 
+    networkState_->changedAttributes_.ClearAll();
+    networkState_->compareAll_ = false;
+
+    // The serialized updates shared by the connections are no longer valid
+    if (changed)
+        networkState_->ClearSerializedUpdates();
+
     // Finally check for user var changes
     for (VariantMap::ConstIterator i = vars_.Begin(); i != vars_.End(); ++i)
     {
@@ -1991,7 +2094,7 @@ void Node::SetEnabled(bool enable, bool recursive, bool storeSelf)
     if (enable != enabled_)
     {
         enabled_ = enable;
-        MarkNetworkUpdate();
+        MarkNetworkUpdate(networkAttrEnabled);
 
         // Notify listener components of the state change
         for (Vector<WeakPtr<Component>>::Iterator i = listeners_.Begin(); i != listeners_.End();)
@@ -93,8 +93,12 @@ public:
 
     /// Mark for attribute check on the next network update.
     void MarkNetworkUpdate() override;
+    /// Mark a network attribute changed by its index in the network attributes. In network change journal mode only the marked attributes are checked on the next network update.
+    void MarkNetworkUpdate(i32 attributeIndex);
     /// Add a replication state that is tracking this node.
     virtual void AddReplicationState(NodeReplicationState* state);
+    /// Remove a replication state that is no longer tracking this node.
+    void RemoveReplicationState(NodeReplicationState* state);
 
     /// Save to an XML file. Return true if successful.
     bool SaveXML(Serializer& dest, const String& indentation = "\t") const;
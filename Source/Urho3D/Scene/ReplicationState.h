@@ -4,9 +4,11 @@
 #pragma once
 
 #include "../Core/Attribute.h"
+#include "../Core/Mutex.h"
 #include "../Container/HashMap.h"
 #include "../Container/HashSet.h"
 #include "../Container/Ptr.h"
+#include "../IO/VectorBuffer.h"
 #include "../Math/StringHash.h"
 
 #include <cstring>
@@ -92,6 +94,12 @@ struct URHO3D_API DirtyBits
     /// Return number of set bits.
     unsigned Count() const { return count_; }
 
+    /// Test for equality with another set of bits.
+    bool operator ==(const DirtyBits& rhs) const
+    {
+        return count_ == rhs.count_ && !memcmp(data_, rhs.data_, MAX_NETWORK_ATTRIBUTES / 8);
+    }
+
     /// Bit data.
     unsigned char data_[MAX_NETWORK_ATTRIBUTES / 8]{};
     /// Number of set bits.
@@ -113,6 +121,26 @@ struct URHO3D_API NetworkState
     VariantMap previousVars_;
     /// Bitmask for intercepting network messages. Used on the client only.
     unsigned long long interceptMask_{};
+    /// Attributes recorded as changed by setters since the last network update. Used in change journal mode.
+    DirtyBits changedAttributes_;
+    /// Whether the object was marked for network update without an attribute index, requiring all attributes to be compared.
+    bool compareAll_{true};
+    /// Serialized delta updates by dirty attribute bits, shared by all connections that send the same update.
+    Vector<Pair<DirtyBits, VectorBuffer>> deltaUpdates_;
+    /// Serialized latest data update shared by all connections. Empty until first written.
+    VectorBuffer latestDataUpdate_;
+    /// Serialized initial delta update shared by all connections. Empty until first written.
+    VectorBuffer initialDeltaUpdate_;
+    /// Mutex for the serialized updates, as connections may build their server updates in parallel.
+    Mutex updateMutex_;
+
+    /// Clear the serialized updates. Called when the current attribute values change.
+    void ClearSerializedUpdates()
+    {
+        deltaUpdates_.Clear();
+        latestDataUpdate_.Clear();
+        initialDeltaUpdate_.Clear();
+    }
 };
 
 /// Base class for per-user network replication states.
@@ -159,11 +187,17 @@ struct URHO3D_API SceneReplicationState : public ReplicationState
     HashMap<unsigned, NodeReplicationState> nodeStates_;
     /// Dirty node IDs.
     HashSet<unsigned> dirtyNodes_;
+    /// Relevant root level node IDs when interest management is in use.
+    HashSet<unsigned> relevantNodes_;
+    /// Whether interest management was in use on the previous update.
+    bool interestManaged_{};
 
     void Clear()
     {
         nodeStates_.Clear();
         dirtyNodes_.Clear();
+        relevantNodes_.Clear();
+        interestManaged_ = false;
     }
 };
 
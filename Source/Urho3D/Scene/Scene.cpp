@@ -35,6 +35,11 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const float DEFAULT_MAX_EXTRAPOLATION = 0.1f;
+/// Fraction of the server clock estimate error corrected on each received network update.
+static const float NETWORK_TIME_CORRECTION = 0.1f;
+/// Server clock estimate error in seconds above which the estimate is reset.
+static const float NETWORK_TIME_RESYNC = 1.0f;
 
 Scene::Scene(Context* context) :
     Node(context),
@@ -48,9 +53,17 @@ Scene::Scene(Context* context) :
     elapsedTime_(0),
     smoothingConstant_(DEFAULT_SMOOTHING_CONSTANT),
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
+    interpolationDelay_(0.0f),
+    maxExtrapolation_(DEFAULT_MAX_EXTRAPOLATION),
+    networkUpdateTime_(0.0),
+    latestNetworkTime_(0.0),
+    networkClock_(0.0),
+    networkTimeOffset_(0.0),
+    networkTimeValid_(false),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    networkChangeJournal_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
@@ -83,6 +96,10 @@ void Scene::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Smoothing Constant", GetSmoothingConstant, SetSmoothingConstant, DEFAULT_SMOOTHING_CONSTANT,
         AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Snap Threshold", GetSnapThreshold, SetSnapThreshold, DEFAULT_SNAP_THRESHOLD, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Interpolation Delay", GetInterpolationDelay, SetInterpolationDelay, 0.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Extrapolation", GetMaxExtrapolation, SetMaxExtrapolation, DEFAULT_MAX_EXTRAPOLATION,
+        AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Network Change Journal", GetNetworkChangeJournal, SetNetworkChangeJournal, false, AM_FILE);
     URHO3D_ACCESSOR_ATTRIBUTE("Elapsed Time", GetElapsedTime, SetElapsedTime, 0.0f, AM_FILE);
     URHO3D_ATTRIBUTE("Next Replicated Node ID", replicatedNodeID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Next Replicated Component ID", replicatedComponentID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
@@ -645,6 +662,43 @@ void Scene::SetSnapThreshold(float threshold)
     Node::MarkNetworkUpdate();
 }
 
+void Scene::SetInterpolationDelay(float delay)
+{
+    interpolationDelay_ = Max(delay, 0.0f);
+    Node::MarkNetworkUpdate();
+}
+
+void Scene::SetMaxExtrapolation(float time)
+{
+    maxExtrapolation_ = Max(time, 0.0f);
+    Node::MarkNetworkUpdate();
+}
+
+void Scene::SetNetworkChangeJournal(bool enable)
+{
+    networkChangeJournal_ = enable;
+}
+
+void Scene::SetNetworkUpdateTime(double time)
+{
+    networkUpdateTime_ = time;
+
+    // Updates arrive late by a varying amount. Follow the server clock slowly so that the jitter does not show in the
+    // interpolation, but reset if it is far off, for example when joining
+    double offset = time - networkClock_;
+    if (!networkTimeValid_ || Abs(offset - networkTimeOffset_) > NETWORK_TIME_RESYNC)
+    {
+        networkTimeOffset_ = offset;
+        latestNetworkTime_ = time;
+        networkTimeValid_ = true;
+    }
+    else
+    {
+        networkTimeOffset_ += (offset - networkTimeOffset_) * NETWORK_TIME_CORRECTION;
+        latestNetworkTime_ = Max(latestNetworkTime_, time);
+    }
+}
+
 void Scene::SetAsyncLoadingMs(int ms)
 {
     asyncLoadingMs_ = Max(ms, 1);
@@ -750,6 +804,8 @@ void Scene::Update(float timeStep)
 
     URHO3D_PROFILE(UpdateScene);
 
+    // Network client interpolation follows the server clock regardless of the time scale
+    networkClock_ += timeStep;
     timeStep *= timeScale_;
 
     using namespace SceneUpdate;
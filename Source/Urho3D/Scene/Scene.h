@@ -144,6 +144,17 @@ public:
     /// Set network client motion smoothing snap threshold.
     /// @property
     void SetSnapThreshold(float threshold);
+    /// Set network client interpolation delay in seconds. When nonzero, received node transforms are buffered with their server time and interpolated this far behind, instead of smoothed exponentially. Default 0.
+    /// @property
+    void SetInterpolationDelay(float delay);
+    /// Set how long in seconds network client interpolation may extrapolate past the latest received transform. Default 0.1.
+    /// @property
+    void SetMaxExtrapolation(float time);
+    /// Set whether to use the network change journal on the server. When enabled, nodes and components that record their changed attributes by index with MarkNetworkUpdate() compare only those attributes on the next network update, instead of all of them. Default false.
+    /// @property
+    void SetNetworkChangeJournal(bool enable);
+    /// Set server time in seconds of the network update being applied, and update the estimate of the server clock. Called by Connection.
+    void SetNetworkUpdateTime(double time);
     /// Set maximum milliseconds per frame to spend on async scene loading.
     /// @property
     void SetAsyncLoadingMs(int ms);
@@ -205,6 +216,25 @@ public:
     /// @property
     float GetSnapThreshold() const { return snapThreshold_; }
 
+    /// Return network client interpolation delay.
+    /// @property
+    float GetInterpolationDelay() const { return interpolationDelay_; }
+
+    /// Return how long network client interpolation may extrapolate.
+    /// @property
+    float GetMaxExtrapolation() const { return maxExtrapolation_; }
+
+    /// Return whether the network change journal is used.
+    /// @property
+    bool GetNetworkChangeJournal() const { return networkChangeJournal_; }
+
+    /// Return server time of the network update being applied.
+    double GetNetworkUpdateTime() const { return networkUpdateTime_; }
+    /// Return latest server time received in network updates.
+    double GetLatestNetworkTime() const { return latestNetworkTime_; }
+    /// Return estimated server time minus the interpolation delay, which network client interpolation shows.
+    double GetInterpolationTime() const { return networkClock_ + networkTimeOffset_ - interpolationDelay_; }
+
     /// Return maximum milliseconds per frame to spend on async loading.
     /// @property
     int GetAsyncLoadingMs() const { return asyncLoadingMs_; }
@@ -228,6 +258,9 @@ public:
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Return the mutex that serializes modifications to shared scene state during threaded update.
+    Mutex& GetSceneMutex() { return sceneMutex_; }
+
     /// Get free node ID, either non-local or local.
     NodeId GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -310,7 +343,7 @@ private:
     HashSet<ComponentId> networkUpdateComponents_;
     /// Delayed dirty notification queue for components.
     Vector<Component*> delayedDirtyComponents_;
-    /// Mutex for the delayed dirty notification queue.
+    /// Mutex for the delayed dirty notification queue and other shared state modified during threaded update.
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
@@ -334,12 +367,28 @@ private:
     float smoothingConstant_;
     /// Motion smoothing snap threshold.
     float snapThreshold_;
+    /// Network client interpolation delay.
+    float interpolationDelay_;
+    /// Network client maximum extrapolation time.
+    float maxExtrapolation_;
+    /// Server time of the network update being applied. Absolute times are in double precision, so that their resolution does not degrade on long sessions.
+    double networkUpdateTime_;
+    /// Latest server time received.
+    double latestNetworkTime_;
+    /// Unscaled time accumulator for estimating the server clock.
+    double networkClock_;
+    /// Estimated difference of the server clock from the network clock.
+    double networkTimeOffset_;
+    /// Server clock estimated flag.
+    bool networkTimeValid_;
     /// Update enabled flag.
     bool updateEnabled_;
     /// Asynchronous loading flag.
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Network change journal flag.
+    bool networkChangeJournal_;
 };
 
 /// Register Scene library objects.
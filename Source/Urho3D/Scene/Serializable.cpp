@@ -4,9 +4,12 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/Mutex.h"
+#include "../IO/BitStream.h"
 #include "../IO/Deserializer.h"
 #include "../IO/Log.h"
 #include "../IO/Serializer.h"
+#include "../IO/VectorBuffer.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONValue.h"
 #include "../Scene/ReplicationState.h"
@@ -20,6 +23,9 @@ using namespace std;
 namespace Urho3D
 {
 
+/// Maximum number of distinct serialized delta updates kept per object.
+static const i32 MAX_SERIALIZED_DELTA_UPDATES = 8;
+
 static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, const AttributeInfo& netAttr, unsigned netAttrIndex)
 {
     if (!attributes)
@@ -36,6 +42,156 @@ static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, con
     return netAttrIndex; // Could not remap
 }
 
+/// Return number of bits to quantize the components of a network attribute to, or zero if not quantized.
+static i32 GetQuantizationBits(const AttributeInfo& attr)
+{
+    if (attr.metadata_.Empty())
+        return 0;
+
+    switch (attr.type_)
+    {
+    case VAR_FLOAT:
+    case VAR_VECTOR2:
+    case VAR_VECTOR3:
+    case VAR_VECTOR4:
+    case VAR_QUATERNION:
+    case VAR_COLOR:
+        break;
+
+    default:
+        return 0;
+    }
+
+    const i32 bits = Clamp(attr.GetMetadata(AttributeMetadata::P_QUANTIZE_BITS).GetI32(), 0, 32);
+    if (!bits || attr.type_ == VAR_QUATERNION)
+        return bits;
+
+    // Without a range every value would quantize to the minimum, so send such attributes unquantized
+    const Variant& min = attr.GetMetadata(AttributeMetadata::P_QUANTIZE_MIN);
+    const Variant& max = attr.GetMetadata(AttributeMetadata::P_QUANTIZE_MAX);
+    if (min.GetType() == VAR_FLOAT && max.GetType() == VAR_FLOAT && max.GetFloat() > min.GetFloat())
+        return bits;
+
+    // Warn only once per attribute, as the updates may be serialized in worker threads
+    static Mutex warnedMutex;
+    static HashSet<const AttributeInfo*> warnedAttributes;
+    MutexLock lock(warnedMutex);
+    if (!warnedAttributes.Contains(&attr))
+    {
+        warnedAttributes.Insert(&attr);
+        URHO3D_LOGWARNING("Network attribute " + attr.name_ + " has quantization bits without a valid quantization range, "
+            "sending it unquantized");
+    }
+    return 0;
+}
+
+/// Return quantization range of a network attribute.
+static void GetQuantizationRange(const AttributeInfo& attr, float& min, float& max)
+{
+    if (attr.type_ == VAR_QUATERNION)
+    {
+        min = -1.0f;
+        max = 1.0f;
+    }
+    else
+    {
+        min = attr.GetMetadata(AttributeMetadata::P_QUANTIZE_MIN).GetFloat();
+        max = attr.GetMetadata(AttributeMetadata::P_QUANTIZE_MAX).GetFloat();
+    }
+}
+
+/// Write a network attribute value, quantized if the attribute has quantization metadata.
+static void WriteNetworkValue(BitWriter& dest, const AttributeInfo& attr, const Variant& value)
+{
+    i32 bits = GetQuantizationBits(attr);
+    if (!bits)
+    {
+        dest.WriteVariantData(value);
+        return;
+    }
+
+    float min, max;
+    GetQuantizationRange(attr, min, max);
+
+    float components[4];
+    i32 numComponents = 0;
+    switch (attr.type_)
+    {
+    case VAR_FLOAT:
+        components[0] = value.GetFloat();
+        numComponents = 1;
+        break;
+
+    case VAR_VECTOR2:
+        memcpy(components, value.GetVector2().Data(), 2 * sizeof(float));
+        numComponents = 2;
+        break;
+
+    case VAR_VECTOR3:
+        memcpy(components, value.GetVector3().Data(), 3 * sizeof(float));
+        numComponents = 3;
+        break;
+
+    case VAR_VECTOR4:
+        memcpy(components, value.GetVector4().Data(), 4 * sizeof(float));
+        numComponents = 4;
+        break;
+
+    case VAR_QUATERNION:
+        memcpy(components, value.GetQuaternion().Normalized().Data(), 4 * sizeof(float));
+        numComponents = 4;
+        break;
+
+    case VAR_COLOR:
+        memcpy(components, value.GetColor().Data(), 4 * sizeof(float));
+        numComponents = 4;
+        break;
+
+    default:
+        break;
+    }
+
+    for (i32 i = 0; i < numComponents; ++i)
+        dest.WriteQuantizedFloat(components[i], min, max, bits);
+}
+
+/// Read a network attribute value written by WriteNetworkValue().
+static Variant ReadNetworkValue(BitReader& source, const AttributeInfo& attr)
+{
+    i32 bits = GetQuantizationBits(attr);
+    if (!bits)
+        return source.ReadVariant(attr.type_);
+
+    float min, max;
+    GetQuantizationRange(attr, min, max);
+
+    float components[4];
+    i32 numComponents = attr.type_ == VAR_FLOAT ? 1 : attr.type_ == VAR_VECTOR2 ? 2 : attr.type_ == VAR_VECTOR3 ? 3 : 4;
+    for (i32 i = 0; i < numComponents; ++i)
+        components[i] = source.ReadQuantizedFloat(min, max, bits);
+
+    switch (attr.type_)
+    {
+    case VAR_FLOAT:
+        return Variant(components[0]);
+
+    case VAR_VECTOR2:
+        return Variant(Vector2(components));
+
+    case VAR_VECTOR3:
+        return Variant(Vector3(components));
+
+    case VAR_VECTOR4:
+        return Variant(Vector4(components));
+
+    case VAR_QUATERNION:
+        return Variant(Quaternion(components[0], components[1], components[2], components[3]).Normalized());
+
+    default:
+        return Variant(Color(components[0], components[1], components[2], components[3]));
+    }
+}
+
 Serializable::Serializable(Context* context) :
     Object(context),
     setInstanceDefault_(false),
@@ -729,26 +885,29 @@ void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeS
     if (!attributes)
         return;
 
-    unsigned numAttributes = attributes->Size();
-    DirtyBits attributeBits;
+    dest.WriteU8(timeStamp);
 
-    // Compare against defaults
-    for (unsigned i = 0; i < numAttributes; ++i)
+    // The update is the same for every connection, so serialize it only once after the attribute values change
+    MutexLock lock(networkState_->updateMutex_);
+    VectorBuffer& update = networkState_->initialDeltaUpdate_;
+    if (!update.GetSize())
     {
-        const AttributeInfo& attr = attributes->At(i);
-        if (networkState_->currentValues_[i] != attr.defaultValue_)
-            attributeBits.Set(i);
-    }
+        unsigned numAttributes = attributes->Size();
+        DirtyBits attributeBits;
 
-    // First write the change bitfield, then attribute data for non-default attributes
-    dest.WriteU8(timeStamp);
-    dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
+        // Compare against defaults
+        for (unsigned i = 0; i < numAttributes; ++i)
+        {
+            const AttributeInfo& attr = attributes->At(i);
+            if (networkState_->currentValues_[i] != attr.defaultValue_)
+                attributeBits.Set(i);
+        }
 
-    for (unsigned i = 0; i < numAttributes; ++i)
-    {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+        // First write the change bitfield, then attribute data for non-default attributes
+        WriteDeltaData(update, attributeBits);
     }
+
+    dest.Write(update.GetData(), update.GetSize());
 }
 
 void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp)
@@ -763,18 +922,33 @@ void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attribute
     if (!attributes)
         return;
 
-    unsigned numAttributes = attributes->Size();
-
     // First write the change bitfield, then attribute data for changed attributes
     // Note: the attribute bits should not contain LATESTDATA attributes
     dest.WriteU8(timeStamp);
-    dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
 
-    for (unsigned i = 0; i < numAttributes; ++i)
+    // Connections that have received the same updates share the serialized update for their dirty bits
+    MutexLock lock(networkState_->updateMutex_);
+    Vector<Pair<DirtyBits, VectorBuffer>>& updates = networkState_->deltaUpdates_;
+    for (i32 i = 0; i < updates.Size(); ++i)
     {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+        if (updates[i].first_ == attributeBits)
+        {
+            dest.Write(updates[i].second_.GetData(), updates[i].second_.GetSize());
+            return;
+        }
     }
+
+    if (updates.Size() >= MAX_SERIALIZED_DELTA_UPDATES)
+    {
+        WriteDeltaData(dest, attributeBits);
+        return;
+    }
+
+    updates.Resize(updates.Size() + 1);
+    Pair<DirtyBits, VectorBuffer>& update = updates.Back();
+    update.first_ = attributeBits;
+    WriteDeltaData(update.second_, attributeBits);
+    dest.Write(update.second_.GetData(), update.second_.GetSize());
 }
 
 void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp)
@@ -789,14 +963,37 @@ void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeSta
     if (!attributes)
         return;
 
-    unsigned numAttributes = attributes->Size();
-
     dest.WriteU8(timeStamp);
 
+    MutexLock lock(networkState_->updateMutex_);
+    VectorBuffer& update = networkState_->latestDataUpdate_;
+    if (!update.GetSize())
+    {
+        BitWriter writer(update);
+        unsigned numAttributes = attributes->Size();
+        for (unsigned i = 0; i < numAttributes; ++i)
+        {
+            if (attributes->At(i).mode_ & AM_LATESTDATA)
+                WriteNetworkValue(writer, attributes->At(i), networkState_->currentValues_[i]);
+        }
+    }
+
+    dest.Write(update.GetData(), update.GetSize());
+}
+
+void Serializable::WriteDeltaData(Serializer& dest, const DirtyBits& attributeBits) const
+{
+    // Write one bit per attribute, then the values packed after each other. Quantized values take only their bits
+    const Vector<AttributeInfo>& attributes = *networkState_->attributes_;
+    unsigned numAttributes = attributes.Size();
+    BitWriter writer(dest);
+    for (unsigned i = 0; i < numAttributes; ++i)
+        writer.WriteBit(attributeBits.IsSet(i));
+
     for (unsigned i = 0; i < numAttributes; ++i)
     {
-        if (attributes->At(i).mode_ & AM_LATESTDATA)
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+        if (attributeBits.IsSet(i))
+            WriteNetworkValue(writer, attributes[i], networkState_->currentValues_[i]);
     }
 }
 
@@ -812,16 +1009,21 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
 
     unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
     unsigned char timeStamp = source.ReadU8();
-    source.Read(attributeBits.data_, (numAttributes + 7) >> 3u);
+    BitReader reader(source);
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (reader.ReadBit())
+            attributeBits.Set(i);
+    }
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    for (unsigned i = 0; i < numAttributes && !reader.IsEof(); ++i)
     {
         if (attributeBits.IsSet(i))
         {
             const AttributeInfo& attr = attributes->At(i);
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, ReadNetworkValue(reader, attr));
                 changed = true;
             }
             else
@@ -833,7 +1035,7 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = ReadNetworkValue(reader, attr);
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
@@ -853,15 +1055,16 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
 
     unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
     unsigned char timeStamp = source.ReadU8();
+    BitReader reader(source);
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    for (unsigned i = 0; i < numAttributes && !reader.IsEof(); ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
         if (attr.mode_ & AM_LATESTDATA)
         {
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, ReadNetworkValue(reader, attr));
                 changed = true;
             }
             else
@@ -873,7 +1076,7 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = ReadNetworkValue(reader, attr);
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
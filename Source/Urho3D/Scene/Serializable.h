@@ -82,11 +82,11 @@ public:
     void SetInterceptNetworkUpdate(const String& attributeName, bool enable);
     /// Allocate network attribute state.
     void AllocateNetworkState();
-    /// Write initial delta network update.
+    /// Write initial delta network update. The serialized attribute data is shared by all connections until the attribute values change. Is thread-safe.
     void WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeStamp);
-    /// Write a delta network update according to dirty attribute bits.
+    /// Write a delta network update according to dirty attribute bits. The serialized attribute data is shared by all connections with the same dirty bits until the attribute values change. Is thread-safe.
     void WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp);
-    /// Write a latest data network update.
+    /// Write a latest data network update. The serialized attribute data is shared by all connections until the attribute values change. Is thread-safe.
     void WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp);
     /// Read and apply a network delta update. Return true if attributes were changed.
     bool ReadDeltaUpdate(Deserializer& source);
@@ -128,6 +128,8 @@ private:
     void SetInstanceDefault(const String& name, const Variant& defaultValue);
     /// Get instance-level default value.
     Variant GetInstanceDefault(const String& name) const;
+    /// Write the change bitfield and the changed network attribute values of a delta update.
+    void WriteDeltaData(Serializer& dest, const DirtyBits& attributeBits) const;
 
     /// Attribute default value at each instance level.
     std::unique_ptr<VariantMap> instanceDefaultValues_;
@@ -215,6 +217,12 @@ namespace AttributeMetadata
 {
     /// Names of vector struct elements. StringVector.
     static const StringHash P_VECTOR_STRUCT_ELEMENTS("VectorStructElements");
+    /// Number of bits (1-32) to quantize each component of a float, vector, quaternion or color attribute to in network replication. Except for quaternions, requires P_QUANTIZE_MIN and P_QUANTIZE_MAX with a non-empty range, otherwise the attribute is sent unquantized and a warning is logged. Int.
+    static const StringHash P_QUANTIZE_BITS("QuantizeBits");
+    /// Minimum value of each quantized component. Not needed for quaternions, which are always within -1 and 1. Float.
+    static const StringHash P_QUANTIZE_MIN("QuantizeMin");
+    /// Maximum value of each quantized component. Values outside the range are clamped. Float.
+    static const StringHash P_QUANTIZE_MAX("QuantizeMax");
 }
 
 /// Get result type of a class member function with zero args.
@@ -13,6 +13,9 @@
 namespace Urho3D
 {
 
+/// Maximum number of targets buffered for interpolation.
+static const i32 MAX_TRANSFORM_SAMPLES = 32;
+
 SmoothedTransform::SmoothedTransform(Context* context) :
     Component(context),
     targetPosition_(Vector3::ZERO),
@@ -31,6 +34,10 @@ void SmoothedTransform::RegisterObject(Context* context)
 
 void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
 {
+    // A snap also ends the interpolation, leaving the latest target to interpolate from
+    if (constant >= 1.0f && samples_.Size() > 1)
+        samples_.Erase(0, samples_.Size() - 1);
+
     if (smoothingMask_ && node_)
     {
         Vector3 position = node_->GetPosition();
@@ -77,31 +84,98 @@ void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
     }
 }
 
-void SmoothedTransform::SetTargetPosition(const Vector3& position)
+void SmoothedTransform::UpdateInterpolation(double time, float maxExtrapolation)
 {
-    targetPosition_ = position;
-    smoothingMask_ |= SMOOTH_POSITION;
+    if (samples_.Empty() || !node_)
+        return;
 
-    // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
+    Vector3 position;
+    Quaternion rotation;
+    bool finished = false;
+
+    i32 next = 0;
+    while (next < samples_.Size() && samples_[next].time_ <= time)
+        ++next;
+
+    if (!next)
     {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
+        position = samples_[0].position_;
+        rotation = samples_[0].rotation_;
+    }
+    else if (next < samples_.Size())
+    {
+        // Cubic Hermite interpolation with the velocities at the samples keeps the motion smooth across samples
+        const TransformSample& start = samples_[next - 1];
+        const TransformSample& end = samples_[next];
+        float interval = (float)(end.time_ - start.time_);
+        float t = (float)(time - start.time_) / interval;
+        float t2 = t * t;
+        float t3 = t2 * t;
+        position = start.position_ * (2.0f * t3 - 3.0f * t2 + 1.0f) + GetSampleVelocity(next - 1) * (interval * (t3 - 2.0f * t2 + t)) +
+            end.position_ * (3.0f * t2 - 2.0f * t3) + GetSampleVelocity(next) * (interval * (t3 - t2));
+        rotation = start.rotation_.Slerp(end.rotation_, t);
+    }
+    else
+    {
+        // Past the latest target, continue at its velocity for a while, then return to it. When newer updates have
+        // arrived without this node, it has not moved since and is not extrapolated
+        const TransformSample& last = samples_.Back();
+        float elapsed = (float)(time - last.time_);
+        float extrapolation = 0.0f;
+        Scene* scene = GetScene();
+        if (samples_.Size() > 1 && elapsed < 2.0f * maxExtrapolation && (!scene || scene->GetLatestNetworkTime() <= last.time_))
+            extrapolation = elapsed <= maxExtrapolation ? elapsed : 2.0f * maxExtrapolation - elapsed;
+
+        position = last.position_ + GetSampleVelocity(samples_.Size() - 1) * extrapolation;
+        rotation = last.rotation_;
+        finished = extrapolation <= 0.0f;
+    }
+
+    node_->SetTransform(position, rotation);
+
+    // Keep the sample before the current interval for its velocity
+    if (next > 2)
+        samples_.Erase(0, next - 2);
+
+    if (finished)
+    {
+        samples_.Erase(0, samples_.Size() - 1);
+        smoothingMask_ = SMOOTH_NONE;
+        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
+        subscribed_ = false;
+    }
+}
+
+void SmoothedTransform::SetTargetPosition(const Vector3& position)
+{
+    TransformSample* sample = GetUpdateSample();
+    if (sample)
+    {
+        sample->position_ = position;
+        targetPosition_ = samples_.Back().position_;
     }
+    else
+        targetPosition_ = position;
+
+    smoothingMask_ |= SMOOTH_POSITION;
+    SubscribeToSmoothing();
 
     SendEvent(E_TARGETPOSITION);
 }
 
 void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
 {
-    targetRotation_ = rotation;
-    smoothingMask_ |= SMOOTH_ROTATION;
-
-    if (!subscribed_)
+    TransformSample* sample = GetUpdateSample();
+    if (sample)
     {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
+        sample->rotation_ = rotation;
+        targetRotation_ = samples_.Back().rotation_;
     }
+    else
+        targetRotation_ = rotation;
+
+    smoothingMask_ |= SMOOTH_ROTATION;
+    SubscribeToSmoothing();
 
     SendEvent(E_TARGETROTATION);
 }
@@ -152,9 +226,64 @@ void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap&
 {
     using namespace UpdateSmoothing;
 
+    Scene* scene = GetScene();
+    if (!samples_.Empty() && scene)
+    {
+        UpdateInterpolation(scene->GetInterpolationTime(), scene->GetMaxExtrapolation());
+        return;
+    }
+
     float constant = eventData[P_CONSTANT].GetFloat();
     float squaredSnapThreshold = eventData[P_SQUAREDSNAPTHRESHOLD].GetFloat();
     Update(constant, squaredSnapThreshold);
 }
 
+void SmoothedTransform::SubscribeToSmoothing()
+{
+    if (!subscribed_)
+    {
+        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+        subscribed_ = true;
+    }
+}
+
+TransformSample* SmoothedTransform::GetUpdateSample()
+{
+    Scene* scene = GetScene();
+    if (!scene || scene->GetInterpolationDelay() <= 0.0f)
+    {
+        samples_.Clear();
+        return nullptr;
+    }
+
+    // Position and rotation of the same update share a sample. Updates may arrive out of order
+    double time = scene->GetNetworkUpdateTime();
+    i32 index = samples_.Size();
+    while (index > 0 && samples_[index - 1].time_ > time)
+        --index;
+    if (index > 0 && samples_[index - 1].time_ == time)
+        return &samples_[index - 1];
+
+    if (samples_.Size() >= MAX_TRANSFORM_SAMPLES)
+    {
+        samples_.Erase(0);
+        index = Max(index - 1, 0);
+    }
+
+    TransformSample sample;
+    sample.time_ = time;
+    sample.position_ = index ? samples_[index - 1].position_ : targetPosition_;
+    sample.rotation_ = index ? samples_[index - 1].rotation_ : targetRotation_;
+    samples_.Insert(index, sample);
+    return &samples_[index];
+}
+
+Vector3 SmoothedTransform::GetSampleVelocity(i32 index) const
+{
+    i32 prev = Max(index - 1, 0);
+    i32 next = Min(index + 1, samples_.Size() - 1);
+    float interval = (float)(samples_[next].time_ - samples_[prev].time_);
+    return interval > 0.0f ? (samples_[next].position_ - samples_[prev].position_) / interval : Vector3::ZERO;
+}
+
 }
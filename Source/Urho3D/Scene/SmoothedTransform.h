@@ -21,7 +21,18 @@ enum SmoothingType : unsigned
 };
 URHO3D_FLAGSET(SmoothingType, SmoothingTypeFlags);
 
-/// Transform smoothing component for network updates.
+/// Node transform received from the server at a server time, for interpolation.
+struct TransformSample
+{
+    /// Server time in seconds.
+    double time_;
+    /// Position in parent space.
+    Vector3 position_;
+    /// Rotation in parent space.
+    Quaternion rotation_;
+};
+
+/// Transform smoothing component for network updates. Smooths exponentially toward the latest target, or interpolates between time-stamped targets if the scene has an interpolation delay.
 class URHO3D_API SmoothedTransform : public Component
 {
     URHO3D_OBJECT(SmoothedTransform, Component);
@@ -35,8 +46,10 @@ public:
     /// @nobind
     static void RegisterObject(Context* context);
 
-    /// Update smoothing.
+    /// Update smoothing. A constant of 1 also snaps the interpolation to the latest target.
     void Update(float constant, float squaredSnapThreshold);
+    /// Update interpolation to a server time. Past the latest target, extrapolate at most the given time and then return to the latest target.
+    void UpdateInterpolation(double time, float maxExtrapolation);
     /// Set target position in parent space.
     /// @property
     void SetTargetPosition(const Vector3& position);
@@ -69,6 +82,9 @@ public:
     /// @property
     bool IsInProgress() const { return smoothingMask_ != SMOOTH_NONE; }
 
+    /// Return number of buffered targets for interpolation.
+    i32 GetNumSamples() const { return samples_.Size(); }
+
 protected:
     /// Handle scene node being assigned at creation.
     void OnNodeSet(Node* node) override;
@@ -76,11 +92,19 @@ protected:
 private:
     /// Handle smoothing update event.
     void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    /// Subscribe to the smoothing update event if not yet subscribed.
+    void SubscribeToSmoothing();
+    /// Return the interpolation sample for the server time of the network update being applied, or null if not interpolating.
+    TransformSample* GetUpdateSample();
+    /// Return velocity of the position at a sample, estimated from the neighbouring samples.
+    Vector3 GetSampleVelocity(i32 index) const;
 
     /// Target position.
     Vector3 targetPosition_;
     /// Target rotation.
     Quaternion targetRotation_;
+    /// Targets with their server times in time order, for interpolation.
+    Vector<TransformSample> samples_;
     /// Active smoothing operations bitmask.
     SmoothingTypeFlags smoothingMask_;
     /// Subscribed to smoothing update event flag.
@@ -0,0 +1,56 @@
+// Copyright (c) 2008-2023 the Urho3D project
+// License: MIT
+
+/// \file
+/// @nobindfile
+
+#pragma once
+
+#include "../Core/WorkQueue.h"
+#include "../Scene/Scene.h"
+
+namespace Urho3D
+{
+
+/// Minimum number of batched world transforms to apply them in worker threads.
+inline constexpr i32 MIN_PARALLEL_TRANSFORMS = 256;
+
+/// Apply a batch of rigid body world transforms from a physics step to the scene nodes with a function, then clear the batch. The transforms have the rigidBody_ and threadSafe_ members. When parallel, the thread-safe transforms are applied in the worker threads in the threaded update mode of the scene, after the others have been applied from the main thread.
+template <class T, class F> void ApplyWorldTransformBatch(Scene* scene, Vector<T>& transforms, bool parallel, const F& apply)
+{
+    auto* queue = scene ? scene->GetSubsystem<WorkQueue>() : nullptr;
+    if (!parallel || !queue || !queue->GetNumThreads() || transforms.Size() < MIN_PARALLEL_TRANSFORMS)
+    {
+        for (const T& transform : transforms)
+            apply(transform);
+    }
+    else
+    {
+        // Apply the transforms that are not safe to apply from worker threads first
+        for (T& transform : transforms)
+        {
+            if (!transform.threadSafe_)
+            {
+                apply(transform);
+                transform.rigidBody_ = nullptr;
+            }
+        }
+
+        // The nodes of the remaining bodies are disjoint subtrees of the scene. The threaded update mode defers the
+        // component dirty notifications and makes the octree and network update queues thread-safe
+        scene->BeginThreadedUpdate();
+        queue->ParallelFor(0, transforms.Size(), MIN_PARALLEL_TRANSFORMS / 4, [&transforms, &apply](i32 begin, i32 end, i32 threadIndex)
+        {
+            for (i32 i = begin; i < end; ++i)
+            {
+                if (transforms[i].rigidBody_)
+                    apply(transforms[i]);
+            }
+        });
+        scene->EndThreadedUpdate();
+    }
+
+    transforms.Clear();
+}
+
+}
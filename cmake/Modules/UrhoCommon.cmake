@@ -254,6 +254,7 @@ if (NOT WEB)
     set (THREADING_DEFAULT TRUE)
 endif ()
 option (URHO3D_THREADING "Enable thread support, on Web platform default to 0, on other platforms default to 1" ${THREADING_DEFAULT})
+cmake_dependent_option (URHO3D_PHYSICS_THREADSAFE "Build Bullet thread-safe, required by the multithreaded physics world and parallel batched physics queries" FALSE "URHO3D_PHYSICS AND URHO3D_THREADING" FALSE)
 if (URHO3D_TESTING)
     if (WEB)
         set (DEFAULT_TIMEOUT 10)
@@ -442,6 +443,12 @@ foreach (OPT
     endif ()
 endforeach ()
 
+# Build Bullet thread-safe only on request, as it adds locking and per-thread bookkeeping also to the sequential physics world.
+# Defined globally, because it changes Bullet's headers for the library and the applications using them alike
+if (URHO3D_PHYSICS_THREADSAFE)
+    add_definitions (-DBT_THREADSAFE=1)
+endif ()
+
 # TODO: The logic below is earmarked to be moved into SDL's CMakeLists.txt when refactoring the library dependency handling, until then ensure the DirectX package is not being searched again in external projects such as when building LuaJIT library
 if (WIN32 AND NOT CMAKE_PROJECT_NAME MATCHES ^Urho3D-ExternalProject-)
     set (DIRECTX_REQUIRED_COMPONENTS)